@@ -0,0 +1,194 @@
+#include "BatchRunner.h"
+#include "fmt/base.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct BatchArgs
+{
+	std::string jobsPath;
+	std::string outPath; // csv results, stdout when empty
+	uint32_t    threads = 0;
+	bool        scaling = false;
+};
+
+void printUsage()
+{
+	fmt::println(stderr, "Usage: budgetgb-batch <jobs.txt> [--threads N] [--out <results.csv>] [--scaling]");
+	fmt::println(stderr, "       jobs.txt holds one job per line: <rom> <frames | movie> [screenshot.ppm]");
+	fmt::println(stderr, "       --scaling runs the batch at 1, 2, 4... threads up to N and reports the speedup");
+}
+
+bool parseArgs(int argc, char **argv, BatchArgs &args)
+{
+	if (argc < 2)
+		return false;
+
+	args.jobsPath = argv[1];
+
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string_view arg = argv[i];
+
+		if (arg == "--threads" && i + 1 < argc)
+			args.threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (arg == "--out" && i + 1 < argc)
+			args.outPath = argv[++i];
+		else if (arg == "--scaling")
+			args.scaling = true;
+		else
+		{
+			fmt::println(stderr, "Unknown argument: {}", arg);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint64_t getTotalFrames(const std::vector<BatchResult> &results)
+{
+	uint64_t frames = 0;
+	for (const BatchResult &result : results)
+		frames += result.Frames;
+
+	return frames;
+}
+
+bool writeResults(const std::string &outPath, const std::vector<BatchJob> &jobs, const std::vector<BatchResult> &results)
+{
+	std::string csv = "rom,input,ok,frames,state_hash,framebuffer_hash,seconds,worker\n";
+
+	for (std::size_t i = 0; i < jobs.size(); ++i)
+	{
+		const BatchJob    &job    = jobs[i];
+		const BatchResult &result = results[i];
+
+		csv += fmt::format("{},{},{},{},{:016x},{:016x},{:.6f},{}\n",
+		                   job.RomPath,
+		                   job.MoviePath.empty() ? std::to_string(job.Frames) : job.MoviePath,
+		                   result.Ok ? 1 : 0,
+		                   result.Frames,
+		                   result.StateHash,
+		                   result.FramebufferHash,
+		                   result.Seconds,
+		                   result.Worker);
+	}
+
+	if (outPath.empty())
+	{
+		fmt::print("{}", csv);
+		return true;
+	}
+
+	std::ofstream outFile(outPath);
+	if (!outFile.is_open())
+	{
+		fmt::println(stderr, "Failed to open results at: {}", outPath);
+		return false;
+	}
+
+	outFile << csv;
+	return outFile.good();
+}
+
+// run the whole batch at doubling thread counts, every run has to reproduce the single threaded hashes
+bool runScaling(const std::vector<BatchJob> &jobs, uint32_t maxThreads)
+{
+	std::vector<BatchResult> reference;
+	double                   referenceFps = 0.0;
+
+	for (uint32_t threads = 1;; threads = std::min(threads * 2, maxThreads))
+	{
+		BatchRunner runner(threads);
+
+		auto                     startTime = std::chrono::steady_clock::now();
+		std::vector<BatchResult> results   = runner.run(jobs);
+		double                   elapsed   = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		const double             fps       = elapsed > 0.0 ? getTotalFrames(results) / elapsed : 0.0;
+
+		if (reference.empty())
+		{
+			reference    = results;
+			referenceFps = fps;
+		}
+
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			if (results[i].Ok != reference[i].Ok || results[i].StateHash != reference[i].StateHash)
+			{
+				fmt::println(stderr, "Job {} ended in a different state on {} threads!", i, threads);
+				return false;
+			}
+		}
+
+		const double speedup = referenceFps > 0.0 ? fps / referenceFps : 0.0;
+		fmt::println("{:>3} threads: {:.3f}s, {:.0f} frames per second, {:.2f}x speedup, {:.0f}% efficiency, {} steals",
+		             threads,
+		             elapsed,
+		             fps,
+		             speedup,
+		             speedup / threads * 100.0,
+		             runner.getStealCount());
+
+		if (threads == maxThreads)
+			break;
+	}
+
+	return true;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+	BatchArgs args;
+	if (!parseArgs(argc, argv, args))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	std::vector<BatchJob> jobs;
+	if (!BatchRunner::loadJobs(args.jobsPath, jobs))
+		return EXIT_FAILURE;
+
+	if (args.scaling)
+	{
+		const uint32_t maxThreads = args.threads != 0 ? args.threads : std::max(1u, std::thread::hardware_concurrency());
+		return runScaling(jobs, maxThreads) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	BatchRunner runner(args.threads);
+
+	auto                     startTime = std::chrono::steady_clock::now();
+	std::vector<BatchResult> results   = runner.run(jobs);
+	double                   elapsed   = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	const uint64_t frames = getTotalFrames(results);
+	const auto     failed = std::count_if(results.begin(), results.end(), [](const BatchResult &result) { return !result.Ok; });
+
+	fmt::println(stderr,
+	             "Ran {} jobs, {} frames on {} threads in {:.3f}s, {:.0f} frames per second, {} steals, {} failed",
+	             jobs.size(),
+	             frames,
+	             runner.getThreadCount(),
+	             elapsed,
+	             elapsed > 0.0 ? frames / elapsed : 0.0,
+	             runner.getStealCount(),
+	             failed);
+
+	if (!writeResults(args.outPath, jobs, results))
+		return EXIT_FAILURE;
+
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,23 +4,82 @@
 
 #include "BudgetGB.h"
 #include "fmt/base.h"
+#include "headless.h"
 #include "renderer.h"
 
+#include <cstdlib>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 // initialization
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv)
 {
+	// headless commands run to completion without ever opening a window
+	if (Headless::isHeadlessCommand(argc, argv))
+		return Headless::run(argc, argv) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+
 	try
 	{
 		if (argc < 2)
 			*appstate = new BudgetGB();
 		else if (argc == 2)
 			*appstate = new BudgetGB(std::string(argv[1]));
+		else if ((argc == 6 || argc == 7) && std::string_view(argv[2]) == "--netplay")
+		{
+			// <rom> --netplay <local port> <peer address> <peer port> [input delay]
+			BudgetGB *gameboy = new BudgetGB(std::string(argv[1]));
+			*appstate         = gameboy;
+
+			const uint16_t localPort  = static_cast<uint16_t>(std::strtoul(argv[3], nullptr, 10));
+			const uint16_t peerPort   = static_cast<uint16_t>(std::strtoul(argv[5], nullptr, 10));
+			const uint32_t inputDelay = argc == 7 ? static_cast<uint32_t>(std::strtoul(argv[6], nullptr, 10)) : 1;
+
+			if (!gameboy->startNetplay(localPort, argv[4], peerPort, inputDelay))
+				return SDL_APP_FAILURE;
+		}
+		else if (argc >= 4 && std::string_view(argv[2]) == "--shm")
+		{
+			// <rom> --shm <name> [hex address ...]
+			BudgetGB *gameboy = new BudgetGB(std::string(argv[1]));
+			*appstate         = gameboy;
+
+			std::vector<uint16_t> ramAddresses;
+			for (int i = 4; i < argc; ++i)
+				ramAddresses.push_back(static_cast<uint16_t>(std::strtoul(argv[i], nullptr, 16)));
+
+			if (!gameboy->startSharedMemory(argv[3], ramAddresses))
+				return SDL_APP_FAILURE;
+		}
+		else if (argc == 6 && std::string_view(argv[2]) == "--link")
+		{
+			// <rom> --link <local port> <peer address> <peer port>
+			BudgetGB *gameboy = new BudgetGB(std::string(argv[1]));
+			*appstate         = gameboy;
+
+			const uint16_t localPort = static_cast<uint16_t>(std::strtoul(argv[3], nullptr, 10));
+			const uint16_t peerPort  = static_cast<uint16_t>(std::strtoul(argv[5], nullptr, 10));
+
+			if (!gameboy->startLink(localPort, argv[4], peerPort))
+				return SDL_APP_FAILURE;
+		}
+		else if (argc == 4 && std::string_view(argv[2]) == "--gdb")
+		{
+			// <rom> --gdb <port>
+			BudgetGB *gameboy = new BudgetGB(std::string(argv[1]));
+			*appstate         = gameboy;
+
+			if (!gameboy->startGdbServer(static_cast<uint16_t>(std::strtoul(argv[3], nullptr, 10))))
+				return SDL_APP_FAILURE;
+		}
 		else
 		{
 			fmt::println(stderr, "Invalid number of arguments, please provide only one path to rom file or none at all!");
+			fmt::println(stderr, "Netplay: BudgetGB <rom> --netplay <local port> <peer address> <peer port> [input delay]");
+			fmt::println(stderr, "Shared memory: BudgetGB <rom> --shm <name> [hex address ...]");
+			fmt::println(stderr, "Link cable: BudgetGB <rom> --link <local port> <peer address> <peer port>");
+			fmt::println(stderr, "Debugger: BudgetGB <rom> --gdb <port>");
 			return SDL_APP_FAILURE;
 		}
 	}
@@ -0,0 +1,90 @@
+#include "AudioDevice.h"
+#include "SharedMemoryChannel.h"
+#include "fmt/base.h"
+
+#include <algorithm>
+#include <array>
+
+AudioDevice::~AudioDevice()
+{
+	close();
+}
+
+bool AudioDevice::open(Apu &apu)
+{
+	close();
+
+	SDL_AudioSpec audioSpec{};
+	audioSpec.format   = SDL_AUDIO_F32;
+	audioSpec.freq     = static_cast<int>(apu.getSampleRate());
+	audioSpec.channels = 1;
+
+	m_apu         = &apu;
+	m_audioStream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &audioSpec, streamCallback, this);
+
+	if (!m_audioStream)
+	{
+		fmt::println("{}", SDL_GetError());
+		return false;
+	}
+
+	// device streams open paused
+	if (!m_paused)
+		SDL_ResumeAudioStreamDevice(m_audioStream);
+
+	return true;
+}
+
+void AudioDevice::close()
+{
+	// destroying the stream joins the device callback, the apu is not read from again afterwards
+	if (m_audioStream)
+		SDL_DestroyAudioStream(m_audioStream);
+
+	m_audioStream = nullptr;
+}
+
+void AudioDevice::pause()
+{
+	m_paused = true;
+
+	if (m_audioStream)
+	{
+		SDL_PauseAudioStreamDevice(m_audioStream);
+		SDL_ClearAudioStream(m_audioStream);
+	}
+}
+
+void AudioDevice::resume()
+{
+	m_paused = false;
+
+	if (m_audioStream)
+		SDL_ResumeAudioStreamDevice(m_audioStream);
+}
+
+void SDLCALL AudioDevice::streamCallback(void *userdata, SDL_AudioStream *audioStream, int additionalAmount, int totalAmount)
+{
+	(void)additionalAmount;
+
+	AudioDevice           *device    = static_cast<AudioDevice *>(userdata);
+	SharedMemoryPublisher *publisher = device->m_publisher.load(std::memory_order_acquire);
+	totalAmount /= sizeof(float);
+
+	while (totalAmount > 0)
+	{
+		std::array<float, 128> samples;
+
+		const int      total       = std::min(totalAmount, (int)samples.size());
+		const uint32_t samplesRead = device->m_apu->pullSamples(samples.data(), total);
+
+		if (samplesRead == 0)
+			break;
+
+		SDL_PutAudioStreamData(audioStream, samples.data(), samplesRead * sizeof(samples[0]));
+		if (publisher)
+			publisher->publishAudio(samples.data(), samplesRead);
+
+		totalAmount -= samplesRead;
+	}
+}
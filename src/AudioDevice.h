@@ -0,0 +1,49 @@
+#pragma once
+
+#include "SDL3/SDL.h"
+#include "apu.h"
+
+#include <atomic>
+
+class SharedMemoryPublisher;
+
+/**
+ * @brief Plays the output of an apu on the default SDL playback device. The device callback drains the apu with
+ * Apu::pullSamples() on the SDL audio thread.
+ */
+class AudioDevice
+{
+  public:
+	AudioDevice() = default;
+	~AudioDevice();
+
+	AudioDevice(const AudioDevice &)            = delete;
+	AudioDevice &operator=(const AudioDevice &) = delete;
+
+	/**
+	 * @brief Open a device stream at the current sample rate of apu, replacing an open one. Call again after
+	 * Apu::setOutputFormat(). The device starts paused, reopening keeps the paused or playing state.
+	 * @return True on success, false otherwise.
+	 */
+	bool open(Apu &apu);
+	void close();
+
+	// pausing also drops samples already queued in the device stream
+	void pause();
+	void resume();
+
+	// also publish every sample played to a shared memory channel, nullptr stops publishing
+	void setPublisher(SharedMemoryPublisher *publisher)
+	{
+		m_publisher.store(publisher, std::memory_order_release);
+	}
+
+  private:
+	static void SDLCALL streamCallback(void *userdata, SDL_AudioStream *audioStream, int additionalAmount, int totalAmount);
+
+	Apu             *m_apu         = nullptr;
+	SDL_AudioStream *m_audioStream = nullptr;
+	bool             m_paused      = true;
+
+	std::atomic<SharedMemoryPublisher *> m_publisher = nullptr; // read by the device callback
+};
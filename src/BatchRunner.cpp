@@ -0,0 +1,120 @@
+#include "BatchRunner.h"
+#include "Movie.h"
+#include "config.h"
+#include "fmt/base.h"
+#include "utils/hash.h"
+#include "utils/screenshot.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+BatchRunner::BatchRunner(uint32_t threadCount)
+	: m_pool(threadCount),
+	  m_cores(m_pool.getThreadCount())
+{
+}
+
+bool BatchRunner::loadJobs(const std::string &path, std::vector<BatchJob> &jobs)
+{
+	std::ifstream jobsFile(path);
+	if (!jobsFile.is_open())
+	{
+		fmt::println(stderr, "Failed to open job list at: {}", path);
+		return false;
+	}
+
+	std::string line;
+	for (uint32_t lineNumber = 1; std::getline(jobsFile, line); ++lineNumber)
+	{
+		std::istringstream fields(line);
+
+		std::string romPath, input, screenshotPath;
+		if (!(fields >> romPath) || romPath[0] == '#')
+			continue;
+
+		if (!(fields >> input))
+		{
+			fmt::println(stderr, "Job on line {} has no frame count or movie!", lineNumber);
+			return false;
+		}
+
+		fields >> screenshotPath;
+
+		BatchJob job;
+		job.RomPath        = romPath;
+		job.ScreenshotPath = screenshotPath;
+
+		char         *end    = nullptr;
+		unsigned long frames = std::strtoul(input.c_str(), &end, 10);
+
+		if (*end == '\0')
+			job.Frames = static_cast<uint32_t>(frames);
+		else
+			job.MoviePath = input;
+
+		jobs.push_back(std::move(job));
+	}
+
+	return true;
+}
+
+std::vector<BatchResult> BatchRunner::run(const std::vector<BatchJob> &jobs)
+{
+	std::vector<BatchResult> results(jobs.size());
+
+	m_pool.run(static_cast<uint32_t>(jobs.size()), [this, &jobs, &results](uint32_t worker, uint32_t index) {
+		// allocated on the worker's own thread, so its memory is first touched there
+		if (!m_cores[worker])
+			m_cores[worker] = std::make_unique<BudgetGBCore>();
+
+		results[index].Worker = worker;
+		results[index].Ok     = runJob(*m_cores[worker], jobs[index], results[index]);
+	});
+
+	return results;
+}
+
+bool BatchRunner::runJob(BudgetGBCore &core, const BatchJob &job, BatchResult &result)
+{
+	std::vector<std::string> recentRoms;
+	if (!core.loadCartridge(job.RomPath, recentRoms, false))
+		return false;
+
+	Movie movie;
+	if (job.MoviePath.empty())
+	{
+		// a reused core may still hold the buttons of a failed movie job
+		core.reset(false);
+		core.setInput(0);
+	}
+	else if (!movie.loadFromFile(job.MoviePath) || !movie.startPlayback(core))
+		return false;
+
+	// nothing listens to the audio, channels still run so the state is unaffected
+	core.m_apu.setOutputEnabled(false);
+
+	const uint32_t frames    = job.MoviePath.empty() ? job.Frames : movie.getFrameCount();
+	Joypad        &joypad    = core.m_cpu.m_joypad;
+	auto           startTime = std::chrono::steady_clock::now();
+
+	for (uint32_t frame = 0; frame < frames; ++frame)
+	{
+		movie.beforeFrame(joypad);
+		core.runFrame();
+		movie.afterFrame(joypad);
+	}
+
+	result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	result.Frames  = frames;
+
+	const BudgetGbConstants::LcdColorBuffer &framebuffer = core.getFramebuffer();
+	result.StateHash                                     = core.hashState();
+	result.FramebufferHash                               = Utils::hash64(framebuffer.data(), framebuffer.size());
+
+	if (!job.ScreenshotPath.empty())
+		return Utils::writeScreenshot(job.ScreenshotPath, framebuffer, BudgetGbConfig::DEFAULT_GB_PALETTE);
+
+	return true;
+}
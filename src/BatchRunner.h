@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BudgetGBCore.h"
+#include "utils/workStealingPool.h"
+
+struct BatchJob
+{
+	std::string RomPath;
+	std::string MoviePath;      // played from its starting state when set
+	uint32_t    Frames = 0;     // frames run from power on without the bootrom when there is no movie
+	std::string ScreenshotPath; // ppm of the last frame when set
+};
+
+struct BatchResult
+{
+	bool     Ok              = false;
+	uint32_t Frames          = 0;
+	uint64_t StateHash       = 0; // BudgetGBCore::hashState() after the last frame
+	uint64_t FramebufferHash = 0;
+	double   Seconds         = 0.0; // emulation only, loading and screenshots excluded
+	uint32_t Worker          = 0;
+};
+
+/**
+ * @brief Runs a list of independent emulation jobs on a work stealing pool. Every worker owns one core that is reused
+ * for all the jobs it runs, roms are loaded without save ram so jobs touch no shared files, and each job writes only
+ * its own result. Results depend only on the job, never on the worker or thread count.
+ */
+class BatchRunner
+{
+  public:
+	/**
+	 * @param threadCount Worker threads, 0 uses one per hardware thread.
+	 */
+	explicit BatchRunner(uint32_t threadCount = 0);
+
+	/**
+	 * @brief Read jobs from a text file, one per line: <rom> <frames | movie> [screenshot.ppm]. Paths can not contain
+	 * whitespace, empty lines and lines starting with # are skipped.
+	 * @return True on success, false otherwise.
+	 */
+	static bool loadJobs(const std::string &path, std::vector<BatchJob> &jobs);
+
+	/**
+	 * @brief Run every job and block until all have finished, results are in job order.
+	 */
+	std::vector<BatchResult> run(const std::vector<BatchJob> &jobs);
+
+	uint32_t getThreadCount() const
+	{
+		return m_pool.getThreadCount();
+	}
+
+	// jobs a worker took from another worker's queue during the last run
+	uint64_t getStealCount() const
+	{
+		return m_pool.getStealCount();
+	}
+
+  private:
+	Utils::WorkStealingPool                    m_pool;
+	std::vector<std::unique_ptr<BudgetGBCore>> m_cores; // one per worker, created by the worker that uses it
+
+	static bool runJob(BudgetGBCore &core, const BatchJob &job, BatchResult &result);
+};
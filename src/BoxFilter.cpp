@@ -1,77 +1,242 @@
 #include "BoxFilter.h"
-#include "SDL3/SDL_timer.h"
-#include "audioLogBuffer.h"
 #include "emulatorConstants.h"
 
 #include <cmath>
+#include <cstring>
 
-BoxFilter::BoxFilter(uint32_t sampleRate)
-	: SAMPLE_RATE(sampleRate),
-	  SAMPLES_PER_AVERAGE(static_cast<float>(BudgetGbConstants::CLOCK_RATE_T) / static_cast<float>(SAMPLE_RATE) / 4.0f),
-	  BOX_WIDTH(static_cast<uint32_t>(SAMPLES_PER_AVERAGE))
+namespace
 {
-	const int SIZE = (SAMPLE_RATE / 60) * 8;
-	m_buffer.resize(SIZE);
+constexpr uint32_t CLOCK_RATE_M = BudgetGbConstants::CLOCK_RATE_T / 4; // samples are pushed every m-cycle
+} // namespace
+
+BoxFilter::BoxFilter(uint32_t sampleRate, ResamplerQuality quality)
+{
+	configure(sampleRate, quality);
 }
 
-bool BoxFilter::pushSample(const Samples &samples, AudioLogging::AudioLogBuffers &buffers)
+void BoxFilter::configure(uint32_t sampleRate, ResamplerQuality quality)
 {
-	bool status = false;
+	m_sampleRate = sampleRate;
+	m_quality    = quality;
+
+	if (m_quality == ResamplerQuality::Box)
+	{
+		m_samplesPerAverage = static_cast<float>(CLOCK_RATE_M) / static_cast<float>(m_sampleRate);
+		m_boxWidth          = static_cast<uint32_t>(m_samplesPerAverage);
+		m_resampler.reset();
+	}
+	else
+	{
+		const uint32_t decimation = PolyphaseResampler::getPreDecimation(m_quality);
+
+		m_samplesPerAverage = static_cast<float>(decimation);
+		m_boxWidth          = decimation;
+		m_resampler         = std::make_unique<PolyphaseResampler>(CLOCK_RATE_M / decimation, m_sampleRate, PolyphaseResampler::getDesign(m_quality));
+	}
+
+	updateLaneScales();
 
-	m_runningSum.Pulse1 += samples.Pulse1;
-	m_runningSum.Pulse2 += samples.Pulse2;
-	m_runningSum.Wave += samples.Wave;
-	m_runningSum.Noise += samples.Noise;
+	// the time stretch stage analyses at the output rate, rebuild it if playing faster than real time
+	if (m_timeStretch)
+	{
+		const float speed = m_timeStretch->getSpeed();
+		m_timeStretch     = std::make_unique<TimeStretch>(m_sampleRate);
+		m_timeStretch->setSpeed(speed);
+	}
+
+	const int SIZE = (m_sampleRate / 60) * 8;
+	m_buffer.assign(SIZE, 0.0f);
+	m_stemBuffer.assign(m_stemsEnabled ? m_buffer.size() : 0, Samples{});
+
+	m_channelHighPasses = ChannelHighPasses{
+		HighPass(m_sampleRate),
+		HighPass(m_sampleRate),
+		HighPass(m_sampleRate),
+		HighPass(m_sampleRate),
+		HighPass(m_sampleRate),
+	};
+
+	clear();
+}
+
+void BoxFilter::flushPacked()
+{
+	DacSamples sums;
+	std::memcpy(&sums, &m_packedSum, sizeof(sums));
 
-	uint32_t widthWithError = BOX_WIDTH + static_cast<uint32_t>(m_error);
+	m_packedSum   = 0;
+	m_packedCount = 0;
 
-	if (++m_sampleCountInBox == widthWithError)
+	// polyphase tiers decimate by at most MAX_PACKED_WIDTH, every flush is a complete box
+	if (m_resampler)
+	{
+		resampleBox(sums);
+		return;
+	}
+
+	m_runningSum.Pulse1 += sums.Pulse1;
+	m_runningSum.Pulse2 += sums.Pulse2;
+	m_runningSum.Wave += sums.Wave;
+	m_runningSum.Noise += sums.Noise;
+
+	m_sampleCountInBox += m_packedWidth;
+
+	if (m_sampleCountInBox == m_boxWidth)
+		flushBox();
+
+	m_packedWidth = std::min(m_boxWidth - m_sampleCountInBox, MAX_PACKED_WIDTH);
+}
+
+void BoxFilter::flushBox()
+{
+	// (average - 7.5) / 7.5 maps dac output 0x0 - 0xF into -1.0f - 1.0f
+	const float scale = 1.0f / (static_cast<float>(m_sampleCountInBox) * 7.5f);
+
+	Samples averages{
+		(m_runningSum.Pulse1 * scale - 1.0f) * m_channelGains.Pulse1,
+		(m_runningSum.Pulse2 * scale - 1.0f) * m_channelGains.Pulse2,
+		(m_runningSum.Wave * scale - 1.0f) * m_channelGains.Wave,
+		(m_runningSum.Noise * scale - 1.0f) * m_channelGains.Noise,
+	};
+
+	m_runningSum       = RunningChannelSums{};
+	m_sampleCountInBox = 0;
+
+	m_error -= static_cast<uint32_t>(m_error);
+	m_error += std::fabs(m_samplesPerAverage - static_cast<uint32_t>(m_samplesPerAverage));
+	m_boxWidth = static_cast<uint32_t>(m_samplesPerAverage) + static_cast<uint32_t>(m_error);
+
+	pushOutput(averages.Pulse1 + averages.Pulse2 + averages.Wave + averages.Noise, averages);
+}
+
+void BoxFilter::resampleBox(const DacSamples &sums)
+{
+	// mix is resampled on its own unless individual channels are consumed, resampling is linear so both agree
+	if (!m_audioLogBuffers && !m_stemsEnabled)
 	{
-		m_samplesAvail     = std::min(m_samplesAvail + 1, (uint32_t)m_buffer.size());
-		m_sampleCountInBox = 0;
+		const float mix = sums.Pulse1 * m_laneScales.Pulse1 + sums.Pulse2 * m_laneScales.Pulse2 + sums.Wave * m_laneScales.Wave + sums.Noise * m_laneScales.Noise - m_mixOffset;
 
-		float pulse1Average = static_cast<float>(m_runningSum.Pulse1) / widthWithError;
-		float pulse2Average = static_cast<float>(m_runningSum.Pulse2) / widthWithError;
-		float waveAverage   = static_cast<float>(m_runningSum.Wave) / widthWithError;
-		float noiseAverage  = static_cast<float>(m_runningSum.Noise) / widthWithError;
+		float out;
+		if (m_resampler->push(&mix, &out, 1))
+			pushOutput(out, Samples{});
 
-		m_buffer[m_head] = m_channelHighPasses.All(pulse1Average + pulse2Average + waveAverage + noiseAverage);
+		return;
+	}
+
+	Samples averages{
+		sums.Pulse1 * m_laneScales.Pulse1 - m_channelGains.Pulse1,
+		sums.Pulse2 * m_laneScales.Pulse2 - m_channelGains.Pulse2,
+		sums.Wave * m_laneScales.Wave - m_channelGains.Wave,
+		sums.Noise * m_laneScales.Noise - m_channelGains.Noise,
+	};
+
+	const std::array<float, PolyphaseResampler::MAX_LANES> in{averages.Pulse1 + averages.Pulse2 + averages.Wave + averages.Noise, averages.Pulse1, averages.Pulse2, averages.Wave, averages.Noise};
+	std::array<float, PolyphaseResampler::MAX_LANES>       out;
+
+	if (m_resampler->push(in.data(), out.data(), PolyphaseResampler::MAX_LANES))
+		pushOutput(out[0], Samples{out[1], out[2], out[3], out[4]});
+}
 
-		buffers.All.AddPoint(m_buffer[m_head]);
-		buffers.Pulse1.AddPoint(m_channelHighPasses.Pulse1(pulse1Average));
-		buffers.Pulse2.AddPoint(m_channelHighPasses.Pulse2(pulse2Average));
-		buffers.Wave.AddPoint(m_channelHighPasses.Wave(waveAverage));
-		buffers.Noise.AddPoint(m_channelHighPasses.Noise(noiseAverage));
+void BoxFilter::updateLaneScales()
+{
+	// (sum / width - 7.5) / 7.5 * gain maps dac output 0x0 - 0xF into -gain - gain with one multiply and subtract
+	const float scale = 1.0f / (static_cast<float>(m_boxWidth) * 7.5f);
+
+	m_laneScales = Samples{
+		scale * m_channelGains.Pulse1,
+		scale * m_channelGains.Pulse2,
+		scale * m_channelGains.Wave,
+		scale * m_channelGains.Noise,
+	};
+
+	m_mixOffset = m_channelGains.Pulse1 + m_channelGains.Pulse2 + m_channelGains.Wave + m_channelGains.Noise;
+}
 
-		m_runningSum = RunningChannelSums{};
+void BoxFilter::setPlaybackSpeed(float speed)
+{
+	if (speed <= 1.0f)
+	{
+		m_timeStretch.reset();
+		return;
+	}
+
+	if (!m_timeStretch)
+		m_timeStretch = std::make_unique<TimeStretch>(m_sampleRate);
+
+	m_timeStretch->setSpeed(speed);
+}
+
+void BoxFilter::pushOutput(float mix, const Samples &channels)
+{
+	const float highPassedMix = m_channelHighPasses.All(mix);
+	Samples     highPassed{};
 
-		m_head = (m_head + 1) % m_buffer.size();
-		if (m_head == m_tail)
+	if (m_audioLogBuffers || m_stemsEnabled)
+	{
+		highPassed = Samples{
+			m_channelHighPasses.Pulse1(channels.Pulse1),
+			m_channelHighPasses.Pulse2(channels.Pulse2),
+			m_channelHighPasses.Wave(channels.Wave),
+			m_channelHighPasses.Noise(channels.Noise),
+		};
+
+		if (m_audioLogBuffers)
 		{
-			m_tail = (m_tail + 1) % m_buffer.size();
+			m_audioLogBuffers->All.AddPoint(highPassedMix);
+			m_audioLogBuffers->Pulse1.AddPoint(highPassed.Pulse1);
+			m_audioLogBuffers->Pulse2.AddPoint(highPassed.Pulse2);
+			m_audioLogBuffers->Wave.AddPoint(highPassed.Wave);
+			m_audioLogBuffers->Noise.AddPoint(highPassed.Noise);
 		}
+	}
 
-		m_error -= static_cast<uint32_t>(m_error);
-		m_error += std::fabs(SAMPLES_PER_AVERAGE - BOX_WIDTH);
-
-		status = true;
+	if (!m_timeStretch)
+	{
+		writeOutput(highPassedMix, highPassed);
+		return;
 	}
 
-	return status;
+	m_timeStretch->push(&highPassedMix, 1);
+
+	float stretched;
+	while (m_timeStretch->read(&stretched, 1))
+		writeOutput(stretched, Samples{});
+}
+
+void BoxFilter::writeOutput(float mix, const Samples &stems)
+{
+	m_samplesAvail = std::min(m_samplesAvail + 1, (uint32_t)m_buffer.size());
+
+	m_buffer[m_head] = mix;
+
+	if (m_stemsEnabled)
+		m_stemBuffer[m_head] = stems;
+
+	if (++m_head == m_buffer.size())
+		m_head = 0;
+
+	if (m_head == m_tail && ++m_tail == m_buffer.size())
+		m_tail = 0;
 }
 
-uint32_t BoxFilter::readSamples(float *buffer, uint32_t size)
+uint32_t BoxFilter::readSamples(float *buffer, Samples *stems, uint32_t size)
 {
-	uint32_t        count         = 0;
-	constexpr float MASTER_VOLUME = 0.05f;
+	uint32_t count = 0;
 
 	while (count < size && m_samplesAvail > 0)
 	{
 		--m_samplesAvail;
+
+		if (stems && m_stemsEnabled)
+		{
+			const Samples &stem = m_stemBuffer[m_tail];
+			stems[count]        = Samples{stem.Pulse1 * MASTER_VOLUME, stem.Pulse2 * MASTER_VOLUME, stem.Wave * MASTER_VOLUME, stem.Noise * MASTER_VOLUME};
+		}
+
 		buffer[count++] = m_buffer[m_tail] * MASTER_VOLUME;
 
-		if (m_tail != m_head)
-			m_tail = (m_tail + 1) % m_buffer.size();
+		if (m_tail != m_head && ++m_tail == m_buffer.size())
+			m_tail = 0;
 	}
 
 	return count;
@@ -1,14 +1,25 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <vector>
 
+#include "PolyphaseResampler.h"
+#include "TimeStretch.h"
 #include "audioLogBuffer.h"
 
+/**
+ * @brief Turns the per m-cycle dac output of the apu into output rate samples. Dac values are box averaged, straight
+ * to the output rate for ResamplerQuality::Box or by a small integer factor in front of a polyphase windowed-sinc stage
+ * for the other tiers.
+ */
 class BoxFilter
 {
   public:
-	BoxFilter(uint32_t sampleRate);
+	BoxFilter(uint32_t sampleRate, ResamplerQuality quality = ResamplerQuality::Medium);
 
 	struct Samples
 	{
@@ -18,10 +29,91 @@ class BoxFilter
 		float Noise;
 	};
 
-	bool pushSample(const Samples &samples, AudioLogging::AudioLogBuffers &buffers);
+	// raw channel dac outputs in the range 0x0 - 0xF
+	struct DacSamples
+	{
+		uint8_t Pulse1;
+		uint8_t Pulse2;
+		uint8_t Wave;
+		uint8_t Noise;
+	};
+
+	/**
+	 * @brief Rebuild the filter for a new output rate or quality, buffered output is dropped. Subscribed buffers and
+	 * stems carry over.
+	 */
+	void configure(uint32_t sampleRate, ResamplerQuality quality);
+
+	// accumulate one m-cycle of dac output, all 4 channels are summed with a single add of their packed bytes
+	void pushSample(const DacSamples &samples)
+	{
+		uint32_t packed;
+		std::memcpy(&packed, &samples, sizeof(packed));
+
+		m_packedSum += packed;
+
+		if (++m_packedCount == m_packedWidth)
+			flushPacked();
+	}
+
+	/**
+	 * @brief Compress output by speed without changing its pitch, for running emulation faster than real time. A speed
+	 * of 1 bypasses the time stretch stage entirely. Stems are not written while stretching.
+	 */
+	void setPlaybackSpeed(float speed);
+
+	float getPlaybackSpeed() const
+	{
+		return m_timeStretch ? m_timeStretch->getSpeed() : 1.0f;
+	}
+
+	/**
+	 * @brief Per channel gain applied when boxes are converted to float, used for muting channels.
+	 */
+	void setChannelGains(const Samples &gains)
+	{
+		m_channelGains = gains;
+		updateLaneScales();
+	}
 
 	// samples are read into buffer and clamped into a 32 bit float sample in the range (-1.0f - 1.0f)
-	uint32_t readSamples(float *buffer, uint32_t size);
+	uint32_t readSamples(float *buffer, uint32_t size)
+	{
+		return readSamples(buffer, nullptr, size);
+	}
+
+	/**
+	 * @brief Same as readSamples() but also reads out the high passed samples of each individual channel.
+	 * @param buffer Mixed output samples.
+	 * @param stems Per channel samples, can be nullptr. Only filled when stems are enabled.
+	 * @param size Max number of samples to read.
+	 * @return Number of samples read.
+	 */
+	uint32_t readSamples(float *buffer, Samples *stems, uint32_t size);
+
+	/**
+	 * @brief Subscribe buffers to visualization capture of every output sample, nullptr unsubscribes. Per channel
+	 * filtering is skipped entirely while nothing is subscribed and stems are disabled.
+	 */
+	void setAudioLogBuffers(AudioLogging::AudioLogBuffers *buffers)
+	{
+		if (buffers && !m_audioLogBuffers)
+			resetChannelHighPasses();
+
+		m_audioLogBuffers = buffers;
+	}
+
+	/**
+	 * @brief Keep per channel samples alongside the mixed output so they can be written out as separate stems.
+	 */
+	void enableStems(bool enable)
+	{
+		if (enable && !m_stemsEnabled)
+			resetChannelHighPasses();
+
+		m_stemsEnabled = enable;
+		m_stemBuffer.assign(enable ? m_buffer.size() : 0, Samples{});
+	}
 
 	uint32_t getSamplesAvail() const
 	{
@@ -30,33 +122,74 @@ class BoxFilter
 
 	uint32_t getAudioFrameSize() const
 	{
-		return SAMPLE_RATE / 60;
+		return m_sampleRate / 60;
+	}
+
+	uint32_t getSampleRate() const
+	{
+		return m_sampleRate;
+	}
+
+	ResamplerQuality getQuality() const
+	{
+		return m_quality;
 	}
 
 	void clear()
 	{
 		std::fill(m_buffer.begin(), m_buffer.end(), (float)0);
+		std::fill(m_stemBuffer.begin(), m_stemBuffer.end(), Samples{});
+		if (m_timeStretch)
+			m_timeStretch->reset();
+
+		m_packedSum        = 0;
+		m_packedCount      = 0;
 		m_runningSum       = RunningChannelSums{};
 		m_sampleCountInBox = 0;
+		m_boxWidth         = static_cast<uint32_t>(m_samplesPerAverage);
+		m_packedWidth      = std::min(m_boxWidth, MAX_PACKED_WIDTH);
 		m_error            = 0;
 		m_head             = 0,
 		m_tail             = 0,
 		m_samplesAvail     = 0;
 	}
 
+	static constexpr float MASTER_VOLUME = 0.05f;
+
   private:
-	const int      SAMPLE_RATE;
-	const float    SAMPLES_PER_AVERAGE;
-	const uint32_t BOX_WIDTH;
+	uint32_t         m_sampleRate = 0;
+	ResamplerQuality m_quality    = ResamplerQuality::Medium;
+
+	// box tier averages a fractional number of m-cycles per output sample, the fraction is carried in m_error
+	float    m_samplesPerAverage = 0;
+	uint32_t m_boxWidth          = 1;
+
+	std::unique_ptr<PolyphaseResampler> m_resampler;   // null for the box tier
+	std::unique_ptr<TimeStretch>        m_timeStretch; // null while playing at normal speed
+
+	std::vector<float>   m_buffer;
+	std::vector<Samples> m_stemBuffer; // empty unless stems are enabled
+	bool                 m_stemsEnabled = false;
 
-	std::vector<float> m_buffer;
+	AudioLogging::AudioLogBuffers *m_audioLogBuffers = nullptr; // visualization subscriber
+
+	Samples m_channelGains{1.0f, 1.0f, 1.0f, 1.0f};
+	Samples m_laneScales{};     // channel gain over the polyphase tier box width and dac range
+	float   m_mixOffset = 4.0f; // sum of channel gains, the dac midpoint removed from the mix
+
+	// byte lanes of the packed sum overflow past 17 samples of 0xF, so wider boxes are flushed in parts into m_runningSum
+	static constexpr uint32_t MAX_PACKED_WIDTH = 16;
+
+	uint32_t m_packedSum   = 0;
+	uint32_t m_packedCount = 0;
+	uint32_t m_packedWidth = 1;
 
 	struct RunningChannelSums
 	{
-		float Pulse1 = 0;
-		float Pulse2 = 0;
-		float Wave   = 0;
-		float Noise  = 0;
+		uint32_t Pulse1 = 0;
+		uint32_t Pulse2 = 0;
+		uint32_t Wave   = 0;
+		uint32_t Noise  = 0;
 	} m_runningSum;
 
 	uint32_t m_sampleCountInBox = 0;
@@ -67,12 +200,20 @@ class BoxFilter
 	class HighPass
 	{
 	  private:
-		static constexpr float adjust = 0.996f;
+		float adjust = 0.996f;
 
 		float prev = 0.0f;
 		float out  = 0.0f;
 
 	  public:
+		HighPass() = default;
+
+		// 0.996 is tuned for 48khz, keep the same corner frequency at other rates
+		HighPass(uint32_t sampleRate)
+			: adjust(static_cast<float>(std::pow(0.996, 48000.0 / sampleRate)))
+		{
+		}
+
 		float operator()(float in)
 		{
 			float delta = in - prev;
@@ -91,4 +232,20 @@ class BoxFilter
 		HighPass Noise;
 		HighPass All;
 	} m_channelHighPasses;
+
+	// per channel filters only run while someone consumes their output, reset them when starting up again
+	void resetChannelHighPasses()
+	{
+		m_channelHighPasses.Pulse1 = HighPass(m_sampleRate);
+		m_channelHighPasses.Pulse2 = HighPass(m_sampleRate);
+		m_channelHighPasses.Wave   = HighPass(m_sampleRate);
+		m_channelHighPasses.Noise  = HighPass(m_sampleRate);
+	}
+
+	void flushPacked();
+	void flushBox();
+	void resampleBox(const DacSamples &sums);
+	void updateLaneScales();
+	void pushOutput(float mix, const Samples &channels);
+	void writeOutput(float mix, const Samples &stems);
 };
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <stdexcept>
 #include <string>
 
@@ -9,9 +12,11 @@
 #include "misc/cpp/imgui_stdlib.h"
 
 #include "BudgetGB.h"
+#include "TimeStretch.h"
 
 constexpr static SDL_DialogFileFilter romFileFilter[] = {
 	{"*.gb", "gb;gb"},
+	{"*.gbs", "gbs;gbs"},
 };
 
 constexpr static SDL_DialogFileFilter bootromFileFilter[] = {
@@ -20,42 +25,49 @@ constexpr static SDL_DialogFileFilter bootromFileFilter[] = {
 
 static void SDLCALL loadRomDialogCallback(void *userdata, const char *const *filelist, int filter);
 static void SDLCALL loadBootromDialogCallback(void *userdata, const char *const *filelist, int filter);
+static void processJoypadKey(const SDL_Event *event, Joypad &joypad);
+static bool parseAddressRange(const std::string &text, uint16_t &start, uint16_t &end);
 
 BudgetGB::BudgetGB(const std::string &cartridgePath)
 	: m_renderContext(RendererGB::initWindowWithRenderer(m_window, static_cast<uint32_t>(m_config.windowScale))),
-	  m_cartridge(),
-	  m_bus(m_cartridge, m_cpu, m_ppu, m_apu),
-	  m_cpu(m_bus),
-	  m_ppu(m_cpu.m_interrupts.m_interruptFlags),
-	  m_apu(BudgetGbConstants::AUDIO_SAMPLE_RATE),
-	  m_disassembler(m_bus)
+	  m_core(m_config.audioSampleRate, m_config.audioQuality),
+	  m_disassembler(m_core.m_bus),
+	  m_debugger(m_core)
 {
 	if (!m_renderContext)
 	{
 		throw std::runtime_error("Failed to initialize window with renderer!");
 	}
 
+	m_audioDevice.open(m_core.m_apu);
+
 	m_guiContext.guiPalettes_activePalette = m_guiContext.guiPalettes_selectedPalette = m_config.activePalette;
 
-	if (cartridgePath != "")
+	const bool isGbs = std::filesystem::path(cartridgePath).extension() == ".gbs";
+
+	if (cartridgePath != "" && !isGbs)
 	{
-		if (m_cartridge.loadCartridgeFromPath(cartridgePath, m_config.recentRoms))
+		if (m_core.loadCartridge(cartridgePath, m_config.recentRoms))
 		{
-			m_apu.resumeAudio();
-			m_disassembler.setProgramCounter(m_cpu.m_programCounter);
+			m_audioDevice.resume();
+			m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
 			m_disassembler.step();
 		}
 	}
 
 	if (m_config.useBootrom)
 	{
-		if (!m_cpu.m_bootrom.loadFromFile(m_config.bootromPath))
+		if (!m_core.m_cpu.m_bootrom.loadFromFile(m_config.bootromPath))
 			m_guiContext.flags |= GuiContextFlags_SHOW_BOOTROM_ERROR;
 	}
 
-	m_cpu.init(m_config.useBootrom && m_cpu.m_bootrom.isLoaded());
-	m_bus.init(m_config.useBootrom && m_cpu.m_bootrom.isLoaded());
-	m_apu.init(m_config.useBootrom && m_cpu.m_bootrom.isLoaded());
+	m_core.reset(m_config.useBootrom && m_core.m_cpu.m_bootrom.isLoaded());
+
+	// gbs playback starts with its init routine rather than a reset
+	if (isGbs)
+		loadCartridge(cartridgePath);
+	else if (m_core.m_cartridge.isLoaded())
+		loadResumeState();
 
 	m_lcdDisplayQuad = RendererGB::texturedQuadCreate(m_renderContext, Utils::Vec2<float>{BudgetGbConstants::LCD_WIDTH, BudgetGbConstants::LCD_HEIGHT});
 
@@ -65,34 +77,45 @@ BudgetGB::BudgetGB(const std::string &cartridgePath)
 
 	m_screenRenderTarget = RendererGB::textureRenderTargetCreate(m_renderContext, Utils::Vec2<float>{(float)width, (float)height});
 	m_screenQuad         = RendererGB::screenQuadCreate(m_renderContext);
+
+	publishFrame();
+
+	constexpr std::chrono::duration<double> TIME_STEP(1.0 / 60.0);
+	m_emulation.start(std::chrono::duration_cast<EmulationThread::Clock::duration>(TIME_STEP), [this](float elapsedSeconds) { emulationStep(elapsedSeconds); });
 }
 
 BudgetGB::~BudgetGB()
 {
+	m_emulation.stop();
+
+	saveResumeState();
+	stopMovie();
 	m_config.activePalette = m_guiContext.guiPalettes_activePalette;
 	RendererGB::freeWindowWithRenderer(m_window, m_renderContext);
 }
 
 void BudgetGB::onUpdate()
 {
-	if (!(m_guiContext.flags & GuiContextFlags_PAUSE) && m_cartridge.isLoaded())
 	{
-		m_accumulatedDeltaTime += ImGui::GetIO().DeltaTime;
-		constexpr float TIME_STEP = 1.0f / 60.0f;
-
-		while (m_accumulatedDeltaTime > TIME_STEP)
-		{
-			m_bus.onUpdate();
-			m_accumulatedDeltaTime -= TIME_STEP;
-		}
+		// the gui is built between emulation steps, debugger views see the state of a whole number of steps
+		auto lock = m_emulation.lock();
+		guiMain();
+		captureGuiViews();
+
+		// nothing runs while paused but the gui can still step or load states
+		if (m_guiContext.flags & GuiContextFlags_PAUSE)
+			publishFrame();
 	}
 
-	guiMain();
+	guiViews();
+
+	m_frames.update();
+	const BudgetGbConstants::LcdColorBuffer &frame = m_frames.getReadBuffer();
 
 	RendererGB::setGlobalPalette(m_renderContext, m_guiContext.guiPalettes_activePalette < 0 ? m_config.defaultPalette : m_config.palettes[m_guiContext.guiPalettes_activePalette]);
 
 	RendererGB::textureRenderTargetSet(m_renderContext, m_screenRenderTarget.get(), Utils::Vec2<float>{(float)m_mainViewportSize.x, (float)m_mainViewportSize.y});
-	RendererGB::texturedQuadUpdateTexture(m_renderContext, m_lcdDisplayQuad.get(), m_ppu.getColorBuffer().data(), m_ppu.getColorBuffer().size());
+	RendererGB::texturedQuadUpdateTexture(m_renderContext, m_lcdDisplayQuad.get(), frame.data(), frame.size());
 	RendererGB::texturedQuadDraw(m_renderContext, m_lcdDisplayQuad.get());
 
 	ImTextureID textureID = RendererGB::textureRenderTargetGetTextureID(m_screenRenderTarget.get());
@@ -104,14 +127,117 @@ void BudgetGB::onUpdate()
 	RendererGB::newFrame(); // begin new frame at end of this game loop
 }
 
+void BudgetGB::emulationStep(float elapsedSeconds)
+{
+	if (m_sharedMemory)
+		applySharedMemoryCommands();
+
+	if (m_gdbServer)
+		m_gdbServer->poll();
+
+	if (m_guiContext.flags & GuiContextFlags_PAUSE || !m_core.m_cartridge.isLoaded())
+		return;
+
+	const bool fastForward = m_guiContext.flags & GuiContextFlags_FAST_FORWARD;
+	const bool unlimited   = fastForward && m_config.fastForwardSpeed == 0 && !m_gbsPlayer && !(m_guiContext.flags & GuiContextFlags_REWIND);
+	uint32_t   framesRun   = 0;
+
+	// unlimited speed runs steps back to back instead of one per time step
+	m_emulation.setPaced(!unlimited);
+
+	// present a frame emulated ahead with the current inputs, frames run ahead would hit breakpoints and watchpoints
+	// and cannot meet the other side of a link cable
+	bool runAhead = !fastForward && !m_gbsPlayer && !(m_guiContext.flags & GuiContextFlags_REWIND) && m_config.runAheadFrames > 0 && !m_debugger.isHooked() && !m_serialLink;
+
+#ifdef BUDGETGB_PROFILER
+	// and would be counted by the profiler twice
+	runAhead = runAhead && !m_profiler;
+#endif
+
+	// the frame run ahead replaces the real one on screen, only shared memory consumers see real frames
+	m_core.m_ppu.setOutputEnabled(!runAhead || m_sharedMemory);
+
+	if (m_gbsPlayer)
+		m_gbsPlayer->onUpdate();
+	else if (m_guiContext.flags & GuiContextFlags_REWIND)
+		m_rewindBuffer.stepBack(m_core);
+	else if (m_netplay)
+	{
+		if (m_netplay->beginFrame(m_netplayInput.getButtons()) && m_core.m_bus.onUpdate())
+		{
+			m_netplay->endFrame();
+			++framesRun;
+
+			if (m_sharedMemory)
+				m_sharedMemory->publishFrame(m_core, false);
+		}
+	}
+	else if (unlimited)
+		framesRun += runUnlimitedFrames();
+	else
+	{
+		const uint32_t framesPerStep = fastForward ? m_config.fastForwardSpeed : 1;
+		for (uint32_t i = 0; i < framesPerStep && !m_debugger.isStopped(); ++i)
+			framesRun += emulateFrame(true);
+	}
+
+	// a stop from the cpu viewer's breakpoints pauses the gui at the instruction it stopped on, an attached debugger
+	// handles its stops itself
+	const bool debuggerAttached = m_gdbServer && m_gdbServer->isAttached();
+	if (m_debugger.isStopped() && !debuggerAttached)
+	{
+		const Debugger::Stop &stop = m_debugger.getStop();
+
+		if (stop.Reason == Debugger::StopReason::Watchpoint)
+			m_guiContext.guiCpuViewer_stopMessage = fmt::format("{} of {:02X} at {:04X}, stopped at {:04X}", stop.Write ? "Write" : "Read", stop.Value, stop.Address, m_core.m_cpu.m_programCounter);
+		else
+			m_guiContext.guiCpuViewer_stopMessage = fmt::format("Breakpoint at {:04X}", stop.Address);
+
+		m_debugger.resume();
+		m_guiContext.flags |= GuiContextFlags_PAUSE | GuiContextFlags_SHOW_CPU_VIEWER;
+		m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+		m_disassembler.step();
+	}
+
+	m_core.m_ppu.setOutputEnabled(true);
+
+	if (runAhead && framesRun > 0)
+		m_core.runAhead(m_config.runAheadFrames);
+
+	updateEffectiveSpeed(framesRun, elapsedSeconds);
+	publishFrame();
+}
+
+void BudgetGB::applyKeyboardInput(uint8_t buttons)
+{
+	// netplay and movie playback own the joypad
+	if (m_netplay)
+		m_netplayInput.setButtons(buttons);
+	else if (m_movie.getMode() != Movie::Mode::Playing)
+		m_core.m_cpu.m_joypad.setButtons(buttons);
+}
+
+void BudgetGB::publishFrame()
+{
+	m_frames.getWriteBuffer() = m_core.m_ppu.getColorBuffer();
+	m_frames.publish();
+}
+
 SDL_AppResult BudgetGB::processEvent(SDL_Event *event)
 {
 	ImGui_ImplSDL3_ProcessEvent(event);
 
+	// keyboard input reaches the emulation thread through its command queue, no lock is needed to press a button
+	const uint8_t previousButtons = m_keyboardInput.getButtons();
 	if (!m_guiContext.blockJoypadInputs)
-		m_cpu.m_joypad.processEvent(event);
+		processJoypadKey(event, m_keyboardInput);
 	else
-		m_cpu.m_joypad.clear();
+		m_keyboardInput.clear();
+
+	if (const uint8_t buttons = m_keyboardInput.getButtons(); buttons != previousButtons)
+		m_emulation.post([this, buttons]() { applyKeyboardInput(buttons); });
+
+	auto lock = m_emulation.lock();
 
 	if (event->type == SDL_EVENT_QUIT)
 		return SDL_APP_SUCCESS;
@@ -134,29 +260,57 @@ SDL_AppResult BudgetGB::processEvent(SDL_Event *event)
 		if (event->button.button == 3) // right mouse button brings up main menu
 			m_guiContext.flags |= GuiContextFlags_SHOW_MAIN_MENU;
 
+	// fast forward for as long as the key is held
+	if ((event->type == SDL_EVENT_KEY_DOWN || event->type == SDL_EVENT_KEY_UP) && event->key.scancode == SDL_SCANCODE_TAB && !event->key.repeat)
+	{
+		if (event->type == SDL_EVENT_KEY_DOWN && isSaveStateAvailable() && !ImGui::GetIO().WantTextInput)
+			setFastForward(true);
+		else if (event->type == SDL_EVENT_KEY_UP)
+			setFastForward(false);
+	}
+
+	// rewind for as long as the key is held
+	if ((event->type == SDL_EVENT_KEY_DOWN || event->type == SDL_EVENT_KEY_UP) && event->key.scancode == SDL_SCANCODE_BACKSPACE && !event->key.repeat)
+	{
+		if (event->type == SDL_EVENT_KEY_DOWN && isSaveStateAvailable() && m_movie.getMode() == Movie::Mode::Idle && !ImGui::GetIO().WantTextInput)
+			setRewinding(true);
+		else if (event->type == SDL_EVENT_KEY_UP)
+			setRewinding(false);
+	}
+
 	if (event->type == SDL_EVENT_KEY_UP)
 	{
 		switch (event->key.scancode)
 		{
 
+		case SDL_SCANCODE_F1:
+			if (isSaveStateAvailable())
+				saveStateSlot();
+			break;
+
+		case SDL_SCANCODE_F2:
+			if (isSaveStateAvailable())
+				loadStateSlot();
+			break;
+
 		case SDL_SCANCODE_F5:
 			m_audioChannelToggle.Pulse1 ^= 1;
-			m_apu.setAudioChannelToggle(m_audioChannelToggle);
+			m_core.m_apu.setAudioChannelToggle(m_audioChannelToggle);
 			break;
 
 		case SDL_SCANCODE_F6:
 			m_audioChannelToggle.Pulse2 ^= 1;
-			m_apu.setAudioChannelToggle(m_audioChannelToggle);
+			m_core.m_apu.setAudioChannelToggle(m_audioChannelToggle);
 			break;
 
 		case SDL_SCANCODE_F7:
 			m_audioChannelToggle.Wave ^= 1;
-			m_apu.setAudioChannelToggle(m_audioChannelToggle);
+			m_core.m_apu.setAudioChannelToggle(m_audioChannelToggle);
 			break;
 
 		case SDL_SCANCODE_F8:
 			m_audioChannelToggle.Noise ^= 1;
-			m_apu.setAudioChannelToggle(m_audioChannelToggle);
+			m_core.m_apu.setAudioChannelToggle(m_audioChannelToggle);
 			break;
 
 		case SDL_SCANCODE_F11:
@@ -175,9 +329,9 @@ SDL_AppResult BudgetGB::processEvent(SDL_Event *event)
 			if (!ImGui::GetIO().WantTextInput)
 			{
 				m_guiContext.flags ^= GuiContextFlags_PAUSE;
-				if (m_guiContext.flags & GuiContextFlags_PAUSE && m_cartridge.isLoaded())
+				if (m_guiContext.flags & GuiContextFlags_PAUSE && m_core.m_cartridge.isLoaded())
 				{
-					m_disassembler.setProgramCounter(m_cpu.m_programCounter);
+					m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
 					m_disassembler.step();
 				}
 			}
@@ -185,7 +339,7 @@ SDL_AppResult BudgetGB::processEvent(SDL_Event *event)
 			break;
 
 		case SDL_SCANCODE_KP_MULTIPLY:
-			if (m_cartridge.isLoaded())
+			if (m_core.m_cartridge.isLoaded())
 				resetBudgetGB();
 			break;
 
@@ -197,18 +351,406 @@ SDL_AppResult BudgetGB::processEvent(SDL_Event *event)
 	return SDL_APP_CONTINUE;
 }
 
+void BudgetGB::requestCartridge(const std::string &cartridgePath)
+{
+	m_emulation.post([this, cartridgePath]() { loadCartridge(cartridgePath); });
+}
+
 bool BudgetGB::loadCartridge(const std::string &cartridgePath)
 {
-	if (m_cartridge.loadCartridgeFromPath(cartridgePath, m_config.recentRoms))
+	// both written next to the rom they belong to
+	saveResumeState();
+	stopMovie();
+	m_netplay.reset();
+
+	if (std::filesystem::path(cartridgePath).extension() == ".gbs")
 	{
+		auto gbsPlayer = std::make_unique<GbsPlayer>(m_core);
+
+		if (gbsPlayer->load(cartridgePath, m_config.recentRoms))
+		{
+			m_gbsPlayer = std::move(gbsPlayer);
+			playGbsTrack(m_gbsPlayer->getCurrentTrack());
+			return true;
+		}
+		else
+		{
+			m_audioDevice.pause();
+			return false;
+		}
+	}
+
+	m_gbsPlayer.reset();
+
+	if (m_core.loadCartridge(cartridgePath, m_config.recentRoms))
+	{
+#ifdef BUDGETGB_PROFILER
+		resetProfiler();
+#endif
 		resetBudgetGB();
+		loadResumeState();
 		return true;
 	}
 	else
 	{
-		m_apu.pauseAudio();
+		m_audioDevice.pause();
+		return false;
+	}
+}
+
+bool BudgetGB::startNetplay(uint16_t localPort, const std::string &peerAddress, uint16_t peerPort, uint32_t inputDelay)
+{
+	auto lock = m_emulation.lock();
+
+	if (!m_core.m_cartridge.isLoaded() || m_gbsPlayer)
+	{
+		fmt::println(stderr, "Netplay needs a rom to be loaded!");
+		return false;
+	}
+
+	stopMovie();
+	setRewinding(false);
+	setFastForward(false);
+
+	// the bootrom is left out so both peers start from the same state whatever bootrom they have
+	m_core.reset(false);
+	m_rewindBuffer.clear();
+	m_netplayInput.clear();
+
+	m_netplay = std::make_unique<RollbackSession>(m_core, inputDelay);
+	if (!m_netplay->connect(localPort, peerAddress, peerPort))
+	{
+		m_netplay.reset();
+		return false;
+	}
+
+	fmt::println("Netplay on port {} with {}:{}, input delay {}", localPort, peerAddress, peerPort, inputDelay);
+	return true;
+}
+
+bool BudgetGB::startSharedMemory(const std::string &name, const std::vector<uint16_t> &ramAddresses)
+{
+	auto lock = m_emulation.lock();
+
+	auto publisher = std::make_unique<SharedMemoryPublisher>();
+	if (!publisher->create(name, ramAddresses))
+		return false;
+
+	m_sharedMemory = std::move(publisher);
+	m_audioDevice.setPublisher(m_sharedMemory.get());
+
+	// consumers see the current frame right away, not only once the emulator runs
+	m_sharedMemory->publishFrame(m_core, m_guiContext.flags & GuiContextFlags_PAUSE);
+
+	fmt::println("Publishing to shared memory {} with {} memory bytes", name, ramAddresses.size());
+	return true;
+}
+
+bool BudgetGB::startLink(uint16_t localPort, const std::string &peerAddress, uint16_t peerPort)
+{
+	auto lock = m_emulation.lock();
+
+	auto link = std::make_unique<UdpSerialLink>();
+	if (!link->connect(localPort, peerAddress, peerPort))
+		return false;
+
+	m_serialLink = std::move(link);
+	m_core.m_cpu.m_serial.setLink(m_serialLink.get());
+
+	fmt::println("Link cable on port {} with {}:{}", localPort, peerAddress, peerPort);
+	return true;
+}
+
+bool BudgetGB::startGdbServer(uint16_t port)
+{
+	auto lock = m_emulation.lock();
+
+	auto server = std::make_unique<GdbServer>(m_core, m_debugger);
+	if (!server->listen(port))
+		return false;
+
+	m_gdbServer = std::move(server);
+
+	fmt::println("Waiting for a debugger on 127.0.0.1:{}", port);
+	return true;
+}
+
+void BudgetGB::applySharedMemoryCommands()
+{
+	using SharedMemoryLayout::CommandType;
+
+	SharedMemoryLayout::Command command;
+	while (m_sharedMemory->popCommand(command))
+	{
+		switch (command.Type)
+		{
+		case CommandType::SetInput:
+			// netplay drives the core joypad itself, input goes in as the local player's
+			(m_netplay ? m_netplayInput : m_core.m_cpu.m_joypad).setButtons(static_cast<uint8_t>(command.Argument));
+			break;
+
+		// a paused emulator publishes no frames, the pause flag is published on its own
+		case CommandType::Pause:
+			if (!(m_guiContext.flags & GuiContextFlags_PAUSE) && m_core.m_cartridge.isLoaded())
+			{
+				m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+				m_disassembler.step();
+			}
+
+			m_guiContext.flags |= GuiContextFlags_PAUSE;
+			m_sharedMemory->publishFrame(m_core, true);
+			break;
+
+		case CommandType::Resume:
+			m_guiContext.flags &= ~GuiContextFlags_PAUSE;
+			m_sharedMemory->publishFrame(m_core, false);
+			break;
+
+		case CommandType::SaveState:
+			if (isSaveStateAvailable())
+				saveStateSlot();
+			break;
+
+		case CommandType::LoadState:
+			if (isSaveStateAvailable())
+			{
+				loadStateSlot();
+				m_sharedMemory->publishFrame(m_core, m_guiContext.flags & GuiContextFlags_PAUSE);
+			}
+			break;
+
+		default:
+			fmt::println(stderr, "Unknown shared memory command: {}", static_cast<uint32_t>(command.Type));
+			break;
+		}
+	}
+}
+
+void BudgetGB::saveStateSlot()
+{
+	std::filesystem::path statePath = m_core.m_cartridge.getCartInfo().CartFilePath;
+	statePath.replace_extension(".state");
+
+	if (!m_core.saveStateToFile(statePath.string()))
+		fmt::println(stderr, "Failed to save state to: {}", statePath.string());
+}
+
+void BudgetGB::loadStateSlot()
+{
+	std::filesystem::path statePath = m_core.m_cartridge.getCartInfo().CartFilePath;
+	statePath.replace_extension(".state");
+
+	// a movie can not continue from a state it did not produce
+	stopMovie();
+
+	if (!m_core.loadStateFromFile(statePath.string()))
+	{
+		fmt::println(stderr, "Failed to load state from: {}", statePath.string());
+		return;
+	}
+
+	m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+	m_disassembler.step();
+}
+
+void BudgetGB::saveResumeState()
+{
+	if (!m_config.autoResume || !isSaveStateAvailable())
+		return;
+
+	std::filesystem::path statePath = m_core.m_cartridge.getCartInfo().CartFilePath;
+	statePath.replace_extension(".resume");
+
+	if (!m_core.saveStateToFile(statePath.string()))
+		fmt::println(stderr, "Failed to save resume state to: {}", statePath.string());
+}
+
+bool BudgetGB::loadResumeState()
+{
+	if (!m_config.autoResume || !isSaveStateAvailable())
+		return false;
+
+	std::filesystem::path statePath = m_core.m_cartridge.getCartInfo().CartFilePath;
+	statePath.replace_extension(".resume");
+
+	std::error_code error;
+	if (!std::filesystem::exists(statePath, error))
+		return false;
+
+	// a state that no longer loads leaves the cold start in place, it is replaced on the next exit
+	auto startTime = std::chrono::steady_clock::now();
+	if (!m_core.loadStateFromFile(statePath.string()))
+		return false;
+
+	std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - startTime;
+	fmt::println("Resumed from {} in {:.3f}ms", statePath.string(), loadTime.count());
+
+	m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+	m_disassembler.step();
+
+	return true;
+}
+
+void BudgetGB::startMovieRecording(bool fromPowerOn)
+{
+	stopMovie();
+
+	if (fromPowerOn)
+	{
+		// the bootrom is left out so playback does not depend on having the same bootrom file
+		m_core.reset(false);
+		m_rewindBuffer.clear();
+
+		m_audioDevice.pause();
+		m_audioDevice.resume();
+	}
+
+	if (!m_movie.startRecording(m_core, fromPowerOn))
+		return;
+
+	m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+	m_disassembler.step();
+}
+
+void BudgetGB::startMoviePlayback()
+{
+	std::filesystem::path moviePath = m_core.m_cartridge.getCartInfo().CartFilePath;
+	moviePath.replace_extension(".movie");
+
+	stopMovie();
+
+	if (!m_movie.loadFromFile(moviePath.string()) || !m_movie.startPlayback(m_core))
+	{
+		fmt::println(stderr, "Failed to play movie: {}", moviePath.string());
+		return;
+	}
+
+	m_rewindBuffer.clear();
+	m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+	m_disassembler.step();
+}
+
+void BudgetGB::stopMovie()
+{
+	const Movie::Mode mode = m_movie.getMode();
+	m_movie.stop();
+
+	if (mode == Movie::Mode::Playing)
+		m_core.m_cpu.m_joypad.setButtons(0);
+
+	if (mode != Movie::Mode::Recording)
+		return;
+
+	std::filesystem::path moviePath = m_core.m_cartridge.getCartInfo().CartFilePath;
+	moviePath.replace_extension(".movie");
+
+	if (!m_movie.saveToFile(moviePath.string()))
+		fmt::println(stderr, "Failed to save movie to: {}", moviePath.string());
+}
+
+bool BudgetGB::emulateFrame(bool paced)
+{
+	m_movie.beforeFrame(m_core.m_cpu.m_joypad);
+
+	if (paced)
+	{
+		if (!m_core.m_bus.onUpdate())
+			return false;
+	}
+	else if (!m_core.runFrame())
 		return false;
+
+	m_movie.afterFrame(m_core.m_cpu.m_joypad);
+	m_rewindBuffer.push(m_core);
+
+	if (m_sharedMemory)
+		m_sharedMemory->publishFrame(m_core, false);
+
+	return true;
+}
+
+void BudgetGB::setRewinding(bool rewinding)
+{
+	if (rewinding == static_cast<bool>(m_guiContext.flags & GuiContextFlags_REWIND))
+		return;
+
+	m_guiContext.flags ^= GuiContextFlags_REWIND;
+
+	if (rewinding)
+	{
+		m_audioDevice.pause();
+		return;
 	}
+
+	// drop the audio of frames that were run again to redraw them
+	m_core.m_apu.clearSamples();
+	m_audioDevice.resume();
+
+	m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+	m_disassembler.step();
+}
+
+void BudgetGB::setFastForward(bool fastForward)
+{
+	if (fastForward == static_cast<bool>(m_guiContext.flags & GuiContextFlags_FAST_FORWARD))
+		return;
+
+	m_guiContext.flags ^= GuiContextFlags_FAST_FORWARD;
+	updateFastForwardAudio();
+
+	m_speedSampleTime   = 0.0f;
+	m_speedSampleFrames = 0;
+	m_effectiveSpeed    = 1.0f;
+
+	if (!fastForward)
+	{
+		m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+		m_disassembler.step();
+	}
+}
+
+void BudgetGB::updateFastForwardAudio()
+{
+	const bool     fastForward = m_guiContext.flags & GuiContextFlags_FAST_FORWARD;
+	const uint32_t speed       = fastForward ? m_config.fastForwardSpeed : 1;
+
+	// unlimited speed has no steady ratio to stretch by, frames run with the output filter skipped entirely
+	m_core.m_apu.setPlaybackSpeed(speed == 0 ? 1.0f : std::min(static_cast<float>(speed), TimeStretch::MAX_SPEED));
+	m_core.m_apu.setOutputEnabled(speed != 0);
+
+	// audio queued at the previous speed would otherwise play out before the change is heard
+	m_core.m_apu.clearSamples();
+}
+
+uint32_t BudgetGB::runUnlimitedFrames()
+{
+	using Clock = std::chrono::steady_clock;
+
+	// the emulation lock is held for the whole run, kept short so the gui gets it between runs without a visible wait
+	const auto deadline  = Clock::now() + std::chrono::milliseconds(4);
+	uint32_t   framesRun = 0;
+
+	do
+		framesRun += emulateFrame(false);
+	while (Clock::now() < deadline && !m_debugger.isStopped());
+
+	return framesRun;
+}
+
+void BudgetGB::updateEffectiveSpeed(uint32_t framesRun, float elapsedSeconds)
+{
+	constexpr float SAMPLE_PERIOD = 0.5f; // seconds
+	constexpr float FRAME_RATE    = static_cast<float>(BudgetGbConstants::CLOCK_RATE_T) / BudgetGbConstants::FRAME_CYCLES;
+
+	m_speedSampleTime += elapsedSeconds;
+	m_speedSampleFrames += framesRun;
+
+	if (m_speedSampleTime < SAMPLE_PERIOD)
+		return;
+
+	m_effectiveSpeed    = m_speedSampleFrames / (m_speedSampleTime * FRAME_RATE);
+	m_speedSampleTime   = 0.0f;
+	m_speedSampleFrames = 0;
 }
 
 void BudgetGB::resizeViewportStretched()
@@ -304,15 +846,15 @@ void BudgetGB::guiMain()
 		if (ImGui::MenuItem("Pause", "P", m_guiContext.flags & GuiContextFlags_PAUSE))
 		{
 			m_guiContext.flags ^= GuiContextFlags_PAUSE;
-			if (m_guiContext.flags & GuiContextFlags_PAUSE && m_cartridge.isLoaded())
+			if (m_guiContext.flags & GuiContextFlags_PAUSE && m_core.m_cartridge.isLoaded())
 			{
-				m_disassembler.setProgramCounter(m_cpu.m_programCounter);
+				m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
 				m_disassembler.step();
 			}
 		}
 
 		if (ImGui::MenuItem("Load ROM..."))
-			SDL_ShowOpenFileDialog(loadRomDialogCallback, this, m_window, romFileFilter, 1, nullptr, false);
+			SDL_ShowOpenFileDialog(loadRomDialogCallback, this, m_window, romFileFilter, 2, nullptr, false);
 
 		if (ImGui::BeginMenu("Window Sizes"))
 		{
@@ -380,7 +922,7 @@ void BudgetGB::guiMain()
 			m_guiContext.flags ^= GuiContextFlags_SHOW_TILES;
 
 			if (m_guiContext.flags & GuiContextFlags_SHOW_TILES)
-				m_patternTileViewport = std::make_unique<PatternTileView>(m_ppu, m_renderContext);
+				m_patternTileViewport = std::make_unique<PatternTileView>(m_core.m_ppu, m_renderContext);
 			else
 				m_patternTileViewport.reset();
 		}
@@ -388,20 +930,146 @@ void BudgetGB::guiMain()
 		if (ImGui::MenuItem("Audio", "", m_guiContext.flags & GuiContextFlags_SHOW_AUDIO))
 		{
 			m_guiContext.flags ^= GuiContextFlags_SHOW_AUDIO;
+
+			if (m_guiContext.flags & GuiContextFlags_SHOW_AUDIO)
+			{
+				m_audioLogBuffers = std::make_unique<AudioLogging::AudioLogBuffers>();
+				m_core.m_apu.setAudioLogBuffers(m_audioLogBuffers.get());
+			}
+			else
+			{
+				m_core.m_apu.setAudioLogBuffers(nullptr);
+				m_audioLogBuffers.reset();
+			}
+		}
+
+		if (ImGui::BeginMenu("Audio Output"))
+		{
+			if (ImGui::BeginMenu("Sample Rate"))
+			{
+				for (uint32_t sampleRate : BudgetGbConstants::AUDIO_SAMPLE_RATES)
+				{
+					std::string label = std::to_string(sampleRate) + " Hz";
+					if (ImGui::MenuItem(label.c_str(), "", m_config.audioSampleRate == sampleRate))
+					{
+						m_config.audioSampleRate = sampleRate;
+						m_core.m_apu.setOutputFormat(m_config.audioSampleRate, m_config.audioQuality);
+						m_audioDevice.open(m_core.m_apu);
+					}
+				}
+
+				ImGui::EndMenu();
+			}
+
+			if (ImGui::BeginMenu("Quality"))
+			{
+				constexpr std::array<std::pair<const char *, ResamplerQuality>, 4> qualities = {{
+					{"Box (legacy)", ResamplerQuality::Box},
+					{"Low", ResamplerQuality::Low},
+					{"Medium", ResamplerQuality::Medium},
+					{"High", ResamplerQuality::High},
+				}};
+
+				for (const auto &[label, quality] : qualities)
+				{
+					if (ImGui::MenuItem(label, "", m_config.audioQuality == quality))
+					{
+						m_config.audioQuality = quality;
+						m_core.m_apu.setOutputFormat(m_config.audioSampleRate, m_config.audioQuality);
+						m_audioDevice.open(m_core.m_apu);
+					}
+				}
+
+				ImGui::EndMenu();
+			}
+
+			ImGui::EndMenu();
 		}
 
 		if (ImGui::MenuItem("CPU Viewer", "", m_guiContext.flags & GuiContextFlags_SHOW_CPU_VIEWER))
 			m_guiContext.flags ^= GuiContextFlags_SHOW_CPU_VIEWER;
 
-		ImGui::BeginDisabled(!m_cartridge.isLoaded());
+		ImGui::BeginDisabled(!m_core.m_cartridge.isLoaded());
 		if (ImGui::MenuItem("Reset", "*"))
 			resetBudgetGB();
 		ImGui::EndDisabled();
 
+		ImGui::BeginDisabled(!isSaveStateAvailable());
+		if (ImGui::MenuItem("Save State", "F1"))
+			saveStateSlot();
+		if (ImGui::MenuItem("Load State", "F2"))
+			loadStateSlot();
+		ImGui::EndDisabled();
+
+		ImGui::MenuItem("Resume On Launch", "", &m_config.autoResume);
+
+		if (ImGui::BeginMenu("Run Ahead"))
+		{
+			if (ImGui::MenuItem("Off", "", m_config.runAheadFrames == 0))
+				m_config.runAheadFrames = 0;
+
+			for (uint32_t frames = 1; frames <= BudgetGbConfig::MAX_RUN_AHEAD; ++frames)
+			{
+				std::string label = std::to_string(frames) + (frames == 1 ? " frame" : " frames");
+				if (ImGui::MenuItem(label.c_str(), "", m_config.runAheadFrames == frames))
+					m_config.runAheadFrames = frames;
+			}
+
+			ImGui::EndMenu();
+		}
+
+		ImGui::BeginDisabled(!isSaveStateAvailable());
+		if (ImGui::BeginMenu("Movie"))
+		{
+			const bool idle = m_movie.getMode() == Movie::Mode::Idle;
+
+			if (ImGui::MenuItem("Record From Power On", "", false, idle))
+				startMovieRecording(true);
+			if (ImGui::MenuItem("Record From Here", "", false, idle))
+				startMovieRecording(false);
+			if (ImGui::MenuItem("Play", "", false, idle))
+				startMoviePlayback();
+			if (ImGui::MenuItem("Stop", "", false, !idle))
+				stopMovie();
+
+			ImGui::EndMenu();
+		}
+		ImGui::EndDisabled();
+
+		if (ImGui::BeginMenu("Fast Forward"))
+		{
+			for (uint32_t speed : BudgetGbConfig::FAST_FORWARD_SPEEDS)
+			{
+				std::string label = speed == 0 ? "Unlimited" : std::to_string(speed) + "x";
+				if (ImGui::MenuItem(label.c_str(), "Tab", m_config.fastForwardSpeed == speed))
+				{
+					m_config.fastForwardSpeed = speed;
+					updateFastForwardAudio();
+				}
+			}
+
+			ImGui::EndMenu();
+		}
+
 		if (ImGui::Selectable("Bootrom"))
 			showBootromModal = true;
 
-		ImGui::BeginDisabled(!m_cartridge.isLoaded());
+		if (m_gbsPlayer && ImGui::BeginMenu("Tracks"))
+		{
+			const Mapper::GbsHeader &header = m_gbsPlayer->getHeader();
+			ImGui::TextDisabled("%s - %s", header.Title.c_str(), header.Author.c_str());
+
+			for (uint8_t track = 0; track < header.TrackCount; ++track)
+			{
+				std::string label = "Track " + std::to_string(track + 1);
+				if (ImGui::MenuItem(label.c_str(), "", m_gbsPlayer->getCurrentTrack() == track))
+					playGbsTrack(track);
+			}
+
+			ImGui::EndMenu();
+		}
+
+		ImGui::BeginDisabled(!m_core.m_cartridge.isLoaded());
 		if (ImGui::Selectable("CartInfo"))
 			showCartInfo = true;
 		ImGui::EndDisabled();
@@ -478,29 +1146,15 @@ void BudgetGB::guiMain()
 	if (m_guiContext.flags & GuiContextFlags_SHOW_PALETTES)
 		guiPalettes();
 
-	if (m_patternTileViewport)
-	{
-		if (!m_patternTileViewport->drawViewportGui(m_renderContext))
-		{
-			m_patternTileViewport.reset();
-			m_guiContext.flags &= ~GuiContextFlags_SHOW_TILES;
-		}
-	}
-
-	if (m_guiContext.flags & GuiContextFlags_SHOW_AUDIO)
-	{
-		if (!AudioWidget::drawAudioWidget(m_apu, m_audioChannelToggle))
-		{
-			m_guiContext.flags &= ~GuiContextFlags_SHOW_AUDIO;
-		}
-	}
+	if (m_guiContext.flags & GuiContextFlags_FAST_FORWARD || m_movie.getMode() != Movie::Mode::Idle || m_netplay)
+		guiStatusOverlay();
 
 	if (showCartInfo)
 		ImGui::OpenPopup("CartInfo");
 
 	if (ImGui::BeginPopupModal("CartInfo", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
 	{
-		const Mapper::CartInfo &cartInfo = m_cartridge.getCartInfo();
+		const Mapper::CartInfo &cartInfo = m_core.m_cartridge.getCartInfo();
 
 		ImGui::Text("Mapper: %s", Mapper::getMapperString(cartInfo.MbcType).data());
 		ImGui::Text("Rom size: %u", cartInfo.RomSize);
@@ -546,7 +1200,7 @@ void BudgetGB::guiMain()
 	{
 		m_guiContext.blockJoypadInputs |= ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows);
 
-		ImGui::Text("%s", m_cpu.m_bootrom.getErrorMsg().c_str());
+		ImGui::Text("%s", m_core.m_cpu.m_bootrom.getErrorMsg().c_str());
 
 		if (ImGui::Button("Ok", ImVec2(80, 0)))
 			ImGui::CloseCurrentPopup();
@@ -555,6 +1209,52 @@ void BudgetGB::guiMain()
 	}
 }
 
+void BudgetGB::captureGuiViews()
+{
+	if (m_patternTileViewport)
+		m_patternTileViewport->captureVram();
+
+	if (m_audioLogBuffers)
+		m_audioLogSnapshot = *m_audioLogBuffers;
+}
+
+void BudgetGB::guiViews()
+{
+	if (m_patternTileViewport)
+	{
+		if (!m_patternTileViewport->drawViewportGui(m_renderContext))
+		{
+			// gui flags are shared with the emulation thread
+			auto lock = m_emulation.lock();
+			m_patternTileViewport.reset();
+			m_guiContext.flags &= ~GuiContextFlags_SHOW_TILES;
+		}
+	}
+
+	if (m_audioLogBuffers)
+	{
+		const Apu::AudioChannelToggle previousToggle = m_audioChannelToggle;
+		const bool                    open           = AudioWidget::drawAudioWidget(m_audioLogSnapshot, m_audioChannelToggle);
+
+		const bool toggled = previousToggle.Pulse1 != m_audioChannelToggle.Pulse1 || previousToggle.Pulse2 != m_audioChannelToggle.Pulse2 ||
+		                     previousToggle.Wave != m_audioChannelToggle.Wave || previousToggle.Noise != m_audioChannelToggle.Noise;
+
+		// changes reach the apu under a short lock of their own, only when there is one
+		if (toggled || !open)
+		{
+			auto lock = m_emulation.lock();
+			m_core.m_apu.setAudioChannelToggle(m_audioChannelToggle);
+
+			if (!open)
+			{
+				m_core.m_apu.setAudioLogBuffers(nullptr);
+				m_audioLogBuffers.reset();
+				m_guiContext.flags &= ~GuiContextFlags_SHOW_AUDIO;
+			}
+		}
+	}
+}
+
 void BudgetGB::guiCpuViewer()
 {
 	bool toggle = m_guiContext.flags & GuiContextFlags_SHOW_CPU_VIEWER;
@@ -571,8 +1271,8 @@ void BudgetGB::guiCpuViewer()
 			ImGui::TableSetColumnIndex(0);
 			if (ImGui::BeginTable("CPU Instruction Log", 1, ImGuiTableFlags_ScrollY, tableSize))
 			{
-				std::size_t position   = m_cpu.m_opcodeLogger.bufferPosition();
-				std::size_t bufferSize = m_cpu.m_opcodeLogger.bufferSize();
+				std::size_t position   = m_core.m_cpu.m_opcodeLogger.bufferPosition();
+				std::size_t bufferSize = m_core.m_cpu.m_opcodeLogger.bufferSize();
 
 				if (m_guiContext.guiCpuViewer_snapInstructionScrollY)
 				{
@@ -592,7 +1292,7 @@ void BudgetGB::guiCpuViewer()
 					{
 						ImGui::TableNextRow();
 						ImGui::TableSetColumnIndex(0);
-						ImGui::Text("%s", m_cpu.m_opcodeLogger.getLogAt((position + row + 1) % bufferSize));
+						ImGui::Text("%s", m_core.m_cpu.m_opcodeLogger.getLogAt((position + row + 1) % bufferSize));
 					}
 				}
 
@@ -607,18 +1307,18 @@ void BudgetGB::guiCpuViewer()
 				ImGui::TableNextRow();
 
 				ImGui::TableSetColumnIndex(0);
-				ImGui::Text("PC: %04X", m_cpu.m_programCounter);
-				ImGui::Text("SP: %04X", m_cpu.m_stackPointer);
-				ImGui::Text("AF: %04X", m_cpu.m_registerAF.get_u16());
-				ImGui::Text("BC: %04X", m_cpu.m_registerBC.get_u16());
-				ImGui::Text("DE: %04X", m_cpu.m_registerDE.get_u16());
-				ImGui::Text("HL: %04X", m_cpu.m_registerHL.get_u16());
+				ImGui::Text("PC: %04X", m_core.m_cpu.m_programCounter);
+				ImGui::Text("SP: %04X", m_core.m_cpu.m_stackPointer);
+				ImGui::Text("AF: %04X", m_core.m_cpu.m_registerAF.get_u16());
+				ImGui::Text("BC: %04X", m_core.m_cpu.m_registerBC.get_u16());
+				ImGui::Text("DE: %04X", m_core.m_cpu.m_registerDE.get_u16());
+				ImGui::Text("HL: %04X", m_core.m_cpu.m_registerHL.get_u16());
 
 				ImGui::TableSetColumnIndex(1);
-				ImGui::Text("Z: %u", m_cpu.m_registerAF.flags.Z);
-				ImGui::Text("N: %u", m_cpu.m_registerAF.flags.N);
-				ImGui::Text("H: %u", m_cpu.m_registerAF.flags.H);
-				ImGui::Text("C: %u", m_cpu.m_registerAF.flags.C);
+				ImGui::Text("Z: %u", m_core.m_cpu.m_registerAF.flags.Z);
+				ImGui::Text("N: %u", m_core.m_cpu.m_registerAF.flags.N);
+				ImGui::Text("H: %u", m_core.m_cpu.m_registerAF.flags.H);
+				ImGui::Text("C: %u", m_core.m_cpu.m_registerAF.flags.C);
 
 				ImGui::EndTable();
 			}
@@ -640,24 +1340,25 @@ void BudgetGB::guiCpuViewer()
 			// pause
 			else if (ImGui::Button("Pause"))
 			{
-				if (m_cartridge.isLoaded())
+				if (m_core.m_cartridge.isLoaded())
 				{
-					m_disassembler.setProgramCounter(m_cpu.m_programCounter);
+					m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
 					m_disassembler.step();
 				}
 				m_guiContext.flags |= GuiContextFlags_PAUSE;
 			}
 
-			ImGui::BeginDisabled(!m_cartridge.isLoaded() || !(m_guiContext.flags & GuiContextFlags_PAUSE));
+			ImGui::BeginDisabled(!m_core.m_cartridge.isLoaded() || !(m_guiContext.flags & GuiContextFlags_PAUSE));
 			if (ImGui::Button("Instruction Step"))
 			{
-				m_cpu.instructionStep();
-				m_disassembler.setProgramCounter(m_cpu.m_programCounter);
+				m_guiContext.guiCpuViewer_stopMessage.clear();
+				m_core.m_cpu.instructionStep();
+				m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
 				m_disassembler.step();
 			}
 			ImGui::EndDisabled();
 
-			ImGui::BeginDisabled(!m_cartridge.isLoaded());
+			ImGui::BeginDisabled(!m_core.m_cartridge.isLoaded());
 			if (ImGui::Button("Reset"))
 			{
 				resetBudgetGB();
@@ -667,7 +1368,7 @@ void BudgetGB::guiCpuViewer()
 			ImGui::NewLine();
 
 			ImGui::Text("Lines to Log");
-			auto &selectedIndex = m_cpu.m_opcodeLogger.m_selectedOptionIdx;
+			auto &selectedIndex = m_core.m_cpu.m_opcodeLogger.m_selectedOptionIdx;
 			ImGui::BeginDisabled(m_guiContext.flags & GuiContextFlags_TOGGLE_INSTRUCTION_LOG);
 			if (ImGui::BeginCombo("", OpcodeLogger::LOGGER_OPTIONS[selectedIndex].label))
 			{
@@ -691,8 +1392,8 @@ void BudgetGB::guiCpuViewer()
 				if (ImGui::Button("Stop Logging"))
 				{
 					m_guiContext.flags &= ~GuiContextFlags_TOGGLE_INSTRUCTION_LOG;
-					m_cpu.m_logEnable = m_guiContext.flags & GuiContextFlags_TOGGLE_INSTRUCTION_LOG;
-					m_cpu.m_opcodeLogger.stopLog();
+					m_core.m_cpu.m_logEnable = m_guiContext.flags & GuiContextFlags_TOGGLE_INSTRUCTION_LOG;
+					m_core.m_cpu.m_opcodeLogger.stopLog();
 				}
 				ImGui::PopStyleColor(1);
 			}
@@ -700,8 +1401,8 @@ void BudgetGB::guiCpuViewer()
 			{
 				m_guiContext.guiCpuViewer_snapInstructionScrollY = true;
 				m_guiContext.flags |= GuiContextFlags_TOGGLE_INSTRUCTION_LOG;
-				m_cpu.m_opcodeLogger.startLog();
-				m_cpu.m_logEnable = m_guiContext.flags & GuiContextFlags_TOGGLE_INSTRUCTION_LOG;
+				m_core.m_cpu.m_opcodeLogger.startLog();
+				m_core.m_cpu.m_logEnable = m_guiContext.flags & GuiContextFlags_TOGGLE_INSTRUCTION_LOG;
 			}
 
 			ImGui::PopStyleColor(2);
@@ -727,6 +1428,14 @@ void BudgetGB::guiCpuViewer()
 				ImGui::EndTable();
 			}
 
+			ImGui::NewLine();
+			guiBreakpoints();
+
+#ifdef BUDGETGB_PROFILER
+			ImGui::NewLine();
+			guiProfiler();
+#endif
+
 			ImGui::EndTable();
 		}
 	}
@@ -735,6 +1444,295 @@ void BudgetGB::guiCpuViewer()
 	m_guiContext.flags = toggle ? (m_guiContext.flags | GuiContextFlags_SHOW_CPU_VIEWER) : (m_guiContext.flags & ~GuiContextFlags_SHOW_CPU_VIEWER);
 }
 
+void BudgetGB::guiBreakpoints()
+{
+	constexpr ImVec4 RED = {0.9686f, 0.1843f, 0.1843f, 1.0f};
+
+	if (!m_guiContext.guiCpuViewer_stopMessage.empty())
+		ImGui::TextColored(RED, "%s", m_guiContext.guiCpuViewer_stopMessage.c_str());
+
+	ImGui::Text("Breakpoints");
+
+	ImGui::SetNextItemWidth(ImGui::CalcTextSize("0000-0000").x + ImGui::GetStyle().FramePadding.x * 2.0f);
+	ImGui::InputTextWithHint("##Breakpoint Address", "C000-C0FF", &m_guiContext.guiCpuViewer_breakpointAddress);
+	ImGui::SameLine();
+	ImGui::Checkbox("Read", &m_guiContext.guiCpuViewer_watchRead);
+	ImGui::SameLine();
+	ImGui::Checkbox("Write", &m_guiContext.guiCpuViewer_watchWrite);
+
+	ImGui::InputTextWithHint("##Breakpoint Condition", "Condition, such as a == 3 && [hl] > $10", &m_guiContext.guiCpuViewer_breakpointCondition);
+	ImGui::SameLine();
+
+	if (ImGui::Button("Add"))
+	{
+		uint16_t    start = 0, end = 0;
+		std::string error;
+
+		const uint8_t flags = (m_guiContext.guiCpuViewer_watchRead ? Debugger::WATCH_READ : 0) | (m_guiContext.guiCpuViewer_watchWrite ? Debugger::WATCH_WRITE : 0);
+
+		if (!parseAddressRange(m_guiContext.guiCpuViewer_breakpointAddress, start, end))
+			error = "Address must be hex, or a first-last range for watchpoints";
+		else if (flags)
+			m_debugger.addWatchpoint(start, end, flags, m_guiContext.guiCpuViewer_breakpointCondition, error);
+		else if (start != end)
+			error = "Execution breakpoints take a single address";
+		else
+			m_debugger.addBreakpoint(start, m_guiContext.guiCpuViewer_breakpointCondition, error);
+
+		m_guiContext.guiCpuViewer_breakpointError = error;
+	}
+
+	if (!m_guiContext.guiCpuViewer_breakpointError.empty())
+		ImGui::TextColored(RED, "%s", m_guiContext.guiCpuViewer_breakpointError.c_str());
+
+	std::vector<Debugger::Breakpoint> &breakpoints = m_debugger.getBreakpoints();
+	std::vector<Debugger::Watchpoint> &watchpoints = m_debugger.getWatchpoints();
+
+	if ((breakpoints.empty() && watchpoints.empty()) || !ImGui::BeginTable("Breakpoint List", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_NoHostExtendX))
+		return;
+
+	ImGui::TableSetupColumn("On");
+	ImGui::TableSetupColumn("Address");
+	ImGui::TableSetupColumn("Condition");
+	ImGui::TableSetupColumn("Hits");
+	ImGui::TableSetupColumn("");
+	ImGui::TableHeadersRow();
+
+	bool changed = false;
+	int  id      = 0;
+
+	// erased entries are dropped after the whole list was drawn
+	auto row = [&](bool &enabled, const std::string &address, const std::string &condition, uint32_t hits) {
+		ImGui::PushID(id++);
+		ImGui::TableNextRow();
+
+		ImGui::TableSetColumnIndex(0);
+		changed |= ImGui::Checkbox("##Enabled", &enabled);
+		ImGui::TableSetColumnIndex(1);
+		ImGui::Text("%s", address.c_str());
+		ImGui::TableSetColumnIndex(2);
+		ImGui::Text("%s", condition.c_str());
+		ImGui::TableSetColumnIndex(3);
+		ImGui::Text("%u", hits);
+		ImGui::TableSetColumnIndex(4);
+		const bool erase = ImGui::SmallButton("Delete");
+
+		ImGui::PopID();
+		return erase;
+	};
+
+	int eraseBreakpoint = -1, eraseWatchpoint = -1;
+
+	for (int i = 0; static_cast<std::size_t>(i) < breakpoints.size(); ++i)
+	{
+		Debugger::Breakpoint &breakpoint = breakpoints[i];
+		if (row(breakpoint.Enabled, fmt::format("Exec {:04X}", breakpoint.Address), breakpoint.Condition, breakpoint.Hits))
+			eraseBreakpoint = i;
+	}
+
+	for (int i = 0; static_cast<std::size_t>(i) < watchpoints.size(); ++i)
+	{
+		Debugger::Watchpoint &watchpoint = watchpoints[i];
+
+		const char *access = watchpoint.Flags == (Debugger::WATCH_READ | Debugger::WATCH_WRITE) ? "Access" : (watchpoint.Flags & Debugger::WATCH_READ ? "Read" : "Write");
+		std::string address = watchpoint.Start == watchpoint.End ? fmt::format("{} {:04X}", access, watchpoint.Start) : fmt::format("{} {:04X}-{:04X}", access, watchpoint.Start, watchpoint.End);
+
+		if (row(watchpoint.Enabled, address, watchpoint.Condition, watchpoint.Hits))
+			eraseWatchpoint = i;
+	}
+
+	ImGui::EndTable();
+
+	if (eraseBreakpoint >= 0)
+		breakpoints.erase(breakpoints.begin() + eraseBreakpoint);
+	if (eraseWatchpoint >= 0)
+		watchpoints.erase(watchpoints.begin() + eraseWatchpoint);
+
+	if (changed || eraseBreakpoint >= 0 || eraseWatchpoint >= 0)
+		m_debugger.update();
+}
+
+#ifdef BUDGETGB_PROFILER
+void BudgetGB::guiProfiler()
+{
+	constexpr uint32_t HOT_SPOT_ROWS  = 32;
+	constexpr uint32_t FUNCTION_ROWS  = 16;
+	constexpr uint32_t REFRESH_FRAMES = 15; // gui frames between hot spot refreshes
+
+	ImGui::Text("Profiler");
+
+	if (!m_profiler)
+	{
+		ImGui::BeginDisabled(!m_core.m_cartridge.isLoaded());
+		if (ImGui::Button("Start Profiling"))
+		{
+			m_profiler     = std::make_unique<Profiler>();
+			m_callProfiler = std::make_unique<CallProfiler>();
+			resetProfiler();
+			m_core.m_cpu.setProfiler(m_profiler.get());
+			m_core.m_cpu.setCallProfiler(m_callProfiler.get());
+		}
+		ImGui::EndDisabled();
+		return;
+	}
+
+	if (ImGui::Button("Stop Profiling"))
+	{
+		m_core.m_cpu.setProfiler(nullptr);
+		m_core.m_cpu.setCallProfiler(nullptr);
+		m_profiler.reset();
+		m_callProfiler.reset();
+		resetProfiler();
+		return;
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Clear"))
+		resetProfiler();
+
+	ImGui::SameLine();
+	if (ImGui::Button("Export"))
+	{
+		std::filesystem::path reportPath = m_core.m_cartridge.getCartInfo().CartFilePath;
+		std::filesystem::path stacksPath = reportPath;
+		reportPath.replace_extension(".profile.csv");
+		stacksPath.replace_extension(".folded");
+
+		m_callProfiler->sync(m_core.m_bus.getElapsedCycles() / 4);
+
+		const bool saved                 = m_profiler->writeReport(reportPath.string()) && m_callProfiler->writeFoldedStacks(stacksPath.string());
+		m_guiContext.guiProfiler_message = saved ? fmt::format("Saved {} and {}", reportPath.filename().string(), stacksPath.filename().string()) : "Export failed";
+	}
+
+	if (!m_guiContext.guiProfiler_message.empty())
+		ImGui::Text("%s", m_guiContext.guiProfiler_message.c_str());
+
+	if (m_guiContext.guiProfiler_refreshCountdown-- == 0)
+	{
+		m_guiContext.guiProfiler_hotSpots = m_profiler->getHotSpots(HOT_SPOT_ROWS);
+
+		m_callProfiler->sync(m_core.m_bus.getElapsedCycles() / 4);
+		m_guiContext.guiProfiler_functions       = m_callProfiler->getFunctions();
+		m_guiContext.guiProfiler_inclusiveCycles = m_callProfiler->getInclusiveCycles();
+
+		const std::vector<CallProfiler::Node> &nodes       = m_callProfiler->getNodes();
+		const std::vector<uint64_t>           &inclusive   = m_guiContext.guiProfiler_inclusiveCycles;
+		std::vector<std::vector<uint32_t>>    &children    = m_guiContext.guiProfiler_children;
+
+		children.assign(nodes.size(), {});
+		for (uint32_t node = CallProfiler::ROOT + 1; node < nodes.size(); ++node)
+			children[nodes[node].Parent].push_back(node);
+
+		for (std::vector<uint32_t> &siblings : children)
+			std::sort(siblings.begin(), siblings.end(), [&inclusive](uint32_t a, uint32_t b) { return inclusive[a] > inclusive[b]; });
+
+		m_guiContext.guiProfiler_refreshCountdown = REFRESH_FRAMES;
+	}
+
+	const double totalCycles = static_cast<double>(std::max<uint64_t>(m_profiler->getTotalCycles(), 1));
+	ImGui::Text("%llu m-cycles, %.1f%% halted", static_cast<unsigned long long>(m_profiler->getTotalCycles()), m_profiler->getHaltedCycles() * 100.0 / totalCycles);
+
+	if (ImGui::BeginTable("Hot Spots", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_NoHostExtendX))
+	{
+		ImGui::TableSetupColumn("Bank");
+		ImGui::TableSetupColumn("Address");
+		ImGui::TableSetupColumn("Executions");
+		ImGui::TableSetupColumn("M-Cycles");
+		ImGui::TableSetupColumn("%");
+		ImGui::TableHeadersRow();
+
+		for (const Profiler::HotSpot &hotSpot : m_guiContext.guiProfiler_hotSpots)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::Text("%02X", hotSpot.Bank);
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%04X", hotSpot.Address);
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%llu", static_cast<unsigned long long>(hotSpot.Counts.Executions));
+			ImGui::TableSetColumnIndex(3);
+			ImGui::Text("%llu", static_cast<unsigned long long>(hotSpot.Counts.Cycles));
+			ImGui::TableSetColumnIndex(4);
+			ImGui::Text("%.2f", hotSpot.Counts.Cycles * 100.0 / totalCycles);
+		}
+
+		ImGui::EndTable();
+	}
+
+	if (m_guiContext.guiProfiler_inclusiveCycles.empty())
+		return;
+
+	const double callGraphCycles = static_cast<double>(std::max<uint64_t>(m_guiContext.guiProfiler_inclusiveCycles[CallProfiler::ROOT], 1));
+
+	ImGui::NewLine();
+	ImGui::Text("Functions");
+
+	if (ImGui::BeginTable("Functions", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_NoHostExtendX))
+	{
+		ImGui::TableSetupColumn("Function");
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableSetupColumn("Inclusive %");
+		ImGui::TableSetupColumn("Exclusive %");
+		ImGui::TableHeadersRow();
+
+		const std::vector<CallProfiler::Function> &functions = m_guiContext.guiProfiler_functions;
+		for (std::size_t i = 0; i < std::min<std::size_t>(functions.size(), FUNCTION_ROWS); ++i)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::Text("%02X:%04X", functions[i].Bank, functions[i].Address);
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%llu", static_cast<unsigned long long>(functions[i].Calls));
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%.2f", functions[i].InclusiveCycles * 100.0 / callGraphCycles);
+			ImGui::TableSetColumnIndex(3);
+			ImGui::Text("%.2f", functions[i].ExclusiveCycles * 100.0 / callGraphCycles);
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::NewLine();
+	ImGui::Text("Call Graph");
+	guiCallGraphNode(CallProfiler::ROOT, callGraphCycles);
+}
+
+// one row of the call graph, a bar as wide as the share of the cycles spent inside the node, with its children below
+void BudgetGB::guiCallGraphNode(uint32_t node, double totalCycles)
+{
+	constexpr double HIDDEN_FRACTION = 0.001; // nodes under 0.1% of the cycles are left out
+
+	const std::vector<uint32_t> &children  = m_guiContext.guiProfiler_children[node];
+	const CallProfiler::Node    &current   = m_callProfiler->getNodes()[node];
+	const float                  inclusive = static_cast<float>(m_guiContext.guiProfiler_inclusiveCycles[node] / totalCycles);
+	const float                  exclusive = static_cast<float>(current.SelfCycles / totalCycles);
+
+	ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth;
+	if (node == CallProfiler::ROOT)
+		flags |= ImGuiTreeNodeFlags_DefaultOpen;
+	if (children.empty())
+		flags |= ImGuiTreeNodeFlags_Leaf;
+
+	const std::string label = fmt::format("{}##{}", m_callProfiler->getName(node), node);
+	const bool        open  = ImGui::TreeNodeEx(label.c_str(), flags);
+
+	ImGui::SameLine(ImGui::GetFontSize() * 16);
+	const std::string overlay = fmt::format("{:.1f}% self {:.1f}%, {} calls", inclusive * 100.0f, exclusive * 100.0f, current.Calls);
+	ImGui::ProgressBar(inclusive, ImVec2(ImGui::GetFontSize() * 16, 0), overlay.c_str());
+
+	if (!open)
+		return;
+
+	for (uint32_t child : children)
+	{
+		if (m_guiContext.guiProfiler_inclusiveCycles[child] >= totalCycles * HIDDEN_FRACTION)
+			guiCallGraphNode(child, totalCycles);
+	}
+
+	ImGui::TreePop();
+}
+#endif
+
 void BudgetGB::guiPalettes()
 {
 	bool toggle = m_guiContext.flags & GuiContextFlags_SHOW_PALETTES;
@@ -942,6 +1940,33 @@ void BudgetGB::guiPalettes()
 	m_guiContext.flags = toggle ? (m_guiContext.flags | GuiContextFlags_SHOW_PALETTES) : (m_guiContext.flags & ~GuiContextFlags_SHOW_PALETTES);
 }
 
+void BudgetGB::guiStatusOverlay()
+{
+	const ImGuiViewport *viewport = ImGui::GetMainViewport();
+	ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + 10.0f, viewport->WorkPos.y + 10.0f));
+	ImGui::SetNextWindowBgAlpha(0.5f);
+
+	constexpr ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+
+	if (ImGui::Begin("##StatusOverlay", nullptr, flags))
+	{
+		if (m_guiContext.flags & GuiContextFlags_FAST_FORWARD)
+			ImGui::Text("Fast forward %.1fx", m_effectiveSpeed);
+
+		if (m_movie.getMode() == Movie::Mode::Recording)
+			ImGui::Text("Recording frame %u", m_movie.getCurrentFrame());
+		else if (m_movie.getMode() == Movie::Mode::Playing)
+			ImGui::Text("Playing frame %u / %u", m_movie.getCurrentFrame(), m_movie.getFrameCount());
+
+		if (m_netplay && m_netplay->hasStartStateMismatch())
+			ImGui::Text("Netplay peer started from a different state");
+		else if (m_netplay)
+			ImGui::Text("Netplay frame %u, %u rollbacks", m_netplay->getFrame(), m_netplay->getStats().Rollbacks);
+	}
+
+	ImGui::End();
+}
+
 static void SDLCALL loadRomDialogCallback(void *userdata, const char *const *filelist, int filter)
 {
 	(void)filter;
@@ -956,7 +1981,8 @@ static void SDLCALL loadRomDialogCallback(void *userdata, const char *const *fil
 	else if (!*filelist)
 		return;
 
-	gameboy->loadCartridge(std::string(*filelist));
+	// dialog callbacks can come from any thread
+	gameboy->requestCartridge(std::string(*filelist));
 }
 
 static void SDLCALL loadBootromDialogCallback(void *userdata, const char *const *filelist, int filter)
@@ -974,3 +2000,77 @@ static void SDLCALL loadBootromDialogCallback(void *userdata, const char *const
 
 	config->bootromPath = *filelist;
 }
+
+// keyboard layout of the joypad
+static void processJoypadKey(const SDL_Event *event, Joypad &joypad)
+{
+	if (event->type != SDL_EVENT_KEY_DOWN && event->type != SDL_EVENT_KEY_UP)
+		return;
+
+	uint8_t button = 0;
+
+	switch (event->key.scancode)
+	{
+	case SDL_SCANCODE_W:
+		button = Joypad::BUTTON_UP;
+		break;
+
+	case SDL_SCANCODE_A:
+		button = Joypad::BUTTON_LEFT;
+		break;
+
+	case SDL_SCANCODE_S:
+		button = Joypad::BUTTON_DOWN;
+		break;
+
+	case SDL_SCANCODE_D:
+		button = Joypad::BUTTON_RIGHT;
+		break;
+
+	case SDL_SCANCODE_L:
+		button = Joypad::BUTTON_A;
+		break;
+
+	case SDL_SCANCODE_K:
+		button = Joypad::BUTTON_B;
+		break;
+
+	case SDL_SCANCODE_Q:
+		button = Joypad::BUTTON_START;
+		break;
+
+	case SDL_SCANCODE_E:
+		button = Joypad::BUTTON_SELECT;
+		break;
+
+	default:
+		return;
+	}
+
+	joypad.setButtonsPressed(button, event->type == SDL_EVENT_KEY_DOWN);
+}
+
+// a hex address, or a first-last range of them
+static bool parseAddressRange(const std::string &text, uint16_t &start, uint16_t &end)
+{
+	const std::size_t dash = text.find('-');
+
+	auto parse = [](const std::string &digits, uint16_t &address) {
+		if (digits.empty() || digits.size() > 4 || digits.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+			return false;
+
+		address = static_cast<uint16_t>(std::strtoul(digits.c_str(), nullptr, 16));
+		return true;
+	};
+
+	if (dash == std::string::npos)
+	{
+		if (!parse(text, start))
+			return false;
+
+		end = start;
+		return true;
+	}
+
+	return parse(text.substr(0, dash), start) && parse(text.substr(dash + 1), end) && start <= end;
+}
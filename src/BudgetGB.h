@@ -6,18 +6,28 @@
 #include <string>
 #include <vector>
 
+#include "AudioDevice.h"
+#include "BudgetGBCore.h"
+#include "Debugger.h"
+#include "EmulationThread.h"
+#include "GdbServer.h"
+#include "Movie.h"
+#include "CallProfiler.h"
+#include "Profiler.h"
+#include "RewindBuffer.h"
+#include "RollbackSession.h"
 #include "SDL3/SDL.h"
-#include "apu.h"
+#include "SerialLink.h"
+#include "SharedMemoryChannel.h"
 #include "audioWidget.h"
-#include "bus.h"
-#include "cartridge.h"
 #include "config.h"
 #include "disassembler.h"
 #include "emulatorConstants.h"
+#include "gbsPlayer.h"
 #include "imgui.h"
 #include "patternTileView.h"
 #include "renderer.h"
-#include "sm83.h"
+#include "utils/tripleBuffer.h"
 #include "utils/vec.h"
 
 class BudgetGB
@@ -30,19 +40,52 @@ class BudgetGB
 	BudgetGB(const std::string &cartridgePath = "");
 	~BudgetGB();
 
-	// Called once per frame at refresh rate
+	/**
+	 * @brief Power cycle the loaded rom without the bootrom and start rollback netplay with a peer, see
+	 * RollbackSession. Netplay lasts until the rom is reset or another one is loaded.
+	 * @return True on success, false otherwise.
+	 */
+	bool startNetplay(uint16_t localPort, const std::string &peerAddress, uint16_t peerPort, uint32_t inputDelay);
+
+	/**
+	 * @brief Publish every frame, the audio output and ramAddresses to a named shared memory segment and take input,
+	 * pause and state slot commands from it, see SharedMemoryLayout. Lasts until the emulator exits.
+	 * @return True on success, false otherwise.
+	 */
+	bool startSharedMemory(const std::string &name, const std::vector<uint16_t> &ramAddresses);
+
+	/**
+	 * @brief Plug a link cable into another emulator process on this machine, see SerialLink. Both sides pass each
+	 * other's port. Lasts until the emulator exits.
+	 * @return True on success, false otherwise.
+	 */
+	bool startLink(uint16_t localPort, const std::string &peerAddress, uint16_t peerPort);
+
+	/**
+	 * @brief Serve gdb remote protocol debuggers on a localhost port, see GdbServer. Lasts until the emulator exits.
+	 * @return True on success, false otherwise.
+	 */
+	bool startGdbServer(uint16_t port);
+
+	// Called once per frame at refresh rate, builds the gui and presents the newest emulated frame
 	void onUpdate();
 
 	SDL_AppResult processEvent(SDL_Event *event);
 
 	/**
 	 * @brief Resets bus and cpu before loading a cartridge from the provided path. Used for loading new cartridges after the gameboy instance
-	 * has been created.
+	 * has been created. The emulation lock must be held.
 	 * @param cartridgePath
 	 * @return True on success, false otherwise.
 	 */
 	bool loadCartridge(const std::string &cartridgePath);
 
+	/**
+	 * @brief Load a cartridge from any thread, such as a file dialog callback. Runs on the emulation thread before its
+	 * next step.
+	 */
+	void requestCartridge(const std::string &cartridgePath);
+
   private:
 	enum GuiContextFlags
 	{
@@ -59,6 +102,9 @@ class BudgetGB
 		GuiContextFlags_SHOW_BOOTROM_ERROR = 1 << 9,
 
 		GuiContextFlags_TOGGLE_INSTRUCTION_LOG = 1 << 10,
+
+		GuiContextFlags_REWIND       = 1 << 11, // set while the rewind key is held
+		GuiContextFlags_FAST_FORWARD = 1 << 12, // set while the fast forward key is held
 	};
 
 	struct GuiContext
@@ -73,6 +119,23 @@ class BudgetGB
 		RendererGB::ShaderSelect shaderSelect = RendererGB::ShaderSelect::None;
 
 		bool guiCpuViewer_snapInstructionScrollY = false;
+
+		// breakpoint and watchpoint entry of the cpu viewer, no read or write access adds an execution breakpoint
+		std::string guiCpuViewer_breakpointAddress; // hex address or first-last range
+		std::string guiCpuViewer_breakpointCondition;
+		std::string guiCpuViewer_breakpointError;
+		std::string guiCpuViewer_stopMessage; // why a breakpoint or watchpoint last paused emulation
+		bool        guiCpuViewer_watchRead  = false;
+		bool        guiCpuViewer_watchWrite = false;
+
+#ifdef BUDGETGB_PROFILER
+		std::vector<Profiler::HotSpot>       guiProfiler_hotSpots; // refreshed a few times a second, sorting every frame is slow
+		std::vector<CallProfiler::Function>  guiProfiler_functions;
+		std::vector<uint64_t>                guiProfiler_inclusiveCycles; // by call graph node
+		std::vector<std::vector<uint32_t>>   guiProfiler_children;        // call graph nodes by parent, most cycles first
+		uint32_t                             guiProfiler_refreshCountdown = 0;
+		std::string                          guiProfiler_message; // result of the last export
+#endif
 	};
 
 	GuiContext             m_guiContext;
@@ -83,14 +146,23 @@ class BudgetGB
 	SDL_Window                *m_window;
 	RendererGB::RenderContext *m_renderContext;
 
-	Cartridge    m_cartridge;
-	Bus          m_bus;
-	Sm83         m_cpu;
-	PPU          m_ppu;
-	Apu          m_apu;
+	BudgetGBCore m_core;
+
+	std::unique_ptr<SharedMemoryPublisher> m_sharedMemory; // set while publishing, outlives the audio device feeding it
+
+	AudioDevice m_audioDevice; // plays m_core's apu output, closed before m_core is destroyed
+
+	// runs emulationStep(), everything the steps touch is only read or changed with its lock held
+	EmulationThread                                        m_emulation;
+	Utils::TripleBuffer<BudgetGbConstants::LcdColorBuffer> m_frames; // emulated frames handed to the ui for presenting
+
 	Disassembler m_disassembler;
+	Debugger     m_debugger; // breakpoints and watchpoints of the cpu viewer, shared with an attached gdb
 
-	float m_accumulatedDeltaTime = 0.0f;
+	// emulated speed relative to real time, sampled over a few host frames for the fast forward overlay
+	float    m_effectiveSpeed    = 1.0f;
+	float    m_speedSampleTime   = 0.0f;
+	uint32_t m_speedSampleFrames = 0;
 
 	RendererGB::TexturedQuadUniquePtr m_lcdDisplayQuad;
 
@@ -101,26 +173,157 @@ class BudgetGB
 
 	std::unique_ptr<PatternTileView> m_patternTileViewport;
 
+	std::unique_ptr<AudioLogging::AudioLogBuffers> m_audioLogBuffers; // only allocated and subscribed to the apu while the audio widget is open
+	AudioLogging::AudioLogBuffers                  m_audioLogSnapshot; // copy of m_audioLogBuffers the audio widget draws from
+
+	std::unique_ptr<GbsPlayer> m_gbsPlayer; // set while a .gbs sound file is loaded instead of a rom
+
+	RewindBuffer m_rewindBuffer; // snapshot of every rom frame, gbs playback is not rewindable
+
+	Movie m_movie; // input recording or playback of the loaded rom, stored next to it as a .movie file
+
+	std::unique_ptr<RollbackSession> m_netplay;      // set while netplay is running
+	Joypad                           m_netplayInput; // local buttons, the core joypad is driven by the session
+
+	Joypad m_keyboardInput; // ui thread copy of the buttons held on the keyboard
+
+	std::unique_ptr<UdpSerialLink> m_serialLink; // set while a link cable is plugged in, see startLink()
+	std::unique_ptr<GdbServer>     m_gdbServer;  // set while serving debuggers, drives m_debugger while one is attached
+
+#ifdef BUDGETGB_PROFILER
+	// set while the cpu viewer is profiling, count every instruction and every call of m_core
+	std::unique_ptr<Profiler>     m_profiler;
+	std::unique_ptr<CallProfiler> m_callProfiler;
+
+	// clear the profiler counters, sized for the loaded rom
+	void resetProfiler()
+	{
+		if (m_profiler)
+			m_profiler->reset(m_core.m_cartridge.isLoaded() ? m_core.m_cartridge.getCartInfo().RomSize / 0x4000 : 1);
+
+		if (m_callProfiler)
+			m_callProfiler->reset(m_core.m_bus.getElapsedCycles() / 4);
+
+		m_guiContext.guiProfiler_hotSpots.clear();
+		m_guiContext.guiProfiler_functions.clear();
+		m_guiContext.guiProfiler_inclusiveCycles.clear();
+		m_guiContext.guiProfiler_children.clear();
+		m_guiContext.guiProfiler_refreshCountdown = 0;
+	}
+#endif
+
 	void resetBudgetGB()
 	{
+		if (m_gbsPlayer)
+		{
+			playGbsTrack(m_gbsPlayer->getCurrentTrack());
+			return;
+		}
+
 		if (m_config.useBootrom)
 		{
-			if (!m_cpu.m_bootrom.loadFromFile(m_config.bootromPath))
+			if (!m_core.m_cpu.m_bootrom.loadFromFile(m_config.bootromPath))
 				m_guiContext.flags |= GuiContextFlags_SHOW_BOOTROM_ERROR;
 		}
 
-		m_cpu.init(m_config.useBootrom && m_cpu.m_bootrom.isLoaded());
-		m_bus.init(m_config.useBootrom && m_cpu.m_bootrom.isLoaded());
-		m_apu.init(m_config.useBootrom && m_cpu.m_bootrom.isLoaded());
-		m_disassembler.setProgramCounter(m_cpu.m_programCounter);
+		stopMovie();
+		m_netplay.reset();
+		m_core.reset(m_config.useBootrom && m_core.m_cpu.m_bootrom.isLoaded());
+		m_rewindBuffer.clear();
+		m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
 		m_disassembler.step();
-		m_cartridge.resetMapper();
 
 		// pause/unpause sequence audio to reset audio stream
-		m_apu.pauseAudio();
-		m_apu.resumeAudio();
+		m_audioDevice.pause();
+		m_audioDevice.resume();
 	}
 
+	/**
+	 * @brief Restart gbs playback from the beginning of a track.
+	 */
+	void playGbsTrack(uint8_t track)
+	{
+		m_gbsPlayer->startTrack(track);
+		m_disassembler.setProgramCounter(m_core.m_cpu.m_programCounter);
+		m_disassembler.step();
+
+		// pause/unpause sequence audio to reset audio stream
+		m_audioDevice.pause();
+		m_audioDevice.resume();
+	}
+
+	// save states are kept for roms only, gbs playback is restarted per track instead. Netplay peers have to run the
+	// same frames so states, rewind, movies and fast forward are all off during netplay
+	bool isSaveStateAvailable() const
+	{
+		return m_core.m_cartridge.isLoaded() && !m_gbsPlayer && !m_netplay;
+	}
+
+	/**
+	 * @brief Save or load the save state slot of the loaded rom, stored next to the rom as a .state file.
+	 */
+	void saveStateSlot();
+	void loadStateSlot();
+
+	/**
+	 * @brief Save the loaded rom to its .resume state file on exit or when another rom is loaded, and continue from
+	 * it the next time the rom is loaded instead of starting cold. Does nothing with auto resume turned off.
+	 */
+	void saveResumeState();
+	bool loadResumeState();
+
+	/**
+	 * @brief Record input to the .movie file of the loaded rom, either from power on without the bootrom or from the
+	 * current state. The file is written when recording stops.
+	 */
+	void startMovieRecording(bool fromPowerOn);
+	void startMoviePlayback();
+	void stopMovie();
+
+	/**
+	 * @brief Emulate one rom frame with movie input applied, then record it to the movie and rewind history.
+	 * @param paced Go through Bus::onUpdate(), which skips the frame while the audio buffer is full.
+	 * @return True if a frame ran.
+	 */
+	bool emulateFrame(bool paced);
+
+	/**
+	 * @brief Run one time step of emulation on the emulation thread: a frame, a fast forwarded batch of frames or a
+	 * rewind step, depending on the current mode. Publishes the frame it ends on.
+	 */
+	void emulationStep(float elapsedSeconds);
+
+	// hand the current ppu frame to the ui, with the emulation lock held
+	void publishFrame();
+
+	// buttons held on the keyboard, applied on the emulation thread to whichever joypad takes local input
+	void applyKeyboardInput(uint8_t buttons);
+
+	// apply the commands consumers of the shared memory segment sent since the last step
+	void applySharedMemoryCommands();
+
+	/**
+	 * @brief Start or stop rewinding, audio is paused while rewinding.
+	 */
+	void setRewinding(bool rewinding);
+
+	/**
+	 * @brief Start or stop fast forwarding at the configured speed multiplier. Fixed multipliers time stretch the
+	 * audio to keep its pitch, unlimited speed mutes it.
+	 */
+	void setFastForward(bool fastForward);
+
+	// apply the audio settings for the current fast forward state and speed
+	void updateFastForwardAudio();
+
+	/**
+	 * @brief Run frames back to back for a few milliseconds, only the last one is presented.
+	 * @return Number of frames emulated.
+	 */
+	uint32_t runUnlimitedFrames();
+
+	void updateEffectiveSpeed(uint32_t framesRun, float elapsedSeconds);
+
 	/**
 	 * @brief Resize viewport to fit any arbitary window size while still respecting the 10:9 aspect
 	 * ratio of gameboy display. Will stretch the visible viewport to the window dimensions to the max.
@@ -143,6 +346,18 @@ class BudgetGB
 	 * @brief Top level entry point for gui.
 	 */
 	void guiMain();
+
+	// copy what guiViews() reads, with the emulation lock held
+	void captureGuiViews();
+
+	// the tile and audio views, slow to build so they draw from copies without the emulation lock
+	void guiViews();
 	void guiCpuViewer();
+	void guiBreakpoints();
+#ifdef BUDGETGB_PROFILER
+	void guiProfiler();
+	void guiCallGraphNode(uint32_t node, double totalCycles);
+#endif
 	void guiPalettes();
+	void guiStatusOverlay();
 };
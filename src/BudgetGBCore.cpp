@@ -0,0 +1,233 @@
+#include "BudgetGBCore.h"
+#include "fmt/base.h"
+#include "utils/hash.h"
+#include "utils/mappedFile.h"
+
+#include <fstream>
+
+BudgetGBCore::BudgetGBCore(uint32_t sampleRate, ResamplerQuality quality)
+	: m_cartridge(),
+	  m_bus(m_cartridge, m_cpu, m_ppu, m_apu),
+	  m_cpu(m_bus),
+	  m_ppu(m_cpu.m_interrupts.m_interruptFlags),
+	  m_apu(sampleRate, quality)
+{
+}
+
+bool BudgetGBCore::loadCartridge(const std::string &path, std::vector<std::string> &recentRoms, bool persistSaveRam)
+{
+	return m_cartridge.loadCartridgeFromPath(path, recentRoms, persistSaveRam);
+}
+
+bool BudgetGBCore::loadRom(const std::string &path, bool persistSaveRam)
+{
+	// recent roms are a frontend concern
+	std::vector<std::string> recentRoms;
+
+	if (!loadCartridge(path, recentRoms, persistSaveRam))
+		return false;
+
+	reset(false);
+	return true;
+}
+
+void BudgetGBCore::reset(bool useBootrom)
+{
+	m_cpu.init(useBootrom);
+	m_bus.init(useBootrom);
+	m_apu.init(useBootrom);
+
+	if (m_cartridge.isLoaded())
+		m_cartridge.resetMapper();
+}
+
+bool BudgetGBCore::saveState(Utils::StateWriter &writer)
+{
+	if (!m_cartridge.isLoaded())
+		return false;
+
+	const Mapper::CartInfo &cartInfo = m_cartridge.getCartInfo();
+
+	uint32_t magic       = STATE_MAGIC;
+	uint16_t version     = STATE_VERSION;
+	uint32_t checksums   = cartInfo.Checksums;
+	uint32_t romSize     = cartInfo.RomSize;
+	uint32_t payloadSize = 0;
+
+	writer.begin();
+	writer(magic, version, checksums, romSize);
+
+	const std::size_t payloadSizeOffset = writer.getSize();
+	writer(payloadSize);
+
+	m_cpu.saveState(writer);
+	m_bus.saveState(writer);
+	m_ppu.saveState(writer);
+	m_apu.saveState(writer);
+	m_cartridge.saveState(writer);
+
+	// layout is fixed for a given version and cartridge, a matching size means the payload loads completely
+	payloadSize = static_cast<uint32_t>(writer.getSize() - payloadSizeOffset - sizeof(payloadSize));
+	writer.overwrite(payloadSizeOffset, payloadSize);
+
+	return true;
+}
+
+bool BudgetGBCore::loadState(const uint8_t *data, std::size_t size)
+{
+	if (!m_cartridge.isLoaded())
+		return false;
+
+	const Mapper::CartInfo &cartInfo = m_cartridge.getCartInfo();
+	Utils::StateReader      reader(data, size);
+
+	uint32_t magic       = 0;
+	uint16_t version     = 0;
+	uint32_t checksums   = 0;
+	uint32_t romSize     = 0;
+	uint32_t payloadSize = 0;
+	reader(magic, version, checksums, romSize, payloadSize);
+
+	if (!reader.isOk() || magic != STATE_MAGIC)
+	{
+		fmt::println(stderr, "Not a save state!");
+		return false;
+	}
+
+	if (version != STATE_VERSION)
+	{
+		fmt::println(stderr, "Save state version {} is not supported, expected version {}", version, STATE_VERSION);
+		return false;
+	}
+
+	if (checksums != cartInfo.Checksums || romSize != cartInfo.RomSize)
+	{
+		fmt::println(stderr, "Save state belongs to a different cartridge!");
+		return false;
+	}
+
+	if (payloadSize != reader.getRemaining())
+	{
+		fmt::println(stderr, "Save state is truncated or corrupt!");
+		return false;
+	}
+
+	m_cpu.loadState(reader);
+	m_bus.loadState(reader);
+	m_ppu.loadState(reader);
+	m_apu.loadState(reader);
+	m_cartridge.loadState(reader);
+
+	return reader.isOk() && reader.getRemaining() == 0;
+}
+
+uint64_t BudgetGBCore::hashState()
+{
+	if (!saveState(m_hashWriter))
+		return 0;
+
+	return Utils::hash64(m_hashWriter.getBuffer().data(), m_hashWriter.getSize());
+}
+
+uint64_t BudgetGBCore::hashRam() const
+{
+	if (!m_cartridge.isLoaded())
+		return 0;
+
+	uint64_t hash = m_bus.hashRam(0);
+	hash          = m_ppu.hashRam(hash);
+	return m_cartridge.hashRam(hash);
+}
+
+bool BudgetGBCore::runAhead(uint32_t frames)
+{
+	if (!saveState(m_runAheadWriter))
+		return false;
+
+	m_apu.setOutputEnabled(false);
+	m_cpu.m_serial.setLinkEnabled(false);
+
+	// only the last frame is shown, the caller may have left the real frame undrawn as well
+	const bool outputEnabled = m_ppu.isOutputEnabled();
+
+	for (uint32_t i = 0; i < frames; ++i)
+	{
+		m_ppu.setOutputEnabled(i + 1 == frames);
+		m_bus.runFrame();
+	}
+
+	m_apu.setOutputEnabled(true);
+	m_ppu.setOutputEnabled(outputEnabled);
+	m_cpu.m_serial.setLinkEnabled(true);
+
+	const std::vector<uint8_t> &state = m_runAheadWriter.getBuffer();
+	return loadState(state.data(), state.size());
+}
+
+std::unique_ptr<BudgetGBCore> BudgetGBCore::fork()
+{
+	if (!m_cartridge.isLoaded())
+		return nullptr;
+
+	auto child = std::make_unique<BudgetGBCore>(m_apu.getSampleRate(), m_apu.getQuality());
+	forkInto(*child);
+
+	return child;
+}
+
+bool BudgetGBCore::forkInto(BudgetGBCore &child)
+{
+	if (!m_cartridge.isLoaded() || &child == this)
+		return false;
+
+	child.m_cartridge.cloneFrom(m_cartridge);
+
+	// the cartridge clone already carries the bank registers and shares the ram, everything else goes through the save
+	// state path
+	m_forkWriter.begin();
+	m_cpu.saveState(m_forkWriter);
+	m_bus.saveState(m_forkWriter);
+	m_ppu.saveState(m_forkWriter);
+	m_apu.saveState(m_forkWriter);
+
+	const std::vector<uint8_t> &state = m_forkWriter.getBuffer();
+	Utils::StateReader          reader(state.data(), state.size());
+
+	child.m_cpu.loadState(reader);
+	child.m_bus.loadState(reader);
+	child.m_ppu.loadState(reader);
+	child.m_apu.loadState(reader);
+	child.m_apu.setOutputEnabled(false);
+
+	return reader.isOk();
+}
+
+bool BudgetGBCore::saveStateToFile(const std::string &path)
+{
+	if (!saveState(m_stateFileWriter))
+		return false;
+
+	std::ofstream stateFile(path, std::ios::binary);
+	if (!stateFile.is_open())
+	{
+		fmt::println(stderr, "Failed to open save state at: {}", path);
+		return false;
+	}
+
+	const std::vector<uint8_t> &buffer = m_stateFileWriter.getBuffer();
+	stateFile.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+	return stateFile.good();
+}
+
+bool BudgetGBCore::loadStateFromFile(const std::string &path)
+{
+	Utils::MappedFile stateFile;
+	if (!stateFile.open(path))
+	{
+		fmt::println(stderr, "Failed to open save state at: {}", path);
+		return false;
+	}
+
+	return loadState(stateFile.data(), stateFile.size());
+}
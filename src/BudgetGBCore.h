@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "apu.h"
+#include "bus.h"
+#include "cartridge.h"
+#include "emulatorConstants.h"
+#include "ppu.h"
+#include "sm83.h"
+#include "utils/stateArchive.h"
+
+/**
+ * @brief The emulated gameboy hardware without any window, renderer, audio device or gui attached. Built as the
+ * BudgetGBCore library with no SDL or ImGui dependency, owned by the BudgetGB frontend and used directly for headless
+ * runs.
+ *
+ * Embedding it takes loadRom(), setInput(), runFrame(), getFramebuffer() and readAudio(). The components are public
+ * for the frontend and tools that need more.
+ */
+class BudgetGBCore
+{
+  public:
+	/**
+	 * @brief Construct gameboy hardware.
+	 * @param sampleRate Audio output sample rate.
+	 * @param quality Audio resampler quality tier.
+	 */
+	BudgetGBCore(uint32_t sampleRate = BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality quality = ResamplerQuality::Medium);
+
+	BudgetGBCore(const BudgetGBCore &)            = delete;
+	BudgetGBCore &operator=(const BudgetGBCore &) = delete;
+
+	/**
+	 * @brief Load cartridge from path, does not reset the cpu or bus.
+	 * @param path
+	 * @param recentRoms
+	 * @param persistSaveRam Read and write the .sav file of battery backed cartridges.
+	 * @return True on success, false otherwise.
+	 */
+	bool loadCartridge(const std::string &path, std::vector<std::string> &recentRoms, bool persistSaveRam = true);
+
+	/**
+	 * @brief Load a rom and power on without the bootrom.
+	 * @param persistSaveRam Read and write the .sav file of battery backed cartridges.
+	 * @return True on success, false otherwise.
+	 */
+	bool loadRom(const std::string &path, bool persistSaveRam = false);
+
+	/**
+	 * @brief Hold buttons for the frames that follow, a Joypad::getButtons() mask.
+	 */
+	void setInput(uint8_t buttons)
+	{
+		m_cpu.m_joypad.setButtons(buttons);
+	}
+
+	// colors of the last frame drawn, LCD_WIDTH * LCD_HEIGHT pixels row by row
+	const BudgetGbConstants::LcdColorBuffer &getFramebuffer() const
+	{
+		return m_ppu.getColorBuffer();
+	}
+
+	/**
+	 * @brief Drain mono audio samples at the output sample rate, about one frame's worth is produced per frame run.
+	 * @return Number of samples read.
+	 */
+	uint32_t readAudio(float *buffer, uint32_t size)
+	{
+		return m_apu.readSamples(buffer, nullptr, size);
+	}
+
+	/**
+	 * @brief Power cycle the cpu, bus, apu and cartridge mapper. Bootrom should already be loaded into the cpu if used.
+	 */
+	void reset(bool useBootrom);
+
+	/**
+	 * @brief Snapshot everything that affects execution into writer, replacing its previous contents. Saving again
+	 * into the same writer does not allocate.
+	 * @return True on success, false when no cartridge is loaded.
+	 */
+	bool saveState(Utils::StateWriter &writer);
+
+	/**
+	 * @brief Restore a snapshot taken with saveState(). Snapshots of another state version or cartridge are rejected
+	 * before anything is loaded.
+	 * @return True on success, false otherwise.
+	 */
+	bool loadState(const uint8_t *data, std::size_t size);
+
+	/**
+	 * @brief Hash of everything saveState() saves: cpu registers, wram, hram, vram, oam, cartridge ram and the apu and
+	 * ppu state machines. Equal hashes mean the cores run identically from here on with the same input.
+	 * @return Utils::hash64() of the state, 0 when no cartridge is loaded.
+	 */
+	uint64_t hashState();
+
+	/**
+	 * @brief Cheaper hash of the memory a game can see: wram, hram, vram, oam and cartridge ram. Cores that differ
+	 * only in cpu registers, timers or the apu and ppu state machines hash the same.
+	 * @return Hash, 0 when no cartridge is loaded.
+	 */
+	uint64_t hashRam() const;
+
+	/**
+	 * @brief Save or load a snapshot as a file. Saving reuses its buffer between calls, loading maps the file and
+	 * reads the snapshot straight out of the mapping.
+	 * @return True on success, false otherwise.
+	 */
+	bool saveStateToFile(const std::string &path);
+	bool loadStateFromFile(const std::string &path);
+
+	/**
+	 * @brief Run frames past the current state with audio output muted and only the last frame drawn, then restore
+	 * the current state. The lcd color buffer is not part of the state, it is left showing the last frame that was
+	 * run ahead, so the real frame before it does not need to be drawn either, see PPU::setOutputEnabled().
+	 * @return True on success, false when no cartridge is loaded.
+	 */
+	bool runAhead(uint32_t frames);
+
+	/**
+	 * @brief Create a child core in the current state for exploring several futures of it. The child shares the rom
+	 * with this core and copies cartridge ram pages only once either core writes to them, the rest of the machine is
+	 * copied outright. The child has no audio device and its audio output is disabled. Children are independent of
+	 * this core and of each other and may run on other threads, forking one core from several threads at once is not
+	 * supported.
+	 * @return Child core, nullptr when no cartridge is loaded.
+	 */
+	std::unique_ptr<BudgetGBCore> fork();
+
+	/**
+	 * @brief Fork into an existing core instead of constructing one, reusing it between branches avoids allocating
+	 * its audio buffers again.
+	 * @return True on success, false when no cartridge is loaded.
+	 */
+	bool forkInto(BudgetGBCore &child);
+
+	/**
+	 * @brief Run cpu until the ppu completes a frame, no audio pacing is done.
+	 * @return False if an attached debugger stopped the cpu before the frame completed, see Bus::setFrameHook().
+	 */
+	bool runFrame()
+	{
+		return m_bus.runFrame();
+	}
+
+	Cartridge m_cartridge;
+	Bus       m_bus;
+	Sm83      m_cpu;
+	PPU       m_ppu;
+	Apu       m_apu;
+
+  private:
+	static constexpr uint32_t STATE_MAGIC   = 0x53424742; // "BGBS" little endian
+	static constexpr uint16_t STATE_VERSION = 2;          // bump whenever any component changes what it saves
+
+	Utils::StateWriter m_stateFileWriter;
+	Utils::StateWriter m_runAheadWriter;
+	Utils::StateWriter m_forkWriter;
+	Utils::StateWriter m_hashWriter;
+};
@@ -0,0 +1,128 @@
+#include "CallProfiler.h"
+#include "fmt/base.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <fstream>
+
+CallProfiler::CallProfiler()
+{
+	reset(0);
+}
+
+void CallProfiler::reset(uint64_t cycles)
+{
+	m_nodes.assign(1, Node{ROOT, 0, 0});
+	m_children.clear();
+	m_stack.assign(1, Frame{ROOT, 0x10000});
+	m_stack.reserve(MAX_DEPTH);
+
+	m_lastCycles       = cycles;
+	m_droppedCalls     = 0;
+	m_unmatchedReturns = 0;
+}
+
+std::vector<uint64_t> CallProfiler::getInclusiveCycles() const
+{
+	std::vector<uint64_t> inclusive(m_nodes.size());
+	for (uint32_t node = 0; node < m_nodes.size(); ++node)
+		inclusive[node] = m_nodes[node].SelfCycles;
+
+	// children are always created after their parent, so one pass from the back adds up every subtree
+	for (uint32_t node = static_cast<uint32_t>(m_nodes.size()) - 1; node > ROOT; --node)
+		inclusive[m_nodes[node].Parent] += inclusive[node];
+
+	return inclusive;
+}
+
+std::vector<CallProfiler::Function> CallProfiler::getFunctions() const
+{
+	const std::vector<uint64_t> inclusive = getInclusiveCycles();
+
+	std::unordered_map<uint32_t, Function> functions;
+	for (uint32_t node = ROOT + 1; node < m_nodes.size(); ++node)
+	{
+		const Node &current = m_nodes[node];
+		const uint32_t key  = ((current.Bank & 0xFFFF) << 16) | current.Address;
+
+		Function &function = functions.try_emplace(key, Function{current.Bank, current.Address}).first->second;
+		function.Calls += current.Calls;
+		function.ExclusiveCycles += current.SelfCycles;
+
+		// a recursive call is already inside the inclusive cycles of the outer one
+		bool recursive = false;
+		for (uint32_t parent = current.Parent; parent != ROOT && !recursive; parent = m_nodes[parent].Parent)
+			recursive = m_nodes[parent].Bank == current.Bank && m_nodes[parent].Address == current.Address;
+
+		if (!recursive)
+			function.InclusiveCycles += inclusive[node];
+	}
+
+	std::vector<Function> sorted;
+	sorted.reserve(functions.size());
+	for (const auto &[key, function] : functions)
+		sorted.push_back(function);
+
+	std::sort(sorted.begin(), sorted.end(), [](const Function &a, const Function &b) { return a.InclusiveCycles > b.InclusiveCycles; });
+	return sorted;
+}
+
+std::string CallProfiler::getName(uint32_t node) const
+{
+	if (node == ROOT)
+		return "main";
+
+	const Node &current = m_nodes[node];
+
+	if (current.Bank == 0)
+	{
+		switch (current.Address)
+		{
+		case 0x40:
+			return "vblank";
+		case 0x48:
+			return "stat";
+		case 0x50:
+			return "timer";
+		case 0x58:
+			return "serial";
+		case 0x60:
+			return "joypad";
+		default:
+			break;
+		}
+	}
+
+	return fmt::format("{:02X}:{:04X}", current.Bank, current.Address);
+}
+
+bool CallProfiler::writeFoldedStacks(const std::string &path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		fmt::println(stderr, "Failed to write call graph: {}", path);
+		return false;
+	}
+
+	std::vector<std::string> paths(m_nodes.size());
+	paths[ROOT] = getName(ROOT);
+
+	// parents come before their children, so every parent path is ready when a child needs it
+	for (uint32_t node = 0; node < m_nodes.size(); ++node)
+	{
+		if (node != ROOT)
+			paths[node] = fmt::format("{};{}", paths[m_nodes[node].Parent], getName(node));
+
+		if (m_nodes[node].SelfCycles)
+			file << fmt::format("{} {}\n", paths[node], m_nodes[node].SelfCycles);
+	}
+
+	if (!file)
+	{
+		fmt::println(stderr, "Failed to write call graph: {}", path);
+		return false;
+	}
+
+	return true;
+}
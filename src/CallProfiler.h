@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Call graph of the cpu with inclusive and exclusive m-cycles, built from a shadow stack of calls.
+ *
+ * The cpu reports CALL, RST and interrupt dispatch as calls and RET and RETI as returns, see Sm83::setCallProfiler().
+ * Every path of calls from the root gets its own node, so a function called from two places has two nodes. Cycles
+ * are only counted when the call stack changes, so the cost is per call rather than per instruction.
+ *
+ * Each frame of the shadow stack remembers where its return address was pushed. A return pops every frame at or below
+ * the stack pointer it pops from, which also drops frames whose return address was popped without a return. A return
+ * above the top frame, like a pushed address used as a jump, leaves the stack alone.
+ */
+class CallProfiler
+{
+  public:
+	static constexpr uint32_t MAX_DEPTH = 256; // deeper calls are counted in the caller
+	static constexpr uint32_t ROOT      = 0;   // node of code outside of any call
+
+	struct Node
+	{
+		uint32_t Parent;
+		uint32_t Bank;
+		uint16_t Address; // entry address of the function
+		uint64_t Calls      = 0;
+		uint64_t SelfCycles = 0; // m-cycles
+	};
+
+	struct Function
+	{
+		uint32_t Bank;
+		uint16_t Address;
+		uint64_t Calls           = 0;
+		uint64_t InclusiveCycles = 0; // recursive calls counted once
+		uint64_t ExclusiveCycles = 0;
+	};
+
+	CallProfiler();
+
+	/**
+	 * @brief Clear the call graph and start counting at cycles m-cycles of the cpu.
+	 */
+	void reset(uint64_t cycles);
+
+	// the cpu pushed a return address to stackPointer and jumped to address in bank
+	void call(uint32_t bank, uint16_t address, uint16_t stackPointer, uint64_t cycles)
+	{
+		sync(cycles);
+
+		if (m_stack.size() == MAX_DEPTH)
+		{
+			++m_droppedCalls;
+			return;
+		}
+
+		const uint32_t node = getChild(m_stack.back().Node, bank, address);
+		++m_nodes[node].Calls;
+		m_stack.push_back(Frame{node, stackPointer});
+	}
+
+	// the cpu popped a return address from stackPointer
+	void ret(uint16_t stackPointer, uint64_t cycles)
+	{
+		sync(cycles);
+
+		if (m_stack.back().StackPointer > stackPointer)
+		{
+			++m_unmatchedReturns;
+			return;
+		}
+
+		while (m_stack.back().StackPointer <= stackPointer)
+			m_stack.pop_back();
+	}
+
+	// count the cycles since the last call or return for the running function, before reading the results
+	void sync(uint64_t cycles)
+	{
+		// loading a state can move the clock back
+		if (cycles > m_lastCycles)
+			m_nodes[m_stack.back().Node].SelfCycles += cycles - m_lastCycles;
+
+		m_lastCycles = cycles;
+	}
+
+	const std::vector<Node> &getNodes() const
+	{
+		return m_nodes;
+	}
+
+	/**
+	 * @return Inclusive m-cycles of every node, by node index.
+	 */
+	std::vector<uint64_t> getInclusiveCycles() const;
+
+	/**
+	 * @return Nodes other than the root merged by entry address, most inclusive cycles first.
+	 */
+	std::vector<Function> getFunctions() const;
+
+	// calls past MAX_DEPTH and returns that matched no call, high counts mean the game manages its stack by hand
+	uint64_t getDroppedCalls() const
+	{
+		return m_droppedCalls;
+	}
+
+	uint64_t getUnmatchedReturns() const
+	{
+		return m_unmatchedReturns;
+	}
+
+	/**
+	 * @brief Name of a node in reports, bank:address or the interrupt for interrupt vectors.
+	 */
+	std::string getName(uint32_t node) const;
+
+	/**
+	 * @brief Write exclusive m-cycles of every call path in the folded stacks format of flamegraph.pl, one
+	 * "main;caller;callee cycles" line per node.
+	 * @return True on success, false otherwise.
+	 */
+	bool writeFoldedStacks(const std::string &path) const;
+
+  private:
+	struct Frame
+	{
+		uint32_t Node;
+		uint32_t StackPointer; // where the return address was pushed, above any address for the root
+	};
+
+	std::vector<Node>                      m_nodes;
+	std::unordered_map<uint64_t, uint32_t> m_children; // parent, bank and address to node
+	std::vector<Frame>                     m_stack;
+	uint64_t                               m_lastCycles       = 0;
+	uint64_t                               m_droppedCalls     = 0;
+	uint64_t                               m_unmatchedReturns = 0;
+
+	uint32_t getChild(uint32_t parent, uint32_t bank, uint16_t address)
+	{
+		const uint64_t key = (static_cast<uint64_t>(parent) << 32) | (static_cast<uint64_t>(bank & 0xFFFF) << 16) | address;
+
+		auto [found, inserted] = m_children.try_emplace(key, static_cast<uint32_t>(m_nodes.size()));
+		if (inserted)
+			m_nodes.push_back(Node{parent, bank, address});
+
+		return found->second;
+	}
+};
@@ -0,0 +1,498 @@
+#include "DebugCondition.h"
+#include "BudgetGBCore.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+namespace
+{
+// every name that is not address or value, indices match DebugCondition::Register
+constexpr std::string_view REGISTER_NAMES[] = {"a", "f", "b", "c", "d", "e", "h", "l", "af", "bc", "de", "hl", "sp", "pc", "ly"};
+} // namespace
+
+class DebugCondition::Parser
+{
+  public:
+	Parser(std::string_view source, std::vector<Instruction> &program)
+		: m_source(source), m_program(program)
+	{
+	}
+
+	bool parse(std::string &error)
+	{
+		if (parseBinary(0))
+		{
+			skipSpace();
+
+			if (m_position < m_source.size())
+				fail(fmt::format("Unexpected '{}'", m_source[m_position]));
+			else if (m_maxDepth > MAX_STACK)
+				fail("Expression is too deeply nested");
+		}
+
+		error = m_error;
+		return m_error.empty();
+	}
+
+  private:
+	struct BinaryOperator
+	{
+		std::string_view Token;
+		uint8_t          Precedence;
+		Op               Opcode;
+	};
+
+	// two character tokens come first so <= is not taken for <
+	static constexpr BinaryOperator BINARY_OPERATORS[] = {
+		{"||", 1, Op::LogicalOr},
+		{"&&", 2, Op::LogicalAnd},
+		{"==", 6, Op::Equal},
+		{"!=", 6, Op::NotEqual},
+		{"<=", 7, Op::LessEqual},
+		{">=", 7, Op::GreaterEqual},
+		{"<<", 8, Op::ShiftLeft},
+		{">>", 8, Op::ShiftRight},
+		{"|", 3, Op::Or},
+		{"^", 4, Op::Xor},
+		{"&", 5, Op::And},
+		{"<", 7, Op::Less},
+		{">", 7, Op::Greater},
+		{"+", 9, Op::Add},
+		{"-", 9, Op::Subtract},
+		{"*", 10, Op::Multiply},
+		{"/", 10, Op::Divide},
+		{"%", 10, Op::Modulo},
+	};
+
+	std::string_view          m_source;
+	std::size_t               m_position = 0;
+	std::vector<Instruction> &m_program;
+	uint32_t                  m_depth    = 0; // values on the stack after the instructions emitted so far
+	uint32_t                  m_maxDepth = 0;
+	std::string               m_error;
+
+	bool fail(std::string_view message)
+	{
+		if (m_error.empty())
+			m_error = fmt::format("{} at column {}", message, m_position + 1);
+
+		return false;
+	}
+
+	void skipSpace()
+	{
+		while (m_position < m_source.size() && std::isspace(static_cast<unsigned char>(m_source[m_position])))
+			++m_position;
+	}
+
+	bool accept(char c)
+	{
+		skipSpace();
+
+		if (m_position < m_source.size() && m_source[m_position] == c)
+		{
+			++m_position;
+			return true;
+		}
+
+		return false;
+	}
+
+	void emit(Op opcode, uint32_t operand = 0)
+	{
+		m_program.push_back(Instruction{opcode, operand});
+
+		switch (opcode)
+		{
+		case Op::Push:
+		case Op::Register:
+		case Op::Address:
+		case Op::Value:
+			++m_depth;
+			break;
+		case Op::Load:
+		case Op::Not:
+		case Op::Negate:
+		case Op::Complement:
+			break;
+		default:
+			--m_depth;
+			break;
+		}
+
+		m_maxDepth = std::max(m_maxDepth, m_depth);
+	}
+
+	// precedence climbing, operators of the same precedence associate to the left
+	bool parseBinary(uint8_t minPrecedence)
+	{
+		if (!parseUnary())
+			return false;
+
+		while (true)
+		{
+			skipSpace();
+
+			const BinaryOperator *found = nullptr;
+			for (const BinaryOperator &binaryOperator : BINARY_OPERATORS)
+			{
+				if (m_source.substr(m_position, binaryOperator.Token.size()) == binaryOperator.Token)
+				{
+					found = &binaryOperator;
+					break;
+				}
+			}
+
+			if (!found || found->Precedence < minPrecedence)
+				return true;
+
+			m_position += found->Token.size();
+
+			if (!parseBinary(static_cast<uint8_t>(found->Precedence + 1)))
+				return false;
+
+			emit(found->Opcode);
+		}
+	}
+
+	bool parseUnary()
+	{
+		if (accept('!'))
+		{
+			if (!parseUnary())
+				return false;
+
+			emit(Op::Not);
+			return true;
+		}
+
+		if (accept('~'))
+		{
+			if (!parseUnary())
+				return false;
+
+			emit(Op::Complement);
+			return true;
+		}
+
+		if (accept('-'))
+		{
+			if (!parseUnary())
+				return false;
+
+			emit(Op::Negate);
+			return true;
+		}
+
+		return parsePrimary();
+	}
+
+	bool parsePrimary()
+	{
+		skipSpace();
+
+		if (m_position >= m_source.size())
+			return fail("Expected an operand");
+
+		if (accept('('))
+		{
+			if (!parseBinary(0))
+				return false;
+
+			return accept(')') || fail("Expected ')'");
+		}
+
+		if (accept('['))
+		{
+			if (!parseBinary(0))
+				return false;
+
+			if (!accept(']'))
+				return fail("Expected ']'");
+
+			emit(Op::Load);
+			return true;
+		}
+
+		const char c = m_source[m_position];
+
+		if (c == '$')
+		{
+			++m_position;
+			return parseNumber(16);
+		}
+
+		if (std::isdigit(static_cast<unsigned char>(c)))
+		{
+			if (m_source.substr(m_position, 2) == "0x" || m_source.substr(m_position, 2) == "0X")
+			{
+				m_position += 2;
+				return parseNumber(16);
+			}
+
+			return parseNumber(10);
+		}
+
+		if (std::isalpha(static_cast<unsigned char>(c)))
+			return parseName();
+
+		return fail(fmt::format("Unexpected '{}'", c));
+	}
+
+	bool parseNumber(uint32_t base)
+	{
+		const std::size_t start = m_position;
+		uint64_t          value = 0;
+
+		while (m_position < m_source.size())
+		{
+			const char c     = static_cast<char>(std::tolower(static_cast<unsigned char>(m_source[m_position])));
+			uint32_t   digit = base;
+
+			if (c >= '0' && c <= '9')
+				digit = static_cast<uint32_t>(c - '0');
+			else if (c >= 'a' && c <= 'f')
+				digit = static_cast<uint32_t>(c - 'a' + 10);
+
+			if (digit >= base)
+				break;
+
+			value = value * base + digit;
+			if (value > UINT32_MAX)
+				return fail("Number is too large");
+
+			++m_position;
+		}
+
+		if (m_position == start)
+			return fail("Expected a number");
+
+		emit(Op::Push, static_cast<uint32_t>(value));
+		return true;
+	}
+
+	bool parseName()
+	{
+		const std::size_t start = m_position;
+		std::string       name;
+
+		while (m_position < m_source.size() && std::isalnum(static_cast<unsigned char>(m_source[m_position])))
+			name.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(m_source[m_position++]))));
+
+		if (name == "address")
+		{
+			emit(Op::Address);
+			return true;
+		}
+
+		if (name == "value")
+		{
+			emit(Op::Value);
+			return true;
+		}
+
+		for (uint32_t index = 0; index < std::size(REGISTER_NAMES); ++index)
+		{
+			if (name == REGISTER_NAMES[index])
+			{
+				emit(Op::Register, index);
+				return true;
+			}
+		}
+
+		m_position = start;
+		return fail(fmt::format("Unknown name '{}'", name));
+	}
+};
+
+bool DebugCondition::compile(std::string_view source, std::string &error)
+{
+	m_program.clear();
+	error.clear();
+
+	if (source.find_first_not_of(" \t") == std::string_view::npos)
+		return true;
+
+	if (!Parser(source, m_program).parse(error))
+	{
+		m_program.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool DebugCondition::evaluate(BudgetGBCore &core, uint16_t address, uint8_t value) const
+{
+	if (m_program.empty())
+		return true;
+
+	const Sm83 &cpu = core.m_cpu;
+
+	uint32_t stack[MAX_STACK];
+	uint32_t top = 0; // values on the stack
+
+	for (const Instruction &instruction : m_program)
+	{
+		switch (instruction.Opcode)
+		{
+		case Op::Push:
+			stack[top++] = instruction.Operand;
+			break;
+
+		case Op::Register:
+		{
+			uint32_t registerValue = 0;
+			switch (instruction.Operand)
+			{
+			case REGISTER_A:
+				registerValue = cpu.m_registerAF.accumulator;
+				break;
+			case REGISTER_F:
+				registerValue = cpu.m_registerAF.flags.getFlagsU8();
+				break;
+			case REGISTER_B:
+				registerValue = cpu.m_registerBC.hi;
+				break;
+			case REGISTER_C:
+				registerValue = cpu.m_registerBC.lo;
+				break;
+			case REGISTER_D:
+				registerValue = cpu.m_registerDE.hi;
+				break;
+			case REGISTER_E:
+				registerValue = cpu.m_registerDE.lo;
+				break;
+			case REGISTER_H:
+				registerValue = cpu.m_registerHL.hi;
+				break;
+			case REGISTER_L:
+				registerValue = cpu.m_registerHL.lo;
+				break;
+			case REGISTER_AF:
+				registerValue = cpu.m_registerAF.get_u16();
+				break;
+			case REGISTER_BC:
+				registerValue = cpu.m_registerBC.get_u16();
+				break;
+			case REGISTER_DE:
+				registerValue = cpu.m_registerDE.get_u16();
+				break;
+			case REGISTER_HL:
+				registerValue = cpu.m_registerHL.get_u16();
+				break;
+			case REGISTER_SP:
+				registerValue = cpu.m_stackPointer;
+				break;
+			case REGISTER_PC:
+				registerValue = cpu.m_programCounter;
+				break;
+			case REGISTER_LY:
+				registerValue = core.m_ppu.getLcdY();
+				break;
+			default:
+				break;
+			}
+
+			stack[top++] = registerValue;
+			break;
+		}
+
+		case Op::Address:
+			stack[top++] = address;
+			break;
+
+		case Op::Value:
+			stack[top++] = value;
+			break;
+
+		case Op::Load:
+			stack[top - 1] = core.m_bus.busReadRaw(static_cast<uint16_t>(stack[top - 1]));
+			break;
+
+		case Op::Not:
+			stack[top - 1] = !stack[top - 1];
+			break;
+
+		case Op::Negate:
+			stack[top - 1] = 0u - stack[top - 1];
+			break;
+
+		case Op::Complement:
+			stack[top - 1] = ~stack[top - 1];
+			break;
+
+		default:
+		{
+			const uint32_t right = stack[--top];
+			uint32_t      &left  = stack[top - 1];
+
+			switch (instruction.Opcode)
+			{
+			case Op::LogicalOr:
+				left = left || right;
+				break;
+			case Op::LogicalAnd:
+				left = left && right;
+				break;
+			case Op::Or:
+				left |= right;
+				break;
+			case Op::Xor:
+				left ^= right;
+				break;
+			case Op::And:
+				left &= right;
+				break;
+			case Op::Equal:
+				left = left == right;
+				break;
+			case Op::NotEqual:
+				left = left != right;
+				break;
+			case Op::Less:
+				left = left < right;
+				break;
+			case Op::LessEqual:
+				left = left <= right;
+				break;
+			case Op::Greater:
+				left = left > right;
+				break;
+			case Op::GreaterEqual:
+				left = left >= right;
+				break;
+			case Op::ShiftLeft:
+				left = right < 32 ? left << right : 0;
+				break;
+			case Op::ShiftRight:
+				left = right < 32 ? left >> right : 0;
+				break;
+			case Op::Add:
+				left += right;
+				break;
+			case Op::Subtract:
+				left -= right;
+				break;
+			case Op::Multiply:
+				left *= right;
+				break;
+			// division by zero gives zero rather than stopping the emulator
+			case Op::Divide:
+				left = right ? left / right : 0;
+				break;
+			case Op::Modulo:
+				left = right ? left % right : 0;
+				break;
+			default:
+				break;
+			}
+			break;
+		}
+		}
+	}
+
+	return stack[0] != 0;
+}
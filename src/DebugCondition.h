@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class BudgetGBCore;
+
+/**
+ * @brief Condition of a breakpoint or watchpoint, compiled once to a small stack bytecode so a hit only runs a few
+ * instructions instead of parsing the expression again.
+ *
+ * Expressions use C operators and precedence: || && | ^ & == != < <= > >= << >> + - * / % and the unary ! ~ -.
+ * Operands are decimal numbers, hex numbers written as 0x1F or $1F, the registers a f b c d e h l af bc de hl sp pc,
+ * ly for the current lcd line, [expr] for the byte at an address, and for watchpoints address and value for the
+ * accessed address and the byte read or written. Values are unsigned 32 bit, a condition holds when it is not zero.
+ */
+class DebugCondition
+{
+  public:
+	static constexpr uint32_t MAX_STACK = 16;
+
+	/**
+	 * @brief Compile source, an empty source compiles to a condition that always holds.
+	 * @param error Set to a description of the problem when compiling fails.
+	 * @return True on success, false otherwise. The condition is left empty on failure.
+	 */
+	bool compile(std::string_view source, std::string &error);
+
+	/**
+	 * @param address Accessed address for watchpoints, the program counter for breakpoints.
+	 * @param value Byte read or written for watchpoints, 0 for breakpoints.
+	 */
+	bool evaluate(BudgetGBCore &core, uint16_t address, uint8_t value) const;
+
+	bool isEmpty() const
+	{
+		return m_program.empty();
+	}
+
+  private:
+	enum class Op : uint8_t
+	{
+		Push, // Operand is the constant
+		Register, // Operand is a Register
+		Address,
+		Value,
+		Load, // replaces the top of the stack with the byte at that address
+
+		Not,
+		Negate,
+		Complement,
+
+		// binary operators pop the right then the left operand and push the result
+		LogicalOr,
+		LogicalAnd,
+		Or,
+		Xor,
+		And,
+		Equal,
+		NotEqual,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+		ShiftLeft,
+		ShiftRight,
+		Add,
+		Subtract,
+		Multiply,
+		Divide,
+		Modulo,
+	};
+
+	enum Register : uint8_t
+	{
+		REGISTER_A,
+		REGISTER_F,
+		REGISTER_B,
+		REGISTER_C,
+		REGISTER_D,
+		REGISTER_E,
+		REGISTER_H,
+		REGISTER_L,
+		REGISTER_AF,
+		REGISTER_BC,
+		REGISTER_DE,
+		REGISTER_HL,
+		REGISTER_SP,
+		REGISTER_PC,
+		REGISTER_LY,
+	};
+
+	struct Instruction
+	{
+		Op       Opcode;
+		uint32_t Operand;
+	};
+
+	std::vector<Instruction> m_program;
+
+	class Parser;
+};
@@ -0,0 +1,246 @@
+#include "Debugger.h"
+
+#include <algorithm>
+#include <array>
+
+Debugger::Debugger(BudgetGBCore &core)
+	: m_core(core)
+{
+	m_core.m_bus.setAccessTrap([this](uint16_t position, uint8_t data, bool write) { onAccess(position, data, write); });
+}
+
+Debugger::~Debugger()
+{
+	m_core.m_bus.clearPageTraps();
+	m_core.m_bus.setAccessTrap(nullptr);
+
+	if (m_hooked)
+		m_core.m_bus.setFrameHook(nullptr);
+}
+
+bool Debugger::addBreakpoint(uint16_t address, std::string_view condition, std::string &error)
+{
+	Breakpoint breakpoint;
+	if (!breakpoint.Program.compile(condition, error))
+		return false;
+
+	breakpoint.Address   = address;
+	breakpoint.Condition = condition;
+
+	m_breakpoints.push_back(std::move(breakpoint));
+	update();
+	return true;
+}
+
+bool Debugger::addWatchpoint(uint16_t start, uint16_t end, uint8_t flags, std::string_view condition, std::string &error)
+{
+	if (end < start || !(flags & (WATCH_READ | WATCH_WRITE)))
+	{
+		error = "Watchpoint needs a range and read or write access";
+		return false;
+	}
+
+	Watchpoint watchpoint;
+	if (!watchpoint.Program.compile(condition, error))
+		return false;
+
+	watchpoint.Start     = start;
+	watchpoint.End       = end;
+	watchpoint.Flags     = flags;
+	watchpoint.Condition = condition;
+
+	m_watchpoints.push_back(std::move(watchpoint));
+	update();
+	return true;
+}
+
+bool Debugger::removeBreakpoint(uint16_t address)
+{
+	auto found = std::find_if(m_breakpoints.begin(), m_breakpoints.end(), [address](const Breakpoint &breakpoint) { return breakpoint.Address == address; });
+	if (found == m_breakpoints.end())
+		return false;
+
+	m_breakpoints.erase(found);
+	update();
+	return true;
+}
+
+bool Debugger::removeWatchpoint(uint16_t start, uint16_t end, uint8_t flags)
+{
+	auto found = std::find_if(m_watchpoints.begin(), m_watchpoints.end(), [=](const Watchpoint &watchpoint) {
+		return watchpoint.Start == start && watchpoint.End == end && watchpoint.Flags == flags;
+	});
+
+	if (found == m_watchpoints.end())
+		return false;
+
+	m_watchpoints.erase(found);
+	update();
+	return true;
+}
+
+void Debugger::clear()
+{
+	m_breakpoints.clear();
+	m_watchpoints.clear();
+	update();
+}
+
+void Debugger::update()
+{
+	m_breakpointMap.reset();
+	for (const Breakpoint &breakpoint : m_breakpoints)
+	{
+		if (breakpoint.Enabled)
+			m_breakpointMap[breakpoint.Address] = true;
+	}
+
+	std::array<uint8_t, 256> pageFlags{};
+	for (const Watchpoint &watchpoint : m_watchpoints)
+	{
+		if (!watchpoint.Enabled)
+			continue;
+
+		for (uint32_t page = watchpoint.Start >> 8; page <= static_cast<uint32_t>(watchpoint.End >> 8); ++page)
+			pageFlags[page] |= watchpoint.Flags;
+	}
+
+	for (uint32_t page = 0; page < pageFlags.size(); ++page)
+		m_core.m_bus.setPageTrap(static_cast<uint8_t>(page), pageFlags[page] & WATCH_READ, pageFlags[page] & WATCH_WRITE);
+
+	updateHook();
+}
+
+void Debugger::pause()
+{
+	stop(Stop{StopReason::Pause, m_core.m_cpu.m_programCounter});
+	updateHook();
+}
+
+void Debugger::resume()
+{
+	m_stopped          = false;
+	m_stepping         = false;
+	m_skipBreakpointAt = m_core.m_cpu.m_programCounter;
+	updateHook();
+}
+
+void Debugger::step()
+{
+	resume();
+	m_stepping = true;
+	updateHook();
+}
+
+void Debugger::setClient(Client *client)
+{
+	m_client = client;
+	updateHook();
+}
+
+bool Debugger::runFrame()
+{
+	if (m_client)
+		m_client->onFrame();
+
+	if (m_stopped)
+		return false;
+
+	Sm83 &cpu = m_core.m_cpu;
+
+	while (true)
+	{
+		const uint16_t programCounter = cpu.m_programCounter;
+
+		if (m_breakpointMap[programCounter] && programCounter != m_skipBreakpointAt && isBreakpointHit(programCounter))
+		{
+			stop(Stop{StopReason::Breakpoint, programCounter});
+			return false;
+		}
+
+		m_skipBreakpointAt = -1;
+		cpu.instructionStep();
+
+		const bool frameComplete = m_core.m_ppu.isFrameComplete();
+
+		if (m_watchHit)
+		{
+			m_watchHit = false;
+			stop(m_pendingStop);
+			return frameComplete;
+		}
+
+		if (m_stepping)
+		{
+			stop(Stop{StopReason::Step, cpu.m_programCounter});
+			return frameComplete;
+		}
+
+		if (frameComplete)
+			return true;
+	}
+}
+
+void Debugger::onAccess(uint16_t position, uint8_t data, bool write)
+{
+	// the first hit of an instruction is the one reported
+	if (m_watchHit)
+		return;
+
+	const uint8_t access = write ? WATCH_WRITE : WATCH_READ;
+
+	for (Watchpoint &watchpoint : m_watchpoints)
+	{
+		if (!watchpoint.Enabled || !(watchpoint.Flags & access) || position < watchpoint.Start || position > watchpoint.End)
+			continue;
+
+		if (!watchpoint.Program.evaluate(m_core, position, data))
+			continue;
+
+		++watchpoint.Hits;
+
+		m_watchHit    = true;
+		m_pendingStop = Stop{StopReason::Watchpoint, position, data, write, watchpoint.Flags};
+		return;
+	}
+}
+
+bool Debugger::isBreakpointHit(uint16_t address)
+{
+	for (Breakpoint &breakpoint : m_breakpoints)
+	{
+		if (breakpoint.Enabled && breakpoint.Address == address && breakpoint.Program.evaluate(m_core, address, 0))
+		{
+			++breakpoint.Hits;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Debugger::stop(const Stop &stop)
+{
+	m_stopped  = true;
+	m_stepping = false;
+	m_stop     = stop;
+
+	if (m_client)
+		m_client->onStop(stop);
+}
+
+void Debugger::updateHook()
+{
+	const bool enabledWatchpoint = std::any_of(m_watchpoints.begin(), m_watchpoints.end(), [](const Watchpoint &watchpoint) { return watchpoint.Enabled; });
+	const bool hook              = m_client || m_stopped || m_stepping || m_breakpointMap.any() || enabledWatchpoint;
+
+	if (hook == m_hooked)
+		return;
+
+	m_hooked = hook;
+
+	if (hook)
+		m_core.m_bus.setFrameHook([this]() { return runFrame(); });
+	else
+		m_core.m_bus.setFrameHook(nullptr);
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BudgetGBCore.h"
+#include "DebugCondition.h"
+
+/**
+ * @brief Execution breakpoints and memory watchpoints of a core, with optional conditions, shared by the cpu viewer
+ * and the gdb server.
+ *
+ * With nothing enabled the core runs its own frame loop untouched. Enabling a breakpoint hooks the frame loop of the
+ * bus with one that checks the program counter against a bitmap before every instruction, see Bus::setFrameHook().
+ * Watchpoints trap the 256 byte pages they cover in the page table of the bus, see Bus::setPageTrap(), so only cpu
+ * accesses to those pages pay for a range check. A watchpoint hit stops the core after the instruction that made the
+ * access.
+ *
+ * A stopped core returns from runFrame() without running, until resume() or step().
+ */
+class Debugger
+{
+  public:
+	enum WatchFlags : uint8_t
+	{
+		WATCH_READ  = 1 << 0,
+		WATCH_WRITE = 1 << 1,
+	};
+
+	enum class StopReason
+	{
+		None,
+		Pause,
+		Step,
+		Breakpoint,
+		Watchpoint,
+	};
+
+	struct Stop
+	{
+		StopReason Reason  = StopReason::None;
+		uint16_t   Address = 0;     // program counter, or the watched address that was accessed
+		uint8_t    Value   = 0;     // byte read or written for watchpoints
+		bool       Write   = false; // the watchpoint access was a write
+		uint8_t    Flags   = 0;     // WatchFlags of the watchpoint that was hit
+	};
+
+	struct Breakpoint
+	{
+		uint16_t       Address = 0;
+		bool           Enabled = true;
+		std::string    Condition; // source of Program
+		DebugCondition Program;
+		uint32_t       Hits = 0;
+	};
+
+	struct Watchpoint
+	{
+		uint16_t       Start   = 0;
+		uint16_t       End     = 0; // inclusive
+		uint8_t        Flags   = 0; // WatchFlags
+		bool           Enabled = true;
+		std::string    Condition; // source of Program, address and value are the accessed address and byte
+		DebugCondition Program;
+		uint32_t       Hits = 0;
+	};
+
+	/**
+	 * @brief A remote debugger driving this one, such as the gdb server. Keeps the frame loop hooked while set.
+	 */
+	class Client
+	{
+	  public:
+		virtual ~Client() = default;
+
+		// called at the start of every hooked frame, before a stopped core returns from it
+		virtual void onFrame() = 0;
+		virtual void onStop(const Stop &stop) = 0;
+	};
+
+	explicit Debugger(BudgetGBCore &core);
+	~Debugger();
+
+	Debugger(const Debugger &)            = delete;
+	Debugger &operator=(const Debugger &) = delete;
+
+	/**
+	 * @param condition Expression compiled with DebugCondition, empty breaks on every hit.
+	 * @param error Set to the compile error when the condition does not compile.
+	 * @return True on success, false otherwise.
+	 */
+	bool addBreakpoint(uint16_t address, std::string_view condition, std::string &error);
+	bool addWatchpoint(uint16_t start, uint16_t end, uint8_t flags, std::string_view condition, std::string &error);
+
+	// remove the first breakpoint or watchpoint that matches exactly, returns false if there is none
+	bool removeBreakpoint(uint16_t address);
+	bool removeWatchpoint(uint16_t start, uint16_t end, uint8_t flags);
+
+	void clear();
+
+	/**
+	 * @brief Breakpoints and watchpoints can be enabled, disabled or erased in place, call update() afterwards.
+	 */
+	std::vector<Breakpoint> &getBreakpoints()
+	{
+		return m_breakpoints;
+	}
+
+	std::vector<Watchpoint> &getWatchpoints()
+	{
+		return m_watchpoints;
+	}
+
+	// rebuild the breakpoint bitmap and the page traps, and hook or unhook the frame loop
+	void update();
+
+	/**
+	 * @brief Stop before the next instruction. Called between frames or from Client::onFrame(), tells the client like
+	 * any other stop.
+	 */
+	void pause();
+
+	/**
+	 * @brief Run from a stop, the instruction at the program counter runs even with a breakpoint on it.
+	 */
+	void resume();
+
+	// resume for one instruction
+	void step();
+
+	bool isStopped() const
+	{
+		return m_stopped;
+	}
+
+	// why the core last stopped
+	const Stop &getStop() const
+	{
+		return m_stop;
+	}
+
+	/**
+	 * @brief Set or remove the client. Must not be called from inside the frame loop, such as from the client itself.
+	 */
+	void setClient(Client *client);
+
+	// the frame loop of the bus goes through the debugger, run ahead and the like should stay off
+	bool isHooked() const
+	{
+		return m_hooked;
+	}
+
+  private:
+	BudgetGBCore &m_core;
+	Client       *m_client = nullptr;
+
+	std::vector<Breakpoint> m_breakpoints;
+	std::vector<Watchpoint> m_watchpoints;
+	std::bitset<0x10000>    m_breakpointMap; // addresses with an enabled breakpoint
+
+	bool    m_hooked           = false;
+	bool    m_stopped          = false;
+	bool    m_stepping         = false; // stop after the next instruction
+	bool    m_watchHit         = false; // a watchpoint was hit by the running instruction, see m_pendingStop
+	int32_t m_skipBreakpointAt = -1;    // program counter resumed from, its breakpoints are skipped once
+	Stop    m_stop;
+	Stop    m_pendingStop;
+
+	// frame loop of the bus while hooked
+	bool runFrame();
+
+	// access trap of the bus, for cpu accesses to pages with an enabled watchpoint
+	void onAccess(uint16_t position, uint8_t data, bool write);
+
+	// true if an enabled breakpoint at address has a condition that holds, counting the hit
+	bool isBreakpointHit(uint16_t address);
+
+	void stop(const Stop &stop);
+	void updateHook();
+};
@@ -0,0 +1,112 @@
+#include "EmulationThread.h"
+
+#include <utility>
+
+EmulationThread::~EmulationThread()
+{
+	stop();
+}
+
+void EmulationThread::start(Clock::duration stepPeriod, std::function<void(float)> step)
+{
+	stop();
+
+	m_step       = std::move(step);
+	m_stepPeriod = stepPeriod;
+	m_stats      = Stats{};
+	m_running    = true;
+	m_thread     = std::thread(&EmulationThread::threadLoop, this);
+}
+
+void EmulationThread::stop()
+{
+	if (!m_thread.joinable())
+		return;
+
+	m_running = false;
+	m_thread.join();
+
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	m_commands.clear();
+}
+
+void EmulationThread::post(std::function<void()> command)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	m_commands.push_back(std::move(command));
+}
+
+std::unique_lock<std::mutex> EmulationThread::lock()
+{
+	m_lockWaiters.fetch_add(1, std::memory_order_relaxed);
+	std::unique_lock<std::mutex> lock(m_emulationMutex);
+	m_lockWaiters.fetch_sub(1, std::memory_order_relaxed);
+
+	return lock;
+}
+
+void EmulationThread::threadLoop()
+{
+	constexpr auto LATE_THRESHOLD = std::chrono::milliseconds(1);
+
+	Clock::time_point deadline  = Clock::now();
+	Clock::time_point lastStart = deadline;
+
+	std::vector<std::function<void()>> commands;
+
+	while (m_running.load(std::memory_order_relaxed))
+	{
+		if (m_paced.load(std::memory_order_relaxed))
+		{
+			deadline += m_stepPeriod;
+
+			// steps behind schedule run back to back until caught up, a long stall restarts the pacing instead
+			const Clock::time_point now = Clock::now();
+			if (now - deadline > m_stepPeriod * MAX_CATCH_UP_STEPS)
+			{
+				std::lock_guard<std::mutex> lock(m_emulationMutex);
+				m_stats.DroppedSteps += (now - deadline) / m_stepPeriod;
+				deadline = now;
+			}
+
+			waitUntil(deadline);
+		}
+		else
+			deadline = Clock::now();
+
+		{
+			std::lock_guard<std::mutex> lock(m_emulationMutex);
+
+			{
+				std::lock_guard<std::mutex> commandLock(m_commandMutex);
+				commands.swap(m_commands);
+			}
+
+			for (auto &command : commands)
+				command();
+
+			commands.clear();
+
+			const Clock::time_point start = Clock::now();
+			m_stats.Steps += 1;
+			m_stats.LateSteps += start - deadline > LATE_THRESHOLD;
+
+			m_step(std::chrono::duration<float>(start - lastStart).count());
+			lastStart = start;
+		}
+
+		// a thread waiting on lock() goes first, the mutex alone would likely be retaken right away
+		while (m_lockWaiters.load(std::memory_order_relaxed) > 0 && m_running.load(std::memory_order_relaxed))
+			std::this_thread::yield();
+	}
+}
+
+void EmulationThread::waitUntil(Clock::time_point deadline)
+{
+	constexpr auto SPIN_MARGIN = std::chrono::milliseconds(2);
+
+	std::this_thread::sleep_until(deadline - SPIN_MARGIN);
+
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs emulation on its own thread, paced by the high resolution clock rather than by the ui loop. Every step
+ * runs with the emulation lock held, other threads take the same lock to read or change the emulation state between
+ * steps, or post commands that run on the emulation thread before its next step.
+ */
+class EmulationThread
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	// a step that falls further behind than this is not caught up on, pacing starts over from the current time
+	static constexpr uint32_t MAX_CATCH_UP_STEPS = 4;
+
+	struct Stats
+	{
+		uint64_t Steps        = 0;
+		uint64_t LateSteps    = 0; // started more than a millisecond after their deadline
+		uint64_t DroppedSteps = 0; // skipped by restarting the pacing after a stall
+	};
+
+	EmulationThread() = default;
+	~EmulationThread();
+
+	EmulationThread(const EmulationThread &)            = delete;
+	EmulationThread &operator=(const EmulationThread &) = delete;
+
+	/**
+	 * @brief Start calling step once every stepPeriod on a new thread.
+	 * @param step Called with the emulation lock held and the seconds since the previous step started.
+	 */
+	void start(Clock::duration stepPeriod, std::function<void(float)> step);
+
+	// finish the running step and join the thread, commands still queued are dropped
+	void stop();
+
+	/**
+	 * @brief Queue a command to run on the emulation thread with the emulation lock held, before the next step.
+	 */
+	void post(std::function<void()> command);
+
+	/**
+	 * @brief Take the emulation lock, waits for a running step to finish. The emulation thread lets a waiting lock go
+	 * first before its next step. Must not be called from a step or command.
+	 */
+	std::unique_lock<std::mutex> lock();
+
+	/**
+	 * @brief Unpaced steps run back to back, for running as fast as possible.
+	 */
+	void setPaced(bool paced)
+	{
+		m_paced.store(paced, std::memory_order_relaxed);
+	}
+
+	bool isRunning() const
+	{
+		return m_thread.joinable();
+	}
+
+	// read with the emulation lock held
+	const Stats &getStats() const
+	{
+		return m_stats;
+	}
+
+  private:
+	std::thread                m_thread;
+	std::function<void(float)> m_step;
+	Clock::duration            m_stepPeriod{};
+
+	std::mutex            m_emulationMutex; // held for every step and command
+	std::atomic<uint32_t> m_lockWaiters = 0;
+	std::atomic<bool>     m_running     = false;
+	std::atomic<bool>     m_paced       = true;
+
+	std::mutex                         m_commandMutex;
+	std::vector<std::function<void()>> m_commands;
+
+	Stats m_stats;
+
+	void threadLoop();
+
+	// sleep most of the way to deadline and yield the rest, sleeps alone overshoot by up to a scheduler tick
+	static void waitUntil(Clock::time_point deadline);
+};
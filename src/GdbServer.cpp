@@ -0,0 +1,576 @@
+#include "GdbServer.h"
+#include "fmt/base.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+void appendHex(std::string &out, uint8_t value)
+{
+	out.push_back(HEX_DIGITS[value >> 4]);
+	out.push_back(HEX_DIGITS[value & 0xF]);
+}
+
+int32_t hexDigit(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+
+	return -1;
+}
+
+// parse a whole string of hex digits, as sent for addresses and lengths
+bool parseHex(std::string_view text, uint32_t &value)
+{
+	if (text.empty() || text.size() > 8)
+		return false;
+
+	value = 0;
+	for (char c : text)
+	{
+		const int32_t digit = hexDigit(c);
+		if (digit < 0)
+			return false;
+
+		value = value << 4 | static_cast<uint32_t>(digit);
+	}
+
+	return true;
+}
+
+// parse a 16 bit register value, sent as little endian bytes
+bool parseRegister(std::string_view text, uint16_t &value)
+{
+	uint32_t lo = 0, hi = 0;
+	if (text.size() != 4 || !parseHex(text.substr(0, 2), lo) || !parseHex(text.substr(2, 2), hi))
+		return false;
+
+	value = static_cast<uint16_t>(hi << 8 | lo);
+	return true;
+}
+
+// split "address,length" with an optional ":data" tail
+bool parseAddressLength(std::string_view arguments, uint32_t &address, uint32_t &length, std::string_view *data = nullptr)
+{
+	const std::size_t comma = arguments.find(',');
+	const std::size_t colon = arguments.find(':');
+
+	if (comma == std::string_view::npos || (data && colon == std::string_view::npos))
+		return false;
+
+	const std::size_t lengthEnd = data ? colon : arguments.size();
+	if (lengthEnd < comma)
+		return false;
+
+	if (data)
+		*data = arguments.substr(colon + 1);
+
+	return parseHex(arguments.substr(0, comma), address) && parseHex(arguments.substr(comma + 1, lengthEnd - comma - 1), length);
+}
+} // namespace
+
+GdbServer::GdbServer(BudgetGBCore &core, Debugger &debugger)
+	: m_core(core), m_debugger(debugger)
+{
+}
+
+GdbServer::~GdbServer()
+{
+	close();
+}
+
+bool GdbServer::listen(uint16_t port)
+{
+	close();
+
+	if (!m_listener.listen(port))
+		return false;
+
+	m_killRequested = false;
+	return true;
+}
+
+void GdbServer::close()
+{
+	detach();
+	m_listener.close();
+	poll();
+}
+
+void GdbServer::poll()
+{
+	if (!m_client.isOpen() && m_listener.accept(m_client))
+	{
+		// a debugger expects the target to be stopped when it attaches, it asks why with ? rather than being told
+		m_debugger.pause();
+		m_lastStop = "S05";
+		m_input.clear();
+
+		fmt::println("Debugger attached");
+	}
+
+	const bool attached = m_client.isOpen();
+	if (attached == m_attached)
+		return;
+
+	m_attached = attached;
+
+	if (attached)
+		m_debugger.setClient(this);
+	else
+	{
+		detach();
+		m_debugger.setClient(nullptr);
+		fmt::println("Debugger detached");
+	}
+}
+
+void GdbServer::onFrame()
+{
+	using Clock = std::chrono::steady_clock;
+
+	service();
+
+	// the debugger hung up, let the core run until poll() notices
+	if (!m_client.isOpen())
+	{
+		detach();
+		return;
+	}
+
+	if (!m_debugger.isStopped())
+		return;
+
+	const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(STOPPED_SERVICE_MS);
+
+	for (Clock::time_point now = Clock::now(); m_debugger.isStopped() && m_client.isOpen() && now < deadline; now = Clock::now())
+	{
+		const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+		if (m_client.waitReadable(static_cast<uint32_t>(std::max<int64_t>(remaining, 1))))
+			service();
+	}
+
+	if (!m_client.isOpen())
+		detach();
+}
+
+void GdbServer::onStop(const Debugger::Stop &stop)
+{
+	switch (stop.Reason)
+	{
+	case Debugger::StopReason::Breakpoint:
+		++m_stats.BreakpointHits;
+		m_lastStop = "T05swbreak:;";
+		break;
+
+	case Debugger::StopReason::Watchpoint:
+	{
+		const bool read  = stop.Flags & Debugger::WATCH_READ;
+		const bool write = stop.Flags & Debugger::WATCH_WRITE;
+
+		++m_stats.WatchpointHits;
+		m_lastStop = fmt::format("T05{}:{:x};", read && write ? "awatch" : (read ? "rwatch" : "watch"), stop.Address);
+		break;
+	}
+
+	case Debugger::StopReason::Pause:
+		m_lastStop = "T02";
+		break;
+
+	default:
+		m_lastStop = "T05";
+		break;
+	}
+
+	if (m_client.isOpen())
+		sendPacket(m_lastStop);
+}
+
+void GdbServer::service()
+{
+	char        buffer[1024];
+	std::size_t size;
+	while ((size = m_client.receive(buffer, sizeof(buffer))) > 0)
+		m_input.append(buffer, size);
+
+	std::size_t position = 0;
+	while (position < m_input.size())
+	{
+		const char c = m_input[position];
+
+		// an interrupt from the debugger, sent outside of any packet
+		if (c == '\x03')
+		{
+			++position;
+			if (!m_debugger.isStopped())
+				m_debugger.pause();
+
+			continue;
+		}
+
+		// acks and anything between packets
+		if (c != '$')
+		{
+			++position;
+			continue;
+		}
+
+		const std::size_t hash = m_input.find('#', position);
+		if (hash == std::string::npos || hash + 2 >= m_input.size())
+			break;
+
+		const std::string_view payload(m_input.data() + position + 1, hash - position - 1);
+
+		uint32_t checksum = 0;
+		parseHex(std::string_view(m_input.data() + hash + 1, 2), checksum);
+
+		uint8_t sum = 0;
+		for (char payloadChar : payload)
+			sum = static_cast<uint8_t>(sum + static_cast<uint8_t>(payloadChar));
+
+		if (sum != checksum)
+			m_client.send("-", 1);
+		else
+		{
+			m_client.send("+", 1);
+			++m_stats.Packets;
+			handlePacket(payload);
+		}
+
+		position = hash + 3;
+	}
+
+	m_input.erase(0, position);
+
+	// a packet that never ends is garbage
+	if (m_input.size() > MAX_PACKET_SIZE * 2)
+		m_input.clear();
+}
+
+void GdbServer::handlePacket(std::string_view packet)
+{
+	const std::string_view arguments = packet.substr(1);
+
+	switch (packet[0])
+	{
+	case '?':
+		sendPacket(m_lastStop);
+		break;
+
+	case 'g':
+		sendPacket(readRegisters());
+		break;
+
+	case 'G':
+	{
+		bool ok = arguments.size() == 6 * 4;
+		for (uint32_t index = 0; ok && index < 6; ++index)
+		{
+			uint16_t value = 0;
+			ok             = parseRegister(arguments.substr(index * 4, 4), value) && writeRegister(index, value);
+		}
+
+		sendPacket(ok ? "OK" : "E01");
+		break;
+	}
+
+	case 'p':
+	{
+		uint32_t index = 0;
+		if (parseHex(arguments, index) && index < 6)
+			sendPacket(readRegisters().substr(index * 4, 4));
+		else
+			sendPacket("E01");
+		break;
+	}
+
+	case 'P':
+	{
+		const std::size_t equals = arguments.find('=');
+		uint32_t          index  = 0;
+		uint16_t          value  = 0;
+
+		const bool ok = equals != std::string_view::npos && parseHex(arguments.substr(0, equals), index) &&
+		                parseRegister(arguments.substr(equals + 1), value) && writeRegister(index, value);
+
+		sendPacket(ok ? "OK" : "E01");
+		break;
+	}
+
+	case 'm':
+		readMemory(arguments);
+		break;
+
+	case 'M':
+		writeMemory(arguments);
+		break;
+
+	case 'c':
+		resume(arguments, false);
+		break;
+
+	case 's':
+		resume(arguments, true);
+		break;
+
+	case 'Z':
+		setBreakpoint(arguments, true);
+		break;
+
+	case 'z':
+		setBreakpoint(arguments, false);
+		break;
+
+	case 'H':
+	case 'T':
+		sendPacket("OK");
+		break;
+
+	case 'D':
+		sendPacket("OK");
+		detach();
+		break;
+
+	case 'k':
+		m_killRequested = true;
+		detach();
+		break;
+
+	case 'q':
+		if (packet.rfind("qSupported", 0) == 0)
+			sendPacket(fmt::format("PacketSize={:x};swbreak+;hwbreak+", MAX_PACKET_SIZE));
+		else if (packet == "qAttached")
+			sendPacket("1");
+		else if (packet == "qC")
+			sendPacket("QC1");
+		else if (packet == "qfThreadInfo")
+			sendPacket("m1");
+		else if (packet == "qsThreadInfo")
+			sendPacket("l");
+		else
+			sendPacket("");
+		break;
+
+	// an empty reply tells the debugger a packet is not supported, such as X and vCont
+	default:
+		sendPacket("");
+		break;
+	}
+}
+
+void GdbServer::sendPacket(std::string_view payload)
+{
+	uint8_t sum = 0;
+	for (char c : payload)
+		sum = static_cast<uint8_t>(sum + static_cast<uint8_t>(c));
+
+	m_reply.clear();
+	m_reply.push_back('$');
+	m_reply.append(payload);
+	m_reply.push_back('#');
+	appendHex(m_reply, sum);
+
+	m_client.send(m_reply.data(), m_reply.size());
+}
+
+void GdbServer::resume(std::string_view address, bool step)
+{
+	uint32_t programCounter = 0;
+	if (parseHex(address, programCounter))
+		m_core.m_cpu.m_programCounter = static_cast<uint16_t>(programCounter);
+
+	if (step)
+		m_debugger.step();
+	else
+		m_debugger.resume();
+}
+
+std::string GdbServer::readRegisters() const
+{
+	const Sm83 &cpu = m_core.m_cpu;
+
+	const uint16_t registers[6] = {
+		cpu.m_registerAF.get_u16(),
+		cpu.m_registerBC.get_u16(),
+		cpu.m_registerDE.get_u16(),
+		cpu.m_registerHL.get_u16(),
+		cpu.m_stackPointer,
+		cpu.m_programCounter,
+	};
+
+	std::string payload;
+	for (uint16_t value : registers)
+	{
+		appendHex(payload, static_cast<uint8_t>(value));
+		appendHex(payload, static_cast<uint8_t>(value >> 8));
+	}
+
+	return payload;
+}
+
+bool GdbServer::writeRegister(uint32_t index, uint16_t value)
+{
+	Sm83 &cpu = m_core.m_cpu;
+
+	switch (index)
+	{
+	case 0:
+		cpu.m_registerAF.accumulator = static_cast<uint8_t>(value >> 8);
+		cpu.m_registerAF.flags.setFlagsU8(static_cast<uint8_t>(value));
+		return true;
+	case 1:
+		cpu.m_registerBC.set_u16(value);
+		return true;
+	case 2:
+		cpu.m_registerDE.set_u16(value);
+		return true;
+	case 3:
+		cpu.m_registerHL.set_u16(value);
+		return true;
+	case 4:
+		cpu.m_stackPointer = value;
+		return true;
+	case 5:
+		cpu.m_programCounter = value;
+		return true;
+	default:
+		return false;
+	}
+}
+
+void GdbServer::readMemory(std::string_view arguments)
+{
+	uint32_t address = 0, length = 0;
+	if (!parseAddressLength(arguments, address, length))
+	{
+		sendPacket("E01");
+		return;
+	}
+
+	length = std::min(length, MAX_PACKET_SIZE / 2 - 4);
+
+	std::string payload;
+	for (uint32_t i = 0; i < length; ++i)
+		appendHex(payload, m_core.m_bus.busReadRaw(static_cast<uint16_t>(address + i)));
+
+	sendPacket(payload);
+}
+
+void GdbServer::writeMemory(std::string_view arguments)
+{
+	uint32_t         address = 0, length = 0;
+	std::string_view data;
+
+	if (!parseAddressLength(arguments, address, length, &data) || data.size() != length * 2)
+	{
+		sendPacket("E01");
+		return;
+	}
+
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		uint32_t value = 0;
+		if (!parseHex(data.substr(i * 2, 2), value))
+		{
+			sendPacket("E01");
+			return;
+		}
+
+		m_core.m_bus.busWriteRaw(static_cast<uint16_t>(address + i), static_cast<uint8_t>(value));
+	}
+
+	sendPacket("OK");
+}
+
+void GdbServer::setBreakpoint(std::string_view arguments, bool insert)
+{
+	// type,address,kind where kind is the breakpoint size or the number of watched bytes
+	uint32_t type = 0, address = 0, kind = 0;
+
+	const std::size_t comma = arguments.find(',');
+	if (comma == std::string_view::npos || !parseHex(arguments.substr(0, comma), type) ||
+	    !parseAddressLength(arguments.substr(comma + 1), address, kind))
+	{
+		sendPacket("E01");
+		return;
+	}
+
+	std::string error;
+
+	switch (type)
+	{
+	// software and hardware breakpoints are the same thing here
+	case 0:
+	case 1:
+	{
+		const uint16_t breakpointAddress = static_cast<uint16_t>(address);
+		auto           found             = std::find(m_breakpoints.begin(), m_breakpoints.end(), breakpointAddress);
+
+		if (insert && found == m_breakpoints.end() && m_debugger.addBreakpoint(breakpointAddress, "", error))
+			m_breakpoints.push_back(breakpointAddress);
+		else if (!insert && found != m_breakpoints.end())
+		{
+			m_breakpoints.erase(found);
+			m_debugger.removeBreakpoint(breakpointAddress);
+		}
+
+		sendPacket("OK");
+		break;
+	}
+
+	// write, read and access watchpoints
+	case 2:
+	case 3:
+	case 4:
+	{
+		const uint8_t  flags = type == 2 ? Debugger::WATCH_WRITE : (type == 3 ? Debugger::WATCH_READ : Debugger::WATCH_READ | Debugger::WATCH_WRITE);
+		const uint16_t start = static_cast<uint16_t>(address);
+		const uint16_t end   = static_cast<uint16_t>(std::min<uint32_t>(address + std::max<uint32_t>(kind, 1) - 1, 0xFFFF));
+
+		auto found = std::find_if(m_watchpoints.begin(), m_watchpoints.end(), [=](const WatchRange &range) {
+			return range.Start == start && range.End == end && range.Flags == flags;
+		});
+
+		if (insert && found == m_watchpoints.end() && m_debugger.addWatchpoint(start, end, flags, "", error))
+			m_watchpoints.push_back(WatchRange{start, end, flags});
+		else if (!insert && found != m_watchpoints.end())
+		{
+			m_watchpoints.erase(found);
+			m_debugger.removeWatchpoint(start, end, flags);
+		}
+
+		sendPacket("OK");
+		break;
+	}
+
+	default:
+		sendPacket("");
+		break;
+	}
+}
+
+void GdbServer::detach()
+{
+	for (uint16_t address : m_breakpoints)
+		m_debugger.removeBreakpoint(address);
+
+	for (const WatchRange &range : m_watchpoints)
+		m_debugger.removeWatchpoint(range.Start, range.End, range.Flags);
+
+	m_breakpoints.clear();
+	m_watchpoints.clear();
+
+	if (m_debugger.isStopped())
+		m_debugger.resume();
+
+	m_client.close();
+	m_input.clear();
+}
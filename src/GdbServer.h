@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BudgetGBCore.h"
+#include "Debugger.h"
+#include "utils/tcpSocket.h"
+
+/**
+ * @brief GDB remote serial protocol stub for debugging a core from gdb or any other client of the protocol, listening
+ * on localhost only.
+ *
+ * The stub is a client of the Debugger of the core, which hooks the frame loop of the bus only while a debugger is
+ * attached or something is enabled. The debugger is serviced from that frame loop, so whoever runs the core keeps
+ * calling runFrame() and poll() as usual.
+ *
+ * Registers are six 16 bit little endian values in the order AF, BC, DE, HL, SP, PC. Memory goes through
+ * Bus::busReadRaw() and Bus::busWriteRaw(). Breakpoints never patch memory, write, read and access watchpoints trap
+ * the pages they cover and stop after the instruction that made the access.
+ */
+class GdbServer : private Debugger::Client
+{
+  public:
+	static constexpr uint32_t MAX_PACKET_SIZE = 4096;
+
+	struct Stats
+	{
+		uint64_t Packets        = 0;
+		uint32_t BreakpointHits = 0;
+		uint32_t WatchpointHits = 0;
+	};
+
+	GdbServer(BudgetGBCore &core, Debugger &debugger);
+	~GdbServer();
+
+	GdbServer(const GdbServer &)            = delete;
+	GdbServer &operator=(const GdbServer &) = delete;
+
+	/**
+	 * @param port 0 picks a free one, see getLocalPort().
+	 * @return True on success, false otherwise.
+	 */
+	bool listen(uint16_t port);
+	void close();
+
+	/**
+	 * @brief Take a debugger that connected or notice that it left, and become or stop being the client of the
+	 * Debugger for it. Call between frames, costs a non blocking accept when nothing changed.
+	 */
+	void poll();
+
+	bool isAttached() const
+	{
+		return m_client.isOpen();
+	}
+
+	// the debugger holds the core, runFrame() serves it for a few milliseconds and returns without running
+	bool isStopped() const
+	{
+		return m_attached && m_debugger.isStopped();
+	}
+
+	// the debugger sent a kill, the debugger is detached and the core is left running
+	bool isKillRequested() const
+	{
+		return m_killRequested;
+	}
+
+	uint16_t getLocalPort() const
+	{
+		return m_listener.getLocalPort();
+	}
+
+	const Stats &getStats() const
+	{
+		return m_stats;
+	}
+
+  private:
+	static constexpr uint32_t STOPPED_SERVICE_MS = 8; // a stopped frame serves the debugger this long, it sends one packet at a time
+
+	struct WatchRange
+	{
+		uint16_t Start;
+		uint16_t End;
+		uint8_t  Flags;
+	};
+
+	BudgetGBCore    &m_core;
+	Debugger        &m_debugger;
+	Utils::TcpSocket m_listener;
+	Utils::TcpSocket m_client;
+
+	bool m_attached      = false; // set as the client of m_debugger
+	bool m_killRequested = false;
+
+	// added by the debugger, removed again when it detaches
+	std::vector<uint16_t>   m_breakpoints;
+	std::vector<WatchRange> m_watchpoints;
+	std::string             m_lastStop = "S05";
+
+	std::string m_input; // received bytes not handled yet
+	std::string m_reply;
+	Stats       m_stats;
+
+	void onFrame() override;
+	void onStop(const Debugger::Stop &stop) override;
+
+	// handle every complete packet received so far
+	void service();
+	void handlePacket(std::string_view packet);
+	void sendPacket(std::string_view payload);
+
+	void resume(std::string_view address, bool step);
+
+	// every register as the payload of a g reply
+	std::string readRegisters() const;
+	bool writeRegister(uint32_t index, uint16_t value);
+	void readMemory(std::string_view arguments);
+	void writeMemory(std::string_view arguments);
+	void setBreakpoint(std::string_view arguments, bool insert);
+
+	// remove what the debugger added and let the core run, the client stays set until poll()
+	void detach();
+};
@@ -6,6 +6,7 @@ enum RegisterAdresses
 {
 	JOYPAD    = 0xFF00,
 	SERIAL_SB = 0xFF01, // Serial transfer data
+	SERIAL_SC = 0xFF02, // Serial transfer control
 
 	TIMER_DIV  = 0xFF04, // divider register
 	TIMER_TIMA = 0xFF05, // timer counter
@@ -0,0 +1,195 @@
+#include "Movie.h"
+#include "fmt/base.h"
+#include "utils/stateArchive.h"
+
+#include <fstream>
+#include <utility>
+
+bool Movie::startRecording(BudgetGBCore &core, bool fromPowerOn)
+{
+	Utils::StateWriter writer;
+	if (!core.saveState(writer))
+		return false;
+
+	const Mapper::CartInfo &cartInfo = core.m_cartridge.getCartInfo();
+
+	m_startState  = writer.getBuffer();
+	m_fromPowerOn = fromPowerOn;
+	m_checksums   = cartInfo.Checksums;
+	m_romSize     = cartInfo.RomSize;
+
+	m_inputs.clear();
+	m_currentFrame = 0;
+	m_mode         = Mode::Recording;
+
+	return true;
+}
+
+bool Movie::startPlayback(BudgetGBCore &core)
+{
+	m_mode = Mode::Idle;
+
+	if (!core.m_cartridge.isLoaded())
+		return false;
+
+	const Mapper::CartInfo &cartInfo = core.m_cartridge.getCartInfo();
+	if (cartInfo.Checksums != m_checksums || cartInfo.RomSize != m_romSize)
+	{
+		fmt::println(stderr, "Movie was recorded on a different cartridge!");
+		return false;
+	}
+
+	if (!core.loadState(m_startState.data(), m_startState.size()))
+		return false;
+
+	m_currentFrame = 0;
+	m_mode         = m_inputs.empty() ? Mode::Idle : Mode::Playing;
+
+	return true;
+}
+
+void Movie::beforeFrame(Joypad &joypad)
+{
+	if (m_mode == Mode::Playing)
+		joypad.setButtons(m_inputs[m_currentFrame]);
+}
+
+void Movie::afterFrame(Joypad &joypad)
+{
+	if (m_mode == Mode::Recording)
+	{
+		m_inputs.push_back(joypad.getButtons());
+		++m_currentFrame;
+	}
+	else if (m_mode == Mode::Playing && ++m_currentFrame == m_inputs.size())
+	{
+		// hand the joypad back with nothing held
+		joypad.setButtons(0);
+		m_mode = Mode::Idle;
+	}
+}
+
+bool Movie::saveToFile(const std::string &path) const
+{
+	Utils::StateWriter writer;
+
+	uint32_t magic       = MOVIE_MAGIC;
+	uint16_t version     = MOVIE_VERSION;
+	uint8_t  fromPowerOn = m_fromPowerOn;
+	uint32_t checksums   = m_checksums;
+	uint32_t romSize     = m_romSize;
+	uint32_t frameCount  = getFrameCount();
+	uint32_t stateSize   = static_cast<uint32_t>(m_startState.size());
+
+	writer.begin();
+	writer(magic, version, fromPowerOn, checksums, romSize, frameCount, stateSize);
+	writer.writeBytes(m_startState.data(), m_startState.size());
+
+	// held buttons rarely change between frames, store runs of identical frames
+	for (std::size_t i = 0; i < m_inputs.size();)
+	{
+		uint8_t  buttons = m_inputs[i];
+		uint32_t length  = 1;
+
+		while (i + length < m_inputs.size() && m_inputs[i + length] == buttons)
+			++length;
+
+		writer(buttons, length);
+		i += length;
+	}
+
+	std::ofstream movieFile(path, std::ios::binary);
+	if (!movieFile.is_open())
+	{
+		fmt::println(stderr, "Failed to open movie at: {}", path);
+		return false;
+	}
+
+	const std::vector<uint8_t> &buffer = writer.getBuffer();
+	movieFile.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+	return movieFile.good();
+}
+
+bool Movie::loadFromFile(const std::string &path)
+{
+	std::ifstream movieFile(path, std::ios::binary | std::ios::ate);
+	if (!movieFile.is_open())
+	{
+		fmt::println(stderr, "Failed to open movie at: {}", path);
+		return false;
+	}
+
+	std::vector<uint8_t> buffer(static_cast<std::size_t>(movieFile.tellg()));
+	movieFile.seekg(0, std::ios::beg);
+	movieFile.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+	if (!movieFile.good())
+	{
+		fmt::println(stderr, "Failed to read movie at: {}", path);
+		return false;
+	}
+
+	Utils::StateReader reader(buffer.data(), buffer.size());
+
+	uint32_t magic       = 0;
+	uint16_t version     = 0;
+	uint8_t  fromPowerOn = 0;
+	uint32_t checksums   = 0;
+	uint32_t romSize     = 0;
+	uint32_t frameCount  = 0;
+	uint32_t stateSize   = 0;
+	reader(magic, version, fromPowerOn, checksums, romSize, frameCount, stateSize);
+
+	if (!reader.isOk() || magic != MOVIE_MAGIC)
+	{
+		fmt::println(stderr, "Not a movie!");
+		return false;
+	}
+
+	if (version != MOVIE_VERSION)
+	{
+		fmt::println(stderr, "Movie version {} is not supported, expected version {}", version, MOVIE_VERSION);
+		return false;
+	}
+
+	std::vector<uint8_t> startState(stateSize <= reader.getRemaining() ? stateSize : 0);
+	std::vector<uint8_t> inputs;
+
+	if (startState.size() != stateSize || !reader.readBytes(startState.data(), startState.size()))
+	{
+		fmt::println(stderr, "Movie is truncated or corrupt!");
+		return false;
+	}
+
+	while (inputs.size() < frameCount)
+	{
+		uint8_t  buttons = 0;
+		uint32_t length  = 0;
+		reader(buttons, length);
+
+		if (!reader.isOk() || length == 0 || length > frameCount - inputs.size())
+		{
+			fmt::println(stderr, "Movie is truncated or corrupt!");
+			return false;
+		}
+
+		inputs.insert(inputs.end(), length, buttons);
+	}
+
+	if (reader.getRemaining() != 0)
+	{
+		fmt::println(stderr, "Movie is truncated or corrupt!");
+		return false;
+	}
+
+	m_mode         = Mode::Idle;
+	m_currentFrame = 0;
+	m_fromPowerOn  = fromPowerOn != 0;
+	m_checksums    = checksums;
+	m_romSize      = romSize;
+	m_startState   = std::move(startState);
+	m_inputs       = std::move(inputs);
+
+	return true;
+}
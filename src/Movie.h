@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BudgetGBCore.h"
+#include "joypad.h"
+
+/**
+ * @brief Per frame joypad input recorded from a known starting state, played back it reproduces the original run
+ * exactly. The starting state is stored even for movies that begin at power on, the save ram of battery backed
+ * cartridges would otherwise differ between machines.
+ *
+ * Files hold the header, the starting state and the input as runs of identical frames.
+ */
+class Movie
+{
+  public:
+	enum class Mode
+	{
+		Idle,
+		Recording,
+		Playing,
+	};
+
+	/**
+	 * @brief Start recording from the current state of core, power cycle core beforehand for a power on movie.
+	 * @param fromPowerOn Stored in the file for information only.
+	 * @return True on success, false when no cartridge is loaded.
+	 */
+	bool startRecording(BudgetGBCore &core, bool fromPowerOn);
+
+	/**
+	 * @brief Load the starting state into core and begin feeding it input. Movies of another cartridge are rejected.
+	 * @return True on success, false otherwise.
+	 */
+	bool startPlayback(BudgetGBCore &core);
+
+	/**
+	 * @brief Stop recording or playback, the recorded input is kept until the next recording starts.
+	 */
+	void stop()
+	{
+		m_mode = Mode::Idle;
+	}
+
+	/**
+	 * @brief Called around every emulated frame. Playback sets the buttons for the frame about to run and releases them
+	 * once the last frame has run, recording stores the buttons that were held during the frame.
+	 */
+	void beforeFrame(Joypad &joypad);
+	void afterFrame(Joypad &joypad);
+
+	bool saveToFile(const std::string &path) const;
+	bool loadFromFile(const std::string &path);
+
+	Mode getMode() const
+	{
+		return m_mode;
+	}
+
+	bool isFromPowerOn() const
+	{
+		return m_fromPowerOn;
+	}
+
+	uint32_t getFrameCount() const
+	{
+		return static_cast<uint32_t>(m_inputs.size());
+	}
+
+	// frames recorded or played back so far
+	uint32_t getCurrentFrame() const
+	{
+		return m_currentFrame;
+	}
+
+  private:
+	static constexpr uint32_t MOVIE_MAGIC   = 0x4D424742; // "BGBM" little endian
+	static constexpr uint16_t MOVIE_VERSION = 1;
+
+	Mode     m_mode         = Mode::Idle;
+	uint32_t m_currentFrame = 0;
+
+	bool     m_fromPowerOn = false;
+	uint32_t m_checksums   = 0; // cartridge the movie was recorded on
+	uint32_t m_romSize     = 0;
+
+	std::vector<uint8_t> m_startState;
+	std::vector<uint8_t> m_inputs; // one Joypad::getButtons() mask per frame
+};
@@ -0,0 +1,160 @@
+#include "PolyphaseResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace
+{
+constexpr double PI = 3.14159265358979323846;
+
+// zeroth order modified bessel function of the first kind, used by the kaiser window
+double besselI0(double x)
+{
+	double sum  = 1.0;
+	double term = 1.0;
+
+	for (int k = 1; k < 32; ++k)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+std::vector<float> buildCoefficients(uint32_t taps, uint32_t phases, double cutoff, double halfWidth, float kaiserBeta)
+{
+	std::vector<float> coefficients(static_cast<std::size_t>(phases) * taps);
+
+	const double windowNorm = besselI0(kaiserBeta);
+
+	for (uint32_t phase = 0; phase < phases; ++phase)
+	{
+		float *row = &coefficients[static_cast<std::size_t>(phase) * taps];
+		double sum = 0.0;
+
+		for (uint32_t tap = 0; tap < taps; ++tap)
+		{
+			// distance in input samples from the output time, tap taps/2 - 1 is the sample at or before the output time
+			const double x = static_cast<double>(tap) - (taps / 2 - 1) - static_cast<double>(phase) / phases;
+
+			const double sinc   = x == 0.0 ? 1.0 : std::sin(2.0 * PI * cutoff * x) / (PI * x) / (2.0 * cutoff);
+			const double ratio  = x / (halfWidth + 1.0);
+			const double window = std::abs(ratio) >= 1.0 ? 0.0 : besselI0(kaiserBeta * std::sqrt(1.0 - ratio * ratio)) / windowNorm;
+
+			row[tap] = static_cast<float>(sinc * window);
+			sum += row[tap];
+		}
+
+		for (uint32_t tap = 0; tap < taps; ++tap)
+			row[tap] = static_cast<float>(row[tap] / sum);
+	}
+
+	return coefficients;
+}
+
+// tables are kept while any resampler uses them, forked cores and cores on other threads build the same ones
+using CoefficientKey = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, float, float>;
+
+std::mutex                                                        coefficientCacheMutex;
+std::map<CoefficientKey, std::weak_ptr<const std::vector<float>>> coefficientCache;
+} // namespace
+
+const char *getResamplerQualityString(ResamplerQuality quality)
+{
+	switch (quality)
+	{
+	case ResamplerQuality::Box:
+		return "box";
+	case ResamplerQuality::Low:
+		return "low";
+	case ResamplerQuality::Medium:
+		return "medium";
+	case ResamplerQuality::High:
+		return "high";
+	default:
+		return "unknown";
+	}
+}
+
+PolyphaseResampler::Design PolyphaseResampler::getDesign(ResamplerQuality quality)
+{
+	switch (quality)
+	{
+	case ResamplerQuality::Low:
+		return Design{4, 256, 0.90f, 6.0f};
+	case ResamplerQuality::High:
+		return Design{16, 512, 0.95f, 10.0f};
+	case ResamplerQuality::Medium:
+	default:
+		return Design{8, 256, 0.92f, 8.6f};
+	}
+}
+
+uint32_t PolyphaseResampler::getPreDecimation(ResamplerQuality quality)
+{
+	switch (quality)
+	{
+	case ResamplerQuality::Low:
+		return 8;
+	case ResamplerQuality::Medium:
+		return 4;
+	case ResamplerQuality::High:
+		return 2;
+	case ResamplerQuality::Box:
+	default:
+		return 1;
+	}
+}
+
+PolyphaseResampler::PolyphaseResampler(uint32_t inputRate, uint32_t outputRate, const Design &design, Utils::SimdLevel simdLevel)
+	: m_phases(design.Phases),
+	  m_step((static_cast<uint64_t>(inputRate) << 32) / outputRate),
+	  m_dotProduct(Utils::getDotProduct(simdLevel))
+{
+	// cutoff in cycles per input sample, scaled down to the output nyquist when decimating
+	const double cutoff = 0.5 * std::min(1.0, static_cast<double>(outputRate) / inputRate) * design.Rolloff;
+
+	// kernel spans ZeroCrossings sinc lobes on each side, rounded up for the simd kernels
+	const double halfWidth = design.ZeroCrossings / (2.0 * cutoff);
+	m_taps                 = (static_cast<uint32_t>(std::ceil(2.0 * halfWidth)) + 7) & ~7u;
+
+	const CoefficientKey key{inputRate, outputRate, design.ZeroCrossings, design.Phases, design.Rolloff, design.KaiserBeta};
+
+	{
+		std::lock_guard<std::mutex> lock(coefficientCacheMutex);
+
+		std::weak_ptr<const std::vector<float>> &cached = coefficientCache[key];
+
+		m_coefficients = cached.lock();
+		if (!m_coefficients)
+		{
+			m_coefficients = std::make_shared<const std::vector<float>>(buildCoefficients(m_taps, m_phases, cutoff, halfWidth, design.KaiserBeta));
+			cached         = m_coefficients;
+
+			// drop tables no resampler uses anymore, like those of output formats switched away from
+			for (auto entry = coefficientCache.begin(); entry != coefficientCache.end();)
+				entry = entry->second.expired() ? coefficientCache.erase(entry) : std::next(entry);
+		}
+	}
+
+	m_coefficientData = m_coefficients->data();
+
+	m_historyStride = m_taps * 2;
+	m_history.resize(static_cast<std::size_t>(m_historyStride) * MAX_LANES);
+
+	reset();
+}
+
+void PolyphaseResampler::reset()
+{
+	std::fill(m_history.begin(), m_history.end(), 0.0f);
+
+	m_writePos       = 0;
+	m_inputCount     = 0;
+	m_nextOutputTime = 0;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "utils/simd.h"
+
+enum class ResamplerQuality
+{
+	Box = 0, // box average straight to the output rate, no polyphase stage
+	Low,
+	Medium,
+	High,
+};
+
+const char *getResamplerQualityString(ResamplerQuality quality);
+
+/**
+ * @brief Streaming windowed-sinc (kaiser) polyphase resampler. Resamples up to MAX_LANES signals in lockstep so the
+ * mixed output and individual channels share one phase computation.
+ */
+class PolyphaseResampler
+{
+  public:
+	static constexpr int MAX_LANES = 5;
+
+	struct Design
+	{
+		uint32_t ZeroCrossings; // sinc zero crossings on each side of the kernel center
+		uint32_t Phases;        // number of precomputed fractional offsets
+		float    Rolloff;       // cutoff as a fraction of the output nyquist
+		float    KaiserBeta;    // window shape, larger trades transition width for stopband attenuation
+	};
+
+	/**
+	 * @brief Design parameters and the pre-decimation factor (input rate divider) of a quality tier.
+	 */
+	static Design getDesign(ResamplerQuality quality);
+	static uint32_t getPreDecimation(ResamplerQuality quality);
+
+	/**
+	 * @brief Build the filter table for a fixed conversion ratio. Only downsampling is supported, inputRate must be at
+	 * least outputRate so every pushed sample produces at most one output sample. Tables are shared by every resampler
+	 * with the same ratio and design, only the first one pays for building it.
+	 */
+	PolyphaseResampler(uint32_t inputRate, uint32_t outputRate, const Design &design, Utils::SimdLevel simdLevel = Utils::detectSimdLevel());
+
+	/**
+	 * @brief Push one input sample for each active lane.
+	 * @param in Input samples, only the first activeLanes are read.
+	 * @param out Output samples, only written when an output sample is produced.
+	 * @param activeLanes Number of lanes to filter, lanes that are skipped fall behind and should be reset before use.
+	 * @return True when an output sample was produced.
+	 */
+	bool push(const float *in, float *out, int activeLanes)
+	{
+		float *history = &m_history[m_writePos];
+		for (int lane = 0; lane < activeLanes; ++lane)
+		{
+			history[lane * m_historyStride]          = in[lane];
+			history[lane * m_historyStride + m_taps] = in[lane];
+		}
+
+		m_writePos = m_writePos + 1 == m_taps ? 0 : m_writePos + 1;
+		++m_inputCount;
+
+		// output is produced once the newest input is the last tap of the kernel centered on the output time
+		if ((m_nextOutputTime >> 32) + m_taps / 2 != m_inputCount - 1)
+			return false;
+
+		const uint32_t phase        = static_cast<uint32_t>(((m_nextOutputTime & 0xFFFFFFFF) * m_phases) >> 32);
+		const float   *coefficients = &m_coefficientData[phase * m_taps];
+
+		// mirrored history makes the last taps samples contiguous starting from the write position
+		for (int lane = 0; lane < activeLanes; ++lane)
+			out[lane] = m_dotProduct(&m_history[lane * m_historyStride + m_writePos], coefficients, m_taps);
+
+		m_nextOutputTime += m_step;
+		return true;
+	}
+
+	void reset();
+
+	uint32_t getTaps() const
+	{
+		return m_taps;
+	}
+
+	uint32_t getPhases() const
+	{
+		return m_phases;
+	}
+
+  private:
+	uint32_t m_taps   = 0; // multiple of 8 for the simd kernels
+	uint32_t m_phases = 0;
+	uint64_t m_step   = 0; // input samples per output sample, 32.32 fixed point
+
+	std::shared_ptr<const std::vector<float>> m_coefficients;              // phases * taps, each phase normalized to unity dc gain
+	const float                              *m_coefficientData = nullptr; // m_coefficients->data()
+
+	std::vector<float> m_history;           // MAX_LANES rows of 2 * taps, every sample is written twice
+	uint32_t           m_historyStride  = 0; // 2 * taps
+	uint32_t           m_writePos       = 0;
+	uint64_t           m_inputCount     = 0;
+	uint64_t           m_nextOutputTime = 0; // 32.32 fixed point input sample position
+
+	Utils::DotProductFn m_dotProduct;
+};
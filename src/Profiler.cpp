@@ -0,0 +1,90 @@
+#include "Profiler.h"
+#include "fmt/base.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <fstream>
+
+void Profiler::reset(uint32_t romBanks)
+{
+	m_romBanks = std::max<uint32_t>(romBanks, 1);
+	m_counters.assign(FIXED_ENTRIES + m_romBanks * BANK_SIZE, Counters{});
+	m_opcodeCounts.fill(0);
+	m_totalCycles  = 0;
+	m_haltedCycles = 0;
+}
+
+std::vector<Profiler::HotSpot> Profiler::getHotSpots(std::size_t count) const
+{
+	std::vector<uint32_t> indices;
+	for (uint32_t index = 0; index < m_counters.size(); ++index)
+	{
+		if (m_counters[index].Executions)
+			indices.push_back(index);
+	}
+
+	count = std::min(count, indices.size());
+
+	auto byCycles = [this](uint32_t a, uint32_t b) { return m_counters[a].Cycles > m_counters[b].Cycles; };
+	std::partial_sort(indices.begin(), indices.begin() + count, indices.end(), byCycles);
+
+	std::vector<HotSpot> hotSpots(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		getLocation(indices[i], hotSpots[i].Bank, hotSpots[i].Address);
+		hotSpots[i].Counts = m_counters[indices[i]];
+	}
+
+	return hotSpots;
+}
+
+bool Profiler::writeReport(const std::string &path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		fmt::println(stderr, "Failed to write profiler report: {}", path);
+		return false;
+	}
+
+	const double totalCycles = static_cast<double>(std::max<uint64_t>(m_totalCycles, 1));
+
+	file << "bank,address,executions,m_cycles,percent\n";
+	for (const HotSpot &hotSpot : getHotSpots(m_counters.size()))
+		file << fmt::format("{},{:04X},{},{},{:.4f}\n", hotSpot.Bank, hotSpot.Address, hotSpot.Counts.Executions, hotSpot.Counts.Cycles, hotSpot.Counts.Cycles * 100.0 / totalCycles);
+
+	file << fmt::format("halted,,,{},{:.4f}\n", m_haltedCycles, m_haltedCycles * 100.0 / totalCycles);
+
+	file << "\nopcode,executions\n";
+	for (uint32_t opcode = 0; opcode < OPCODE_COUNT; ++opcode)
+	{
+		if (!m_opcodeCounts[opcode])
+			continue;
+
+		if (opcode & CB_PREFIX)
+			file << fmt::format("CB {:02X},{}\n", opcode & 0xFF, m_opcodeCounts[opcode]);
+		else
+			file << fmt::format("{:02X},{}\n", opcode, m_opcodeCounts[opcode]);
+	}
+
+	if (!file)
+	{
+		fmt::println(stderr, "Failed to write profiler report: {}", path);
+		return false;
+	}
+
+	return true;
+}
+
+void Profiler::getLocation(uint32_t index, uint32_t &bank, uint16_t &address) const
+{
+	if (index < FIXED_ENTRIES)
+	{
+		bank    = 0;
+		address = static_cast<uint16_t>(index);
+		return;
+	}
+
+	bank    = (index - FIXED_ENTRIES) / BANK_SIZE;
+	address = static_cast<uint16_t>(BANK_SIZE + (index - FIXED_ENTRIES) % BANK_SIZE);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Counts executions and m-cycles of every instruction by rom bank and address, plus executions of every opcode.
+ * Counters live in one flat array indexed by bank and address, so counting an instruction is two adds.
+ *
+ * The cpu only feeds a profiler in builds with BUDGETGB_PROFILER defined, see Sm83::setProfiler(), other builds have
+ * no profiling code in the instruction loop at all. Cycles of an instruction include the interrupt dispatch that
+ * follows it. Code running from ram or the boot rom counts as bank 0.
+ */
+class Profiler
+{
+  public:
+	static constexpr uint32_t OPCODE_COUNT = 512;
+	static constexpr uint16_t CB_PREFIX    = 0x100; // opcode histogram index of CB prefixed opcodes
+
+	struct Counters
+	{
+		uint64_t Executions = 0;
+		uint64_t Cycles     = 0; // m-cycles
+	};
+
+	struct HotSpot
+	{
+		uint32_t Bank;
+		uint16_t Address;
+		Counters Counts;
+	};
+
+	/**
+	 * @brief Size the counters for a rom of romBanks 16kb banks and clear them.
+	 */
+	void reset(uint32_t romBanks);
+
+	// count an instruction at address of bank that took cycles m-cycles, opcode is CB_PREFIX | n for CB n
+	void record(uint32_t bank, uint16_t address, uint16_t opcode, uint32_t cycles)
+	{
+		Counters &counters = m_counters[getIndex(bank, address)];
+		counters.Executions += 1;
+		counters.Cycles += cycles;
+
+		m_opcodeCounts[opcode] += 1;
+		m_totalCycles += cycles;
+	}
+
+	// count m-cycles the cpu spent halted
+	void recordHalt(uint32_t cycles)
+	{
+		m_haltedCycles += cycles;
+		m_totalCycles += cycles;
+	}
+
+	/**
+	 * @return Up to count instructions that took the most cycles, most first.
+	 */
+	std::vector<HotSpot> getHotSpots(std::size_t count) const;
+
+	const std::array<uint64_t, OPCODE_COUNT> &getOpcodeCounts() const
+	{
+		return m_opcodeCounts;
+	}
+
+	// m-cycles counted so far, halted ones included
+	uint64_t getTotalCycles() const
+	{
+		return m_totalCycles;
+	}
+
+	uint64_t getHaltedCycles() const
+	{
+		return m_haltedCycles;
+	}
+
+	/**
+	 * @brief Write a CSV report of every instruction that ran, most cycles first, then the opcode histogram as a second
+	 * table after a blank line.
+	 * @return True on success, false otherwise.
+	 */
+	bool writeReport(const std::string &path) const;
+
+  private:
+	static constexpr uint32_t FIXED_ENTRIES = 0x10000; // bank 0 and everything outside of the banked rom, by address
+	static constexpr uint32_t BANK_SIZE     = 0x4000;
+
+	std::vector<Counters>              m_counters = std::vector<Counters>(FIXED_ENTRIES + BANK_SIZE);
+	uint32_t                           m_romBanks = 1; // banks above 0 with their own counters
+	std::array<uint64_t, OPCODE_COUNT> m_opcodeCounts{};
+	uint64_t                           m_totalCycles  = 0;
+	uint64_t                           m_haltedCycles = 0;
+
+	// rom addresses of banks other than 0 go after the fixed entries, one block of counters per bank
+	uint32_t getIndex(uint32_t bank, uint16_t address) const
+	{
+		if (bank == 0 || address >= 0x8000)
+			return address;
+
+		return FIXED_ENTRIES + (bank % m_romBanks) * BANK_SIZE + (address & (BANK_SIZE - 1));
+	}
+
+	void getLocation(uint32_t index, uint32_t &bank, uint16_t &address) const;
+};
@@ -0,0 +1,131 @@
+#include "RewindBuffer.h"
+#include "utils/deltaCodec.h"
+
+#include <algorithm>
+
+RewindBuffer::RewindBuffer(std::size_t capacity, uint32_t maxSnapshots)
+	: m_capacity(capacity),
+	  m_maxSnapshots(std::max(maxSnapshots, 1u))
+{
+}
+
+void RewindBuffer::push(BudgetGBCore &core)
+{
+	if (!core.saveState(m_writer))
+		return;
+
+	const std::vector<uint8_t> &snapshot = m_writer.getBuffer();
+	m_coreAhead                          = false;
+
+	// first snapshot or a different cartridge, there is nothing to delta against
+	if (m_current.size() != snapshot.size())
+	{
+		clear();
+		m_current = snapshot;
+		return;
+	}
+
+	if (m_storage.empty())
+	{
+		m_storage.resize(m_capacity);
+		m_entries.resize(m_maxSnapshots);
+	}
+
+	m_encoded.resize(Utils::getMaxXorDeltaSize(snapshot.size()));
+
+	const std::size_t size = Utils::encodeXorDelta(snapshot.data(), m_current.data(), snapshot.size(), m_encoded.data());
+	std::copy(snapshot.begin(), snapshot.end(), m_current.begin());
+
+	if (size > m_capacity)
+	{
+		while (m_entryCount > 0)
+			dropOldest();
+
+		return;
+	}
+
+	if (m_storageHead + size > m_capacity)
+		m_storageHead = 0;
+
+	// deltas are written in storage order, so the oldest ones are always the first to be overwritten
+	while (m_entryCount > 0)
+	{
+		const Entry &oldest = m_entries[m_entryFirst];
+
+		if (m_entryCount < m_maxSnapshots && (oldest.Offset >= m_storageHead + size || oldest.Offset + oldest.Size <= m_storageHead))
+			break;
+
+		dropOldest();
+	}
+
+	std::copy(m_encoded.begin(), m_encoded.begin() + size, m_storage.begin() + m_storageHead);
+
+	m_entries[(m_entryFirst + m_entryCount) % m_maxSnapshots] = Entry{m_storageHead, size};
+	++m_entryCount;
+
+	m_storageHead += size;
+	m_usedBytes += size;
+}
+
+bool RewindBuffer::stepBack(BudgetGBCore &core)
+{
+	// the frame on screen produced m_current, or the snapshot after it when the last step back redrew a frame. Redrawing
+	// the frame before it means running it again from the snapshot two frames back
+	const uint32_t steps = m_coreAhead ? 1 : 2;
+
+	if (m_entryCount < steps)
+		return false;
+
+	for (uint32_t i = 0; i < steps; ++i)
+	{
+		if (!popNewest())
+		{
+			clear();
+			return false;
+		}
+	}
+
+	if (!core.loadState(m_current.data(), m_current.size()))
+	{
+		clear();
+		return false;
+	}
+
+	core.runFrame();
+	m_coreAhead = true;
+
+	return true;
+}
+
+void RewindBuffer::clear()
+{
+	m_current.clear();
+
+	m_storageHead = 0;
+	m_usedBytes   = 0;
+	m_entryFirst  = 0;
+	m_entryCount  = 0;
+	m_coreAhead   = false;
+}
+
+void RewindBuffer::dropOldest()
+{
+	m_usedBytes -= m_entries[m_entryFirst].Size;
+	m_entryFirst = (m_entryFirst + 1) % m_maxSnapshots;
+	--m_entryCount;
+}
+
+bool RewindBuffer::popNewest()
+{
+	const Entry &newest = m_entries[(m_entryFirst + m_entryCount - 1) % m_maxSnapshots];
+
+	if (!Utils::applyXorDelta(&m_storage[newest.Offset], newest.Size, m_current.data(), m_current.size()))
+		return false;
+
+	// the next delta is written where this one was
+	m_storageHead = newest.Offset;
+	m_usedBytes -= newest.Size;
+	--m_entryCount;
+
+	return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BudgetGBCore.h"
+#include "utils/stateArchive.h"
+
+/**
+ * @brief History of per frame save states for hold to rewind. The newest snapshot is kept whole and every older one
+ * is stored as a run length encoded xor delta against the snapshot after it, see Utils::encodeXorDelta(). Deltas live
+ * in a fixed size ring, the oldest history is dropped once it is full.
+ */
+class RewindBuffer
+{
+  public:
+	static constexpr std::size_t DEFAULT_CAPACITY      = 32 * 1024 * 1024;
+	static constexpr uint32_t    DEFAULT_MAX_SNAPSHOTS = 60 * 60 * 10; // 10 minutes of frames
+
+	/**
+	 * @brief Construct rewind history, storage is allocated on the first push.
+	 * @param capacity Bytes of encoded deltas to keep.
+	 * @param maxSnapshots Upper bound on the number of frames kept regardless of how well they compress.
+	 */
+	RewindBuffer(std::size_t capacity = DEFAULT_CAPACITY, uint32_t maxSnapshots = DEFAULT_MAX_SNAPSHOTS);
+
+	/**
+	 * @brief Snapshot core, called once after every emulated frame.
+	 */
+	void push(BudgetGBCore &core);
+
+	/**
+	 * @brief Move core back one frame. The frame is run again from the snapshot before it so the ppu redraws it, audio
+	 * produced by the rerun should be discarded by the caller.
+	 * @return True on success, false once the history is exhausted.
+	 */
+	bool stepBack(BudgetGBCore &core);
+
+	/**
+	 * @brief Drop all history, needed whenever the core is reset or a different cartridge is loaded.
+	 */
+	void clear();
+
+	uint32_t getSnapshotCount() const
+	{
+		return m_entryCount;
+	}
+
+	// bytes of encoded deltas currently held
+	std::size_t getUsedBytes() const
+	{
+		return m_usedBytes;
+	}
+
+  private:
+	struct Entry
+	{
+		std::size_t Offset = 0;
+		std::size_t Size   = 0;
+	};
+
+	std::size_t m_capacity;
+	uint32_t    m_maxSnapshots;
+
+	Utils::StateWriter   m_writer;
+	std::vector<uint8_t> m_current; // newest snapshot, deltas are applied backwards from here
+	std::vector<uint8_t> m_encoded; // scratch for the delta being pushed, sized for the worst case
+
+	std::vector<uint8_t> m_storage; // ring of encoded deltas
+	std::size_t          m_storageHead = 0;
+	std::size_t          m_usedBytes   = 0;
+
+	std::vector<Entry> m_entries; // ring of deltas from oldest to newest
+	uint32_t           m_entryFirst = 0;
+	uint32_t           m_entryCount = 0;
+
+	bool m_coreAhead = false; // core ran one frame past m_current to redraw it after a step back
+
+	void dropOldest();
+
+	// apply the newest delta to m_current and forget it
+	bool popNewest();
+};
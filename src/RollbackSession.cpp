@@ -0,0 +1,171 @@
+#include "RollbackSession.h"
+#include "fmt/base.h"
+#include "utils/hash.h"
+
+#include <algorithm>
+#include <chrono>
+
+RollbackSession::RollbackSession(BudgetGBCore &core, uint32_t inputDelay)
+	: m_core(core),
+	  m_inputDelay(std::min(inputDelay, MAX_ROLLBACK_FRAMES))
+{
+	// nobody holds anything during the delay before the first input applies, on either peer
+	m_localInputEnd      = m_inputDelay;
+	m_remoteConfirmedEnd = m_inputDelay;
+}
+
+bool RollbackSession::connect(uint16_t localPort, const std::string &peerAddress, uint16_t peerPort)
+{
+	if (!m_core.saveState(m_states[0]))
+		return false;
+
+	// exchanged with every packet, peers that start from different states would desync from the first frame
+	const std::vector<uint8_t> &startState = m_states[0].getBuffer();
+	m_startStateHash                       = Utils::hash64(startState.data(), startState.size());
+
+	return m_socket.open(localPort) && m_socket.setPeer(peerAddress, peerPort);
+}
+
+bool RollbackSession::beginFrame(uint8_t localButtons)
+{
+	if (m_localInputEnd == m_frame + m_inputDelay)
+		m_localInputs[m_localInputEnd++ % INPUT_WINDOW] = localButtons;
+
+	poll();
+
+	// every state that could still be rolled back to has to fit in the state slots
+	if (m_frame >= m_remoteConfirmedEnd + MAX_ROLLBACK_FRAMES)
+	{
+		++m_stats.StalledFrames;
+		return false;
+	}
+
+	m_core.saveState(m_states[m_frame % STATE_SLOTS]);
+	m_core.m_cpu.m_joypad.setButtons(getFrameInput(m_frame));
+
+	return true;
+}
+
+void RollbackSession::poll()
+{
+	receivePackets();
+	sendInputs();
+
+	if (m_rollbackFrame != NO_ROLLBACK)
+	{
+		rollback(m_rollbackFrame);
+		m_rollbackFrame = NO_ROLLBACK;
+	}
+}
+
+void RollbackSession::receivePackets()
+{
+	std::size_t size;
+	while ((size = m_socket.receive(m_packetBuffer.data(), m_packetBuffer.size())) > 0)
+	{
+		Utils::StateReader reader(m_packetBuffer.data(), size);
+
+		uint32_t magic      = 0;
+		uint64_t startHash  = 0;
+		uint32_t ackedEnd   = 0;
+		uint32_t firstFrame = 0;
+		uint8_t  count      = 0;
+		reader(magic, startHash, ackedEnd, firstFrame, count);
+
+		if (!reader.isOk() || magic != PACKET_MAGIC)
+			continue;
+
+		if (startHash != m_startStateHash)
+		{
+			if (!m_startStateMismatch)
+				fmt::println(stderr, "Netplay peer started from a different state!");
+
+			m_startStateMismatch = true;
+			continue;
+		}
+
+		m_remoteAckedEnd = std::max(m_remoteAckedEnd, ackedEnd);
+
+		for (uint32_t frame = firstFrame; frame < firstFrame + count; ++frame)
+		{
+			uint8_t input = 0;
+			reader(input);
+
+			// inputs are resent until acknowledged, skip the ones already confirmed. A gap means packets arrived out of
+			// order, the missing frames are resent with the next one
+			if (!reader.isOk() || frame > m_remoteConfirmedEnd)
+				break;
+
+			if (frame < m_remoteConfirmedEnd)
+				continue;
+
+			if (frame < m_frame && m_remoteInputs[frame % INPUT_WINDOW] != input)
+				m_rollbackFrame = std::min(m_rollbackFrame, frame);
+
+			m_remoteInputs[frame % INPUT_WINDOW] = input;
+			m_lastRemoteInput                    = input;
+			++m_remoteConfirmedEnd;
+		}
+	}
+}
+
+void RollbackSession::sendInputs()
+{
+	const uint32_t firstFrame = std::max(m_remoteAckedEnd, m_localInputEnd > MAX_PACKET_INPUTS ? m_localInputEnd - MAX_PACKET_INPUTS : 0);
+
+	uint32_t magic    = PACKET_MAGIC;
+	uint32_t ackedEnd = m_remoteConfirmedEnd;
+	uint32_t first    = firstFrame;
+	uint8_t  count    = static_cast<uint8_t>(m_localInputEnd - std::min(firstFrame, m_localInputEnd));
+
+	m_packetWriter.begin();
+	m_packetWriter(magic, m_startStateHash, ackedEnd, first, count);
+
+	for (uint32_t frame = firstFrame; frame < firstFrame + count; ++frame)
+		m_packetWriter(m_localInputs[frame % INPUT_WINDOW]);
+
+	m_socket.send(m_packetWriter.getBuffer().data(), m_packetWriter.getSize());
+}
+
+void RollbackSession::rollback(uint32_t frame)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	const std::vector<uint8_t> &state = m_states[frame % STATE_SLOTS].getBuffer();
+	if (!m_core.loadState(state.data(), state.size()))
+		return;
+
+	// the frames were already seen and heard with the predicted input
+	const bool outputEnabled = m_core.m_ppu.isOutputEnabled();
+	m_core.m_apu.setOutputEnabled(false);
+	m_core.m_ppu.setOutputEnabled(false);
+	m_core.m_cpu.m_serial.setLinkEnabled(false);
+
+	for (uint32_t resimulated = frame; resimulated < m_frame; ++resimulated)
+	{
+		if (resimulated != frame)
+			m_core.saveState(m_states[resimulated % STATE_SLOTS]);
+
+		m_core.m_cpu.m_joypad.setButtons(getFrameInput(resimulated));
+		m_core.runFrame();
+	}
+
+	m_core.m_apu.setOutputEnabled(true);
+	m_core.m_ppu.setOutputEnabled(outputEnabled);
+	m_core.m_cpu.m_serial.setLinkEnabled(true);
+
+	m_stats.Rollbacks += 1;
+	m_stats.ResimulatedFrames += m_frame - frame;
+	m_stats.MaxRollbackFrames = std::max(m_stats.MaxRollbackFrames, m_frame - frame);
+	m_stats.ResimulatedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint8_t RollbackSession::getFrameInput(uint32_t frame)
+{
+	// unconfirmed remote input is predicted to stay the same, the prediction is stored to check it against the real
+	// input once that arrives
+	if (frame >= m_remoteConfirmedEnd)
+		m_remoteInputs[frame % INPUT_WINDOW] = m_lastRemoteInput;
+
+	return m_localInputs[frame % INPUT_WINDOW] | m_remoteInputs[frame % INPUT_WINDOW];
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "BudgetGBCore.h"
+#include "utils/stateArchive.h"
+#include "utils/udpSocket.h"
+
+/**
+ * @brief Two player rollback netplay over udp. Both peers run the same game and share its one joypad, a button is
+ * held while either player holds it.
+ *
+ * Every frame sends all local input the peer has not acknowledged yet, so lost datagrams need no retransmit logic.
+ * Frames whose remote input has not arrived run with the remote player still holding their last known buttons. When
+ * the real input arrives and differs, the state saved at the start of the first mispredicted frame is loaded and every
+ * frame since is run again with the ppu and apu output muted. Peers must start from the same state, load the same
+ * cartridge without save ram or with identical save ram and use the same input delay.
+ */
+class RollbackSession
+{
+  public:
+	static constexpr uint32_t MAX_ROLLBACK_FRAMES = 8; // frames run ahead of the remote input before waiting for it
+
+	struct Stats
+	{
+		uint32_t Rollbacks          = 0;
+		uint64_t ResimulatedFrames  = 0;
+		uint32_t MaxRollbackFrames  = 0;
+		double   ResimulatedSeconds = 0.0;
+		uint32_t StalledFrames      = 0; // beginFrame() calls that had to wait for remote input
+	};
+
+	/**
+	 * @param inputDelay Frames between local input being read and the frame it applies to, hides that much latency
+	 * without any rollback.
+	 */
+	RollbackSession(BudgetGBCore &core, uint32_t inputDelay = 1);
+
+	/**
+	 * @brief Open the local port and set the peer. The current state of the core is frame 0 of the session.
+	 * @return True on success, false otherwise.
+	 */
+	bool connect(uint16_t localPort, const std::string &peerAddress, uint16_t peerPort);
+
+	/**
+	 * @brief Exchange input with the peer and roll back if needed, then set up the joypad for the next frame. Calling
+	 * it again without endFrame() in between is allowed, local buttons are only read once per frame.
+	 * @param localButtons Joypad::getButtons() mask of the local player.
+	 * @return True if the next frame can run, false while waiting for remote input.
+	 */
+	bool beginFrame(uint8_t localButtons);
+
+	// the frame set up by beginFrame() ran
+	void endFrame()
+	{
+		++m_frame;
+	}
+
+	/**
+	 * @brief Exchange input with the peer and roll back if needed without starting a frame.
+	 */
+	void poll();
+
+	// every frame run so far used the real remote input
+	bool isConfirmed() const
+	{
+		return m_remoteConfirmedEnd >= m_frame;
+	}
+
+	bool hasStartStateMismatch() const
+	{
+		return m_startStateMismatch;
+	}
+
+	uint32_t getFrame() const
+	{
+		return m_frame;
+	}
+
+	const Stats &getStats() const
+	{
+		return m_stats;
+	}
+
+	uint16_t getLocalPort() const
+	{
+		return m_socket.getLocalPort();
+	}
+
+  private:
+	static constexpr uint32_t PACKET_MAGIC      = 0x4E424742; // "BGBN" little endian
+	static constexpr uint32_t INPUT_WINDOW      = 128;        // frames of input kept, far more than can be in flight
+	static constexpr uint32_t STATE_SLOTS       = MAX_ROLLBACK_FRAMES + 1;
+	static constexpr uint32_t MAX_PACKET_INPUTS = 64;
+	static constexpr uint32_t NO_ROLLBACK       = UINT32_MAX;
+
+	BudgetGBCore    &m_core;
+	Utils::UdpSocket m_socket;
+	const uint32_t   m_inputDelay;
+
+	uint32_t m_frame = 0; // next frame to run
+
+	std::array<uint8_t, INPUT_WINDOW> m_localInputs{};
+	std::array<uint8_t, INPUT_WINDOW> m_remoteInputs{}; // confirmed input, or the prediction a frame ran with
+	uint32_t                          m_localInputEnd      = 0; // local input is known for frames before this
+	uint32_t                          m_remoteConfirmedEnd = 0; // remote input is confirmed for frames before this
+	uint32_t                          m_remoteAckedEnd     = 0; // peer has confirmed local input for frames before this
+	uint8_t                           m_lastRemoteInput    = 0;
+	uint32_t                          m_rollbackFrame      = NO_ROLLBACK; // first frame that ran with a wrong prediction
+
+	std::array<Utils::StateWriter, STATE_SLOTS> m_states; // state at the start of each frame that may be rolled back to
+
+	uint64_t m_startStateHash     = 0;
+	bool     m_startStateMismatch = false;
+
+	Utils::StateWriter       m_packetWriter;
+	std::array<uint8_t, 512> m_packetBuffer{};
+	Stats                    m_stats;
+
+	void receivePackets();
+	void sendInputs();
+
+	// load the state at the start of frame and run every frame up to the current one again
+	void rollback(uint32_t frame);
+
+	// joypad buttons for a frame, predicting the remote input if it is not confirmed
+	uint8_t getFrameInput(uint32_t frame);
+};
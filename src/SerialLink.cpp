@@ -0,0 +1,140 @@
+#include "SerialLink.h"
+
+#include <chrono>
+#include <thread>
+
+bool SerialLink::exchange(uint64_t barrier, const PortState &local, PortState &remote)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MS);
+
+	barrier += m_barrierOffset;
+	sendMessage(Message{barrier, local});
+	++m_stats.Exchanges;
+
+	bool peerBehind = false;
+	bool waited     = false;
+
+	while (true)
+	{
+		Message message;
+		while (receiveMessage(message))
+		{
+			if (message.Barrier == barrier)
+			{
+				remote    = message.State;
+				m_stalled = false;
+				return true;
+			}
+
+			if (message.Barrier > barrier)
+			{
+				// the peer ran on without this side after a timeout, carry on from its barrier. It is waiting for a
+				// message under its own barrier number
+				m_barrierOffset += message.Barrier - barrier;
+				sendMessage(Message{message.Barrier, local});
+
+				remote    = message.State;
+				m_stalled = false;
+				++m_stats.Resyncs;
+				return true;
+			}
+
+			// an older barrier, the peer is catching up and will get here
+			peerBehind = true;
+		}
+
+		if (m_stalled && !peerBehind)
+			return false;
+
+		if (std::chrono::steady_clock::now() >= deadline)
+		{
+			m_stats.Timeouts += !m_stalled;
+			m_stalled = true;
+			return false;
+		}
+
+		m_stats.Waits += !waited;
+		waited = true;
+
+		// the peer is usually a fraction of a quantum away, sleeping would overshoot that many times over
+		std::this_thread::yield();
+	}
+}
+
+std::pair<std::unique_ptr<LocalSerialLink>, std::unique_ptr<LocalSerialLink>> LocalSerialLink::createPair()
+{
+	auto queues = std::make_shared<std::array<Queue, 2>>();
+
+	std::unique_ptr<LocalSerialLink> first(new LocalSerialLink());
+	first->m_queues       = queues;
+	first->m_sendQueue    = &(*queues)[0];
+	first->m_receiveQueue = &(*queues)[1];
+
+	std::unique_ptr<LocalSerialLink> second(new LocalSerialLink());
+	second->m_queues       = queues;
+	second->m_sendQueue    = &(*queues)[1];
+	second->m_receiveQueue = &(*queues)[0];
+
+	return {std::move(first), std::move(second)};
+}
+
+void LocalSerialLink::sendMessage(const Message &message)
+{
+	const uint32_t writeIndex = m_sendQueue->WriteIndex.load(std::memory_order_relaxed);
+	if (writeIndex - m_sendQueue->ReadIndex.load(std::memory_order_acquire) == QUEUE_SIZE)
+		return;
+
+	m_sendQueue->Messages[writeIndex & (QUEUE_SIZE - 1)] = message;
+	m_sendQueue->WriteIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+bool LocalSerialLink::receiveMessage(Message &message)
+{
+	const uint32_t readIndex = m_receiveQueue->ReadIndex.load(std::memory_order_relaxed);
+	if (readIndex == m_receiveQueue->WriteIndex.load(std::memory_order_acquire))
+		return false;
+
+	message = m_receiveQueue->Messages[readIndex & (QUEUE_SIZE - 1)];
+	m_receiveQueue->ReadIndex.store(readIndex + 1, std::memory_order_release);
+	return true;
+}
+
+bool UdpSerialLink::connect(uint16_t localPort, const std::string &peerAddress, uint16_t peerPort)
+{
+	return m_socket.open(localPort) && m_socket.setPeer(peerAddress, peerPort);
+}
+
+void UdpSerialLink::sendMessage(const Message &message)
+{
+	uint32_t magic   = PACKET_MAGIC;
+	uint64_t barrier = message.Barrier;
+	uint8_t  data    = message.State.Data;
+	uint8_t  flags   = static_cast<uint8_t>(message.State.Ready | message.State.Done << 1);
+
+	m_packetWriter.begin();
+	m_packetWriter(magic, barrier, data, flags);
+
+	m_socket.send(m_packetWriter.getBuffer().data(), m_packetWriter.getSize());
+}
+
+bool UdpSerialLink::receiveMessage(Message &message)
+{
+	std::size_t size;
+	while ((size = m_socket.receive(m_packetBuffer.data(), m_packetBuffer.size())) > 0)
+	{
+		Utils::StateReader reader(m_packetBuffer.data(), size);
+
+		uint32_t magic = 0;
+		uint8_t  flags = 0;
+		reader(magic, message.Barrier, message.State.Data, flags);
+
+		if (!reader.isOk() || magic != PACKET_MAGIC)
+			continue;
+
+		message.State.Ready = flags & 1;
+		message.State.Done  = flags & 2;
+		return true;
+	}
+
+	return false;
+}
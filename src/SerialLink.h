@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "utils/stateArchive.h"
+#include "utils/udpSocket.h"
+
+/**
+ * @brief One end of a link cable between two emulator instances, see Serial.
+ *
+ * Both sides stop every quantum of emulated t-cycles, counted from when the link was plugged in, and swap the state of
+ * their serial port. A transfer is settled at the first exchange after the side on the internal clock shifted out
+ * its byte, so the two instances never drift more than a quantum apart and a transfer finishes at most a quantum late.
+ * A side whose peer does not show up within TIMEOUT runs on as if unplugged and picks the peer up again once it
+ * answers, from whichever of the two is further ahead. Both sides must use the same quantum.
+ */
+class SerialLink
+{
+  public:
+	static constexpr uint32_t DEFAULT_QUANTUM = 1024; // t-cycles, about 4000 exchanges per emulated second
+
+	struct PortState
+	{
+		uint8_t Data  = 0xFF;
+		bool    Ready = false; // a transfer on the external clock is waiting for the other side
+		bool    Done  = false; // a transfer on the internal clock shifted out its byte
+	};
+
+	struct Stats
+	{
+		uint64_t Exchanges = 0;
+		uint64_t Waits     = 0; // exchanges where the peer had not reached the barrier yet
+		uint32_t Timeouts  = 0; // times the peer stopped answering
+		uint32_t Resyncs   = 0; // times the barriers jumped ahead to a peer that ran on without this side
+	};
+
+	virtual ~SerialLink() = default;
+
+	/**
+	 * @brief Swap port states with the peer at a barrier, waits for the peer to reach it.
+	 * @param barrier t-cycles since the link was plugged in.
+	 * @return False if the peer did not answer, remote is left as it was.
+	 */
+	bool exchange(uint64_t barrier, const PortState &local, PortState &remote);
+
+	uint32_t getQuantum() const
+	{
+		return m_quantum;
+	}
+
+	// set before plugging the link in
+	void setQuantum(uint32_t quantum)
+	{
+		m_quantum = quantum;
+	}
+
+	const Stats &getStats() const
+	{
+		return m_stats;
+	}
+
+  protected:
+	struct Message
+	{
+		uint64_t  Barrier = 0;
+		PortState State;
+	};
+
+	virtual void sendMessage(const Message &message) = 0;
+
+	// next message from the peer in the order it was sent, false if none is pending
+	virtual bool receiveMessage(Message &message) = 0;
+
+  private:
+	static constexpr uint32_t TIMEOUT_MS = 250;
+
+	uint32_t m_quantum       = DEFAULT_QUANTUM;
+	uint64_t m_barrierOffset = 0;     // added to barriers, moved forward when resyncing with a peer that ran ahead
+	bool     m_stalled       = false; // the peer timed out, barriers go by without waiting until it answers
+	Stats    m_stats;
+};
+
+/**
+ * @brief Link cable between two instances in the same process, each running on its own thread.
+ */
+class LocalSerialLink : public SerialLink
+{
+  public:
+	/**
+	 * @brief Create both ends of a link, each is used by one thread only.
+	 */
+	static std::pair<std::unique_ptr<LocalSerialLink>, std::unique_ptr<LocalSerialLink>> createPair();
+
+  protected:
+	void sendMessage(const Message &message) override;
+	bool receiveMessage(Message &message) override;
+
+  private:
+	static constexpr uint32_t QUEUE_SIZE = 256; // messages, a power of two. Sending to a full queue drops the message
+
+	// single producer single consumer ring of messages going one way
+	struct Queue
+	{
+		alignas(64) std::atomic<uint32_t> WriteIndex = 0;
+		alignas(64) std::atomic<uint32_t> ReadIndex  = 0;
+		std::array<Message, QUEUE_SIZE>   Messages{};
+	};
+
+	std::shared_ptr<std::array<Queue, 2>> m_queues;
+	Queue                                *m_sendQueue    = nullptr;
+	Queue                                *m_receiveQueue = nullptr;
+};
+
+/**
+ * @brief Link cable to an instance in another process over udp, meant for localhost where datagrams are not lost.
+ */
+class UdpSerialLink : public SerialLink
+{
+  public:
+	/**
+	 * @brief Open the local port and set the peer.
+	 * @param localPort 0 picks a free one, see getLocalPort().
+	 * @return True on success, false otherwise.
+	 */
+	bool connect(uint16_t localPort, const std::string &peerAddress, uint16_t peerPort);
+
+	uint16_t getLocalPort() const
+	{
+		return m_socket.getLocalPort();
+	}
+
+	// for a peer whose port is only known once its socket is open
+	bool setPeer(const std::string &peerAddress, uint16_t peerPort)
+	{
+		return m_socket.setPeer(peerAddress, peerPort);
+	}
+
+  protected:
+	void sendMessage(const Message &message) override;
+	bool receiveMessage(Message &message) override;
+
+  private:
+	static constexpr uint32_t PACKET_MAGIC = 0x4C424742; // "BGBL" little endian
+
+	Utils::UdpSocket        m_socket;
+	Utils::StateWriter      m_packetWriter;
+	std::array<uint8_t, 32> m_packetBuffer{};
+};
@@ -0,0 +1,151 @@
+#include "SharedMemoryChannel.h"
+#include "fmt/base.h"
+
+#include <algorithm>
+#include <new>
+
+using namespace SharedMemoryLayout;
+
+bool SharedMemoryPublisher::create(const std::string &name, const std::vector<uint16_t> &ramAddresses)
+{
+	close();
+
+	if (ramAddresses.size() > MAX_RAM_BYTES)
+	{
+		fmt::println(stderr, "Shared memory can publish at most {} memory bytes!", MAX_RAM_BYTES);
+		return false;
+	}
+
+	if (!m_memory.create(name, sizeof(Segment)))
+	{
+		fmt::println(stderr, "Failed to create shared memory: {}", name);
+		return false;
+	}
+
+	m_segment           = new (m_memory.data()) Segment{};
+	m_segment->Width    = BudgetGbConstants::LCD_WIDTH;
+	m_segment->Height   = BudgetGbConstants::LCD_HEIGHT;
+	m_segment->RamCount = static_cast<uint32_t>(ramAddresses.size());
+	std::copy(ramAddresses.begin(), ramAddresses.end(), m_segment->RamAddresses);
+
+	// consumers check the magic last, a segment with it set is fully initialized
+	m_segment->Version = VERSION;
+	std::atomic_thread_fence(std::memory_order_release);
+	m_segment->Magic = MAGIC;
+
+	m_frameCount = 0;
+	return true;
+}
+
+void SharedMemoryPublisher::close()
+{
+	m_memory.close();
+	m_segment = nullptr;
+}
+
+void SharedMemoryPublisher::publishFrame(BudgetGBCore &core, bool paused)
+{
+	const uint32_t sequence = m_segment->Sequence.load(std::memory_order_relaxed);
+
+	m_segment->Sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	m_segment->Paused      = paused;
+	m_segment->SampleRate  = core.m_apu.getSampleRate();
+	m_segment->FrameCount  = ++m_frameCount;
+	m_segment->Framebuffer = core.getFramebuffer();
+
+	for (uint32_t i = 0; i < m_segment->RamCount; ++i)
+		m_segment->Ram[i] = core.m_bus.busReadRaw(m_segment->RamAddresses[i]);
+
+	m_segment->Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SharedMemoryPublisher::publishAudio(const float *samples, uint32_t count)
+{
+	uint64_t writeIndex = m_segment->AudioWriteIndex.load(std::memory_order_relaxed);
+
+	for (uint32_t i = 0; i < count; ++i)
+		m_segment->Audio[(writeIndex + i) & (AUDIO_RING_SIZE - 1)] = samples[i];
+
+	m_segment->AudioWriteIndex.store(writeIndex + count, std::memory_order_release);
+}
+
+bool SharedMemoryPublisher::popCommand(Command &command)
+{
+	const uint32_t readIndex = m_segment->CommandReadIndex.load(std::memory_order_relaxed);
+	if (readIndex == m_segment->CommandWriteIndex.load(std::memory_order_acquire))
+		return false;
+
+	command = m_segment->Commands[readIndex & (COMMAND_RING_SIZE - 1)];
+	m_segment->CommandReadIndex.store(readIndex + 1, std::memory_order_release);
+	return true;
+}
+
+bool SharedMemoryClient::open(const std::string &name)
+{
+	close();
+
+	if (!m_memory.open(name) || m_memory.size() < sizeof(Segment))
+	{
+		fmt::println(stderr, "Failed to open shared memory: {}", name);
+		close();
+		return false;
+	}
+
+	m_segment = reinterpret_cast<Segment *>(m_memory.data());
+
+	const bool initialized = m_segment->Magic == MAGIC;
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	if (!initialized || m_segment->Version != VERSION)
+	{
+		fmt::println(stderr, "Shared memory {} is not a version {} BudgetGB segment!", name, VERSION);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void SharedMemoryClient::close()
+{
+	m_memory.close();
+	m_segment = nullptr;
+}
+
+uint32_t SharedMemoryClient::readAudio(float *buffer, uint32_t size, uint64_t &readIndex) const
+{
+	uint64_t writeIndex = m_segment->AudioWriteIndex.load(std::memory_order_acquire);
+
+	if (writeIndex - readIndex > AUDIO_RING_SIZE)
+		readIndex = writeIndex - AUDIO_RING_SIZE;
+
+	const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(writeIndex - readIndex, size));
+	for (uint32_t i = 0; i < count; ++i)
+		buffer[i] = m_segment->Audio[(readIndex + i) & (AUDIO_RING_SIZE - 1)];
+
+	// samples the emulator wrote over while they were copied are dropped from the front
+	std::atomic_thread_fence(std::memory_order_acquire);
+	writeIndex = m_segment->AudioWriteIndex.load(std::memory_order_relaxed);
+
+	uint32_t overwritten = 0;
+	if (writeIndex - readIndex > AUDIO_RING_SIZE)
+		overwritten = static_cast<uint32_t>(std::min<uint64_t>(writeIndex - readIndex - AUDIO_RING_SIZE, count));
+
+	std::copy(buffer + overwritten, buffer + count, buffer);
+	readIndex += count;
+
+	return count - overwritten;
+}
+
+bool SharedMemoryClient::pushCommand(CommandType type, uint32_t argument)
+{
+	const uint32_t writeIndex = m_segment->CommandWriteIndex.load(std::memory_order_relaxed);
+	if (writeIndex - m_segment->CommandReadIndex.load(std::memory_order_acquire) == COMMAND_RING_SIZE)
+		return false;
+
+	m_segment->Commands[writeIndex & (COMMAND_RING_SIZE - 1)] = Command{type, argument};
+	m_segment->CommandWriteIndex.store(writeIndex + 1, std::memory_order_release);
+	return true;
+}
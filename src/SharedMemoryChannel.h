@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BudgetGBCore.h"
+#include "emulatorConstants.h"
+#include "utils/sharedMemory.h"
+
+/**
+ * @brief Layout of the shared memory segment a running emulator publishes to local tools such as bots, recorders and
+ * dashboards. Consumers map it with SharedMemoryClient, or any other language that can map a POSIX shared memory
+ * object, and read frames in place.
+ *
+ * Sequence up to Framebuffer is covered by a seqlock: the emulator makes Sequence odd, writes the frame, ram and frame
+ * count, then makes it even again. A read is consistent when Sequence was the same even value before and after it.
+ * Audio is a ring of mono samples that only moves forward, AudioWriteIndex counts every sample ever written. Commands
+ * go the other way through a single producer single consumer ring, the emulator applies them before its next frame.
+ */
+namespace SharedMemoryLayout
+{
+constexpr uint32_t MAGIC   = 0x53424742; // "BGBS"
+constexpr uint32_t VERSION = 1;
+
+constexpr uint32_t MAX_RAM_BYTES     = 256;
+constexpr uint32_t AUDIO_RING_SIZE   = 1 << 14; // samples, a power of two
+constexpr uint32_t COMMAND_RING_SIZE = 64;      // a power of two
+
+enum class CommandType : uint32_t
+{
+	SetInput  = 1, // Argument is a Joypad::getButtons() mask
+	Pause     = 2,
+	Resume    = 3,
+	SaveState = 4, // save or load the state slot of the loaded rom
+	LoadState = 5,
+};
+
+struct Command
+{
+	CommandType Type;
+	uint32_t    Argument;
+};
+
+struct Segment
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t RamCount;
+	uint16_t RamAddresses[MAX_RAM_BYTES];
+
+	alignas(64) std::atomic<uint32_t> Sequence;
+	uint32_t                          Paused;     // 1 while the emulator is paused
+	uint32_t                          SampleRate; // of the audio ring, follows output format changes
+	uint64_t                          FrameCount; // bumped on every publish, poll it for new frames
+	uint8_t                           Ram[MAX_RAM_BYTES]; // values of RamAddresses at the end of the frame
+	BudgetGbConstants::LcdColorBuffer Framebuffer;        // color indices 0 - 3
+
+	alignas(64) std::atomic<uint64_t> AudioWriteIndex;
+	float                             Audio[AUDIO_RING_SIZE];
+
+	// the two indices are on separate cache lines, each is only written by one side
+	alignas(64) std::atomic<uint32_t> CommandWriteIndex;
+	alignas(64) std::atomic<uint32_t> CommandReadIndex;
+	Command                           Commands[COMMAND_RING_SIZE];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free, "Atomics in shared memory must be lock free");
+} // namespace SharedMemoryLayout
+
+/**
+ * @brief Emulator side of the shared memory channel, creates the segment and owns its name.
+ */
+class SharedMemoryPublisher
+{
+  public:
+	/**
+	 * @brief Create the segment, replacing one left behind by a crashed run under the same name.
+	 * @param ramAddresses Memory bytes published with every frame, at most MAX_RAM_BYTES.
+	 * @return True on success, false otherwise.
+	 */
+	bool create(const std::string &name, const std::vector<uint16_t> &ramAddresses);
+	void close();
+
+	bool isOpen() const
+	{
+		return m_memory.isOpen();
+	}
+
+	/**
+	 * @brief Publish the last frame of core with the seqlock, called once per emulated frame at vblank.
+	 */
+	void publishFrame(BudgetGBCore &core, bool paused);
+
+	/**
+	 * @brief Append output samples to the audio ring, from the one thread that drains the apu.
+	 */
+	void publishAudio(const float *samples, uint32_t count);
+
+	/**
+	 * @brief Take the oldest command sent by a consumer.
+	 * @return False if there is none.
+	 */
+	bool popCommand(SharedMemoryLayout::Command &command);
+
+  private:
+	Utils::SharedMemory          m_memory;
+	SharedMemoryLayout::Segment *m_segment    = nullptr;
+	uint64_t                     m_frameCount = 0;
+};
+
+/**
+ * @brief Consumer side of the shared memory channel.
+ */
+class SharedMemoryClient
+{
+  public:
+	/**
+	 * @brief Map the segment of a running emulator.
+	 * @return True on success, false if there is none with that name or it has another layout version.
+	 */
+	bool open(const std::string &name);
+	void close();
+
+	const SharedMemoryLayout::Segment *getSegment() const
+	{
+		return m_segment;
+	}
+
+	/**
+	 * @brief Run read on the segment in place under the seqlock, again until it saw a consistent frame. read must only
+	 * look at the segment, what it saw is thrown away on a retry.
+	 * @return False if no consistent frame was seen within maxAttempts.
+	 */
+	template <typename Fn>
+	bool readFrame(Fn &&read, uint32_t maxAttempts = 1000) const
+	{
+		for (uint32_t attempt = 0; attempt < maxAttempts; ++attempt)
+		{
+			const uint32_t before = m_segment->Sequence.load(std::memory_order_acquire);
+			if (before & 1)
+				continue;
+
+			read(*m_segment);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (m_segment->Sequence.load(std::memory_order_relaxed) == before)
+				return true;
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Copy audio samples written since readIndex and advance it. A reader that fell more than a ring behind
+	 * skips ahead to the oldest sample still in the ring.
+	 * @return Number of samples read.
+	 */
+	uint32_t readAudio(float *buffer, uint32_t size, uint64_t &readIndex) const;
+
+	/**
+	 * @return False if the command ring is full.
+	 */
+	bool pushCommand(SharedMemoryLayout::CommandType type, uint32_t argument = 0);
+
+  private:
+	Utils::SharedMemory          m_memory;
+	SharedMemoryLayout::Segment *m_segment = nullptr;
+};
@@ -0,0 +1,77 @@
+#include "StateIndex.h"
+
+#include <algorithm>
+#include <utility>
+
+StateIndex::StateIndex(std::size_t expectedStates)
+{
+	// kept at most half full so probe runs stay short
+	std::size_t capacity = 16;
+	while (capacity < expectedStates * 2)
+		capacity *= 2;
+
+	m_slots.resize(capacity, EMPTY_SLOT);
+}
+
+bool StateIndex::insert(uint64_t hash)
+{
+	if (hash == EMPTY_SLOT)
+	{
+		if (m_hasZero)
+			return false;
+
+		m_hasZero = true;
+		++m_count;
+		return true;
+	}
+
+	std::size_t slot = findSlot(hash);
+	if (m_slots[slot] == hash)
+		return false;
+
+	m_slots[slot] = hash;
+	++m_count;
+
+	if (m_count * 2 > m_slots.size())
+		grow();
+
+	return true;
+}
+
+bool StateIndex::contains(uint64_t hash) const
+{
+	if (hash == EMPTY_SLOT)
+		return m_hasZero;
+
+	return m_slots[findSlot(hash)] == hash;
+}
+
+void StateIndex::clear()
+{
+	std::fill(m_slots.begin(), m_slots.end(), EMPTY_SLOT);
+	m_count   = 0;
+	m_hasZero = false;
+}
+
+std::size_t StateIndex::findSlot(uint64_t hash) const
+{
+	const std::size_t mask = m_slots.size() - 1;
+	std::size_t       slot = static_cast<std::size_t>(hash) & mask;
+
+	while (m_slots[slot] != EMPTY_SLOT && m_slots[slot] != hash)
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+void StateIndex::grow()
+{
+	std::vector<uint64_t> slots(m_slots.size() * 2, EMPTY_SLOT);
+	std::swap(slots, m_slots);
+
+	for (uint64_t hash : slots)
+	{
+		if (hash != EMPTY_SLOT)
+			m_slots[findSlot(hash)] = hash;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Set of state hashes already visited, lets an exploration drop branches that reach a state it has seen. Keys
+ * are BudgetGBCore::hashState() or hashRam() values, which are already well mixed, so they index the open addressed
+ * table directly and a lookup touches one or two cache lines. Not thread safe, insert the hashes of branches run on a
+ * thread pool from one thread.
+ */
+class StateIndex
+{
+  public:
+	/**
+	 * @param expectedStates Table is sized to hold this many hashes without growing.
+	 */
+	explicit StateIndex(std::size_t expectedStates = 1024);
+
+	/**
+	 * @return True if hash was not in the index yet.
+	 */
+	bool insert(uint64_t hash);
+
+	bool contains(uint64_t hash) const;
+
+	void clear();
+
+	std::size_t size() const
+	{
+		return m_count;
+	}
+
+  private:
+	static constexpr uint64_t EMPTY_SLOT = 0; // a hash of 0 is tracked by m_hasZero instead
+
+	std::vector<uint64_t> m_slots;
+	std::size_t           m_count   = 0;
+	bool                  m_hasZero = false;
+
+	// slot holding hash, or the empty slot it would go in
+	std::size_t findSlot(uint64_t hash) const;
+
+	void grow();
+};
@@ -0,0 +1,153 @@
+#include "TimeStretch.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double OVERLAP_SECONDS = 0.010; // 20ms segments overlapped by half
+constexpr double SEARCH_SECONDS  = 0.005; // long enough to cover a full period of anything above 200hz
+constexpr int    COARSE_STEP     = 4;     // search every 4th offset first, then refine around the best one
+} // namespace
+
+TimeStretch::TimeStretch(uint32_t sampleRate, Utils::SimdLevel simdLevel)
+	: m_overlap((static_cast<uint32_t>(sampleRate * OVERLAP_SECONDS) + 7) & ~7u),
+	  m_searchRange(static_cast<uint32_t>(sampleRate * SEARCH_SECONDS)),
+	  m_dotProduct(Utils::getDotProduct(simdLevel))
+{
+	const uint32_t segment = m_overlap * 2;
+
+	m_window.resize(segment);
+	for (uint32_t i = 0; i < segment; ++i)
+		m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * i / segment));
+
+	m_tail.resize(m_overlap);
+	m_energy.resize(static_cast<std::size_t>(m_searchRange) * 2 + m_overlap + 1);
+
+	reset();
+}
+
+void TimeStretch::setSpeed(float speed)
+{
+	m_speed = std::clamp(speed, 1.0f, MAX_SPEED);
+}
+
+void TimeStretch::reset()
+{
+	std::fill(m_tail.begin(), m_tail.end(), 0.0f);
+
+	m_input.clear();
+	m_output.clear();
+	m_outputRead  = 0;
+	m_analysisPos = 0.0;
+	m_previousPos = -1;
+}
+
+void TimeStretch::push(const float *samples, uint32_t count)
+{
+	m_input.insert(m_input.end(), samples, samples + count);
+
+	while (processSegment())
+		;
+}
+
+uint32_t TimeStretch::read(float *buffer, uint32_t size)
+{
+	const uint32_t count = std::min(size, getSamplesAvail());
+
+	std::copy(m_output.begin() + m_outputRead, m_output.begin() + m_outputRead + count, buffer);
+	m_outputRead += count;
+
+	if (m_outputRead == m_output.size())
+	{
+		m_output.clear();
+		m_outputRead = 0;
+	}
+
+	return count;
+}
+
+bool TimeStretch::processSegment()
+{
+	const int64_t target = static_cast<int64_t>(m_analysisPos);
+
+	// the whole search region and the natural continuation of the previous segment have to be buffered
+	const int64_t buffered = static_cast<int64_t>(m_input.size());
+	if (target + m_searchRange + m_overlap * 2 > buffered || (m_previousPos >= 0 && m_previousPos + m_overlap * 2 > buffered))
+		return false;
+
+	const int64_t position = m_previousPos < 0 ? target : target + findBestOffset(target);
+	const float  *segment  = &m_input[position];
+
+	for (uint32_t i = 0; i < m_overlap; ++i)
+		m_output.push_back(m_tail[i] + segment[i] * m_window[i]);
+
+	for (uint32_t i = 0; i < m_overlap; ++i)
+		m_tail[i] = segment[m_overlap + i] * m_window[m_overlap + i];
+
+	m_previousPos = position;
+	m_analysisPos += m_overlap * static_cast<double>(m_speed);
+
+	discardInput();
+	return true;
+}
+
+int TimeStretch::findBestOffset(int64_t target)
+{
+	// the previous segment's second half continues best into itself, look for the offset that resembles it most
+	const float  *reference = &m_input[m_previousPos + m_overlap];
+	const int64_t first     = std::max<int64_t>(target - m_searchRange, 0);
+	const int64_t last      = target + m_searchRange;
+
+	// prefix sums of squares give the energy of every candidate for normalizing the correlation
+	m_energy[0] = 0.0;
+	for (int64_t i = first; i < last + m_overlap; ++i)
+		m_energy[i - first + 1] = m_energy[i - first] + static_cast<double>(m_input[i]) * m_input[i];
+
+	auto score = [&](int64_t candidate) {
+		const double correlation = m_dotProduct(&m_input[candidate], reference, m_overlap);
+		const double energy      = m_energy[candidate - first + m_overlap] - m_energy[candidate - first];
+		return correlation / std::sqrt(energy + 1e-9);
+	};
+
+	int64_t best      = target;
+	double  bestScore = score(target);
+
+	for (int64_t candidate = first; candidate <= last; candidate += COARSE_STEP)
+	{
+		const double candidateScore = score(candidate);
+		if (candidateScore > bestScore)
+		{
+			best      = candidate;
+			bestScore = candidateScore;
+		}
+	}
+
+	const int64_t coarseBest = best;
+	for (int64_t candidate = std::max(coarseBest - COARSE_STEP + 1, first); candidate <= std::min(coarseBest + COARSE_STEP - 1, last); ++candidate)
+	{
+		const double candidateScore = score(candidate);
+		if (candidateScore > bestScore)
+		{
+			best      = candidate;
+			bestScore = candidateScore;
+		}
+	}
+
+	return static_cast<int>(best - target);
+}
+
+void TimeStretch::discardInput()
+{
+	// keep everything the next search or continuation can still reach, drop the rest in large chunks
+	const int64_t keepFrom = std::min<int64_t>(static_cast<int64_t>(m_analysisPos) - m_searchRange, m_previousPos);
+
+	if (keepFrom < static_cast<int64_t>(m_overlap) * 8)
+		return;
+
+	m_input.erase(m_input.begin(), m_input.begin() + keepFrom);
+	m_analysisPos -= static_cast<double>(keepFrom);
+	m_previousPos -= keepFrom;
+}
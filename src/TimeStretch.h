@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/simd.h"
+
+/**
+ * @brief Streaming WSOLA (waveform similarity overlap-add) time compression. Plays audio back faster than it was
+ * produced without shifting its pitch by overlap-adding windowed segments that are picked from the input at the playback
+ * speed, each one nudged within a small search range to line up with the waveform of the previous segment.
+ */
+class TimeStretch
+{
+  public:
+	static constexpr float MAX_SPEED = 8.0f;
+
+	TimeStretch(uint32_t sampleRate, Utils::SimdLevel simdLevel = Utils::detectSimdLevel());
+
+	/**
+	 * @brief Set how many seconds of input are compressed into one second of output, clamped to 1 - MAX_SPEED.
+	 */
+	void setSpeed(float speed);
+
+	float getSpeed() const
+	{
+		return m_speed;
+	}
+
+	/**
+	 * @brief Queue input samples, output is produced one segment hop at a time once enough input is buffered.
+	 */
+	void push(const float *samples, uint32_t count);
+
+	/**
+	 * @brief Read out compressed samples.
+	 * @return Number of samples read.
+	 */
+	uint32_t read(float *buffer, uint32_t size);
+
+	uint32_t getSamplesAvail() const
+	{
+		return static_cast<uint32_t>(m_output.size() - m_outputRead);
+	}
+
+	void reset();
+
+  private:
+	uint32_t m_overlap;     // samples overlap-added between segments, also the output hop. multiple of 8 for the simd kernels
+	uint32_t m_searchRange; // max samples a segment is shifted from its ideal position
+
+	float m_speed = 1.0f;
+
+	std::vector<float>  m_window; // hann window of 2 * overlap, halves sum to 1 when overlapped
+	std::vector<float>  m_tail;   // windowed second half of the previous segment
+	std::vector<double> m_energy; // prefix sums of squared input across the search region
+
+	std::vector<float> m_input;
+	double             m_analysisPos = 0.0;   // ideal input position of the next segment
+	int64_t            m_previousPos = -1;    // input position of the previous segment, -1 before the first
+	std::vector<float> m_output;
+	std::size_t        m_outputRead = 0;
+
+	Utils::DotProductFn m_dotProduct;
+
+	bool processSegment();
+	int  findBestOffset(int64_t target);
+	void discardInput();
+};
@@ -1,61 +1,16 @@
 #include "apu.h"
 #include "IORegisters.h"
-#include "fmt/core.h"
 
 #include <algorithm>
 
-namespace
+Apu::Apu(uint32_t sampleRate, ResamplerQuality quality)
+	: m_boxFilter(sampleRate, quality)
 {
-void SDLCALL audioDeviceStreamCallback(void *userdata, SDL_AudioStream *audioStream, int additionalAmount, int totalAmount)
-{
-	(void)additionalAmount;
-
-	Apu::AudioCallbackData *callBackData = (Apu::AudioCallbackData *)userdata;
-	totalAmount /= sizeof(float);
-
-	SDL_LockMutex(callBackData->AudioThreadCtx.Mutex);
-
-	while (totalAmount > 0)
-	{
-		std::array<float, 128> samples;
-
-		const int total = std::min(totalAmount, (int)samples.size());
-
-		const uint32_t samplesRead = callBackData->Buffer->readSamples(samples.data(), total);
-
-		if (samplesRead == 0)
-			break;
-
-		SDL_PutAudioStreamData(audioStream, samples.data(), samplesRead * sizeof(samples[0]));
-		totalAmount -= samplesRead;
-	}
-
-	SDL_UnlockMutex(callBackData->AudioThreadCtx.Mutex);
-}
-} // namespace
-
-Apu::Apu(uint32_t sampleRate)
-	: m_boxFilter(sampleRate)
-{
-	if (!(m_audioCallbackData.AudioThreadCtx.Mutex = SDL_CreateMutex()))
-		fmt::println("{}", SDL_GetError());
-
-	if (!m_audioStream)
-		fmt::println("{}", SDL_GetError());
-
-	SDL_AudioSpec audioSpec{};
-	audioSpec.format   = SDL_AUDIO_F32;
-	audioSpec.freq     = sampleRate;
-	audioSpec.channels = 1;
-
-	m_audioCallbackData.Buffer = &m_boxFilter;
-
-	m_audioStream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &audioSpec, audioDeviceStreamCallback, (void *)&m_audioCallbackData);
 }
 
 bool Apu::beginAudioFrame()
 {
-	SDL_LockMutex(m_audioCallbackData.AudioThreadCtx.Mutex);
+	m_outputMutex.lock();
 
 	if (m_boxFilter.getSamplesAvail() > m_boxFilter.getAudioFrameSize() * 2)
 	{
@@ -70,7 +25,13 @@ bool Apu::beginAudioFrame()
 
 void Apu::endAudioFrame()
 {
-	SDL_UnlockMutex(m_audioCallbackData.AudioThreadCtx.Mutex);
+	m_outputMutex.unlock();
+}
+
+uint32_t Apu::pullSamples(float *buffer, uint32_t size)
+{
+	std::lock_guard<std::mutex> lock(m_outputMutex);
+	return m_boxFilter.readSamples(buffer, size);
 }
 
 void Apu::tick(uint8_t divider)
@@ -105,7 +66,9 @@ void Apu::tick(uint8_t divider)
 		}
 	}
 
-	mixAudio();
+	if (m_outputEnabled)
+		mixAudio();
+
 	updateChannelStatus();
 
 	clockPulsePeriod(m_pulse1.PeriodAndDuty, m_pulse1.Registers.PeriodLo, m_pulse1.Registers.PeriodHiAndControl);
@@ -362,23 +325,25 @@ uint8_t Apu::readWaveRam(uint16_t position) const
 	return m_waveRam[position & 0xF];
 }
 
-void Apu::pauseAudio()
+void Apu::clearSamples()
 {
-	SDL_LockMutex(m_audioCallbackData.AudioThreadCtx.Mutex);
-	m_audioCallbackData.StopAudioPlayback = true;
-	SDL_UnlockMutex(m_audioCallbackData.AudioThreadCtx.Mutex);
-
-	SDL_PauseAudioStreamDevice(m_audioStream);
-	SDL_ClearAudioStream(m_audioStream);
+	std::lock_guard<std::mutex> lock(m_outputMutex);
+	m_boxFilter.clear();
 }
 
-void Apu::resumeAudio()
+void Apu::setOutputFormat(uint32_t sampleRate, ResamplerQuality quality)
 {
-	SDL_LockMutex(m_audioCallbackData.AudioThreadCtx.Mutex);
-	m_audioCallbackData.StopAudioPlayback = false;
-	SDL_UnlockMutex(m_audioCallbackData.AudioThreadCtx.Mutex);
+	if (sampleRate == m_boxFilter.getSampleRate() && quality == m_boxFilter.getQuality())
+		return;
 
-	SDL_ResumeAudioStreamDevice(m_audioStream);
+	std::lock_guard<std::mutex> lock(m_outputMutex);
+	m_boxFilter.configure(sampleRate, quality);
+}
+
+void Apu::setPlaybackSpeed(float speed)
+{
+	std::lock_guard<std::mutex> lock(m_outputMutex);
+	m_boxFilter.setPlaybackSpeed(speed);
 }
 
 void Apu::init(bool useBootrom)
@@ -428,6 +393,36 @@ void Apu::init(bool useBootrom)
 	m_boxFilter.clear();
 }
 
+void Apu::saveState(Utils::StateWriter &writer)
+{
+	serialize(writer);
+}
+
+void Apu::loadState(Utils::StateReader &reader)
+{
+	serialize(reader);
+}
+
+template <typename Archive>
+void Apu::serialize(Archive &archive)
+{
+	// register structs are single byte bitfields and copied whole, channel state is listed field by field to skip padding
+	archive(m_audioControl, m_masterVolume);
+
+	archive(m_pulse1.Registers, m_pulse1.PeriodAndDuty.PeriodDivider, m_pulse1.PeriodAndDuty.DutyCycleIndex);
+	archive(m_pulse1.VolumeEnvelope.Volume, m_pulse1.VolumeEnvelope.EnvelopePeriod, m_pulse1.Length.LengthPeriod);
+	archive(m_pulse1.FrequencySweep.TempPeriodDivider, m_pulse1.FrequencySweep.SweepPeriod);
+
+	archive(m_pulse2.Registers, m_pulse2.PeriodAndDuty.PeriodDivider, m_pulse2.PeriodAndDuty.DutyCycleIndex);
+	archive(m_pulse2.VolumeEnvelope.Volume, m_pulse2.VolumeEnvelope.EnvelopePeriod, m_pulse2.Length.LengthPeriod);
+
+	archive(m_wave.Registers, m_wave.PeriodDivider, m_wave.LengthPeriod, m_wave.Volume, m_wave.WaveRamIndex, m_wave.SampleBuffer);
+
+	archive(m_noise.Registers, m_noise.PeriodDivider, m_noise.LFSR, m_noise.LengthTimer, m_noise.EnvelopeTimer, m_noise.Volume);
+
+	archive(m_waveRam, m_prevDivider, m_apuDivider);
+}
+
 void Apu::Pulse1::clockPulseFrequencySweep()
 {
 	// do not perform freq sweep iterations if the sweep period is 0
@@ -508,12 +503,8 @@ uint8_t Apu::Pulse2::outputSample() const
 
 void Apu::mixAudio()
 {
-	float pulse1Sample = ((m_pulse1.outputSample() - 7.5f) / 7.5f) * (m_audioChannelToggle.Pulse1 ? 1.0f : 0.0f);
-	float pulse2Sample = ((m_pulse2.outputSample() - 7.5f) / 7.5f) * (m_audioChannelToggle.Pulse2 ? 1.0f : 0.0f);
-	float waveSample   = ((m_wave.outputSample() - 7.5f) / 7.5f) * (m_audioChannelToggle.Wave ? 1.0f : 0.0f);
-	float noiseSample  = ((m_noise.outputSample() - 7.5f) / 7.5f) * (m_audioChannelToggle.Noise ? 1.0f : 0.0f);
-
-	m_boxFilter.pushSample(BoxFilter::Samples{pulse1Sample, pulse2Sample, waveSample, noiseSample}, m_audioLogBuffers);
+	// channel toggles are applied as gains once per averaged box instead of every m-cycle
+	m_boxFilter.pushSample(BoxFilter::DacSamples{m_pulse1.outputSample(), m_pulse2.outputSample(), m_wave.outputSample(), m_noise.outputSample()});
 }
 
 void Apu::updateChannelStatus()
@@ -2,21 +2,56 @@
 
 #include <array>
 #include <cstdint>
+#include <mutex>
 #include <utility>
 
 #include "BoxFilter.h"
-#include "SDL3/SDL.h"
-#include "Utils/vec.h"
 #include "audioLogBuffer.h"
 #include "emulatorConstants.h"
+#include "utils/stateArchive.h"
+#include "utils/vec.h"
 
 class Apu
 {
   public:
-	Apu(uint32_t sampleRate);
-
+	/**
+	 * @brief Construct apu. Output samples are buffered until drained with readSamples() or pullSamples(), playing
+	 * them is left to the frontend.
+	 * @param sampleRate Output sample rate.
+	 * @param quality Resampler quality tier used to convert the dac output to sampleRate.
+	 */
+	Apu(uint32_t sampleRate, ResamplerQuality quality = ResamplerQuality::Medium);
+
+	/**
+	 * @brief Bracket a frame run while another thread drains samples with pullSamples().
+	 * @return False without holding the output lock when enough samples are buffered, the frame should be skipped.
+	 */
 	bool beginAudioFrame();
 	void endAudioFrame();
+
+	/**
+	 * @brief Drain output samples from another thread, such as an audio device callback.
+	 * @return Number of samples read.
+	 */
+	uint32_t pullSamples(float *buffer, uint32_t size);
+
+	/**
+	 * @brief Drain filtered output samples on the emulation thread, for headless runs with nothing pulling samples.
+	 * @param buffer Mixed output samples.
+	 * @param stems Per channel samples, can be nullptr. Only filled if stems are enabled.
+	 * @param size Max number of samples to read.
+	 * @return Number of samples read.
+	 */
+	uint32_t readSamples(float *buffer, BoxFilter::Samples *stems, uint32_t size)
+	{
+		return m_boxFilter.readSamples(buffer, stems, size);
+	}
+
+	void enableStems(bool enable)
+	{
+		m_boxFilter.enableStems(enable);
+	}
+
 	void tick(uint8_t divider);
 
 	void    writeIO(uint16_t position, uint8_t data);
@@ -25,16 +60,63 @@ class Apu
 	void    writeWaveRam(uint16_t position, uint8_t data);
 	uint8_t readWaveRam(uint16_t position) const;
 
-	void pauseAudio();
-	void resumeAudio();
+	// drop buffered output samples, used to discard audio of frames that are run again while rewinding
+	void clearSamples();
+
+	/**
+	 * @brief Stop pushing samples to the output filter, channels keep running. Used for frames that are emulated but
+	 * never heard, which also skips the cost of filtering them.
+	 */
+	void setOutputEnabled(bool enabled)
+	{
+		m_outputEnabled = enabled;
+	}
+
+	/**
+	 * @brief Change the output sample rate and resampler quality, a device playing the output has to be reopened at
+	 * the new rate. Buffered samples are dropped.
+	 */
+	void setOutputFormat(uint32_t sampleRate, ResamplerQuality quality);
+
+	/**
+	 * @brief Compress audio of emulation running at speed times real time into real time playback, keeping its pitch.
+	 * A speed of 1 turns time stretching off.
+	 */
+	void setPlaybackSpeed(float speed);
+
+	float getPlaybackSpeed() const
+	{
+		return m_boxFilter.getPlaybackSpeed();
+	}
+
+	uint32_t getSampleRate() const
+	{
+		return m_boxFilter.getSampleRate();
+	}
+
+	ResamplerQuality getQuality() const
+	{
+		return m_boxFilter.getQuality();
+	}
 
-	AudioLogging::AudioLogBuffers &getAudioLogBuffers()
+	/**
+	 * @brief Subscribe buffers to visualization capture of the output, nullptr unsubscribes. Capture costs nothing while
+	 * unsubscribed.
+	 */
+	void setAudioLogBuffers(AudioLogging::AudioLogBuffers *buffers)
 	{
-		return m_audioLogBuffers;
+		m_boxFilter.setAudioLogBuffers(buffers);
 	}
 
 	void init(bool useBootrom);
 
+	/**
+	 * @brief Save or load channel registers, timers and wave ram. Output filtering and buffered samples are not part
+	 * of the state, playback continues without a gap after a load.
+	 */
+	void saveState(Utils::StateWriter &writer);
+	void loadState(Utils::StateReader &reader);
+
 	static constexpr std::array<std::array<uint8_t, 8>, 4> WAVE_DUTIES = {{
 		{0, 0, 0, 0, 0, 0, 0, 1},
 		{0, 1, 1, 1, 1, 1, 1, 0},
@@ -408,17 +490,6 @@ class Apu
 		uint8_t outputSample() const;
 	};
 
-	struct AudioCallbackData
-	{
-		BoxFilter *Buffer            = nullptr;
-		bool       StopAudioPlayback = false;
-
-		struct AudioThreadContext
-		{
-			SDL_Mutex *Mutex = nullptr;
-		} AudioThreadCtx;
-	};
-
 	struct AudioChannelToggle
 	{
 		bool Pulse1 = true;
@@ -430,6 +501,13 @@ class Apu
 	void setAudioChannelToggle(const AudioChannelToggle &channelToggle)
 	{
 		m_audioChannelToggle = channelToggle;
+
+		m_boxFilter.setChannelGains(BoxFilter::Samples{
+			channelToggle.Pulse1 ? 1.0f : 0.0f,
+			channelToggle.Pulse2 ? 1.0f : 0.0f,
+			channelToggle.Wave ? 1.0f : 0.0f,
+			channelToggle.Noise ? 1.0f : 0.0f,
+		});
 	}
 
 	const AudioChannelToggle &getAudioChannelToggle() const
@@ -441,6 +519,9 @@ class Apu
 	void mixAudio();
 	void updateChannelStatus();
 
+	template <typename Archive>
+	void serialize(Archive &archive);
+
 	static void clockPulsePeriod(PulsePeriodDivider &in, RegisterPulsePeriodLo &periodLo, RegisterPulsePeriodHighAndControl &periodHi);
 	static void clockPulseVolumeEnvelope(PulseEnvelope &in, const RegisterVolumeAndEnvelope &reg);
 	static void clockPulseLength(PulseLength &in);
@@ -458,12 +539,9 @@ class Apu
 	uint16_t m_prevDivider = 0; // hold the previous divide value to detect a falling edge on bit 4
 	uint8_t  m_apuDivider  = 0; // incremented on bit 4 falling edge of system divider
 
-	SDL_AudioStream  *m_audioStream;
-	AudioCallbackData m_audioCallbackData{};
-
-	BoxFilter m_boxFilter;
-
-	AudioLogging::AudioLogBuffers m_audioLogBuffers;
+	BoxFilter  m_boxFilter;
+	std::mutex m_outputMutex; // held by the emulation thread while it fills m_boxFilter, see pullSamples()
+	bool       m_outputEnabled = true;
 
 	AudioChannelToggle m_audioChannelToggle;
 };
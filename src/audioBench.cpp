@@ -0,0 +1,467 @@
+#include "audioBench.h"
+#include "BoxFilter.h"
+#include "TimeStretch.h"
+#include "apu.h"
+#include "emulatorConstants.h"
+#include "fmt/base.h"
+#include "utils/simd.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t CLOCK_RATE_M = BudgetGbConstants::CLOCK_RATE_T / 4;
+
+constexpr std::array<ResamplerQuality, 4> QUALITIES = {ResamplerQuality::Box, ResamplerQuality::Low, ResamplerQuality::Medium, ResamplerQuality::High};
+
+constexpr double PI = 3.14159265358979323846;
+
+// worst aliasing in db each tier may measure at any output rate, in the order of QUALITIES
+constexpr std::array<double, QUALITIES.size()> ALIASING_CEILINGS = {-20.0, -40.0, -48.0, -58.0};
+
+// time stretch input, and how far the pitch and length of its output may be off
+constexpr double STRETCH_FREQUENCY        = 440.0;
+constexpr double STRETCH_PITCH_TOLERANCE  = 0.03;
+constexpr double STRETCH_LENGTH_TOLERANCE = 0.02;
+
+// square wave period in m-cycles, roughly 7khz and not a divisor of any output rate so aliases land between harmonics
+constexpr uint32_t SQUARE_PERIOD = 149;
+
+/**
+ * @brief Busy channel dac output resembling game audio, two pulses, a saw on the wave channel and lfsr noise.
+ */
+class DacSignal
+{
+  public:
+	BoxFilter::DacSamples next()
+	{
+		++m_cycle;
+
+		if ((m_cycle & 7) == 0)
+		{
+			const uint16_t bit = (m_lfsr ^ (m_lfsr >> 1)) & 1;
+			m_lfsr             = static_cast<uint16_t>((m_lfsr >> 1) | (bit << 14));
+		}
+
+		return BoxFilter::DacSamples{
+			static_cast<uint8_t>((m_cycle % SQUARE_PERIOD) < SQUARE_PERIOD / 2 ? 15 : 0),
+			static_cast<uint8_t>((m_cycle % 211) < 52 ? 9 : 0),
+			static_cast<uint8_t>((m_cycle / 16) & 0xF),
+			static_cast<uint8_t>((m_lfsr & 1) ? 6 : 0),
+		};
+	}
+
+  private:
+	uint64_t m_cycle = 0;
+	uint16_t m_lfsr  = 0x7FFF;
+};
+
+/**
+ * @brief Reference copy of the float box filter path the apu used before the resampler tiers, converting every m-cycle
+ * of dac output to float and averaging it. Kept only as the baseline for the benchmark.
+ */
+class LegacyBoxFilter
+{
+  public:
+	LegacyBoxFilter(uint32_t sampleRate)
+		: m_samplesPerAverage(static_cast<float>(CLOCK_RATE_M) / sampleRate),
+		  m_boxWidth(static_cast<uint32_t>(m_samplesPerAverage)),
+		  m_buffer((sampleRate / 60) * 8)
+	{
+	}
+
+	void pushSample(const BoxFilter::DacSamples &samples)
+	{
+		// conversion the apu did for every m-cycle before pushing float samples
+		m_sum.Pulse1 += ((samples.Pulse1 - 7.5f) / 7.5f) * (m_toggle.Pulse1 ? 1.0f : 0.0f);
+		m_sum.Pulse2 += ((samples.Pulse2 - 7.5f) / 7.5f) * (m_toggle.Pulse2 ? 1.0f : 0.0f);
+		m_sum.Wave += ((samples.Wave - 7.5f) / 7.5f) * (m_toggle.Wave ? 1.0f : 0.0f);
+		m_sum.Noise += ((samples.Noise - 7.5f) / 7.5f) * (m_toggle.Noise ? 1.0f : 0.0f);
+
+		const uint32_t widthWithError = m_boxWidth + static_cast<uint32_t>(m_error);
+
+		if (++m_count == widthWithError)
+		{
+			const float mix = (m_sum.Pulse1 + m_sum.Pulse2 + m_sum.Wave + m_sum.Noise) / widthWithError;
+
+			m_out            = (m_out * 0.996f) + (mix - m_prev);
+			m_prev           = mix;
+			m_samplesAvail   = std::min(m_samplesAvail + 1, static_cast<uint32_t>(m_buffer.size()));
+			m_buffer[m_head] = m_out;
+			m_head           = (m_head + 1) % m_buffer.size();
+
+			if (m_head == m_tail)
+				m_tail = (m_tail + 1) % m_buffer.size();
+
+			m_sum   = {};
+			m_count = 0;
+			m_error -= static_cast<uint32_t>(m_error);
+			m_error += m_samplesPerAverage - m_boxWidth;
+		}
+	}
+
+	void readSamples(float *buffer, uint32_t size)
+	{
+		for (uint32_t count = 0; count < size && m_samplesAvail > 0; ++count)
+		{
+			--m_samplesAvail;
+			buffer[count] = m_buffer[m_tail] * BoxFilter::MASTER_VOLUME;
+
+			if (m_tail != m_head)
+				m_tail = (m_tail + 1) % m_buffer.size();
+		}
+	}
+
+	uint32_t getAudioFrameSize() const
+	{
+		return static_cast<uint32_t>(m_buffer.size() / 8);
+	}
+
+  private:
+	float                   m_samplesPerAverage;
+	uint32_t                m_boxWidth;
+	BoxFilter::Samples      m_sum{};
+	Apu::AudioChannelToggle m_toggle;
+	uint32_t                m_count = 0;
+	float                   m_error = 0;
+	float                   m_prev  = 0;
+	float                   m_out   = 0;
+	std::vector<float>      m_buffer;
+	uint32_t                m_head = 0, m_tail = 0, m_samplesAvail = 0;
+};
+
+// one second of dac output, generated up front so the benchmark only times the filters
+std::vector<BoxFilter::DacSamples> generateSignal()
+{
+	DacSignal                          signal;
+	std::vector<BoxFilter::DacSamples> samples(CLOCK_RATE_M / 60 * 60);
+
+	for (auto &sample : samples)
+		sample = signal.next();
+
+	return samples;
+}
+
+// seconds of wall time to filter seconds of dac output
+template <typename Filter>
+double benchmarkFilter(Filter &filter, const std::vector<BoxFilter::DacSamples> &signal, double seconds)
+{
+	std::vector<float> drain(filter.getAudioFrameSize() * 2);
+
+	const uint64_t cycles         = static_cast<uint64_t>(seconds * CLOCK_RATE_M);
+	const uint32_t cyclesPerFrame = CLOCK_RATE_M / 60;
+
+	auto        startTime = std::chrono::steady_clock::now();
+	std::size_t position  = 0;
+
+	for (uint64_t cycle = 0; cycle < cycles; cycle += cyclesPerFrame)
+	{
+		// drain once per emulated frame like the frontend does, signal length is a whole number of frames
+		if (position == signal.size())
+			position = 0;
+
+		for (const std::size_t frameEnd = position + cyclesPerFrame; position < frameEnd; ++position)
+			filter.pushSample(signal[position]);
+
+		filter.readSamples(drain.data(), static_cast<uint32_t>(drain.size()));
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	return elapsed.count();
+}
+
+template <std::size_t Size>
+double median(std::array<double, Size> values)
+{
+	std::nth_element(values.begin(), values.begin() + Size / 2, values.end());
+	return values[Size / 2];
+}
+
+// in place iterative radix-2 fft, size must be a power of 2
+void fft(std::vector<std::complex<double>> &data)
+{
+	const std::size_t size = data.size();
+
+	for (std::size_t i = 1, j = 0; i < size; ++i)
+	{
+		std::size_t bit = size >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+
+		if (i < j)
+			std::swap(data[i], data[j]);
+	}
+
+	for (std::size_t length = 2; length <= size; length <<= 1)
+	{
+		const std::complex<double> step = std::polar(1.0, -2.0 * PI / length);
+
+		for (std::size_t start = 0; start < size; start += length)
+		{
+			std::complex<double> twiddle = 1.0;
+			for (std::size_t k = 0; k < length / 2; ++k)
+			{
+				const std::complex<double> even = data[start + k];
+				const std::complex<double> odd  = data[start + k + length / 2] * twiddle;
+
+				data[start + k]              = even + odd;
+				data[start + k + length / 2] = even - odd;
+				twiddle *= step;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Resample a square wave and return the energy ratio in db of everything that is not a harmonic of the square
+ * wave (aliasing and other artifacts) to the harmonics, between 20hz and 20khz or the output nyquist.
+ */
+double measureAliasing(uint32_t sampleRate, ResamplerQuality quality)
+{
+	constexpr std::size_t FFT_SIZE     = 1 << 15;
+	constexpr int         LOBE_BINS    = 6; // blackman-harris main lobe is 4 bins wide on each side
+	const uint32_t        warmup       = sampleRate / 2;
+	const double          squareFreq   = static_cast<double>(CLOCK_RATE_M) / SQUARE_PERIOD;
+	const double          binWidth     = static_cast<double>(sampleRate) / FFT_SIZE;
+	const double          bandTop      = std::min(20000.0, sampleRate * 0.5);
+	const std::size_t     lastBandBin  = static_cast<std::size_t>(bandTop / binWidth);
+	const std::size_t     firstBandBin = static_cast<std::size_t>(std::ceil(20.0 / binWidth));
+
+	BoxFilter          filter(sampleRate, quality);
+	std::vector<float> output;
+	std::vector<float> chunk(filter.getAudioFrameSize() * 2);
+	uint64_t           cycle = 0;
+
+	// only pulse 1 plays, the constant level of the silent channels is removed by the output high pass
+	while (output.size() < warmup + FFT_SIZE)
+	{
+		++cycle;
+		filter.pushSample(BoxFilter::DacSamples{static_cast<uint8_t>((cycle % SQUARE_PERIOD) < SQUARE_PERIOD / 2 ? 15 : 0), 0, 0, 0});
+
+		if (filter.getSamplesAvail() >= chunk.size() / 2)
+		{
+			const uint32_t count = filter.readSamples(chunk.data(), static_cast<uint32_t>(chunk.size()));
+			output.insert(output.end(), chunk.begin(), chunk.begin() + count);
+		}
+	}
+
+	std::vector<std::complex<double>> spectrum(FFT_SIZE);
+	for (std::size_t i = 0; i < FFT_SIZE; ++i)
+	{
+		const double t      = 2.0 * PI * i / (FFT_SIZE - 1);
+		const double window = 0.35875 - 0.48829 * std::cos(t) + 0.14128 * std::cos(2.0 * t) - 0.01168 * std::cos(3.0 * t);
+		spectrum[i]         = output[warmup + i] * window;
+	}
+
+	fft(spectrum);
+
+	std::vector<bool> isHarmonic(FFT_SIZE / 2, false);
+	for (double harmonic = squareFreq; harmonic < sampleRate * 0.5; harmonic += squareFreq)
+	{
+		const long center = std::lround(harmonic / binWidth);
+		for (long bin = center - LOBE_BINS; bin <= center + LOBE_BINS; ++bin)
+		{
+			if (bin >= 0 && bin < static_cast<long>(isHarmonic.size()))
+				isHarmonic[bin] = true;
+		}
+	}
+
+	double harmonicEnergy = 0.0;
+	double otherEnergy    = 0.0;
+
+	for (std::size_t bin = firstBandBin; bin <= lastBandBin && bin < isHarmonic.size(); ++bin)
+	{
+		const double energy = std::norm(spectrum[bin]);
+		(isHarmonic[bin] ? harmonicEnergy : otherEnergy) += energy;
+	}
+
+	return 10.0 * std::log10(std::max(otherEnergy, 1e-30) / std::max(harmonicEnergy, 1e-30));
+}
+
+struct StretchResult
+{
+	double Elapsed   = 0.0; // wall time to compress the input
+	double PeakFreq  = 0.0; // strongest frequency of the output
+	double OutputLen = 0.0; // seconds of output produced
+};
+
+/**
+ * @brief Time compressing speed * seconds of a 440hz square wave into real time and find the pitch of the result,
+ * which should still be 440hz.
+ */
+StretchResult measureTimeStretch(uint32_t sampleRate, float speed, double seconds)
+{
+	constexpr std::size_t FFT_SIZE = 1 << 15;
+
+	const std::size_t  inputLength = static_cast<std::size_t>(seconds * speed * sampleRate);
+	std::vector<float> input(inputLength);
+	for (std::size_t i = 0; i < inputLength; ++i)
+		input[i] = std::fmod(i * STRETCH_FREQUENCY / sampleRate, 1.0) < 0.5 ? 0.5f : -0.5f;
+
+	TimeStretch timeStretch(sampleRate);
+	timeStretch.setSpeed(speed);
+
+	const uint32_t     chunkSize = sampleRate / 60;
+	std::vector<float> output;
+	output.reserve(static_cast<std::size_t>(seconds * sampleRate) + chunkSize);
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (std::size_t position = 0; position < inputLength; position += chunkSize)
+	{
+		timeStretch.push(&input[position], static_cast<uint32_t>(std::min<std::size_t>(chunkSize, inputLength - position)));
+
+		const std::size_t start = output.size();
+		output.resize(start + timeStretch.getSamplesAvail());
+		timeStretch.read(&output[start], static_cast<uint32_t>(output.size() - start));
+	}
+
+	StretchResult result;
+	result.Elapsed   = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	result.OutputLen = static_cast<double>(output.size()) / sampleRate;
+
+	if (output.size() < FFT_SIZE)
+		return result;
+
+	std::vector<std::complex<double>> spectrum(FFT_SIZE);
+	for (std::size_t i = 0; i < FFT_SIZE; ++i)
+		spectrum[i] = output[output.size() - FFT_SIZE + i] * (0.5 - 0.5 * std::cos(2.0 * PI * i / (FFT_SIZE - 1)));
+
+	fft(spectrum);
+
+	std::size_t peak = 1;
+	for (std::size_t bin = 1; bin < FFT_SIZE / 2; ++bin)
+	{
+		if (std::norm(spectrum[bin]) > std::norm(spectrum[peak]))
+			peak = bin;
+	}
+
+	result.PeakFreq = static_cast<double>(peak) * sampleRate / FFT_SIZE;
+	return result;
+}
+} // namespace
+
+bool AudioBench::run(double seconds)
+{
+	fmt::println("Simd: {}, {:.1f}s of dac output per run", Utils::getSimdLevelString(Utils::detectSimdLevel()), seconds);
+	fmt::println("");
+	fmt::println("{:>8} {:>8} {:>7} {:>8} {:>14} {:>10} {:>11}", "rate", "quality", "taps", "phases", "ms/s of audio", "vs legacy", "alias (dB)");
+
+	// runs of every filter are interleaved and compared with the legacy run next to them, the median of those ratios
+	// holds up against clock changes and scheduler noise that a single run or the fastest one does not
+	constexpr int RUNS = 15;
+
+	bool cheapestBeatsBox  = true;
+	bool aliasingInCeiling = true;
+
+	const std::vector<BoxFilter::DacSamples> signal = generateSignal();
+
+	for (uint32_t sampleRate : BudgetGbConstants::AUDIO_SAMPLE_RATES)
+	{
+		LegacyBoxFilter        legacy(sampleRate);
+		std::vector<BoxFilter> filters;
+		filters.reserve(QUALITIES.size());
+
+		for (ResamplerQuality quality : QUALITIES)
+			filters.emplace_back(sampleRate, quality);
+
+		std::array<double, RUNS>                                legacyTimes{};
+		std::array<std::array<double, RUNS>, QUALITIES.size()> times{};
+		std::array<std::array<double, RUNS>, QUALITIES.size()> ratios{};
+
+		for (int run = 0; run < RUNS; ++run)
+		{
+			legacyTimes[run] = benchmarkFilter(legacy, signal, seconds);
+
+			for (std::size_t i = 0; i < filters.size(); ++i)
+			{
+				times[i][run]  = benchmarkFilter(filters[i], signal, seconds);
+				ratios[i][run] = times[i][run] / legacyTimes[run];
+			}
+		}
+
+		const double legacyTime = median(legacyTimes);
+
+		fmt::println("{:>8} {:>8} {:>7} {:>8} {:>14.3f} {:>9.2f}x {:>11}", sampleRate, "legacy", 0, 0, legacyTime * 1000.0 / seconds, 1.0, "-");
+
+		for (std::size_t i = 0; i < QUALITIES.size(); ++i)
+		{
+			const ResamplerQuality quality = QUALITIES[i];
+
+			uint32_t taps   = 0;
+			uint32_t phases = 0;
+
+			if (quality != ResamplerQuality::Box)
+			{
+				PolyphaseResampler resampler(CLOCK_RATE_M / PolyphaseResampler::getPreDecimation(quality), sampleRate, PolyphaseResampler::getDesign(quality));
+				taps   = resampler.getTaps();
+				phases = resampler.getPhases();
+			}
+
+			const double ratio    = median(ratios[i]);
+			const double aliasing = measureAliasing(sampleRate, quality);
+
+			if (aliasing > ALIASING_CEILINGS[i])
+				aliasingInCeiling = false;
+
+			if (quality == ResamplerQuality::Low && ratio >= 1.0)
+				cheapestBeatsBox = false;
+
+			fmt::println("{:>8} {:>8} {:>7} {:>8} {:>14.3f} {:>9.2f}x {:>11.1f}",
+			             sampleRate,
+			             getResamplerQualityString(quality),
+			             taps,
+			             phases,
+			             median(times[i]) * 1000.0 / seconds,
+			             ratio,
+			             aliasing);
+		}
+	}
+
+	fmt::println("");
+	fmt::println("Low tier {} the legacy box filter at every rate", cheapestBeatsBox ? "beats" : "does not beat");
+	fmt::println("Aliasing of every tier is {} its ceiling at every rate ({} / {} / {} / {} dB)",
+	             aliasingInCeiling ? "within" : "not within",
+	             ALIASING_CEILINGS[0],
+	             ALIASING_CEILINGS[1],
+	             ALIASING_CEILINGS[2],
+	             ALIASING_CEILINGS[3]);
+
+	fmt::println("");
+	fmt::println("{:>8} {:>6} {:>14} {:>17} {:>12}", "rate", "speed", "ms/s of output", "output length (s)", "pitch (hz)");
+
+	// a 440hz square compressed by any speed should still peak at 440hz and play for as long as it took to emulate
+	bool stretchKeepsPitch = true;
+
+	for (uint32_t sampleRate : {BudgetGbConstants::AUDIO_SAMPLE_RATE, BudgetGbConstants::AUDIO_SAMPLE_RATES.back()})
+	{
+		for (float speed : {2.0f, 4.0f, 8.0f})
+		{
+			const StretchResult result = measureTimeStretch(sampleRate, speed, seconds);
+
+			// input goes in a frame at a time, so short runs may also be a frame short
+			const double lengthTolerance = std::max(seconds * STRETCH_LENGTH_TOLERANCE, 1.0 / 60.0);
+
+			if (std::abs(result.PeakFreq - STRETCH_FREQUENCY) > STRETCH_FREQUENCY * STRETCH_PITCH_TOLERANCE || std::abs(result.OutputLen - seconds) > lengthTolerance)
+				stretchKeepsPitch = false;
+
+			fmt::println("{:>8} {:>5.0f}x {:>14.3f} {:>17.3f} {:>12.1f}", sampleRate, speed, result.Elapsed * 1000.0 / std::max(result.OutputLen, 1e-9), result.OutputLen, result.PeakFreq);
+		}
+	}
+
+	fmt::println("");
+	fmt::println("Time stretch {} within {:.0f}% of {:.0f} Hz and {:.0f}% of the expected length at every speed",
+	             stretchKeepsPitch ? "stays" : "does not stay",
+	             STRETCH_PITCH_TOLERANCE * 100.0,
+	             STRETCH_FREQUENCY,
+	             STRETCH_LENGTH_TOLERANCE * 100.0);
+
+	return cheapestBeatsBox && aliasingInCeiling && stretchKeepsPitch;
+}
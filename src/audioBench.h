@@ -0,0 +1,16 @@
+#pragma once
+
+namespace AudioBench
+{
+
+/**
+ * @brief Benchmark every output rate and resampler quality tier against the legacy box filter, then measure aliasing
+ * of each tier by resampling a square wave and comparing non harmonic to harmonic energy in the audible band. Also
+ * times the time stretch stage at each fast forward speed and checks the pitch of its output.
+ * @param seconds Seconds of dac output filtered per benchmark run.
+ * @return True if the cheapest polyphase tier ran faster than the box filter at every rate and the aliasing of every
+ * tier stayed within its ceiling and the time stretch output kept its pitch and length.
+ */
+bool run(double seconds);
+
+} // namespace AudioBench
@@ -1,33 +1,67 @@
 #pragma once
 
-#include "utils/vec.h"
-
-#include <utility>
+#include <algorithm>
+#include <array>
 
 namespace AudioLogging
 {
 
-template <int size>
-struct AudioScrollingBuffer
+// Min/max envelope of an audio signal for plotting. Every bucket covers samplesPerBucket consecutive samples so the cost
+// of plotting only depends on the bucket count and not on how many samples are captured.
+template <int bucketCount, int samplesPerBucket>
+struct AudioEnvelopeBuffer
 {
+	struct Bucket
+	{
+		float X   = 0;
+		float Min = 0;
+		float Max = 0;
+	};
+
 	int Offset = 0;
 
-	std::array<Utils::Vec2<float>, size> Data{};
+	std::array<Bucket, bucketCount> Data{};
 
 	void AddPoint(float amp)
 	{
-		Data[Offset] = Utils::Vec2<float>{(float)Offset, amp};
-		Offset       = (Offset + 1) % Data.size();
+		if (m_sampleCount == 0)
+		{
+			m_min = amp;
+			m_max = amp;
+		}
+		else
+		{
+			m_min = std::min(m_min, amp);
+			m_max = std::max(m_max, amp);
+		}
+
+		if (++m_sampleCount == samplesPerBucket)
+		{
+			Data[Offset]  = Bucket{(float)Offset, m_min, m_max};
+			Offset        = (Offset + 1) % Data.size();
+			m_sampleCount = 0;
+		}
 	}
+
+  private:
+	int   m_sampleCount = 0; // samples accumulated into the current bucket
+	float m_min         = 0;
+	float m_max         = 0;
 };
 
+static constexpr int ENVELOPE_BUCKETS   = 200;
+static constexpr int SAMPLES_PER_BUCKET = 4;
+
+typedef AudioEnvelopeBuffer<ENVELOPE_BUCKETS, SAMPLES_PER_BUCKET> AudioEnvelope;
+
+// Visualization capture of the apu output, only filled while subscribed with Apu::setAudioLogBuffers()
 struct AudioLogBuffers
 {
-	AudioScrollingBuffer<800> Pulse1;
-	AudioScrollingBuffer<800> Pulse2;
-	AudioScrollingBuffer<800> Wave;
-	AudioScrollingBuffer<800> Noise;
-	AudioScrollingBuffer<800> All;
+	AudioEnvelope Pulse1;
+	AudioEnvelope Pulse2;
+	AudioEnvelope Wave;
+	AudioEnvelope Noise;
+	AudioEnvelope All;
 };
 
 } // namespace AudioLogging
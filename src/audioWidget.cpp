@@ -16,9 +16,36 @@ constexpr ImVec4 Color4(const uint8_t r, const uint8_t g, const uint8_t b)
 	return ImVec4(r / 255.0f, g / 255.0f, b / 255.0f, 1.0f);
 }
 
+// envelope is drawn as the shaded area between the min and max of each bucket, outlined so flat stretches stay visible
+void plotEnvelope(const char *label, const AudioLogging::AudioEnvelope &envelope, const ImVec4 &color, float yLimit)
+{
+	ImPlotFlags     plotFlags     = ImPlotFlags_NoLegend;
+	ImPlotAxisFlags plotLineFlags = ImPlotAxisFlags_NoTickLabels;
+
+	const ImVec2 plotSize = ImVec2(-1, 125);
+
+	const auto &bucket = envelope.Data[0];
+	const int   count  = (int)envelope.Data.size();
+	const int   stride = sizeof(bucket);
+
+	if (ImPlot::BeginPlot(label, plotSize, plotFlags))
+	{
+		ImPlot::SetupAxes(nullptr, nullptr, plotLineFlags, plotLineFlags);
+		ImPlot::SetupAxisLimits(ImAxis_X1, 0, (double)count, ImGuiCond_Always);
+		ImPlot::SetupAxisLimits(ImAxis_Y1, -yLimit, yLimit);
+		ImPlot::PushStyleColor(ImPlotCol_Line, color);
+		ImPlot::PushStyleColor(ImPlotCol_Fill, color);
+		ImPlot::PlotShaded(label, &bucket.X, &bucket.Min, &bucket.Max, count, ImPlotShadedFlags_None, 0, stride);
+		ImPlot::PlotLine(label, &bucket.X, &bucket.Min, count, ImPlotLineFlags_None, 0, stride);
+		ImPlot::PlotLine(label, &bucket.X, &bucket.Max, count, ImPlotLineFlags_None, 0, stride);
+		ImPlot::PopStyleColor(2);
+		ImPlot::EndPlot();
+	}
+}
+
 } // namespace
 
-bool AudioWidget::drawAudioWidget(Apu &apu, Apu::AudioChannelToggle &audioChannelToggle)
+bool AudioWidget::drawAudioWidget(const AudioLogging::AudioLogBuffers &buffers, Apu::AudioChannelToggle &audioChannelToggle)
 {
 	bool toggle = true;
 
@@ -35,75 +62,17 @@ bool AudioWidget::drawAudioWidget(Apu &apu, Apu::AudioChannelToggle &audioChanne
 		ImGui::SetItemTooltip("F5 - F8 hotkeys");
 		// clang-format on
 
-		const AudioLogging::AudioLogBuffers &buffers = apu.getAudioLogBuffers();
-
-		ImPlotFlags     plotFlags     = ImPlotFlags_NoLegend;
-		ImPlotAxisFlags plotLineFlags = ImPlotAxisFlags_NoTickLabels;
-
-		const ImVec2 plotSize = ImVec2(-1, 125);
-
 		constexpr ImVec4 pulse1Color = Color4(0x23, 0x17, 0xA8);
 		constexpr ImVec4 pulse2Color = Color4(0x5B, 0x10, 0x8D);
 		constexpr ImVec4 waveColor   = Color4(0x10, 0x10, 0xFF);
 		constexpr ImVec4 noiseColor  = Color4(0xFF, 0x60, 0xA8);
 		constexpr ImVec4 allColor    = Color4(0xF6, 0x30, 0x30);
 
-		if (ImPlot::BeginPlot("Pulse 1", plotSize, plotFlags))
-		{
-			ImPlot::SetupAxes(nullptr, nullptr, plotLineFlags, plotLineFlags);
-			ImPlot::SetupAxisLimits(ImAxis_X1, 0, (double)buffers.Pulse1.Data.size(), ImGuiCond_Always);
-			ImPlot::SetupAxisLimits(ImAxis_Y1, -2.0f, 2.0f);
-			ImPlot::PushStyleColor(ImPlotCol_Line, pulse1Color);
-			ImPlot::PlotLine("Pulse 1", &buffers.Pulse1.Data[0].x, &buffers.Pulse1.Data[0].y, (int)buffers.Pulse1.Data.size(), ImPlotLineFlags_None, 0, sizeof(buffers.Pulse1.Data[0]));
-			ImPlot::PopStyleColor(1);
-			ImPlot::EndPlot();
-		}
-
-		if (ImPlot::BeginPlot("Pulse 2", plotSize, plotFlags))
-		{
-			ImPlot::SetupAxes(nullptr, nullptr, plotLineFlags, plotLineFlags);
-			ImPlot::SetupAxisLimits(ImAxis_X1, 0, (double)buffers.Pulse2.Data.size(), ImGuiCond_Always);
-			ImPlot::SetupAxisLimits(ImAxis_Y1, -2.0f, 2.0f);
-			ImPlot::PushStyleColor(ImPlotCol_Line, pulse2Color);
-			ImPlot::PlotLine("Pulse 2", &buffers.Pulse2.Data[0].x, &buffers.Pulse2.Data[0].y, (int)buffers.Pulse2.Data.size(), ImPlotLineFlags_None, 0, sizeof(buffers.Pulse2.Data[0]));
-			ImPlot::PopStyleColor(1);
-			ImPlot::EndPlot();
-		}
-
-		if (ImPlot::BeginPlot("Wave", plotSize, plotFlags))
-		{
-			ImPlot::SetupAxes(nullptr, nullptr, plotLineFlags, plotLineFlags);
-			ImPlot::SetupAxisLimits(ImAxis_X1, 0, (double)buffers.Wave.Data.size(), ImGuiCond_Always);
-			ImPlot::SetupAxisLimits(ImAxis_Y1, -2.0f, 2.0f);
-			ImPlot::PushStyleColor(ImPlotCol_Line, waveColor);
-			ImPlot::PlotLine("Wave", &buffers.Wave.Data[0].x, &buffers.Wave.Data[0].y, (int)buffers.Wave.Data.size(), ImPlotLineFlags_None, 0, sizeof(buffers.Wave.Data[0]));
-			ImPlot::PopStyleColor(1);
-			ImPlot::EndPlot();
-		}
-
-		if (ImPlot::BeginPlot("Noise", plotSize, plotFlags))
-		{
-			ImPlot::SetupAxes(nullptr, nullptr, plotLineFlags, plotLineFlags);
-			ImPlot::SetupAxisLimits(ImAxis_X1, 0, (double)buffers.All.Data.size(), ImGuiCond_Always);
-			ImPlot::SetupAxisLimits(ImAxis_Y1, -2.0f, 2.0f);
-			ImPlot::PushStyleColor(ImPlotCol_Line, noiseColor);
-			ImPlot::PlotLine("Noise", &buffers.Noise.Data[0].x, &buffers.Noise.Data[0].y, (int)buffers.Noise.Data.size(), ImPlotLineFlags_None, 0, sizeof(buffers.Noise.Data[0]));
-			ImPlot::PopStyleColor(1);
-			ImPlot::EndPlot();
-		}
-
-		if (ImPlot::BeginPlot("All", plotSize, plotFlags))
-		{
-			ImPlot::SetupAxes(nullptr, nullptr, plotLineFlags, plotLineFlags);
-			ImPlot::SetupAxisLimits(ImAxis_X1, 0, (double)buffers.All.Data.size(), ImGuiCond_Always);
-			ImPlot::SetupAxisLimits(ImAxis_Y1, -4.0f, 4.0f);
-			ImPlot::PushStyleColor(ImPlotCol_Line, allColor);
-			ImPlot::PlotLine("All", &buffers.All.Data[0].x, &buffers.All.Data[0].y, (int)buffers.All.Data.size(), ImPlotLineFlags_None, 0, sizeof(buffers.All.Data[0]));
-			ImPlot::PopStyleColor(1);
-			ImPlot::EndPlot();
-		}
-
-		apu.setAudioChannelToggle(audioChannelToggle);
+		plotEnvelope("Pulse 1", buffers.Pulse1, pulse1Color, 2.0f);
+		plotEnvelope("Pulse 2", buffers.Pulse2, pulse2Color, 2.0f);
+		plotEnvelope("Wave", buffers.Wave, waveColor, 2.0f);
+		plotEnvelope("Noise", buffers.Noise, noiseColor, 2.0f);
+		plotEnvelope("All", buffers.All, allColor, 4.0f);
 	}
 	ImGui::End();
 
@@ -6,5 +6,12 @@
 class AudioWidget
 {
   public:
-	static bool drawAudioWidget(Apu &apu, Apu::AudioChannelToggle &audioChannelToggle);
+	/**
+	 * @brief Draw channel toggles and the captured output envelopes. Touches no apu state, so it can be drawn without
+	 * the emulation lock.
+	 * @param buffers Copy of the buffers subscribed to the apu with Apu::setAudioLogBuffers().
+	 * @param audioChannelToggle Edited by the checkboxes, the caller hands changes to the apu.
+	 * @return False when the widget is closed.
+	 */
+	static bool drawAudioWidget(const AudioLogging::AudioLogBuffers &buffers, Apu::AudioChannelToggle &audioChannelToggle);
 };
\ No newline at end of file
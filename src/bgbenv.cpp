@@ -0,0 +1,220 @@
+#include "bgbenv.h"
+#include "BudgetGBCore.h"
+#include "emulatorConstants.h"
+#include "fmt/base.h"
+#include "utils/simd.h"
+#include "utils/stateArchive.h"
+#include "utils/threadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct BgbEnv
+{
+	std::vector<std::unique_ptr<BudgetGBCore>> Cores;
+	std::unique_ptr<Utils::ThreadPool>         Pool; // null when the batch runs on the calling thread
+	uint32_t                                   ChunkCount = 1;
+
+	Utils::StateWriter                ResetState;
+	BudgetGbConstants::LcdColorBuffer ResetFrame{}; // frames are not part of a state, the one shown when the snapshot was taken
+
+	Utils::DownsampleFn    Downsample = nullptr;
+	uint32_t               Factor     = 1;
+	std::array<uint8_t, 4> Shades{};
+	std::vector<uint16_t>  RamAddresses;
+	std::size_t            FrameSize       = 0;
+	std::size_t            ObservationSize = 0;
+};
+
+namespace
+{
+constexpr std::array<uint8_t, 4> GRAYSCALE_SHADES   = {255, 170, 85, 0};
+constexpr std::array<uint8_t, 4> COLOR_INDEX_SHADES = {0, 1, 2, 3};
+
+void writeObservation(const BgbEnv &envs, BudgetGBCore &core, const BudgetGbConstants::LcdColorBuffer &frame, uint8_t *observation)
+{
+	envs.Downsample(frame.data(), BudgetGbConstants::LCD_WIDTH, BudgetGbConstants::LCD_HEIGHT, envs.Factor, envs.Shades.data(), observation);
+
+	uint8_t *ram = observation + envs.FrameSize;
+	for (uint16_t address : envs.RamAddresses)
+		*ram++ = core.m_bus.busReadRaw(address);
+}
+
+// run fn(first, last) over contiguous ranges of environments, one range per worker
+template <typename Fn>
+void forEachChunk(BgbEnv &envs, Fn &&fn)
+{
+	const uint32_t envCount = static_cast<uint32_t>(envs.Cores.size());
+
+	if (!envs.Pool)
+	{
+		fn(0u, envCount);
+		return;
+	}
+
+	for (uint32_t chunk = 0; chunk < envs.ChunkCount; ++chunk)
+	{
+		const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(envCount) * chunk / envs.ChunkCount);
+		const uint32_t last  = static_cast<uint32_t>(static_cast<uint64_t>(envCount) * (chunk + 1) / envs.ChunkCount);
+
+		envs.Pool->submit([&fn, first, last]() { fn(first, last); });
+	}
+
+	envs.Pool->wait();
+}
+
+bool createEnvs(const BgbEnvConfig &config, BgbEnv &envs)
+{
+	if (!config.romPath || config.envCount == 0)
+	{
+		fmt::println(stderr, "Environment batch needs a rom and at least one environment!");
+		return false;
+	}
+
+	if (config.downsample != 1 && config.downsample != 2 && config.downsample != 4)
+	{
+		fmt::println(stderr, "Downsample factor {} is not one of 1, 2 or 4!", config.downsample);
+		return false;
+	}
+
+	envs.Downsample = Utils::getDownsample(Utils::detectSimdLevel());
+	envs.Factor     = config.downsample;
+	envs.Shades     = config.grayscale ? GRAYSCALE_SHADES : COLOR_INDEX_SHADES;
+	envs.FrameSize  = (BudgetGbConstants::LCD_WIDTH / envs.Factor) * (BudgetGbConstants::LCD_HEIGHT / envs.Factor);
+
+	if (config.ramAddresses)
+		envs.RamAddresses.assign(config.ramAddresses, config.ramAddresses + config.ramAddressCount);
+
+	envs.ObservationSize = envs.FrameSize + envs.RamAddresses.size();
+
+	BudgetGBCore original;
+	if (!original.loadRom(config.romPath))
+		return false;
+
+	original.m_apu.setOutputEnabled(false);
+	for (uint32_t frame = 0; frame < config.resetFrames; ++frame)
+		original.runFrame();
+
+	if (!original.saveState(envs.ResetState))
+		return false;
+
+	envs.ResetFrame = original.getFramebuffer();
+
+	// forks share the rom, cartridge ram pages are only copied once an environment writes to them
+	for (uint32_t i = 0; i < config.envCount; ++i)
+	{
+		envs.Cores.push_back(original.fork());
+		if (!envs.Cores.back())
+			return false;
+	}
+
+	const uint32_t threadCount = config.threadCount != 0 ? config.threadCount : std::max(1u, std::thread::hardware_concurrency());
+	envs.ChunkCount            = std::min(threadCount, config.envCount);
+
+	if (envs.ChunkCount > 1)
+		envs.Pool = std::make_unique<Utils::ThreadPool>(envs.ChunkCount);
+
+	return true;
+}
+} // namespace
+
+BgbEnv *bgb_env_create(const BgbEnvConfig *config)
+{
+	if (!config)
+		return nullptr;
+
+	// exceptions must not cross into a c caller
+	try
+	{
+		auto envs = std::make_unique<BgbEnv>();
+		return createEnvs(*config, *envs) ? envs.release() : nullptr;
+	}
+	catch (const std::exception &error)
+	{
+		fmt::println(stderr, "Failed to create environment batch: {}", error.what());
+		return nullptr;
+	}
+}
+
+void bgb_env_destroy(BgbEnv *envs)
+{
+	delete envs;
+}
+
+uint32_t bgb_env_count(const BgbEnv *envs)
+{
+	return static_cast<uint32_t>(envs->Cores.size());
+}
+
+size_t bgb_env_observation_size(const BgbEnv *envs)
+{
+	return envs->ObservationSize;
+}
+
+bool bgb_env_step(BgbEnv *envs, const uint8_t *actions, uint32_t frameskip, uint8_t *observations)
+{
+	if (frameskip == 0)
+		return false;
+
+	forEachChunk(*envs, [envs, actions, frameskip, observations](uint32_t first, uint32_t last) {
+		for (uint32_t i = first; i < last; ++i)
+		{
+			BudgetGBCore &core = *envs->Cores[i];
+			core.setInput(actions[i]);
+
+			// frames in between are never observed, skip drawing them
+			core.m_ppu.setOutputEnabled(false);
+			for (uint32_t frame = 1; frame < frameskip; ++frame)
+				core.runFrame();
+
+			core.m_ppu.setOutputEnabled(true);
+			core.runFrame();
+
+			writeObservation(*envs, core, core.getFramebuffer(), observations + i * envs->ObservationSize);
+		}
+	});
+
+	return true;
+}
+
+bool bgb_env_reset(BgbEnv *envs, const uint8_t *resetMask, uint8_t *observations)
+{
+	const std::vector<uint8_t> &state = envs->ResetState.getBuffer();
+	std::atomic<bool>           ok    = true;
+
+	forEachChunk(*envs, [envs, resetMask, observations, &state, &ok](uint32_t first, uint32_t last) {
+		for (uint32_t i = first; i < last; ++i)
+		{
+			if (resetMask && !resetMask[i])
+				continue;
+
+			BudgetGBCore &core = *envs->Cores[i];
+
+			// a failed load can only mean a broken snapshot, every environment would fail the same way
+			if (!core.loadState(state.data(), state.size()))
+				ok = false;
+
+			writeObservation(*envs, core, envs->ResetFrame, observations + i * envs->ObservationSize);
+		}
+	});
+
+	return ok.load();
+}
+
+bool bgb_env_set_reset_state(BgbEnv *envs, uint32_t envIndex)
+{
+	if (envIndex >= envs->Cores.size())
+		return false;
+
+	BudgetGBCore &core = *envs->Cores[envIndex];
+	if (!core.saveState(envs->ResetState))
+		return false;
+
+	envs->ResetFrame = core.getFramebuffer();
+	return true;
+}
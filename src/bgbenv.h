@@ -0,0 +1,89 @@
+#pragma once
+
+/*
+ * C API stepping a batch of emulator instances at once, built as the bgbenv shared library for reinforcement learning
+ * environments and other foreign callers.
+ *
+ * Every environment of a batch runs the same rom. An observation is the last frame, optionally shrunk and in
+ * grayscale, followed by the selected memory bytes, all environments' observations are packed back to back in one
+ * caller owned buffer of envCount * bgb_env_observation_size() bytes.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#ifdef BGBENV_BUILD
+#define BGBENV_API __declspec(dllexport)
+#else
+#define BGBENV_API __declspec(dllimport)
+#endif
+#else
+#define BGBENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* joypad buttons of an action, any combination can be held */
+#define BGB_BUTTON_A      (1u << 0)
+#define BGB_BUTTON_B      (1u << 1)
+#define BGB_BUTTON_SELECT (1u << 2)
+#define BGB_BUTTON_START  (1u << 3)
+#define BGB_BUTTON_RIGHT  (1u << 4)
+#define BGB_BUTTON_LEFT   (1u << 5)
+#define BGB_BUTTON_UP     (1u << 6)
+#define BGB_BUTTON_DOWN   (1u << 7)
+
+typedef struct BgbEnv BgbEnv;
+
+typedef struct BgbEnvConfig
+{
+	const char *romPath;
+	uint32_t    envCount;
+	uint32_t    threadCount; /* 0 uses one per hardware thread */
+
+	uint32_t downsample; /* 1, 2 or 4, frames shrink to 160x144, 80x72 or 40x36 */
+	bool     grayscale;  /* shades from 255 (lightest) to 0, otherwise color indices 0 to 3 averaged over a block */
+
+	const uint16_t *ramAddresses; /* memory bytes appended to every observation, may be NULL */
+	uint32_t        ramAddressCount;
+
+	uint32_t resetFrames; /* frames run from power on before taking the snapshot every reset loads */
+} BgbEnvConfig;
+
+/*
+ * Load the rom once, run it for resetFrames and start every environment from that snapshot. Returns NULL on failure.
+ */
+BGBENV_API BgbEnv *bgb_env_create(const BgbEnvConfig *config);
+
+BGBENV_API void bgb_env_destroy(BgbEnv *envs);
+
+BGBENV_API uint32_t bgb_env_count(const BgbEnv *envs);
+
+/* bytes of one environment's observation */
+BGBENV_API size_t bgb_env_observation_size(const BgbEnv *envs);
+
+/*
+ * Hold actions[i] on environment i for frameskip frames, then write every observation. Only the last of the frames is
+ * drawn. Returns false if frameskip is 0.
+ */
+BGBENV_API bool bgb_env_step(BgbEnv *envs, const uint8_t *actions, uint32_t frameskip, uint8_t *observations);
+
+/*
+ * Load the snapshot into the environments whose resetMask byte is non zero, or all of them when resetMask is NULL,
+ * and write their observations. Observations of the other environments are left untouched.
+ */
+BGBENV_API bool bgb_env_reset(BgbEnv *envs, const uint8_t *resetMask, uint8_t *observations);
+
+/*
+ * Replace the snapshot resets load with the current state of one environment.
+ */
+BGBENV_API bool bgb_env_set_reset_state(BgbEnv *envs, uint32_t envIndex);
+
+#ifdef __cplusplus
+}
+#endif
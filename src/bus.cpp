@@ -1,14 +1,32 @@
 #include "bus.h"
-#include "BudgetGB.h"
 #include "IORegisters.h"
 #include "fmt/base.h"
 #include "sm83.h"
+#include "utils/hash.h"
 
 Bus::Bus(Cartridge &cartridge, Sm83 &cpu, PPU &ppu, Apu &apu)
 	: m_cartridge(cartridge), m_cpu(cpu), m_ppu(ppu), m_apu(apu)
 {
 	std::fill(m_wram.begin(), m_wram.end(), static_cast<uint8_t>(0));
 	std::fill(m_hram.begin(), m_hram.end(), static_cast<uint8_t>(0));
+
+	for (uint32_t page = 0; page < m_pageTable.size(); ++page)
+	{
+		const uint32_t position = page << 8;
+
+		if (position < CARTRIDGE_ROM_END)
+			m_pageTable[page] = PAGE_ROM;
+		else if (position < VRAM_END)
+			m_pageTable[page] = PAGE_VRAM;
+		else if (position < EXTERNAL_RAM_END)
+			m_pageTable[page] = PAGE_EXTERNAL_RAM;
+		else if (position < ECHO_RAM_END)
+			m_pageTable[page] = PAGE_WRAM;
+		else if (position < UNUSABLE_END)
+			m_pageTable[page] = PAGE_OAM;
+		else
+			m_pageTable[page] = PAGE_HIGH;
+	}
 }
 
 void Bus::clearWram()
@@ -16,6 +34,30 @@ void Bus::clearWram()
 	std::fill(m_wram.begin(), m_wram.end(), static_cast<uint8_t>(0));
 }
 
+void Bus::saveState(Utils::StateWriter &writer)
+{
+	writer(m_tCycles, m_ppuDetached, m_wram, m_hram);
+}
+
+void Bus::loadState(Utils::StateReader &reader)
+{
+	reader(m_tCycles, m_ppuDetached, m_wram, m_hram);
+}
+
+uint64_t Bus::hashRam(uint64_t seed) const
+{
+	seed = Utils::hash64(m_wram.data(), m_wram.size(), seed);
+	return Utils::hash64(m_hram.data(), m_hram.size(), seed);
+}
+
+uint32_t Bus::getRomBank(uint16_t position) const
+{
+	if (position >= CARTRIDGE_ROM_END || !m_cartridge.isLoaded() || (!m_cpu.m_bootRomDisable && position < BOOT_ROM_END))
+		return 0;
+
+	return m_cartridge.getRomBank(position);
+}
+
 uint8_t Bus::busReadRaw(uint16_t position)
 {
 	if (position < CARTRIDGE_ROM_END)
@@ -68,106 +110,150 @@ uint8_t Bus::busReadRaw(uint16_t position)
 	}
 }
 
-uint8_t Bus::cpuRead(uint16_t position)
+void Bus::busWriteRaw(uint16_t position, uint8_t data)
 {
-	uint8_t out = 0;
-
 	if (position < CARTRIDGE_ROM_END)
 	{
-		if (m_cpu.m_bootRomDisable)
-		{
-			out = m_cartridge.cartridgeRead(position);
-		}
-		else if (position < BOOT_ROM_END)
-		{
-			out = m_cpu.m_bootrom.read(position);
-		}
-		else
-		{
-			out = m_cartridge.cartridgeRead(position);
-		}
 	}
 	else if (position < VRAM_END)
 	{
-		out = m_ppu.readVram(position);
+		m_ppu.debugWriteVram(position, data);
 	}
 	else if (position < EXTERNAL_RAM_END)
 	{
-		out = m_cartridge.cartridgeRead(position);
+		m_cartridge.cartridgeWrite(position, data);
 	}
 	else if (position < ECHO_RAM_END)
 	{
-		out = m_wram[(position & 0xDFFF) & 0x1FFF];
+		m_wram[(position & 0xDFFF) & 0x1FFF] = data;
 	}
 	else if (position < OAM_END)
 	{
-		out = m_ppu.readOam(position);
+		m_ppu.writeOamDMA(position, data);
 	}
 	else if (position < UNUSABLE_END)
 	{
-		out = 0;
 	}
 	else if (position < IO_REGISTERS_END)
 	{
 		if (position >= IORegisters::WAVE_RAM_START && position <= IORegisters::WAVE_RAM_END)
-			out = m_apu.readWaveRam(position);
+			m_apu.writeWaveRam(position, data);
 		else
-			out = readIO(position);
+			writeIO(position, data);
 	}
 	else if (position < HRAM_END)
 	{
-		out = m_hram[position & 0x7F];
+		m_hram[position & 0x7F] = data;
 	}
 	// interrupt enable register at 0xFFFF
 	else
 	{
-		out = m_cpu.m_interrupts.m_interruptEnable;
+		m_cpu.m_interrupts.m_interruptEnable = data;
+	}
+}
+
+uint8_t Bus::cpuRead(uint16_t position)
+{
+	const uint8_t page = m_pageTable[position >> 8];
+	uint8_t       out  = 0;
+
+	switch (page & PAGE_REGION_MASK)
+	{
+	case PAGE_ROM:
+		if (m_cpu.m_bootRomDisable || position >= BOOT_ROM_END)
+			out = m_cartridge.cartridgeRead(position);
+		else
+			out = m_cpu.m_bootrom.read(position);
+		break;
+
+	case PAGE_VRAM:
+		out = m_ppu.readVram(position);
+		break;
+
+	case PAGE_EXTERNAL_RAM:
+		out = m_cartridge.cartridgeRead(position);
+		break;
+
+	case PAGE_WRAM:
+		out = m_wram[(position & 0xDFFF) & 0x1FFF];
+		break;
+
+	case PAGE_OAM:
+		out = position < OAM_END ? m_ppu.readOam(position) : 0;
+		break;
+
+	default:
+		if (position < IO_REGISTERS_END)
+		{
+			if (position >= IORegisters::WAVE_RAM_START && position <= IORegisters::WAVE_RAM_END)
+				out = m_apu.readWaveRam(position);
+			else
+				out = readIO(position);
+		}
+		else if (position < HRAM_END)
+		{
+			out = m_hram[position & 0x7F];
+		}
+		// interrupt enable register at 0xFFFF
+		else
+		{
+			out = m_cpu.m_interrupts.m_interruptEnable;
+		}
+		break;
 	}
 
+	if (page & PAGE_TRAP_READ)
+		m_accessTrap(position, out, false);
+
 	tickM();
 	return out;
 }
 
 void Bus::cpuWrite(uint16_t position, uint8_t data)
 {
-	if (position < CARTRIDGE_ROM_END)
+	const uint8_t page = m_pageTable[position >> 8];
+
+	if (page & PAGE_TRAP_WRITE)
+		m_accessTrap(position, data, true);
+
+	switch (page & PAGE_REGION_MASK)
 	{
+	case PAGE_ROM:
+	case PAGE_EXTERNAL_RAM:
 		m_cartridge.cartridgeWrite(position, data);
-	}
-	else if (position < VRAM_END)
-	{
+		break;
+
+	case PAGE_VRAM:
 		m_ppu.writeVram(position, data);
-	}
-	else if (position < EXTERNAL_RAM_END)
-	{
-		m_cartridge.cartridgeWrite(position, data);
-	}
-	else if (position < ECHO_RAM_END)
-	{
+		break;
+
+	case PAGE_WRAM:
 		m_wram[(position & 0xDFFF) & 0x1FFF] = data;
-	}
-	else if (position < OAM_END)
-	{
-		m_ppu.writeOam(position, data);
-	}
-	else if (position < UNUSABLE_END)
-	{
-	}
-	else if (position < IO_REGISTERS_END)
-	{
-		if (position >= IORegisters::WAVE_RAM_START && position <= IORegisters::WAVE_RAM_END)
-			m_apu.writeWaveRam(position, data);
+		break;
+
+	case PAGE_OAM:
+		if (position < OAM_END)
+			m_ppu.writeOam(position, data);
+		break;
+
+	default:
+		if (position < IO_REGISTERS_END)
+		{
+			if (position >= IORegisters::WAVE_RAM_START && position <= IORegisters::WAVE_RAM_END)
+				m_apu.writeWaveRam(position, data);
+			else
+				writeIO(position, data);
+		}
+		else if (position < HRAM_END)
+		{
+			m_hram[position & 0x7F] = data;
+		}
+		// interrupt enable register at 0xFFFF
 		else
-			writeIO(position, data);
-	}
-	else if (position < HRAM_END)
-	{
-		m_hram[position & 0x7F] = data;
-	}
-	// interrupt enable register at 0xFFFF
-	else
-	{
-		m_cpu.m_interrupts.m_interruptEnable = data;
+		{
+			m_cpu.m_interrupts.m_interruptEnable = data;
+		}
+		break;
 	}
 
 	tickM();
@@ -183,22 +269,37 @@ void Bus::tickM()
 		handleOamDMA();
 
 	m_apu.tick(m_cpu.m_timer.getDivider());
-	m_ppu.tick();
-	m_ppu.tick();
-	m_ppu.tick();
-	m_ppu.tick();
+
+	if (!m_ppuDetached)
+	{
+		m_ppu.tick();
+		m_ppu.tick();
+		m_ppu.tick();
+		m_ppu.tick();
+	}
+
 	m_cpu.m_timer.tick(m_cpu.m_interrupts.m_interruptFlags);
+	m_cpu.m_serial.tick(m_cpu.m_interrupts.m_interruptFlags);
 }
 
-void Bus::onUpdate()
+bool Bus::runFrame()
+{
+	if (m_frameHook)
+		return m_frameHook();
+
+	while (!m_ppu.isFrameComplete())
+		m_cpu.instructionStep();
+
+	return true;
+}
+
+bool Bus::onUpdate()
 {
 	using namespace BudgetGbConstants;
 
 	if (m_apu.beginAudioFrame())
 	{
-
-		while (!m_ppu.isFrameComplete())
-			m_cpu.instructionStep();
+		const bool frameComplete = runFrame();
 
 		/*const float AUDIO_FRAME = (static_cast<float>(CLOCK_RATE_T) / AUDIO_SAMPLE_RATE) * (AUDIO_SAMPLE_RATE / 60.0f);
 		while (m_tCycles < AUDIO_FRAME)
@@ -207,7 +308,10 @@ void Bus::onUpdate()
 		m_tCycles -= AUDIO_FRAME;*/
 
 		m_apu.endAudioFrame();
+		return frameComplete;
 	}
+
+	return false;
 }
 
 void Bus::writeIO(uint16_t position, uint8_t data)
@@ -219,6 +323,11 @@ void Bus::writeIO(uint16_t position, uint8_t data)
 		break;
 
 	case IORegisters::SERIAL_SB:
+		m_cpu.m_serial.writeData(data);
+		break;
+
+	case IORegisters::SERIAL_SC:
+		m_cpu.m_serial.writeControl(data);
 		break;
 
 	case IORegisters::TIMER_DIV:
@@ -325,7 +434,10 @@ uint8_t Bus::readIO(uint16_t position)
 		return m_cpu.m_joypad.readJoypad();
 
 	case IORegisters::SERIAL_SB:
-		return 0xFF;
+		return m_cpu.m_serial.readData();
+
+	case IORegisters::SERIAL_SC:
+		return m_cpu.m_serial.readControl();
 
 	case IORegisters::TIMER_DIV:
 		return m_cpu.m_timer.getDivider();
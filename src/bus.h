@@ -8,6 +8,7 @@
 #include "cartridge.h"
 #include "emulatorConstants.h"
 #include "ppu.h"
+#include "utils/stateArchive.h"
 #include "utils/vec.h"
 
 class Sm83; // forward declare Sm83
@@ -33,6 +34,24 @@ class Bus
 	static constexpr uint16_t IO_REGISTERS_END  = 0xFF80;
 	static constexpr uint16_t HRAM_END          = 0xFFFF;
 
+	// region of every 256 byte page in the page table, the top bits mark pages whose accesses go through the trap
+
+	enum PageRegion : uint8_t
+	{
+		PAGE_ROM          = 0,
+		PAGE_VRAM         = 1,
+		PAGE_EXTERNAL_RAM = 2,
+		PAGE_WRAM         = 3, // echo ram included
+		PAGE_OAM          = 4, // oam and the unusable area after it
+		PAGE_HIGH         = 5, // io registers, hram and the interrupt enable register
+	};
+
+	static constexpr uint8_t PAGE_REGION_MASK = 0x3F;
+	static constexpr uint8_t PAGE_TRAP_READ   = 0x40;
+	static constexpr uint8_t PAGE_TRAP_WRITE  = 0x80;
+
+	using AccessTrap = std::function<void(uint16_t position, uint8_t data, bool write)>;
+
 	Bus(Cartridge &cartridge, Sm83 &cpu, PPU &ppu, Apu &apu);
 
 	void clearWram();
@@ -45,6 +64,13 @@ class Bus
 	 */
 	uint8_t busReadRaw(uint16_t position);
 
+	/**
+	 * @brief Write counterpart of busReadRaw() for debuggers, does not clock the cpu and ignores the ppu access
+	 * restrictions. Writes to rom are dropped instead of reaching the mapper registers, io registers are written as
+	 * the cpu would.
+	 */
+	void busWriteRaw(uint16_t position, uint8_t data);
+
 	/**
 	 * @brief Reads contents off bus based on cpu memory map, clocks cpu for 1 M-cycle.
 	 * @param position
@@ -64,20 +90,93 @@ class Bus
 	 */
 	void init(bool useBootrom)
 	{
-		m_tCycles = 0;
+		m_tCycles     = 0;
+		m_ppuDetached = false;
 
 		std::fill(m_wram.begin(), m_wram.end(), static_cast<uint8_t>(0));
 		std::fill(m_hram.begin(), m_hram.end(), static_cast<uint8_t>(0));
 		m_ppu.init(useBootrom);
 	}
 
+	/**
+	 * @brief Save or load wram, hram and the cycle counter. Components on the bus are saved separately, see
+	 * BudgetGBCore::saveState().
+	 */
+	void saveState(Utils::StateWriter &writer);
+	void loadState(Utils::StateReader &reader);
+
+	// chain a hash of wram and hram onto seed, see BudgetGBCore::hashRam()
+	uint64_t hashRam(uint64_t seed) const;
+
 	// one m-cycle clock
 	void tickM();
 
 	/**
-	 * @brief Run cpu for
+	 * @brief Stop clocking the ppu, used for sound only playback where nothing is drawn. Reattached on init().
+	 */
+	void setPpuDetached(bool detached)
+	{
+		m_ppuDetached = detached;
+	}
+
+	/**
+	 * @brief Rom bank the cpu sees at position, for profilers. The boot rom, ram and everything else outside of the
+	 * cartridge rom counts as bank 0.
+	 */
+	uint32_t getRomBank(uint16_t position) const;
+
+	// total elapsed t-cycles since init
+	uint64_t getElapsedCycles() const
+	{
+		return m_tCycles;
+	}
+
+	/**
+	 * @brief Run cpu for one frame when the audio buffer has room for more samples, otherwise does nothing.
+	 * @return True when a frame was run to completion.
 	 */
-	void onUpdate();
+	bool onUpdate();
+
+	/**
+	 * @brief Run cpu until the ppu completes a frame with no audio pacing.
+	 * @return False if a frame hook stopped the cpu before the frame completed.
+	 */
+	bool runFrame();
+
+	/**
+	 * @brief Take over the frame loop of runFrame(), for a debugger that looks at every instruction. The hook runs the
+	 * cpu until the ppu completes a frame or the debugger stops it and returns whether the frame completed. Without a
+	 * hook the frame loop has no per instruction checks at all. Must not be changed from inside the hook.
+	 */
+	void setFrameHook(std::function<bool()> hook)
+	{
+		m_frameHook = std::move(hook);
+	}
+
+	/**
+	 * @brief Set the function cpuRead() and cpuWrite() call for accesses to trapped pages, see setPageTrap(). Reads
+	 * call it after the byte was read and writes before the byte is written, both before the m-cycle is clocked.
+	 */
+	void setAccessTrap(AccessTrap trap)
+	{
+		m_accessTrap = std::move(trap);
+	}
+
+	/**
+	 * @brief Mark a 256 byte page as trapped for cpu reads, writes or both, for debugger watchpoints. Accesses to
+	 * pages that are not trapped dispatch through the page table as always and never see the trap. Needs an access
+	 * trap set while any page is trapped. busReadRaw() and busWriteRaw() are never trapped.
+	 */
+	void setPageTrap(uint8_t page, bool read, bool write)
+	{
+		m_pageTable[page] = static_cast<uint8_t>((m_pageTable[page] & PAGE_REGION_MASK) | (read ? PAGE_TRAP_READ : 0) | (write ? PAGE_TRAP_WRITE : 0));
+	}
+
+	void clearPageTraps()
+	{
+		for (uint8_t &page : m_pageTable)
+			page &= PAGE_REGION_MASK;
+	}
 
   private:
 	Cartridge &m_cartridge;
@@ -85,7 +184,13 @@ class Bus
 	PPU       &m_ppu;
 	Apu       &m_apu;
 
-	float m_tCycles = 0; // track total elapsed gameboy cycles
+	uint64_t m_tCycles     = 0; // track total elapsed gameboy cycles
+	bool     m_ppuDetached = false;
+
+	std::function<bool()> m_frameHook; // set while a debugger is attached, see setFrameHook()
+	AccessTrap            m_accessTrap; // see setAccessTrap()
+
+	std::array<uint8_t, 256> m_pageTable; // PageRegion and trap bits of every page, indexed by the address high byte
 
 	// memory components
 
@@ -3,6 +3,7 @@
 #include "fmt/base.h"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include <fstream>
 #include <string>
@@ -21,6 +22,7 @@ static bool readCartridgeHeader(std::ifstream &romFile, Mapper::CartInfo &cartIn
 	constexpr int CARTRIDGE_TYPE_POS = 0x0147;
 	constexpr int ROM_SIZE_POS       = 0x0148;
 	constexpr int RAM_SIZE_POS       = 0x0149;
+	constexpr int CHECKSUMS_POS      = 0x014D;
 
 	// set mbc type
 
@@ -33,6 +35,12 @@ static bool readCartridgeHeader(std::ifstream &romFile, Mapper::CartInfo &cartIn
 	romFile.seekg(RAM_SIZE_POS, std::ios::beg);
 	romFile.read(reinterpret_cast<char *>(&cartInfo.RamSize), 1);
 
+	// 0x014D header checksum followed by the big endian 0x014E - 0x014F global checksum
+	std::array<uint8_t, 3> checksums{};
+	romFile.seekg(CHECKSUMS_POS, std::ios::beg);
+	romFile.read(reinterpret_cast<char *>(checksums.data()), checksums.size());
+	cartInfo.Checksums = (checksums[0] << 16) | (checksums[1] << 8) | checksums[2];
+
 	// set rom size https://gbdev.io/pandocs/The_Cartridge_Header.html#0148--rom-size
 
 	// rom size values above 0x08 are not well documented and possibly incorrect, they are not used by official games anyways
@@ -88,7 +96,66 @@ static bool readCartridgeHeader(std::ifstream &romFile, Mapper::CartInfo &cartIn
 	return true;
 }
 
-bool Cartridge::loadCartridgeFromPath(const std::string &path, std::vector<std::string> &recentRoms)
+/**
+ * @brief Read and validate a gbs file header.
+ * @param gbsFile File object that is already opened, will not be closed once this function returns
+ * @param header Header that will be filled out
+ * @param errorMsg contains error msg if function return false
+ * @return true success, false fail
+ */
+static bool readGbsHeader(std::ifstream &gbsFile, Mapper::GbsHeader &header, std::string &errorMsg)
+{
+	std::array<uint8_t, Mapper::GbsHeader::SIZE> raw{};
+	gbsFile.seekg(0, std::ios::beg);
+	gbsFile.read(reinterpret_cast<char *>(raw.data()), raw.size());
+
+	if (gbsFile.gcount() != static_cast<std::streamsize>(raw.size()) || std::memcmp(raw.data(), "GBS", 3) != 0)
+	{
+		errorMsg = "Not a gbs file!";
+		return false;
+	}
+
+	if (raw[0x03] != 1)
+	{
+		errorMsg = "Unsupported gbs version!";
+		return false;
+	}
+
+	auto readU16 = [&raw](std::size_t offset) { return static_cast<uint16_t>(raw[offset] | (raw[offset + 1] << 8)); };
+	auto readStr = [&raw](std::size_t offset) {
+		const char *str = reinterpret_cast<const char *>(&raw[offset]);
+		return std::string(str, std::find(str, str + 32, '\0'));
+	};
+
+	header.TrackCount   = raw[0x04];
+	header.FirstTrack   = raw[0x05] == 0 ? 0 : raw[0x05] - 1;
+	header.LoadAddress  = readU16(0x06);
+	header.InitAddress  = readU16(0x08);
+	header.PlayAddress  = readU16(0x0A);
+	header.StackPointer = readU16(0x0C);
+	header.TimerModulo  = raw[0x0E];
+	header.TimerControl = raw[0x0F];
+	header.Title        = readStr(0x10);
+	header.Author       = readStr(0x30);
+	header.Copyright    = readStr(0x50);
+
+	// driver code lives below the load address
+	if (header.LoadAddress < 0x400 || header.LoadAddress >= 0x8000)
+	{
+		errorMsg = "Invalid gbs load address!";
+		return false;
+	}
+
+	if (header.TrackCount == 0)
+	{
+		errorMsg = "Gbs file has no tracks!";
+		return false;
+	}
+
+	return true;
+}
+
+bool Cartridge::loadCartridgeFromPath(const std::string &path, std::vector<std::string> &recentRoms, bool persistSaveRam)
 {
 	std::ifstream romFile(path, std::ios::binary);
 	recentRoms.erase(std::remove(recentRoms.begin(), recentRoms.end(), path), recentRoms.end());
@@ -100,7 +167,8 @@ bool Cartridge::loadCartridgeFromPath(const std::string &path, std::vector<std::
 	}
 
 	Mapper::CartInfo cartInfo{};
-	cartInfo.CartFilePath = path;
+	cartInfo.CartFilePath   = path;
+	cartInfo.PersistSaveRam = persistSaveRam;
 	if (!readCartridgeHeader(romFile, cartInfo, m_errorMsg))
 	{
 		fmt::println("{}", m_errorMsg);
@@ -120,3 +188,49 @@ bool Cartridge::loadCartridgeFromPath(const std::string &path, std::vector<std::
 
 	return m_cartridgeLoaded = true;
 }
+
+bool Cartridge::loadGbsFromPath(const std::string &path, std::vector<std::string> &recentRoms, Mapper::GbsHeader &header)
+{
+	std::ifstream gbsFile(path, std::ios::binary);
+	recentRoms.erase(std::remove(recentRoms.begin(), recentRoms.end(), path), recentRoms.end());
+
+	if (!gbsFile.is_open())
+	{
+		fmt::println(stderr, "Failed to open gbs at: {}", path);
+		return m_cartridgeLoaded = false;
+	}
+
+	if (!readGbsHeader(gbsFile, header, m_errorMsg))
+	{
+		fmt::println("{}", m_errorMsg);
+		return m_cartridgeLoaded = false;
+	}
+
+	gbsFile.seekg(0, std::ios::end);
+	const std::size_t dataSize = static_cast<std::size_t>(gbsFile.tellg()) - Mapper::GbsHeader::SIZE;
+
+	// image spans from address 0 to the end of the music data, rounded up to whole 16kb banks with a minimum of 32kb
+	const std::size_t imageSize = header.LoadAddress + dataSize;
+
+	Mapper::CartInfo cartInfo{};
+	cartInfo.CartFilePath   = path;
+	cartInfo.PersistSaveRam = false;
+	cartInfo.RomSize        = static_cast<uint32_t>(std::max<std::size_t>(0x8000, (imageSize + 0x3FFF) & ~static_cast<std::size_t>(0x3FFF)));
+	cartInfo.RamSize        = 1024 * 8;
+
+	if (cartInfo.RomSize > 0x4000 * 256)
+	{
+		m_errorMsg = "Gbs file too large!";
+		fmt::println("{}", m_errorMsg);
+		return m_cartridgeLoaded = false;
+	}
+
+	m_mapper = std::make_unique<Mapper::GBS>(gbsFile, cartInfo, header);
+
+	if (recentRoms.size() == BudgetGbConfig::MAX_RECENT_ROMS)
+		recentRoms.pop_back();
+
+	recentRoms.insert(recentRoms.begin(), path);
+
+	return m_cartridgeLoaded = true;
+}
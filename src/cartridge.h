@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "config.h"
+#include "mappers/GBS.h"
 #include "mappers/mapper.h"
 
 class Cartridge
@@ -16,7 +17,32 @@ class Cartridge
 		m_cartridgeLoaded = false;
 	}
 
-	bool loadCartridgeFromPath(const std::string &path, std::vector<std::string> &recentRoms);
+	/**
+	 * @brief Load cartridge rom and instantiate its mapper.
+	 * @param path
+	 * @param recentRoms Path is moved to the front of the recent roms list on success.
+	 * @param persistSaveRam Read and write the .sav file of battery backed cartridges.
+	 * @return True on success, false otherwise.
+	 */
+	bool loadCartridgeFromPath(const std::string &path, std::vector<std::string> &recentRoms, bool persistSaveRam = true);
+
+	/**
+	 * @brief Load a .gbs sound file as a cartridge, see GbsPlayer for driving its init and play routines.
+	 * @param path
+	 * @param recentRoms Path is moved to the front of the recent roms list on success.
+	 * @param header Out variable filled with the gbs file header.
+	 * @return True on success, false otherwise.
+	 */
+	bool loadGbsFromPath(const std::string &path, std::vector<std::string> &recentRoms, Mapper::GbsHeader &header);
+
+	/**
+	 * @brief Load the cartridge of other with a clone of its mapper, see Mapper::IMapper::clone().
+	 */
+	void cloneFrom(const Cartridge &other)
+	{
+		m_mapper          = other.m_cartridgeLoaded ? other.m_mapper->clone() : nullptr;
+		m_cartridgeLoaded = other.m_cartridgeLoaded;
+	}
 
 	bool isLoaded() const
 	{
@@ -33,6 +59,12 @@ class Cartridge
 		m_mapper->write(position, data);
 	}
 
+	// see Mapper::IMapper::getRomBank()
+	uint32_t getRomBank(uint16_t position) const
+	{
+		return m_mapper->getRomBank(position);
+	}
+
 	// Retrieves cartridge info that is valid assuming the cartridge is loaded.
 	const Mapper::CartInfo &getCartInfo() const
 	{
@@ -44,6 +76,21 @@ class Cartridge
 		m_mapper->reset();
 	}
 
+	void saveState(Utils::StateWriter &writer)
+	{
+		m_mapper->saveState(writer);
+	}
+
+	void loadState(Utils::StateReader &reader)
+	{
+		m_mapper->loadState(reader);
+	}
+
+	uint64_t hashRam(uint64_t seed) const
+	{
+		return m_mapper->hashRam(seed);
+	}
+
 	const char *getCartridgeErrorMsg()
 	{
 		return m_errorMsg.c_str();
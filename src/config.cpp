@@ -48,6 +48,13 @@ void BudgetGbConfig::Config::saveConfig()
 
 	config["active palette"] = activePalette;
 
+	config["audio"]["sample rate"] = audioSampleRate;
+	config["audio"]["quality"]     = audioQuality;
+
+	config["emulation"]["run ahead frames"]   = runAheadFrames;
+	config["emulation"]["fast forward speed"] = fastForwardSpeed;
+	config["emulation"]["auto resume"]        = autoResume;
+
 	std::ofstream configFile(CONFIG_FILE_NAME);
 	if (configFile.is_open())
 	{
@@ -130,6 +137,45 @@ void BudgetGbConfig::Config::loadConfig()
 			activePalette = selectedPalette;
 		}
 
+		// audio settings are newer than the rest of the config, older config files will not have them
+		if (config.contains("audio"))
+		{
+			const auto    &audio      = config["audio"];
+			const uint32_t sampleRate = audio.value("sample rate", BudgetGbConstants::AUDIO_SAMPLE_RATE);
+
+			if (std::find(BudgetGbConstants::AUDIO_SAMPLE_RATES.begin(), BudgetGbConstants::AUDIO_SAMPLE_RATES.end(), sampleRate) != BudgetGbConstants::AUDIO_SAMPLE_RATES.end())
+				audioSampleRate = sampleRate;
+
+			switch (static_cast<ResamplerQuality>(audio.value("quality", static_cast<int>(ResamplerQuality::Medium))))
+			{
+			case ResamplerQuality::Box:
+				audioQuality = ResamplerQuality::Box;
+				break;
+			case ResamplerQuality::Low:
+				audioQuality = ResamplerQuality::Low;
+				break;
+			case ResamplerQuality::Medium:
+				audioQuality = ResamplerQuality::Medium;
+				break;
+			case ResamplerQuality::High:
+				audioQuality = ResamplerQuality::High;
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (config.contains("emulation"))
+		{
+			const auto &emulation = config["emulation"];
+			runAheadFrames        = std::min(emulation.value("run ahead frames", 0u), MAX_RUN_AHEAD);
+			autoResume            = emulation.value("auto resume", autoResume);
+
+			const uint32_t speed = emulation.value("fast forward speed", fastForwardSpeed);
+			if (std::find(FAST_FORWARD_SPEEDS.begin(), FAST_FORWARD_SPEEDS.end(), speed) != FAST_FORWARD_SPEEDS.end())
+				fastForwardSpeed = speed;
+		}
+
 		configFile.close();
 	}
 }
\ No newline at end of file
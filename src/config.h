@@ -5,6 +5,9 @@
 #include <string>
 #include <vector>
 
+#include "PolyphaseResampler.h"
+#include "emulatorConstants.h"
+
 static constexpr int DEFAULT_ACTIVE_PALETTE = -1;
 
 namespace BudgetGbConfig
@@ -13,6 +16,10 @@ namespace BudgetGbConfig
 static constexpr const char *CONFIG_FILE_NAME = "config.json";
 static constexpr uint32_t    MAX_RECENT_ROMS  = 10;
 static constexpr uint32_t    MAX_PALETTES     = 10;
+static constexpr uint32_t    MAX_RUN_AHEAD    = 3; // frames
+
+// fast forward multipliers, 0 runs as fast as possible
+static constexpr std::array<uint32_t, 5> FAST_FORWARD_SPEEDS = {2, 3, 4, 8, 0};
 
 static constexpr std::array<std::array<float, 3>, 4> DEFAULT_GB_PALETTE = {{
 	{232.0f / 255.0f, 252.0f / 255.0f, 204.0f / 255.0f},
@@ -77,7 +84,12 @@ struct Config
 	FullscreenMode           fullscreenMode = FullscreenMode::STRETCHED;
 	std::vector<Palette>     palettes;
 	Palette                  defaultPalette;
-	int                      activePalette = DEFAULT_ACTIVE_PALETTE;
+	int                      activePalette    = DEFAULT_ACTIVE_PALETTE;
+	uint32_t                 audioSampleRate  = BudgetGbConstants::AUDIO_SAMPLE_RATE;
+	ResamplerQuality         audioQuality     = ResamplerQuality::Medium;
+	uint32_t                 runAheadFrames   = 0; // 0 disables run ahead
+	uint32_t                 fastForwardSpeed = 4; // one of FAST_FORWARD_SPEEDS
+	bool                     autoResume       = true; // continue roms where they were left on the next launch
 
 	void loadConfig();
 	void saveConfig();
@@ -0,0 +1,92 @@
+#include "gbsPlayer.h"
+#include "fmt/base.h"
+
+#include <array>
+
+GbsPlayer::GbsPlayer(BudgetGBCore &core)
+	: m_core(core)
+{
+}
+
+bool GbsPlayer::load(const std::string &path, std::vector<std::string> &recentRoms)
+{
+	if (!m_core.m_cartridge.loadGbsFromPath(path, recentRoms, m_header))
+		return false;
+
+	return startTrack(m_header.FirstTrack);
+}
+
+bool GbsPlayer::startTrack(uint8_t track)
+{
+	m_currentTrack = track < m_header.TrackCount ? track : 0;
+
+	m_core.reset(false);
+	m_core.m_bus.setPpuDetached(true);
+
+	Sm83 &cpu = m_core.m_cpu;
+
+	cpu.m_timer.m_timerModulo  = m_header.TimerModulo;
+	cpu.m_timer.m_timerControl = m_header.TimerControl & 0x7;
+
+	// timer driven play rate, bit 7 requests cgb double speed which is not emulated
+	if (m_header.TimerControl & 0x04)
+	{
+		constexpr std::array<uint32_t, 4> TIMER_PERIODS = {1024, 16, 64, 256}; // t-cycles per timer increment
+		m_playPeriod                                    = static_cast<uint64_t>(TIMER_PERIODS[m_header.TimerControl & 0x3]) * (256 - m_header.TimerModulo);
+	}
+	else
+	{
+		m_playPeriod = BudgetGbConstants::FRAME_CYCLES;
+	}
+
+	cpu.m_programCounter         = Mapper::GBS::INIT_ENTRY;
+	cpu.m_stackPointer           = m_header.StackPointer;
+	cpu.m_registerAF.accumulator = m_currentTrack;
+
+	// give init up to a second to return to the idle loop
+	const uint64_t initDeadline = m_core.m_bus.getElapsedCycles() + BudgetGbConstants::CLOCK_RATE_T;
+	while (cpu.m_programCounter != Mapper::GBS::IDLE_LOOP)
+	{
+		if (m_core.m_bus.getElapsedCycles() >= initDeadline)
+		{
+			fmt::println(stderr, "Gbs init routine for track {} did not return!", m_currentTrack + 1);
+			return false;
+		}
+
+		cpu.instructionStep();
+	}
+
+	m_nextPlayCycle = m_core.m_bus.getElapsedCycles();
+	return true;
+}
+
+void GbsPlayer::onUpdate()
+{
+	if (m_core.m_apu.beginAudioFrame())
+	{
+		runFrame();
+		m_core.m_apu.endAudioFrame();
+	}
+}
+
+void GbsPlayer::runCycles(uint64_t cycles)
+{
+	Bus  &bus = m_core.m_bus;
+	Sm83 &cpu = m_core.m_cpu;
+
+	const uint64_t endCycle = bus.getElapsedCycles() + cycles;
+
+	while (bus.getElapsedCycles() < endCycle)
+	{
+		if (bus.getElapsedCycles() >= m_nextPlayCycle)
+		{
+			// a play routine still running when the next call is due is allowed to finish, that call is dropped
+			if (cpu.m_programCounter == Mapper::GBS::IDLE_LOOP)
+				cpu.m_programCounter = Mapper::GBS::PLAY_ENTRY;
+
+			m_nextPlayCycle += m_playPeriod;
+		}
+
+		cpu.instructionStep();
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BudgetGBCore.h"
+#include "mappers/GBS.h"
+
+/**
+ * @brief Plays .gbs sound files on top of the cpu, bus and apu of a core. The ppu is detached from the bus and the
+ * play routine is called at the rate given by the gbs timer settings, or at the vblank rate if the timer is unused.
+ */
+class GbsPlayer
+{
+  public:
+	GbsPlayer(BudgetGBCore &core);
+
+	/**
+	 * @brief Load gbs file into the core's cartridge slot and start its first track.
+	 * @param path
+	 * @param recentRoms
+	 * @return True on success, false otherwise.
+	 */
+	bool load(const std::string &path, std::vector<std::string> &recentRoms);
+
+	/**
+	 * @brief Reset the core and run the init routine for a track.
+	 * @param track 0 based track number.
+	 * @return False if init routine did not return in a reasonable amount of time.
+	 */
+	bool startTrack(uint8_t track);
+
+	/**
+	 * @brief Run for the same duration as one lcd frame, calling the play routine whenever it is due.
+	 */
+	void runFrame()
+	{
+		runCycles(BudgetGbConstants::FRAME_CYCLES);
+	}
+
+	/**
+	 * @brief Audio paced equivalent of Bus::onUpdate().
+	 */
+	void onUpdate();
+
+	const Mapper::GbsHeader &getHeader() const
+	{
+		return m_header;
+	}
+
+	uint8_t getCurrentTrack() const
+	{
+		return m_currentTrack;
+	}
+
+  private:
+	BudgetGBCore     &m_core;
+	Mapper::GbsHeader m_header;
+
+	uint8_t  m_currentTrack  = 0;
+	uint64_t m_playPeriod    = BudgetGbConstants::FRAME_CYCLES; // t-cycles between play calls
+	uint64_t m_nextPlayCycle = 0;
+
+	void runCycles(uint64_t cycles);
+};
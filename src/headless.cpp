@@ -0,0 +1,2356 @@
+#include "headless.h"
+#include "BudgetGBCore.h"
+#include "CallProfiler.h"
+#include "DebugCondition.h"
+#include "Debugger.h"
+#include "EmulationThread.h"
+#include "GdbServer.h"
+#include "Movie.h"
+#include "Profiler.h"
+#include "RewindBuffer.h"
+#include "RollbackSession.h"
+#include "SerialLink.h"
+#include "SharedMemoryChannel.h"
+#include "StateIndex.h"
+#include "audioBench.h"
+#include "emulatorConstants.h"
+#include "fmt/base.h"
+#include "fmt/format.h"
+#include "gbsPlayer.h"
+#include "utils/hash.h"
+#include "utils/tcpSocket.h"
+#include "utils/threadPool.h"
+#include "utils/tripleBuffer.h"
+#include "utils/udpSocket.h"
+#include "utils/wavWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct RenderAudioArgs
+{
+	std::string inputPath;
+	std::string outPath;
+	uint64_t    frames  = 0;
+	double      seconds = 0.0;
+	bool        stems   = false;
+	uint32_t    threads = 0; // 0 uses all hardware threads
+
+	uint32_t         sampleRate = BudgetGbConstants::AUDIO_SAMPLE_RATE;
+	ResamplerQuality quality    = ResamplerQuality::Medium;
+	float            speed      = 1.0f; // emulated seconds per second of output
+};
+
+void printUsage()
+{
+	fmt::println(stderr, "Usage: BudgetGB --render-audio <rom> --out <file.wav> [--frames N | --seconds S] [--stems] [--rate HZ] [--quality Q] [--speed X]");
+	fmt::println(stderr, "       BudgetGB --render-gbs <file.gbs> --out <file.wav> [--frames N | --seconds S] [--stems] [--threads N] [--rate HZ] [--quality Q] [--speed X]");
+	fmt::println(stderr, "       BudgetGB --audio-bench [--seconds S]");
+	fmt::println(stderr, "       BudgetGB --state-bench <rom> [--frames N]");
+	fmt::println(stderr, "       BudgetGB --play-movie <movie> --rom <rom> [--hashes <file.txt>]");
+	fmt::println(stderr, "       BudgetGB --netplay-bench <rom> [--frames N] [--delay D] [--latency L] [--loss P]");
+	fmt::println(stderr, "       BudgetGB --determinism <rom> [--frames N]");
+	fmt::println(stderr, "       BudgetGB --fork-bench <rom> [--frames N] [--children C] [--branch-frames F] [--threads T]");
+	fmt::println(stderr, "       BudgetGB --shm-bench <rom> [--frames N]");
+	fmt::println(stderr, "       BudgetGB --pacing-bench <rom> [--seconds S] [--stall MS] [--locked-stall MS]");
+	fmt::println(stderr, "       BudgetGB --link-bench <rom> [--frames N] [--udp]");
+	fmt::println(stderr, "       BudgetGB --gdb <rom> [--port P]");
+	fmt::println(stderr, "       BudgetGB --gdb-check <rom> [--frames N]");
+	fmt::println(stderr, "       BudgetGB --debugger-check <rom> [--frames N]");
+	fmt::println(stderr, "       BudgetGB --profile <rom> [--frames N] [--out <file.csv>] [--folded <file.folded>]");
+	fmt::println(stderr, "       Q is one of box, low, medium, high. HZ is one of 22050, 44100, 48000, 96000");
+	fmt::println(stderr, "       X time compresses audio between 1 and 8 times without changing pitch, not combinable with --stems");
+}
+
+bool parseQuality(std::string_view name, ResamplerQuality &quality)
+{
+	for (ResamplerQuality candidate : {ResamplerQuality::Box, ResamplerQuality::Low, ResamplerQuality::Medium, ResamplerQuality::High})
+	{
+		if (name == getResamplerQualityString(candidate))
+		{
+			quality = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool parseSampleRate(const char *value, uint32_t &sampleRate)
+{
+	const uint32_t rate = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+
+	if (std::find(BudgetGbConstants::AUDIO_SAMPLE_RATES.begin(), BudgetGbConstants::AUDIO_SAMPLE_RATES.end(), rate) == BudgetGbConstants::AUDIO_SAMPLE_RATES.end())
+		return false;
+
+	sampleRate = rate;
+	return true;
+}
+
+bool parseRenderAudioArgs(int argc, char **argv, RenderAudioArgs &args)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view arg      = argv[i];
+		bool             hasValue = i + 1 < argc;
+
+		if ((arg == "--render-audio" || arg == "--render-gbs") && hasValue)
+			args.inputPath = argv[++i];
+		else if (arg == "--out" && hasValue)
+			args.outPath = argv[++i];
+		else if (arg == "--frames" && hasValue)
+			args.frames = std::strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--seconds" && hasValue)
+			args.seconds = std::strtod(argv[++i], nullptr);
+		else if (arg == "--threads" && hasValue)
+			args.threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (arg == "--rate" && hasValue && parseSampleRate(argv[i + 1], args.sampleRate))
+			++i;
+		else if (arg == "--quality" && hasValue && parseQuality(argv[i + 1], args.quality))
+			++i;
+		else if (arg == "--speed" && hasValue)
+			args.speed = std::strtof(argv[++i], nullptr);
+		else if (arg == "--stems")
+			args.stems = true;
+		else
+		{
+			fmt::println(stderr, "Unrecognized or incomplete argument: {}", arg);
+			return false;
+		}
+	}
+
+	if (args.inputPath.empty() || args.outPath.empty() || (args.frames == 0 && args.seconds <= 0.0) || (args.frames != 0 && args.seconds > 0.0))
+		return false;
+
+	// stems are not time stretched
+	if (args.speed < 1.0f || args.speed > TimeStretch::MAX_SPEED || (args.speed > 1.0f && args.stems))
+		return false;
+
+	return true;
+}
+
+// <out>.wav -> <out>.<suffix>.wav
+std::string suffixedPath(const std::string &outPath, std::string_view suffix)
+{
+	std::string base = outPath;
+	if (base.size() > 4 && base.compare(base.size() - 4, 4, ".wav") == 0)
+		base.resize(base.size() - 4);
+
+	return base + "." + std::string(suffix) + ".wav";
+}
+
+// Mixed output plus optional per channel stems, drained from the apu after every emulated frame.
+class AudioOutput
+{
+  public:
+	bool open(const std::string &outPath, uint32_t sampleRate, bool stems)
+	{
+		constexpr std::array<std::string_view, 4> STEM_NAMES = {"pulse1", "pulse2", "wave", "noise"};
+
+		m_stems = stems;
+
+		if (!m_mixWriter.open(outPath, sampleRate))
+			return false;
+
+		if (m_stems)
+		{
+			for (std::size_t i = 0; i < m_stemWriters.size(); ++i)
+			{
+				if (!m_stemWriters[i].open(suffixedPath(outPath, STEM_NAMES[i]), sampleRate))
+					return false;
+
+				m_stemChannels[i].resize(CHUNK_SIZE);
+			}
+
+			m_stemChunk.resize(CHUNK_SIZE);
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief Write out all samples available in the apu.
+	 * @return Number of samples written, never more than maxSamples.
+	 */
+	uint64_t drain(Apu &apu, uint64_t maxSamples)
+	{
+		uint64_t written     = 0;
+		uint32_t samplesRead = 0;
+
+		while (written < maxSamples && (samplesRead = apu.readSamples(m_mixChunk.data(), m_stems ? m_stemChunk.data() : nullptr, CHUNK_SIZE)) > 0)
+		{
+			const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(samplesRead, maxSamples - written));
+
+			m_mixWriter.write(m_mixChunk.data(), count);
+
+			if (m_stems)
+			{
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					m_stemChannels[0][i] = m_stemChunk[i].Pulse1;
+					m_stemChannels[1][i] = m_stemChunk[i].Pulse2;
+					m_stemChannels[2][i] = m_stemChunk[i].Wave;
+					m_stemChannels[3][i] = m_stemChunk[i].Noise;
+				}
+
+				for (std::size_t channel = 0; channel < m_stemWriters.size(); ++channel)
+					m_stemWriters[channel].write(m_stemChannels[channel].data(), count);
+			}
+
+			written += count;
+		}
+
+		return written;
+	}
+
+  private:
+	// box filter ring buffer holds 8 frames of audio, draining after every frame is enough to never drop samples
+	static constexpr uint32_t CHUNK_SIZE = BudgetGbConstants::AUDIO_SAMPLE_RATES.back() / 60 * 2;
+
+	bool m_stems = false;
+
+	Utils::WavWriter                m_mixWriter;
+	std::array<Utils::WavWriter, 4> m_stemWriters;
+
+	std::vector<float>                m_mixChunk = std::vector<float>(CHUNK_SIZE);
+	std::vector<BoxFilter::Samples>   m_stemChunk;
+	std::array<std::vector<float>, 4> m_stemChannels;
+};
+
+struct RenderStats
+{
+	uint64_t frames  = 0;
+	uint64_t samples = 0;
+};
+
+/**
+ * @brief Run frames and stream audio out until the requested duration is reached.
+ * @param runFrame Callable that emulates one frame on core.
+ */
+template <typename RunFrame>
+bool renderCore(BudgetGBCore &core, const RenderAudioArgs &args, const std::string &outPath, RunFrame &&runFrame, RenderStats &stats)
+{
+	core.m_apu.enableStems(args.stems);
+	core.m_apu.setPlaybackSpeed(args.speed);
+
+	AudioOutput output;
+	if (!output.open(outPath, core.m_apu.getSampleRate(), args.stems))
+		return false;
+
+	// a duration in seconds is rendered as an exact sample count, a frame count renders however many samples those frames produce
+	const uint64_t targetSamples = args.seconds > 0.0 ? static_cast<uint64_t>(std::llround(args.seconds * core.m_apu.getSampleRate())) : UINT64_MAX;
+	const uint64_t targetFrames  = args.frames != 0 ? args.frames : UINT64_MAX;
+
+	while (stats.frames < targetFrames && stats.samples < targetSamples)
+	{
+		runFrame();
+		++stats.frames;
+
+		stats.samples += output.drain(core.m_apu, targetSamples - stats.samples);
+	}
+
+	return true;
+}
+
+void printTiming(std::string_view label, const RenderStats &stats, uint32_t sampleRate, double elapsedSeconds)
+{
+	using namespace BudgetGbConstants;
+
+	const double emulatedSeconds = static_cast<double>(stats.frames) * FRAME_CYCLES / CLOCK_RATE_T;
+	fmt::println("{}: {} frames ({:.2f}s of audio, {} samples) in {:.3f}s, {:.1f}x real time",
+	             label,
+	             stats.frames,
+	             static_cast<double>(stats.samples) / sampleRate,
+	             stats.samples,
+	             elapsedSeconds,
+	             elapsedSeconds > 0.0 ? emulatedSeconds / elapsedSeconds : 0.0);
+}
+
+bool renderAudio(const RenderAudioArgs &args)
+{
+	BudgetGBCore             core(args.sampleRate, args.quality);
+	std::vector<std::string> recentRoms;
+
+	if (!core.loadCartridge(args.inputPath, recentRoms, false))
+		return false;
+
+	core.reset(false);
+
+	RenderStats stats;
+	auto        startTime = std::chrono::steady_clock::now();
+
+	if (!renderCore(core, args, args.outPath, [&core]() { core.runFrame(); }, stats))
+		return false;
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	printTiming("Rendered", stats, core.m_apu.getSampleRate(), elapsed.count());
+
+	return true;
+}
+
+// every track is rendered on its own core, worker threads pull tracks until none are left
+bool renderGbs(const RenderAudioArgs &args)
+{
+	Mapper::GbsHeader header;
+	{
+		Cartridge                cartridge;
+		std::vector<std::string> recentRoms;
+
+		if (!cartridge.loadGbsFromPath(args.inputPath, recentRoms, header))
+			return false;
+	}
+
+	fmt::println("{} - {} ({} tracks)", header.Title, header.Author, header.TrackCount);
+
+	const uint32_t threadCount = std::min<uint32_t>(args.threads != 0 ? args.threads : std::max(1u, std::thread::hardware_concurrency()), header.TrackCount);
+
+	std::atomic<uint32_t> nextTrack{0};
+	std::atomic<bool>     failed{false};
+
+	auto worker = [&]() {
+		BudgetGBCore             core(args.sampleRate, args.quality);
+		GbsPlayer                player(core);
+		std::vector<std::string> recentRoms;
+
+		if (!player.load(args.inputPath, recentRoms))
+		{
+			failed = true;
+			return;
+		}
+
+		uint32_t track;
+		while ((track = nextTrack.fetch_add(1)) < header.TrackCount)
+		{
+			auto startTime = std::chrono::steady_clock::now();
+
+			RenderStats       stats;
+			const std::string outPath = suffixedPath(args.outPath, fmt::format("track{:02}", track + 1));
+
+			if (!player.startTrack(static_cast<uint8_t>(track)) || !renderCore(core, args, outPath, [&player]() { player.runFrame(); }, stats))
+			{
+				failed = true;
+				continue;
+			}
+
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+			printTiming(fmt::format("Track {:02}", track + 1), stats, core.m_apu.getSampleRate(), elapsed.count());
+		}
+	};
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (uint32_t i = 0; i < threadCount; ++i)
+		workers.emplace_back(worker);
+
+	for (auto &thread : workers)
+		thread.join();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	fmt::println("Rendered {} tracks on {} threads in {:.3f}s", header.TrackCount, threadCount, elapsed.count());
+
+	return !failed;
+}
+/**
+ * @brief Time pushing frames into a rewind buffer, then step back through the most recent ones and check that each
+ * lands on the state that frame was saved with.
+ */
+bool rewindBench(BudgetGBCore &core, uint64_t frames)
+{
+	constexpr uint64_t CHECKED_FRAMES = 120;
+
+	RewindBuffer                      rewindBuffer;
+	Utils::StateWriter                writer;
+	std::vector<std::vector<uint8_t>> expected;
+
+	double pushSeconds = 0.0;
+
+	for (uint64_t i = 0; i < frames + 1; ++i)
+	{
+		core.runFrame();
+
+		auto startTime = std::chrono::steady_clock::now();
+		rewindBuffer.push(core);
+		pushSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+		if (frames - i < CHECKED_FRAMES)
+		{
+			core.saveState(writer);
+			expected.push_back(writer.getBuffer());
+		}
+	}
+
+	const uint32_t snapshots     = rewindBuffer.getSnapshotCount();
+	const double   bytesPerFrame = snapshots ? static_cast<double>(rewindBuffer.getUsedBytes()) / snapshots : 0.0;
+
+	fmt::println("Rewind: {} frames in {} bytes, {:.0f} bytes per frame, {:.2f}us per push", snapshots, rewindBuffer.getUsedBytes(), bytesPerFrame, frames ? pushSeconds * 1e6 / frames : 0.0);
+
+	if (bytesPerFrame > 0.0)
+		fmt::println("Rewind: {:.1f} minutes of history fit in {} MB", RewindBuffer::DEFAULT_CAPACITY / bytesPerFrame / 3600.0, RewindBuffer::DEFAULT_CAPACITY / (1024 * 1024));
+
+	// the newest expected state is the one on screen, each step back lands one frame earlier
+	uint64_t matched = 0;
+	for (std::size_t i = expected.size() - 1; i-- > 0;)
+	{
+		if (!rewindBuffer.stepBack(core))
+			break;
+
+		core.saveState(writer);
+		if (writer.getBuffer() != expected[i])
+			break;
+
+		++matched;
+	}
+
+	fmt::println("Rewind: {} of {} frames stepped back exactly", matched, expected.size() - 1);
+	return matched == expected.size() - 1;
+}
+
+/**
+ * @brief Time saving and loading states of a rom after running it for some frames, then check that a loaded state
+ * replays the same frames as the original run.
+ */
+bool stateBench(const std::string &romPath, uint64_t frames)
+{
+	constexpr int ITERATIONS    = 1000;
+	constexpr int REPLAY_FRAMES = 60;
+
+	BudgetGBCore             core(BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality::Medium);
+	std::vector<std::string> recentRoms;
+
+	if (!core.loadCartridge(romPath, recentRoms, false))
+		return false;
+
+	core.reset(false);
+	for (uint64_t i = 0; i < frames; ++i)
+		core.runFrame();
+
+	Utils::StateWriter writer;
+	core.saveState(writer);
+
+	const std::vector<uint8_t> snapshot = writer.getBuffer();
+
+	auto startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; ++i)
+		core.saveState(writer);
+	std::chrono::duration<double, std::micro> saveTime = std::chrono::steady_clock::now() - startTime;
+
+	startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; ++i)
+		core.loadState(snapshot.data(), snapshot.size());
+	std::chrono::duration<double, std::micro> loadTime = std::chrono::steady_clock::now() - startTime;
+
+	fmt::println("State size: {} bytes", snapshot.size());
+	fmt::println("Save: {:.2f}us, load: {:.2f}us", saveTime.count() / ITERATIONS, loadTime.count() / ITERATIONS);
+
+	// auto resume on launch loads through a file mapping
+	{
+		const std::filesystem::path statePath = std::filesystem::temp_directory_path() / "budgetgb-state-bench.state";
+		if (!core.saveStateToFile(statePath.string()))
+			return false;
+
+		startTime = std::chrono::steady_clock::now();
+		bool loaded = core.loadStateFromFile(statePath.string());
+		std::chrono::duration<double, std::micro> firstLoadTime = std::chrono::steady_clock::now() - startTime;
+
+		startTime = std::chrono::steady_clock::now();
+		for (int i = 0; i < ITERATIONS && loaded; ++i)
+			loaded = core.loadStateFromFile(statePath.string());
+		std::chrono::duration<double, std::micro> fileLoadTime = std::chrono::steady_clock::now() - startTime;
+
+		std::error_code error;
+		std::filesystem::remove(statePath, error);
+
+		if (!loaded)
+			return false;
+
+		fmt::println("Load from file: {:.2f}us first, {:.2f}us after", firstLoadTime.count(), fileLoadTime.count() / ITERATIONS);
+	}
+
+	for (int i = 0; i < REPLAY_FRAMES; ++i)
+		core.runFrame();
+
+	core.saveState(writer);
+	const std::vector<uint8_t> original = writer.getBuffer();
+
+	if (!core.loadState(snapshot.data(), snapshot.size()))
+		return false;
+
+	for (int i = 0; i < REPLAY_FRAMES; ++i)
+		core.runFrame();
+
+	core.saveState(writer);
+	const bool deterministic = writer.getBuffer() == original;
+
+	fmt::println("Replay after load: {}", deterministic ? "identical" : "diverged");
+
+	// a host frame with run ahead is one real frame plus the frames run ahead and the save and load around them
+	for (uint32_t runAhead = 0; runAhead <= BudgetGbConfig::MAX_RUN_AHEAD; ++runAhead)
+	{
+		startTime = std::chrono::steady_clock::now();
+		// the frame run ahead is the one shown, the frontend does not draw the real one
+		core.m_ppu.setOutputEnabled(runAhead == 0);
+
+		for (int i = 0; i < REPLAY_FRAMES; ++i)
+		{
+			core.runFrame();
+			core.runAhead(runAhead);
+		}
+
+		core.m_ppu.setOutputEnabled(true);
+		std::chrono::duration<double, std::milli> frameTime = std::chrono::steady_clock::now() - startTime;
+
+		const double hostFrameMs = frameTime.count() / REPLAY_FRAMES;
+		fmt::println("Run ahead {}: {:.3f}ms per host frame, {:.1f}% of a 60hz frame", runAhead, hostFrameMs, hostFrameMs * 6.0);
+	}
+	return deterministic && rewindBench(core, frames);
+}
+
+
+/**
+ * @brief Play a movie back as fast as the core runs, then report the speed and a hash of the final state. A hash of
+ * every frame is written to hashesPath if given, one line per frame, so two runs can be diffed.
+ */
+bool playMovie(const std::string &moviePath, const std::string &romPath, const std::string &hashesPath)
+{
+	Movie movie;
+	if (!movie.loadFromFile(moviePath))
+		return false;
+
+	BudgetGBCore             core(BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality::Medium);
+	std::vector<std::string> recentRoms;
+
+	// the movie carries its own save ram in the starting state
+	if (!core.loadCartridge(romPath, recentRoms, false) || !movie.startPlayback(core))
+		return false;
+
+	// nothing listens to the audio, channels still run so the state is unaffected
+	core.m_apu.setOutputEnabled(false);
+
+	std::ofstream hashesFile;
+	if (!hashesPath.empty())
+	{
+		hashesFile.open(hashesPath);
+		if (!hashesFile.is_open())
+		{
+			fmt::println(stderr, "Failed to open hashes file at: {}", hashesPath);
+			return false;
+		}
+	}
+
+	Joypad &joypad = core.m_cpu.m_joypad;
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	while (movie.getMode() == Movie::Mode::Playing)
+	{
+		movie.beforeFrame(joypad);
+		core.runFrame();
+		movie.afterFrame(joypad);
+
+		if (hashesFile.is_open())
+			hashesFile << fmt::format("{} {:016x}\n", movie.getCurrentFrame(), core.hashState());
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+	const double emulatedSeconds = static_cast<double>(movie.getFrameCount()) * BudgetGbConstants::FRAME_CYCLES / BudgetGbConstants::CLOCK_RATE_T;
+	fmt::println("Played {} frames in {:.3f}s, {:.0f} fps, {:.1f}x real time{}",
+	             movie.getFrameCount(),
+	             elapsed.count(),
+	             elapsed.count() > 0.0 ? movie.getFrameCount() / elapsed.count() : 0.0,
+	             elapsed.count() > 0.0 ? emulatedSeconds / elapsed.count() : 0.0,
+	             hashesFile.is_open() ? " including per frame hashing" : "");
+
+	fmt::println("Final state hash: {:016x}", core.hashState());
+
+	return hashesFile.is_open() ? hashesFile.good() : true;
+}
+
+
+// Forwards datagrams between two local sockets after a delay in ticks, dropping some at random.
+class LossyRelay
+{
+  public:
+	LossyRelay(uint32_t latency, double loss)
+		: m_latency(latency),
+		  m_loss(loss)
+	{
+	}
+
+	bool open()
+	{
+		return m_sides[0].Socket.open(0) && m_sides[1].Socket.open(0);
+	}
+
+	// port a peer sends to, its datagrams come out of the other side
+	uint16_t getPort(int side) const
+	{
+		return m_sides[side].Socket.getLocalPort();
+	}
+
+	bool setPeerPort(int side, uint16_t port)
+	{
+		return m_sides[side].Socket.setPeer("127.0.0.1", port);
+	}
+
+	void tick(uint64_t now)
+	{
+		std::array<uint8_t, 512> buffer;
+
+		for (int side = 0; side < 2; ++side)
+		{
+			std::size_t size;
+			while ((size = m_sides[side].Socket.receive(buffer.data(), buffer.size())) > 0)
+			{
+				if (m_random(m_generator) >= m_loss)
+					m_sides[side ^ 1].Queue.push_back({now + m_latency, std::vector<uint8_t>(buffer.begin(), buffer.begin() + size)});
+			}
+		}
+
+		for (Side &side : m_sides)
+		{
+			for (; !side.Queue.empty() && side.Queue.front().Due <= now; side.Queue.pop_front())
+				side.Socket.send(side.Queue.front().Data.data(), side.Queue.front().Data.size());
+		}
+	}
+
+  private:
+	struct Datagram
+	{
+		uint64_t             Due;
+		std::vector<uint8_t> Data;
+	};
+
+	struct Side
+	{
+		Utils::UdpSocket     Socket;
+		std::deque<Datagram> Queue; // datagrams waiting to be sent out of this side
+	};
+
+	uint32_t m_latency;
+	double   m_loss;
+
+	std::array<Side, 2>                    m_sides;
+	std::mt19937                           m_generator{1};
+	std::uniform_real_distribution<double> m_random{0.0, 1.0};
+};
+
+// buttons a simulated player holds on a frame, a new random set every 20 frames
+uint8_t getBotInput(uint32_t player, uint32_t frame)
+{
+	const uint32_t block = frame / 20;
+	return static_cast<uint8_t>(Utils::hash64(&block, sizeof(block), player));
+}
+
+/**
+ * @brief Run two netplay peers in one process over loopback udp. Their datagrams go through a relay that adds latency
+ * and loss so predictions miss and frames are rolled back, then both peers must end on the same state.
+ */
+bool netplayBench(const std::string &romPath, uint32_t frames, uint32_t inputDelay, uint32_t latency, double loss)
+{
+	constexpr uint32_t SYNC_TICKS = 10000;
+
+	BudgetGBCore                  coreA(BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality::Medium);
+	BudgetGBCore                  coreB(BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality::Medium);
+	std::array<BudgetGBCore *, 2> cores = {&coreA, &coreB};
+	std::vector<std::string>      recentRoms;
+
+	for (BudgetGBCore *core : cores)
+	{
+		if (!core->loadCartridge(romPath, recentRoms, false))
+			return false;
+
+		core->reset(false);
+		core->m_apu.setOutputEnabled(false);
+	}
+
+	// worst case a host frame has to fit in: a full rollback on top of the frame itself
+	{
+		Utils::StateWriter writer;
+		coreA.saveState(writer);
+
+		coreA.m_ppu.setOutputEnabled(false);
+		auto startTime = std::chrono::steady_clock::now();
+
+		for (uint32_t i = 0; i < RollbackSession::MAX_ROLLBACK_FRAMES; ++i)
+			coreA.runFrame();
+
+		std::chrono::duration<double, std::milli> resimulateTime = std::chrono::steady_clock::now() - startTime;
+		coreA.m_ppu.setOutputEnabled(true);
+		coreA.loadState(writer.getBuffer().data(), writer.getSize());
+
+		fmt::println("Resimulating {} frames: {:.3f}ms, {:.1f}% of a 60hz frame", RollbackSession::MAX_ROLLBACK_FRAMES, resimulateTime.count(), resimulateTime.count() * 6.0);
+	}
+
+	LossyRelay relay(latency, loss);
+	if (!relay.open())
+		return false;
+
+	RollbackSession                  sessionA(coreA, inputDelay);
+	RollbackSession                  sessionB(coreB, inputDelay);
+	std::array<RollbackSession *, 2> sessions = {&sessionA, &sessionB};
+
+	for (int side = 0; side < 2; ++side)
+	{
+		if (!sessions[side]->connect(0, "127.0.0.1", relay.getPort(side)) || !relay.setPeerPort(side, sessions[side]->getLocalPort()))
+			return false;
+	}
+
+	// one tick is one host frame, both peers try to run a frame every tick
+	uint64_t tick      = 0;
+	auto     startTime = std::chrono::steady_clock::now();
+
+	while ((sessionA.getFrame() < frames || sessionB.getFrame() < frames) && !sessionA.hasStartStateMismatch() && !sessionB.hasStartStateMismatch())
+	{
+		relay.tick(tick++);
+
+		for (uint32_t player = 0; player < 2; ++player)
+		{
+			RollbackSession &session = *sessions[player];
+			if (session.getFrame() < frames && session.beginFrame(getBotInput(player, session.getFrame() + inputDelay)))
+			{
+				cores[player]->runFrame();
+				session.endFrame();
+			}
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+	// the last frames may still be predicted, let the final inputs arrive and any rollbacks happen
+	for (uint32_t i = 0; i < SYNC_TICKS && !(sessionA.isConfirmed() && sessionB.isConfirmed()); ++i)
+	{
+		relay.tick(tick++);
+		sessionA.poll();
+		sessionB.poll();
+	}
+
+	fmt::println("Netplay: {} frames in {} ticks, {:.3f}s, input delay {}, latency {} frames, {:.0f}% loss", frames, tick, elapsed.count(), inputDelay, latency, loss * 100.0);
+
+	for (uint32_t player = 0; player < 2; ++player)
+	{
+		const RollbackSession::Stats &stats = sessions[player]->getStats();
+		fmt::println("Peer {}: {} rollbacks, {} frames resimulated, {} at most, {:.1f}us per resimulated frame, {} stalled ticks",
+		             player + 1,
+		             stats.Rollbacks,
+		             stats.ResimulatedFrames,
+		             stats.MaxRollbackFrames,
+		             stats.ResimulatedFrames ? stats.ResimulatedSeconds * 1e6 / stats.ResimulatedFrames : 0.0,
+		             stats.StalledFrames);
+	}
+
+	const uint64_t hashA  = coreA.hashState();
+	const uint64_t hashB  = coreB.hashState();
+	const bool     synced = sessionA.isConfirmed() && sessionB.isConfirmed() && hashA == hashB;
+
+	fmt::println("Final state hashes: {:016x} {:016x}, {}", hashA, hashB, synced ? "in sync" : "desynced");
+	return synced;
+}
+
+/**
+ * @brief Fork children from a rom after running it for some frames and run them on a thread pool, each with its own
+ * input. A child fed the parent's input has to end on the parent's state and a child run again on its own has to end
+ * on the state it reached on the pool.
+ */
+bool forkBench(const std::string &romPath, uint32_t frames, uint32_t children, uint32_t branchFrames, uint32_t threads)
+{
+	constexpr int ITERATIONS = 1000;
+
+	BudgetGBCore             parent(BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality::Medium);
+	std::vector<std::string> recentRoms;
+
+	if (!parent.loadCartridge(romPath, recentRoms, false))
+		return false;
+
+	parent.reset(false);
+	parent.m_apu.setOutputEnabled(false);
+
+	for (uint32_t i = 0; i < frames; ++i)
+		parent.runFrame();
+
+	Utils::StateWriter writer;
+	parent.saveState(writer);
+	const std::vector<uint8_t> snapshot = writer.getBuffer();
+
+	// forking into a reused core against copying the whole state into it
+	BudgetGBCore reused(BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality::Medium);
+
+	auto startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; ++i)
+		parent.forkInto(reused);
+	std::chrono::duration<double, std::micro> forkIntoTime = std::chrono::steady_clock::now() - startTime;
+
+	startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		parent.saveState(writer);
+		reused.loadState(writer.getBuffer().data(), writer.getSize());
+	}
+	std::chrono::duration<double, std::micro> copyTime = std::chrono::steady_clock::now() - startTime;
+
+	fmt::println("Fork into a reused core: {:.2f}us, full state save and load: {:.2f}us", forkIntoTime.count() / ITERATIONS, copyTime.count() / ITERATIONS);
+
+	bool matchesParent = true;
+	{
+		std::unique_ptr<BudgetGBCore> child = parent.fork();
+
+		for (uint32_t frame = 0; frame < branchFrames; ++frame)
+		{
+			parent.m_cpu.m_joypad.setButtons(getBotInput(0, frame));
+			child->m_cpu.m_joypad.setButtons(getBotInput(0, frame));
+			parent.runFrame();
+			child->runFrame();
+		}
+
+		matchesParent = parent.hashState() == child->hashState();
+		fmt::println("Child with the parent's input: {}", matchesParent ? "identical" : "diverged");
+	}
+
+	parent.m_cpu.m_joypad.setButtons(0);
+	if (!parent.loadState(snapshot.data(), snapshot.size()))
+		return false;
+
+	std::vector<std::unique_ptr<BudgetGBCore>> branches(children);
+
+	startTime = std::chrono::steady_clock::now();
+	for (auto &branch : branches)
+		branch = parent.fork();
+	std::chrono::duration<double, std::micro> forkTime = std::chrono::steady_clock::now() - startTime;
+
+	auto runBranch = [branchFrames](BudgetGBCore &core, uint32_t branch) {
+		for (uint32_t frame = 0; frame < branchFrames; ++frame)
+		{
+			core.m_cpu.m_joypad.setButtons(getBotInput(branch + 1, frame));
+			core.runFrame();
+		}
+	};
+
+	std::vector<uint64_t> hashes(children);
+	Utils::ThreadPool     pool(threads);
+
+	startTime = std::chrono::steady_clock::now();
+	for (uint32_t branch = 0; branch < children; ++branch)
+	{
+		pool.submit([&, branch]() {
+			runBranch(*branches[branch], branch);
+			hashes[branch] = branches[branch]->hashState();
+		});
+	}
+	pool.wait();
+	std::chrono::duration<double> runTime = std::chrono::steady_clock::now() - startTime;
+
+	const double totalFrames = static_cast<double>(children) * branchFrames;
+	fmt::println("Forked {} children: {:.2f}us each", children, children ? forkTime.count() / children : 0.0);
+	fmt::println("Ran {} frames each on {} threads: {:.3f}s, {:.0f} frames per second total", branchFrames, pool.getThreadCount(), runTime.count(), totalFrames / runTime.count());
+
+	StateIndex index(children);
+	for (uint64_t hash : hashes)
+		index.insert(hash);
+
+	fmt::println("Distinct end states: {}", index.size());
+
+	// the last branch again on this thread alone, sharing pages with other children must not have leaked writes
+	bool matchesRerun = true;
+	if (children != 0)
+	{
+		std::unique_ptr<BudgetGBCore> rerun = parent.fork();
+		runBranch(*rerun, children - 1);
+
+		matchesRerun = rerun->hashState() == hashes[children - 1];
+		fmt::println("Rerun of a child alone: {}", matchesRerun ? "identical" : "diverged");
+	}
+
+	return matchesParent && matchesRerun;
+}
+
+/**
+ * @brief Run a rom twice side by side from power on with the same input and compare the full state and ram hashes
+ * after every frame. The first frame that differs is reported with the components whose state differs, along with
+ * what each hash costs next to a frame.
+ */
+bool determinismCheck(const std::string &romPath, uint32_t frames)
+{
+	constexpr std::array<const char *, 5> COMPONENTS = {"cpu", "bus", "ppu", "apu", "cartridge"};
+
+	BudgetGBCore                  first(BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality::Medium);
+	BudgetGBCore                  second(BudgetGbConstants::AUDIO_SAMPLE_RATE, ResamplerQuality::Medium);
+	std::array<BudgetGBCore *, 2> cores = {&first, &second};
+	std::vector<std::string>      recentRoms;
+
+	for (BudgetGBCore *core : cores)
+	{
+		if (!core->loadCartridge(romPath, recentRoms, false))
+			return false;
+
+		core->reset(false);
+		core->m_apu.setOutputEnabled(false);
+	}
+
+	auto saveComponent = [](BudgetGBCore &core, std::size_t component, Utils::StateWriter &writer) {
+		writer.begin();
+
+		switch (component)
+		{
+		case 0:
+			core.m_cpu.saveState(writer);
+			break;
+		case 1:
+			core.m_bus.saveState(writer);
+			break;
+		case 2:
+			core.m_ppu.saveState(writer);
+			break;
+		case 3:
+			core.m_apu.saveState(writer);
+			break;
+		default:
+			core.m_cartridge.saveState(writer);
+			break;
+		}
+	};
+
+	std::chrono::duration<double, std::micro> frameTime{}, stateHashTime{}, ramHashTime{};
+
+	for (uint32_t frame = 0; frame < frames; ++frame)
+	{
+		for (BudgetGBCore *core : cores)
+			core->m_cpu.m_joypad.setButtons(getBotInput(0, frame));
+
+		// only the first core is timed, the second one runs and hashes the same way
+		auto frameStart = std::chrono::steady_clock::now();
+		first.runFrame();
+		frameTime += std::chrono::steady_clock::now() - frameStart;
+		second.runFrame();
+
+		auto           hashStart = std::chrono::steady_clock::now();
+		const uint64_t stateHash = first.hashState();
+		auto           hashEnd   = std::chrono::steady_clock::now();
+		const uint64_t ramHash   = first.hashRam();
+		auto           ramEnd    = std::chrono::steady_clock::now();
+
+		stateHashTime += hashEnd - hashStart;
+		ramHashTime += ramEnd - hashEnd;
+
+		if (stateHash != second.hashState() || ramHash != second.hashRam())
+		{
+			fmt::println("Diverged after frame {}, ram hashes {}", frame, ramHash == second.hashRam() ? "match" : "differ");
+
+			Utils::StateWriter firstWriter, secondWriter;
+			for (std::size_t component = 0; component < COMPONENTS.size(); ++component)
+			{
+				saveComponent(first, component, firstWriter);
+				saveComponent(second, component, secondWriter);
+
+				if (firstWriter.getBuffer() != secondWriter.getBuffer())
+					fmt::println("  {} state differs", COMPONENTS[component]);
+			}
+
+			return false;
+		}
+	}
+
+	const double frameUs = frames ? frameTime.count() / frames : 0.0;
+	const double stateUs = frames ? stateHashTime.count() / frames : 0.0;
+	const double ramUs   = frames ? ramHashTime.count() / frames : 0.0;
+
+	fmt::println("Deterministic over {} frames, final state hash {:016x}", frames, first.hashState());
+	fmt::println("Frame: {:.1f}us, state hash: {:.2f}us ({:.2f}%), ram hash: {:.2f}us ({:.2f}%)",
+	             frameUs,
+	             stateUs,
+	             frameUs > 0.0 ? stateUs * 100.0 / frameUs : 0.0,
+	             ramUs,
+	             frameUs > 0.0 ? ramUs * 100.0 / frameUs : 0.0);
+
+	return true;
+}
+
+bool shmBench(const std::string &romPath, uint32_t frames)
+{
+	using SharedMemoryLayout::CommandType;
+
+	BudgetGBCore core;
+	if (!core.loadRom(romPath))
+		return false;
+
+	const std::string           name         = fmt::format("budgetgb-shm-bench-{}", std::random_device{}());
+	const std::vector<uint16_t> ramAddresses = {0xFF40, 0xFF42, 0xFF43, 0xFF47, 0xC000, 0xC001};
+
+	SharedMemoryPublisher publisher;
+	if (!publisher.create(name, ramAddresses))
+		return false;
+
+	// hash of every published frame, indexed by its frame count. Written before the frame is published so the seqlock
+	// also orders it for the consumer. Pausing and resuming publish the frame again
+	std::vector<uint64_t> publishedHashes(frames + 16, 0);
+	std::atomic<bool>     done = false;
+
+	struct ConsumerStats
+	{
+		uint64_t FramesSeen   = 0;
+		uint64_t Polls        = 0; // consistent reads, whether or not the frame was new
+		uint64_t Reads        = 0; // calls of the read function, the ones over Polls were torn and retried
+		uint64_t Mismatches   = 0;
+		uint64_t AudioSamples = 0;
+		uint32_t CommandsSent = 0;
+		bool     SawPause     = false;
+		bool     Opened       = false;
+	} consumerStats;
+
+	std::thread consumer([&]() {
+		SharedMemoryClient client;
+		if (!client.open(name))
+			return;
+
+		consumerStats.Opened = true;
+
+		uint64_t                lastFrame  = 0;
+		uint64_t                audioIndex = 0;
+		std::array<float, 4096> audio;
+		bool                    paused = false;
+
+		while (!done.load(std::memory_order_acquire))
+		{
+			uint64_t frameCount = 0, frameHash = 0;
+			uint32_t framePaused = 0;
+
+			// the frame is hashed where it lies in the segment, nothing is copied out
+			bool consistent = client.readFrame([&](const SharedMemoryLayout::Segment &segment) {
+				++consumerStats.Reads;
+				frameCount  = segment.FrameCount;
+				framePaused = segment.Paused;
+				frameHash   = frameCount != lastFrame ? Utils::hash64(segment.Framebuffer.data(), segment.Framebuffer.size()) : 0;
+			});
+
+			consumerStats.AudioSamples += client.readAudio(audio.data(), static_cast<uint32_t>(audio.size()), audioIndex);
+
+			consumerStats.Polls += consistent;
+
+			if (!consistent || frameCount == lastFrame)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			lastFrame = frameCount;
+			++consumerStats.FramesSeen;
+
+			if (frameCount >= publishedHashes.size() || publishedHashes[frameCount] != frameHash)
+				++consumerStats.Mismatches;
+
+			auto send = [&](CommandType type, uint32_t argument = 0) { consumerStats.CommandsSent += client.pushCommand(type, argument); };
+
+			// drive the game, pause once and resume as soon as the pause is seen, then save and load a state
+			send(CommandType::SetInput, getBotInput(0, static_cast<uint32_t>(frameCount)));
+
+			if (framePaused)
+			{
+				consumerStats.SawPause = true;
+				send(CommandType::Resume);
+			}
+			else if (frameCount == frames / 4 && !paused)
+			{
+				paused = true;
+				send(CommandType::Pause);
+			}
+			else if (frameCount == frames / 2)
+				send(CommandType::SaveState);
+			else if (frameCount == frames * 3 / 4)
+				send(CommandType::LoadState);
+		}
+	});
+
+	Utils::StateWriter                        savedState;
+	uint64_t                                  savedHash = 0, frameCount = 0;
+	uint32_t                                  emulated = 0, commandsApplied = 0, pauses = 0, stateMismatches = 0;
+	bool                                      paused = false;
+	std::array<float, 2048>                   audio;
+	std::chrono::duration<double, std::micro> publishTime{};
+
+	auto publish = [&]() {
+		publishedHashes[++frameCount] = Utils::hash64(core.getFramebuffer().data(), core.getFramebuffer().size());
+
+		auto start = std::chrono::steady_clock::now();
+		publisher.publishFrame(core, paused);
+		publishTime += std::chrono::steady_clock::now() - start;
+	};
+
+	auto benchStart = std::chrono::steady_clock::now();
+
+	while (emulated < frames || paused)
+	{
+		SharedMemoryLayout::Command command;
+		while (publisher.popCommand(command))
+		{
+			++commandsApplied;
+
+			if (command.Type == CommandType::SetInput)
+				core.setInput(static_cast<uint8_t>(command.Argument));
+			else if (command.Type == CommandType::Pause || command.Type == CommandType::Resume)
+			{
+				paused = command.Type == CommandType::Pause;
+				pauses += paused;
+				publish();
+			}
+			else if (command.Type == CommandType::SaveState)
+			{
+				core.saveState(savedState);
+				savedHash = core.hashState();
+			}
+			else if (command.Type == CommandType::LoadState)
+			{
+				const std::vector<uint8_t> &state = savedState.getBuffer();
+				if (!core.loadState(state.data(), state.size()) || core.hashState() != savedHash)
+					++stateMismatches;
+			}
+		}
+
+		// a consumer that never resumes can not hang the bench
+		if (paused)
+		{
+			if (std::chrono::steady_clock::now() - benchStart > std::chrono::seconds(10))
+				break;
+
+			std::this_thread::yield();
+			continue;
+		}
+
+		if (frameCount + 1 >= publishedHashes.size())
+			break;
+
+		core.runFrame();
+		++emulated;
+
+		publisher.publishAudio(audio.data(), core.readAudio(audio.data(), static_cast<uint32_t>(audio.size())));
+		publish();
+
+		// give a consumer sharing the core time to keep up, as the real frontend's frame pacing would
+		std::this_thread::yield();
+	}
+
+	std::chrono::duration<double> benchTime = std::chrono::steady_clock::now() - benchStart;
+
+	// the consumer checks the last frame before it sees done
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	done.store(true, std::memory_order_release);
+	consumer.join();
+
+	if (!consumerStats.Opened)
+		return false;
+
+	fmt::println("Emulated {} frames in {:.2f}s, published {} times at {:.2f}us per publish",
+	             emulated,
+	             benchTime.count(),
+	             frameCount,
+	             frameCount ? publishTime.count() / frameCount : 0.0);
+	fmt::println("Consumer saw {} frames, {} torn reads retried, {} framebuffer mismatches, {} audio samples",
+	             consumerStats.FramesSeen,
+	             consumerStats.Reads - consumerStats.Polls,
+	             consumerStats.Mismatches,
+	             consumerStats.AudioSamples);
+	fmt::println("{} commands sent, {} applied, {} pauses, pause seen: {}, state load mismatches: {}",
+	             consumerStats.CommandsSent,
+	             commandsApplied,
+	             pauses,
+	             consumerStats.SawPause ? "yes" : "no",
+	             stateMismatches);
+
+	return consumerStats.Mismatches == 0 && stateMismatches == 0;
+}
+
+struct PacingStats
+{
+	uint64_t Frames   = 0;
+	double   MaxGapMs = 0.0; // longest wall clock time between two emulated frames
+	double   JitterMs = 0.0; // mean distance of the gaps from the time step
+
+	void addGap(double gapMs, double stepMs)
+	{
+		MaxGapMs = std::max(MaxGapMs, gapMs);
+		JitterMs += (std::abs(gapMs - stepMs) - JitterMs) / static_cast<double>(++Frames);
+	}
+};
+
+bool pacingBench(const std::string &romPath, double seconds, uint32_t stallMs, uint32_t lockedStallMs)
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr double   STEP_MS         = 1000.0 / 60.0;
+	constexpr uint32_t STALL_EVERY     = 10; // host frames, the others take a normal 16ms
+	const auto         stepPeriod      = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(STEP_MS));
+	const auto         hostFramePeriod = std::chrono::milliseconds(16);
+	const auto         stallPeriod     = std::chrono::milliseconds(stallMs);
+	const auto         lockedStall     = std::chrono::milliseconds(std::min(lockedStallMs, stallMs)); // part of a stall spent holding the emulation lock
+	const auto         benchDuration   = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+	auto hostFrameTime = [&](uint32_t hostFrame) { return hostFrame % STALL_EVERY == STALL_EVERY - 1 ? stallPeriod : hostFramePeriod; };
+
+	// the old single threaded loop: a slow host frame holds up emulation, which then catches up in a burst
+	PacingStats singleThreaded;
+	{
+		BudgetGBCore core;
+		if (!core.loadRom(romPath))
+			return false;
+
+		core.m_apu.setOutputEnabled(false);
+
+		const Clock::time_point start = Clock::now();
+		Clock::time_point       last          = start, lastFrame = start;
+		double                  accumulatedMs = 0.0;
+
+		for (uint32_t hostFrame = 0; Clock::now() - start < benchDuration; ++hostFrame)
+		{
+			const Clock::time_point now = Clock::now();
+			accumulatedMs += std::chrono::duration<double, std::milli>(now - last).count();
+			last = now;
+
+			for (; accumulatedMs > STEP_MS; accumulatedMs -= STEP_MS)
+			{
+				core.runFrame();
+
+				const Clock::time_point frameTime = Clock::now();
+				singleThreaded.addGap(std::chrono::duration<double, std::milli>(frameTime - lastFrame).count(), STEP_MS);
+				lastFrame = frameTime;
+			}
+
+			std::this_thread::sleep_for(hostFrameTime(hostFrame));
+		}
+	}
+
+	struct Frame
+	{
+		uint64_t                          Number = 0;
+		uint64_t                          Hash   = 0;
+		BudgetGbConstants::LcdColorBuffer Pixels{};
+	};
+
+	BudgetGBCore core;
+	if (!core.loadRom(romPath))
+		return false;
+
+	core.m_apu.setOutputEnabled(false);
+
+	EmulationThread            emulation;
+	Utils::TripleBuffer<Frame> frames;
+	PacingStats                threaded;
+	uint64_t                   frameNumber = 0;
+	Clock::time_point          lastFrame   = Clock::now();
+
+	emulation.start(stepPeriod, [&](float) {
+		core.runFrame();
+
+		const Clock::time_point frameTime = Clock::now();
+		threaded.addGap(std::chrono::duration<double, std::milli>(frameTime - lastFrame).count(), STEP_MS);
+		lastFrame = frameTime;
+
+		Frame &frame = frames.getWriteBuffer();
+		frame.Number = ++frameNumber;
+		frame.Pixels = core.getFramebuffer();
+		frame.Hash   = Utils::hash64(frame.Pixels.data(), frame.Pixels.size());
+		frames.publish();
+	});
+
+	uint64_t presented = 0, lastPresented = 0, tornFrames = 0, inconsistentSnapshots = 0, commandsRun = 0;
+
+	std::array<uint8_t, PPU::VRAM_SIZE> vramCopy{};
+
+	const Clock::time_point start = Clock::now();
+	for (uint32_t hostFrame = 0; Clock::now() - start < benchDuration; ++hostFrame)
+	{
+		const bool stalled = hostFrameTime(hostFrame) == stallPeriod;
+
+		{
+			// the locked gui pass: widgets that act on the core and copying what the slow views read, which stays put
+			// until the lock is let go
+			auto           lock        = emulation.lock();
+			const uint64_t stateHash   = core.hashState();
+			const uint64_t frameBefore = frameNumber;
+
+			vramCopy = core.m_ppu.getVram();
+
+			if (stalled)
+				std::this_thread::sleep_for(lockedStall);
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+			inconsistentSnapshots += core.hashState() != stateHash || frameNumber != frameBefore;
+		}
+
+		emulation.post([&commandsRun]() { ++commandsRun; });
+
+		if (frames.update())
+		{
+			const Frame &frame = frames.getReadBuffer();
+
+			tornFrames += Utils::hash64(frame.Pixels.data(), frame.Pixels.size()) != frame.Hash;
+			tornFrames += frame.Number <= lastPresented;
+			lastPresented = frame.Number;
+			++presented;
+		}
+
+		// building the slow views from the copies, presenting and waiting for vsync, the emulation thread is not held up by
+		// any of it
+		std::this_thread::sleep_for(hostFrameTime(hostFrame) - (stalled ? lockedStall : Clock::duration::zero()));
+	}
+
+	const std::chrono::duration<double> elapsed = Clock::now() - start;
+	emulation.stop();
+
+	const EmulationThread::Stats &stats = emulation.getStats();
+
+	fmt::println("Host frames of 16ms with every {}th taking {}ms, {}ms of it holding the emulation lock, {:.1f}s each",
+	             STALL_EVERY,
+	             stallMs,
+	             lockedStall.count(),
+	             seconds);
+	fmt::println("Single threaded: {} frames, longest gap {:.1f}ms, mean jitter {:.2f}ms", singleThreaded.Frames, singleThreaded.MaxGapMs, singleThreaded.JitterMs);
+	fmt::println("Emulation thread: {} frames ({:.1f} fps), longest gap {:.1f}ms, mean jitter {:.2f}ms, {} late and {} dropped steps",
+	             threaded.Frames,
+	             threaded.Frames / elapsed.count(),
+	             threaded.MaxGapMs,
+	             threaded.JitterMs,
+	             stats.LateSteps,
+	             stats.DroppedSteps);
+	fmt::println("Presented {} frames, {} torn or out of order, {} inconsistent snapshots, {} commands run",
+	             presented,
+	             tornFrames,
+	             inconsistentSnapshots,
+	             commandsRun);
+
+	return tornFrames == 0 && inconsistentSnapshots == 0;
+}
+
+/**
+ * @brief Run a rom on two instances joined by a link cable, each on its own thread, and time them against a single
+ * instance. Every frame the first side starts a transfer on its internal clock and the second waits on the external
+ * clock, both bytes have to arrive on the other side by the end of the frame.
+ */
+bool linkBench(const std::string &romPath, uint32_t frames, bool udp)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::array<BudgetGBCore, 2> cores;
+	for (BudgetGBCore &core : cores)
+	{
+		if (!core.loadRom(romPath))
+			return false;
+
+		core.m_apu.setOutputEnabled(false);
+	}
+
+	// the unlinked baseline, run and then reset so both sides start linked from power on
+	const Clock::time_point singleStart = Clock::now();
+	for (uint32_t frame = 0; frame < frames; ++frame)
+		cores[0].runFrame();
+
+	const std::chrono::duration<double> singleElapsed = Clock::now() - singleStart;
+	cores[0].reset(false);
+	cores[1].reset(false);
+
+	std::array<std::unique_ptr<SerialLink>, 2> links;
+	if (udp)
+	{
+		auto first  = std::make_unique<UdpSerialLink>();
+		auto second = std::make_unique<UdpSerialLink>();
+
+		if (!first->connect(0, "127.0.0.1", 0) || !second->connect(0, "127.0.0.1", first->getLocalPort()) ||
+		    !first->setPeer("127.0.0.1", second->getLocalPort()))
+			return false;
+
+		links = {std::move(first), std::move(second)};
+	}
+	else
+	{
+		auto [first, second] = LocalSerialLink::createPair();
+		links                = {std::move(first), std::move(second)};
+	}
+
+	std::array<uint32_t, 2> failedTransfers{};
+
+	auto runSide = [&](uint32_t side) {
+		BudgetGBCore &core = cores[side];
+		core.m_cpu.m_serial.setLink(links[side].get());
+
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			const uint8_t sent     = static_cast<uint8_t>(side == 0 ? frame : ~frame);
+			const uint8_t expected = static_cast<uint8_t>(side == 0 ? ~frame : frame);
+
+			core.m_cpu.m_serial.writeData(sent);
+			core.m_cpu.m_serial.writeControl(side == 0 ? Serial::SC_TRANSFER_ENABLE | Serial::SC_INTERNAL_CLOCK : Serial::SC_TRANSFER_ENABLE);
+			core.runFrame();
+
+			failedTransfers[side] += core.m_cpu.m_serial.readData() != expected || (core.m_cpu.m_serial.readControl() & Serial::SC_TRANSFER_ENABLE);
+		}
+
+		core.m_cpu.m_serial.setLink(nullptr);
+	};
+
+	const Clock::time_point linkedStart = Clock::now();
+
+	std::thread second(runSide, 1);
+	runSide(0);
+	second.join();
+
+	const std::chrono::duration<double> linkedElapsed = Clock::now() - linkedStart;
+
+	fmt::println("{} frames over a {} link, quantum {} t-cycles, {} hardware threads", frames, udp ? "udp" : "local", links[0]->getQuantum(), std::thread::hardware_concurrency());
+	fmt::println("Single instance: {:.1f}ms, linked pair: {:.1f}ms ({:.2f}x)",
+	             singleElapsed.count() * 1000.0,
+	             linkedElapsed.count() * 1000.0,
+	             singleElapsed.count() > 0.0 ? linkedElapsed.count() / singleElapsed.count() : 0.0);
+
+	for (uint32_t side = 0; side < 2; ++side)
+	{
+		const SerialLink::Stats &stats = links[side]->getStats();
+		fmt::println("Side {}: {} exchanges, {} waited, {} timeouts, {} resyncs, {} failed transfers",
+		             side,
+		             stats.Exchanges,
+		             stats.Waits,
+		             stats.Timeouts,
+		             stats.Resyncs,
+		             failedTransfers[side]);
+	}
+
+	return failedTransfers[0] == 0 && failedTransfers[1] == 0;
+}
+
+/**
+ * @brief Most run instruction over the next 20000, which is in a loop so a breakpoint on it is hit again right away.
+ */
+uint16_t findLoopAddress(BudgetGBCore &core)
+{
+	std::vector<uint32_t> pcCounts(0x10000, 0);
+	for (uint32_t i = 0; i < 20000; ++i)
+	{
+		++pcCounts[core.m_cpu.m_programCounter];
+		core.m_cpu.instructionStep();
+	}
+
+	return static_cast<uint16_t>(std::max_element(pcCounts.begin(), pcCounts.end()) - pcCounts.begin());
+}
+
+/**
+ * @brief A wram or hram byte that changes from frame to frame, for watchpoints.
+ * @return -1 if none changed within 10 frames.
+ */
+int32_t findChangingRamByte(BudgetGBCore &core)
+{
+	std::vector<uint16_t> ramAddresses;
+	for (uint32_t address = 0xC000; address < 0xE000; ++address)
+		ramAddresses.push_back(static_cast<uint16_t>(address));
+	for (uint32_t address = 0xFF80; address < 0xFFFF; ++address)
+		ramAddresses.push_back(static_cast<uint16_t>(address));
+
+	int32_t watchAddress = -1;
+	for (uint32_t frame = 0; frame < 10 && watchAddress < 0; ++frame)
+	{
+		std::vector<uint8_t> before;
+		for (uint16_t address : ramAddresses)
+			before.push_back(core.m_bus.busReadRaw(address));
+
+		core.runFrame();
+
+		for (std::size_t i = 0; i < ramAddresses.size() && watchAddress < 0; ++i)
+			if (core.m_bus.busReadRaw(ramAddresses[i]) != before[i])
+				watchAddress = ramAddresses[i];
+	}
+
+	return watchAddress;
+}
+
+/**
+ * @brief Remote protocol client for gdbCheck(), sends one packet and waits for its reply.
+ */
+class GdbTestClient
+{
+  public:
+	bool connect(uint16_t port)
+	{
+		return m_socket.connect("127.0.0.1", port);
+	}
+
+	void sendRaw(std::string_view bytes)
+	{
+		m_socket.send(bytes.data(), bytes.size());
+	}
+
+	void send(std::string_view payload)
+	{
+		uint8_t sum = 0;
+		for (char c : payload)
+			sum = static_cast<uint8_t>(sum + static_cast<uint8_t>(c));
+
+		sendRaw(fmt::format("${}#{:02x}", payload, sum));
+	}
+
+	// the payload of the next packet from the server, empty if none arrives within a few seconds
+	std::string receive()
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+		while (std::chrono::steady_clock::now() < deadline && m_socket.isOpen())
+		{
+			const std::size_t start = m_input.find('$');
+			const std::size_t hash  = m_input.find('#', start == std::string::npos ? 0 : start);
+
+			if (start != std::string::npos && hash != std::string::npos && hash + 2 < m_input.size())
+			{
+				std::string payload = m_input.substr(start + 1, hash - start - 1);
+				m_input.erase(0, hash + 3);
+				return payload;
+			}
+
+			char buffer[512];
+			if (m_socket.waitReadable(100))
+				m_input.append(buffer, m_socket.receive(buffer, sizeof(buffer)));
+		}
+
+		return {};
+	}
+
+	std::string request(std::string_view payload)
+	{
+		send(payload);
+		return receive();
+	}
+
+  private:
+	Utils::TcpSocket m_socket;
+	std::string      m_input;
+};
+
+/**
+ * @brief Drive the gdb stub with a client on another thread: registers, memory, stepping, a breakpoint, write and
+ * read watchpoints and an interrupt, then detach and time frames with the server listening against a core without one.
+ */
+bool gdbCheck(const std::string &romPath, uint32_t frames)
+{
+	BudgetGBCore core;
+	if (!core.loadRom(romPath))
+		return false;
+
+	core.m_apu.setOutputEnabled(false);
+
+	for (uint32_t frame = 0; frame < 60; ++frame)
+		core.runFrame();
+
+	const uint16_t loopAddress  = findLoopAddress(core);
+	const int32_t  watchAddress = findChangingRamByte(core);
+
+	Debugger debugger(core);
+	GdbServer server(core, debugger);
+	if (!server.listen(0))
+		return false;
+
+	std::vector<std::string> failures;
+	std::atomic<bool>        clientDone = false;
+
+	std::thread clientThread([&]() {
+		GdbTestClient client;
+
+		auto expect = [&](bool ok, std::string_view what, const std::string &reply) {
+			if (!ok)
+				failures.push_back(fmt::format("{}: got \"{}\"", what, reply));
+		};
+
+		if (!client.connect(server.getLocalPort()))
+		{
+			failures.push_back("connect");
+			clientDone = true;
+			return;
+		}
+
+		std::string reply = client.request("?");
+		expect(reply == "S05", "stopped on attach", reply);
+
+		reply = client.request("qSupported:swbreak+");
+		expect(reply.find("PacketSize=") != std::string::npos, "qSupported", reply);
+
+		auto readPc = [&]() {
+			const std::string registers = client.request("g");
+			expect(registers.size() == 24, "register count", registers);
+			return registers.size() == 24 ? static_cast<uint16_t>(std::strtoul(registers.substr(22, 2).append(registers.substr(20, 2)).c_str(), nullptr, 16)) : 0;
+		};
+
+		const uint16_t pc = readPc();
+
+		reply = client.request(fmt::format("m{:x},3", pc));
+		expect(reply.size() == 6, "memory read", reply);
+
+		reply = client.request("s");
+		expect(reply == "T05", "single step", reply);
+
+		reply = client.request(fmt::format("Z0,{:x},1", loopAddress));
+		expect(reply == "OK", "set breakpoint", reply);
+
+		reply = client.request("c");
+		expect(reply.find("swbreak") != std::string::npos, "breakpoint stop", reply);
+		expect(readPc() == loopAddress, "breakpoint address", reply);
+
+		reply = client.request(fmt::format("z0,{:x},1", loopAddress));
+		expect(reply == "OK", "remove breakpoint", reply);
+
+		if (watchAddress >= 0)
+		{
+			reply = client.request(fmt::format("Z2,{:x},1", watchAddress));
+			expect(reply == "OK", "set watchpoint", reply);
+
+			reply = client.request("c");
+			expect(reply == fmt::format("T05watch:{:x};", watchAddress), "watchpoint stop", reply);
+
+			reply = client.request(fmt::format("z2,{:x},1", watchAddress));
+			expect(reply == "OK", "remove watchpoint", reply);
+		}
+
+		// instruction fetches are reads, a read watchpoint on the loop stops right away
+		reply = client.request(fmt::format("Z3,{:x},1", loopAddress));
+		expect(reply == "OK", "set read watchpoint", reply);
+
+		reply = client.request("c");
+		expect(reply == fmt::format("T05rwatch:{:x};", loopAddress), "read watchpoint stop", reply);
+
+		reply = client.request(fmt::format("z3,{:x},1", loopAddress));
+		expect(reply == "OK", "remove read watchpoint", reply);
+
+		// write hram and put it back
+		const std::string original = client.request("mff80,2");
+		reply                      = client.request("Mff80,2:a55a");
+		expect(reply == "OK", "memory write", reply);
+		reply = client.request("mff80,2");
+		expect(reply == "a55a", "memory read back", reply);
+		client.request(fmt::format("Mff80,2:{}", original));
+
+		client.send("c");
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		client.sendRaw("\x03");
+		reply = client.receive();
+		expect(reply == "T02", "interrupt", reply);
+
+		reply = client.request("D");
+		expect(reply == "OK", "detach", reply);
+
+		clientDone = true;
+	});
+
+	while (!clientDone)
+	{
+		server.poll();
+		core.runFrame();
+	}
+
+	clientThread.join();
+	server.poll();
+
+	const bool unhooked = !server.isAttached() && !debugger.isHooked();
+
+	// detached, the frame loop is the plain one whether or not a server is listening
+	BudgetGBCore plain;
+	if (!plain.loadRom(romPath))
+		return false;
+
+	plain.m_apu.setOutputEnabled(false);
+
+	auto timeFrames = [frames](BudgetGBCore &target, GdbServer *listening) {
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+		{
+			if (listening)
+				listening->poll();
+
+			target.runFrame();
+		}
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	const double plainMs     = timeFrames(plain, nullptr);
+	const double listeningMs = timeFrames(core, &server);
+
+	const GdbServer::Stats &stats = server.getStats();
+	fmt::println("Breakpoint at {:04x}, watchpoint at {}", loopAddress, watchAddress >= 0 ? fmt::format("{:04x}", watchAddress) : "none");
+	fmt::println("{} packets, {} breakpoint and {} watchpoint hits, {}", stats.Packets, stats.BreakpointHits, stats.WatchpointHits, unhooked ? "unhooked on detach" : "still hooked after detach");
+	fmt::println("{} frames without a server: {:.1f}ms, detached with a server listening: {:.1f}ms", frames, plainMs, listeningMs);
+
+	for (const std::string &failure : failures)
+		fmt::println("Failed {}", failure);
+
+	return failures.empty() && unhooked;
+}
+
+/**
+ * @brief Run a rom paced at 60 frames per second, serving debuggers on a localhost port until one sends a kill.
+ */
+bool gdbServe(const std::string &romPath, uint16_t port)
+{
+	BudgetGBCore core;
+	if (!core.loadRom(romPath))
+		return false;
+
+	core.m_apu.setOutputEnabled(false);
+
+	Debugger  debugger(core);
+	GdbServer server(core, debugger);
+	if (!server.listen(port))
+		return false;
+
+	fmt::println("Waiting for a debugger on 127.0.0.1:{}", server.getLocalPort());
+
+	const auto framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / 60.0));
+	auto       deadline    = std::chrono::steady_clock::now();
+
+	while (!server.isKillRequested())
+	{
+		server.poll();
+
+		// a stopped core already spent a few milliseconds serving the debugger
+		if (core.runFrame())
+		{
+			deadline += framePeriod;
+			std::this_thread::sleep_until(deadline);
+		}
+		else
+			deadline = std::chrono::steady_clock::now();
+	}
+
+	return true;
+}
+
+/**
+ * @brief Check condition compilation against known registers, then execution breakpoints, conditional breakpoints and
+ * read and write watchpoints on a running rom, and time frames with a trap on a page the game leaves alone against a
+ * core without a debugger. Both must end in the same state.
+ */
+bool debuggerCheck(const std::string &romPath, uint32_t frames)
+{
+	std::vector<std::string> failures;
+
+	auto expect = [&failures](bool ok, const std::string &what) {
+		if (!ok)
+			failures.push_back(what);
+	};
+
+	// conditions, evaluated against registers and memory set here
+	{
+		BudgetGBCore scratch;
+		if (!scratch.loadRom(romPath))
+			return false;
+
+		scratch.m_cpu.m_registerBC.set_u16(0x1234);
+		scratch.m_cpu.m_registerAF.accumulator = 0x80;
+		scratch.m_bus.busWriteRaw(0xFF80, 0x5A);
+
+		const std::pair<std::string_view, bool> conditions[] = {
+			{"", true},
+			{"b == 0x12 && c == $34", true},
+			{"bc >> 8 == 18", true},
+			{"2 + 3 * 4 == 14 && (2 + 3) * 4 == 20", true},
+			{"10 - 4 - 3 == 3", true},
+			{"-1 == 0xFFFFFFFF", true},
+			{"!(1 < 2) || ~0 == 0", false},
+			{"a & 0x80 && [0xff80] == 0x5a", true},
+			{"[0xff00 | 0x80] == value", true},
+			{"address == 0xc000 && value != 0", true},
+			{"7 / 0 == 0 && 7 % 0 == 0", true},
+			{"1 << 40 == 0", true},
+		};
+
+		for (const auto &[source, holds] : conditions)
+		{
+			DebugCondition condition;
+			std::string    error;
+
+			if (!condition.compile(source, error))
+				failures.push_back(fmt::format("compile \"{}\": {}", source, error));
+			else
+				expect(condition.evaluate(scratch, 0xC000, 0x5A) == holds, fmt::format("evaluate \"{}\"", source));
+		}
+
+		for (std::string_view source : {"1 +", "(1", "[2", "foo == 1", "1 $", "0x", "4294967296", "((((((((((((((((1))))))))))))))) + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + 1))))))))))))))))"})
+		{
+			DebugCondition condition;
+			std::string    error;
+			expect(!condition.compile(source, error) && !error.empty() && condition.isEmpty(), fmt::format("compile error for \"{}\"", source));
+		}
+	}
+
+	BudgetGBCore core;
+	if (!core.loadRom(romPath))
+		return false;
+
+	core.m_apu.setOutputEnabled(false);
+
+	for (uint32_t frame = 0; frame < 60; ++frame)
+		core.runFrame();
+
+	const uint16_t loopAddress  = findLoopAddress(core);
+	const int32_t  watchAddress = findChangingRamByte(core);
+
+	Debugger    debugger(core);
+	std::string error;
+
+	// run until the debugger stops the core, up to a few frames
+	auto runUntilStop = [&]() {
+		for (uint32_t frame = 0; frame < 10 && !debugger.isStopped(); ++frame)
+			core.runFrame();
+
+		return debugger.isStopped();
+	};
+
+	expect(!debugger.isHooked(), "unhooked with nothing set");
+
+	// execution breakpoint, hit again after resuming from it
+	debugger.addBreakpoint(loopAddress, "", error);
+	expect(debugger.isHooked(), "hooked with a breakpoint");
+
+	for (uint32_t hit = 1; hit <= 2; ++hit)
+	{
+		const bool stopped = runUntilStop();
+		expect(stopped && debugger.getStop().Reason == Debugger::StopReason::Breakpoint && core.m_cpu.m_programCounter == loopAddress,
+		       fmt::format("breakpoint hit {}", hit));
+		expect(debugger.getBreakpoints()[0].Hits == hit, fmt::format("breakpoint hit count {}", hit));
+		debugger.resume();
+	}
+
+	debugger.step();
+	expect(runUntilStop() && debugger.getStop().Reason == Debugger::StopReason::Step, "single step");
+	debugger.resume();
+
+	// conditional breakpoints, one that never holds and one on the loop counter of the first
+	debugger.clear();
+	debugger.addBreakpoint(loopAddress, "pc != pc", error);
+
+	for (uint32_t frame = 0; frame < 10; ++frame)
+		core.runFrame();
+
+	expect(!debugger.isStopped() && debugger.getBreakpoints()[0].Hits == 0, "false condition never stops");
+
+	debugger.clear();
+	const bool conditionCompiled = debugger.addBreakpoint(loopAddress, fmt::format("pc == {:#x} && sp == {}", loopAddress, core.m_cpu.m_stackPointer), error);
+	expect(conditionCompiled, fmt::format("conditional breakpoint: {}", error));
+	expect(runUntilStop() && core.m_cpu.m_programCounter == loopAddress, "true condition stops");
+	debugger.resume();
+
+	expect(!debugger.addBreakpoint(loopAddress, "pc ==", error) && !error.empty(), "bad condition rejected");
+
+	// write watchpoint on a byte the game changes every frame, and one whose condition never holds
+	debugger.clear();
+
+	if (watchAddress >= 0)
+	{
+		const uint16_t address = static_cast<uint16_t>(watchAddress);
+
+		debugger.addWatchpoint(address, address, Debugger::WATCH_WRITE, "value != value", error);
+		for (uint32_t frame = 0; frame < 10; ++frame)
+			core.runFrame();
+
+		expect(!debugger.isStopped(), "false watch condition never stops");
+
+		debugger.clear();
+		debugger.addWatchpoint(address, address, Debugger::WATCH_WRITE, fmt::format("address == {:#x}", address), error);
+
+		const bool            stopped = runUntilStop();
+		const Debugger::Stop &stop    = debugger.getStop();
+		expect(stopped && stop.Reason == Debugger::StopReason::Watchpoint && stop.Address == address && stop.Write, "write watchpoint");
+		expect(core.m_bus.busReadRaw(address) == stop.Value, "write watchpoint stops after the write");
+		debugger.resume();
+	}
+	else
+		failures.push_back("no ram byte changed for the write watchpoint");
+
+	// read watchpoint on the loop, instruction fetches are cpu reads too
+	debugger.clear();
+	{
+		debugger.addWatchpoint(loopAddress, loopAddress, Debugger::WATCH_READ, "", error);
+
+		const bool            stopped = runUntilStop();
+		const Debugger::Stop &stop    = debugger.getStop();
+		expect(stopped && stop.Reason == Debugger::StopReason::Watchpoint && !stop.Write && stop.Address == loopAddress, "read watchpoint");
+		debugger.resume();
+	}
+
+	debugger.clear();
+	expect(!debugger.isHooked(), "unhooked after clearing");
+
+	// a trapped page nothing accesses and a breakpoint that never holds, against no debugger at all
+	BudgetGBCore plain;
+	BudgetGBCore trapped;
+	if (!plain.loadRom(romPath) || !trapped.loadRom(romPath))
+		return false;
+
+	plain.m_apu.setOutputEnabled(false);
+	trapped.m_apu.setOutputEnabled(false);
+
+	Debugger trappedDebugger(trapped);
+
+	auto timeFrames = [frames](BudgetGBCore &target) {
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+			target.runFrame();
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	const double plainMs = timeFrames(plain);
+
+	trappedDebugger.addWatchpoint(0xE000, 0xE0FF, Debugger::WATCH_READ | Debugger::WATCH_WRITE, "", error);
+	const double watchMs = timeFrames(trapped);
+
+	trappedDebugger.addBreakpoint(loopAddress, "0", error);
+	const double breakMs = timeFrames(trapped);
+
+	// the plain core catches up on the frames the trapped one ran with the breakpoint
+	timeFrames(plain);
+
+	expect(!trappedDebugger.isStopped() && plain.hashState() == trapped.hashState(), "same state with traps that never hit");
+
+	fmt::println("Breakpoint at {:04x}, write watchpoint at {}", loopAddress, watchAddress >= 0 ? fmt::format("{:04x}", watchAddress) : "none");
+	fmt::println("{} frames without a debugger: {:.1f}ms, watching an untouched page: {:.1f}ms, with a breakpoint too: {:.1f}ms", frames, plainMs, watchMs, breakMs);
+
+	for (const std::string &failure : failures)
+		fmt::println("Failed {}", failure);
+
+	return failures.empty();
+}
+
+/**
+ * @brief Profile frames of a rom with the instruction profiler and with the call profiler, checking both leave
+ * emulation unchanged and account for every cycle, and write the instruction report to outPath and the call graph to
+ * foldedPath.
+ */
+bool profileRun(const std::string &romPath, uint32_t frames, const std::string &outPath, const std::string &foldedPath)
+{
+#ifndef BUDGETGB_PROFILER
+	(void)romPath;
+	(void)frames;
+	(void)outPath;
+	(void)foldedPath;
+	fmt::println(stderr, "Profiling needs a build with BUDGETGB_PROFILER defined, configure with -DENABLE_PROFILER=ON");
+	return false;
+#else
+	BudgetGBCore plain;
+	BudgetGBCore profiled;
+	BudgetGBCore callProfiled;
+	if (!plain.loadRom(romPath) || !profiled.loadRom(romPath) || !callProfiled.loadRom(romPath))
+		return false;
+
+	plain.m_apu.setOutputEnabled(false);
+	profiled.m_apu.setOutputEnabled(false);
+	callProfiled.m_apu.setOutputEnabled(false);
+
+	Profiler profiler;
+	profiler.reset(profiled.m_cartridge.getCartInfo().RomSize / 0x4000);
+	profiled.m_cpu.setProfiler(&profiler);
+
+	CallProfiler   callProfiler;
+	const uint64_t callStartCycles = callProfiled.m_bus.getElapsedCycles() / 4;
+	callProfiler.reset(callStartCycles);
+	callProfiled.m_cpu.setCallProfiler(&callProfiler);
+
+	auto timeFrames = [frames](BudgetGBCore &target) {
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame)
+			target.runFrame();
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	const double plainMs        = timeFrames(plain);
+	const double profiledMs     = timeFrames(profiled);
+	const double callProfiledMs = timeFrames(callProfiled);
+
+	profiled.m_cpu.setProfiler(nullptr);
+	callProfiled.m_cpu.setCallProfiler(nullptr);
+
+	bool ok = true;
+
+	if (plain.hashState() != profiled.hashState() || plain.hashState() != callProfiled.hashState())
+	{
+		fmt::println("Failed profiled core diverged from the plain one");
+		ok = false;
+	}
+
+	const std::vector<Profiler::HotSpot> hotSpots = profiler.getHotSpots(SIZE_MAX);
+
+	uint64_t executions        = 0;
+	uint64_t instructionCycles = 0;
+	for (const Profiler::HotSpot &hotSpot : hotSpots)
+	{
+		executions += hotSpot.Counts.Executions;
+		instructionCycles += hotSpot.Counts.Cycles;
+	}
+
+	if (instructionCycles + profiler.getHaltedCycles() != profiler.getTotalCycles())
+	{
+		fmt::println("Failed cycles of instructions and halts do not add up to the total");
+		ok = false;
+	}
+
+	const double totalCycles = static_cast<double>(std::max<uint64_t>(profiler.getTotalCycles(), 1));
+
+	fmt::println("{} instructions at {} addresses, {} m-cycles, {:.1f}% halted", executions, hotSpots.size(), profiler.getTotalCycles(), profiler.getHaltedCycles() * 100.0 / totalCycles);
+
+	for (std::size_t i = 0; i < std::min<std::size_t>(hotSpots.size(), 10); ++i)
+		fmt::println("  {:02x}:{:04x} {:>10} executions {:>10} m-cycles {:5.1f}%", hotSpots[i].Bank, hotSpots[i].Address, hotSpots[i].Counts.Executions, hotSpots[i].Counts.Cycles, hotSpots[i].Counts.Cycles * 100.0 / totalCycles);
+
+	// every cycle since the reset lands in exactly one node
+	const uint64_t callEndCycles = callProfiled.m_bus.getElapsedCycles() / 4;
+	callProfiler.sync(callEndCycles);
+
+	const std::vector<uint64_t>               inclusive = callProfiler.getInclusiveCycles();
+	const std::vector<CallProfiler::Function> functions = callProfiler.getFunctions();
+
+	if (inclusive[CallProfiler::ROOT] != callEndCycles - callStartCycles)
+	{
+		fmt::println("Failed call graph counted {} m-cycles of {}", inclusive[CallProfiler::ROOT], callEndCycles - callStartCycles);
+		ok = false;
+	}
+
+	const double callGraphCycles = static_cast<double>(std::max<uint64_t>(inclusive[CallProfiler::ROOT], 1));
+
+	fmt::println("{} functions in {} call paths, {} calls past the depth limit, {} unmatched returns", functions.size(), callProfiler.getNodes().size() - 1, callProfiler.getDroppedCalls(), callProfiler.getUnmatchedReturns());
+
+	for (std::size_t i = 0; i < std::min<std::size_t>(functions.size(), 10); ++i)
+		fmt::println("  {:02x}:{:04x} {:>10} calls inclusive {:5.1f}% exclusive {:5.1f}%", functions[i].Bank, functions[i].Address, functions[i].Calls, functions[i].InclusiveCycles * 100.0 / callGraphCycles, functions[i].ExclusiveCycles * 100.0 / callGraphCycles);
+
+	fmt::println("{} frames without a profiler: {:.1f}ms, instruction profiler: {:.1f}ms ({:+.1f}%), call profiler: {:.1f}ms ({:+.1f}%)", frames, plainMs, profiledMs, (profiledMs / plainMs - 1.0) * 100.0, callProfiledMs, (callProfiledMs / plainMs - 1.0) * 100.0);
+
+	if (!outPath.empty())
+	{
+		if (!profiler.writeReport(outPath))
+			return false;
+
+		fmt::println("Wrote {}", outPath);
+	}
+
+	if (!foldedPath.empty())
+	{
+		if (!callProfiler.writeFoldedStacks(foldedPath))
+			return false;
+
+		fmt::println("Wrote {}", foldedPath);
+	}
+
+	return ok;
+#endif
+}
+
+} // namespace
+
+bool Headless::isHeadlessCommand(int argc, char **argv)
+{
+	return argc >= 2 && std::string_view(argv[1]).rfind("--", 0) == 0;
+}
+
+bool Headless::run(int argc, char **argv)
+{
+	std::string_view command = argv[1];
+
+	if (command == "--render-audio" || command == "--render-gbs")
+	{
+		RenderAudioArgs args;
+		if (!parseRenderAudioArgs(argc, argv, args))
+		{
+			printUsage();
+			return false;
+		}
+
+		return command == "--render-audio" ? renderAudio(args) : renderGbs(args);
+	}
+
+	if (command == "--audio-bench")
+	{
+		double seconds = 10.0;
+		for (int i = 2; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]) == "--seconds" && i + 1 < argc)
+				seconds = std::strtod(argv[++i], nullptr);
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return AudioBench::run(seconds > 0.0 ? seconds : 10.0);
+	}
+
+	if (command == "--state-bench" && argc >= 3)
+	{
+		uint64_t frames = 60;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]) == "--frames" && i + 1 < argc)
+				frames = std::strtoull(argv[++i], nullptr, 10);
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return stateBench(argv[2], frames);
+	}
+
+	if (command == "--play-movie" && argc >= 3)
+	{
+		std::string romPath, hashesPath;
+		for (int i = 3; i < argc; ++i)
+		{
+			std::string_view arg = argv[i];
+
+			if (arg == "--rom" && i + 1 < argc)
+				romPath = argv[++i];
+			else if (arg == "--hashes" && i + 1 < argc)
+				hashesPath = argv[++i];
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		if (romPath.empty())
+		{
+			printUsage();
+			return false;
+		}
+
+		return playMovie(argv[2], romPath, hashesPath);
+	}
+
+	if (command == "--netplay-bench" && argc >= 3)
+	{
+		uint32_t frames = 3600, inputDelay = 1, latency = 4;
+		double   loss   = 0.05;
+
+		for (int i = 3; i < argc; ++i)
+		{
+			std::string_view arg      = argv[i];
+			bool             hasValue = i + 1 < argc;
+
+			if (arg == "--frames" && hasValue)
+				frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--delay" && hasValue)
+				inputDelay = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--latency" && hasValue)
+				latency = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--loss" && hasValue)
+				loss = std::strtod(argv[++i], nullptr);
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return netplayBench(argv[2], frames, inputDelay, latency, loss);
+	}
+
+	if (command == "--determinism" && argc >= 3)
+	{
+		uint32_t frames = 3600;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]) == "--frames" && i + 1 < argc)
+				frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return determinismCheck(argv[2], frames);
+	}
+
+	if (command == "--fork-bench" && argc >= 3)
+	{
+		uint32_t frames = 600, children = 64, branchFrames = 300, threads = 0;
+
+		for (int i = 3; i < argc; ++i)
+		{
+			std::string_view arg      = argv[i];
+			bool             hasValue = i + 1 < argc;
+
+			if (arg == "--frames" && hasValue)
+				frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--children" && hasValue)
+				children = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--branch-frames" && hasValue)
+				branchFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--threads" && hasValue)
+				threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return forkBench(argv[2], frames, children, branchFrames, threads);
+	}
+
+	if (command == "--shm-bench" && argc >= 3)
+	{
+		uint32_t frames = 600;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]) == "--frames" && i + 1 < argc)
+				frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return shmBench(argv[2], frames);
+	}
+
+	if (command == "--pacing-bench" && argc >= 3)
+	{
+		double   seconds       = 5.0;
+		uint32_t stallMs       = 50;
+		uint32_t lockedStallMs = 2;
+
+		for (int i = 3; i < argc; ++i)
+		{
+			std::string_view arg      = argv[i];
+			bool             hasValue = i + 1 < argc;
+
+			if (arg == "--seconds" && hasValue)
+				seconds = std::strtod(argv[++i], nullptr);
+			else if (arg == "--stall" && hasValue)
+				stallMs = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--locked-stall" && hasValue)
+				lockedStallMs = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return pacingBench(argv[2], seconds, stallMs, lockedStallMs);
+	}
+
+	if (command == "--link-bench" && argc >= 3)
+	{
+		uint32_t frames = 600;
+		bool     udp    = false;
+
+		for (int i = 3; i < argc; ++i)
+		{
+			std::string_view arg = argv[i];
+
+			if (arg == "--frames" && i + 1 < argc)
+				frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--udp")
+				udp = true;
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return linkBench(argv[2], frames, udp);
+	}
+
+	if (command == "--gdb" && argc >= 3)
+	{
+		uint16_t port = 2345;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]) == "--port" && i + 1 < argc)
+				port = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return gdbServe(argv[2], port);
+	}
+
+	if (command == "--gdb-check" && argc >= 3)
+	{
+		uint32_t frames = 300;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]) == "--frames" && i + 1 < argc)
+				frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return gdbCheck(argv[2], frames);
+	}
+
+	if (command == "--debugger-check" && argc >= 3)
+	{
+		uint32_t frames = 300;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (std::string_view(argv[i]) == "--frames" && i + 1 < argc)
+				frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return debuggerCheck(argv[2], frames);
+	}
+
+	if (command == "--profile" && argc >= 3)
+	{
+		uint32_t    frames = 600;
+		std::string outPath;
+		std::string foldedPath;
+		for (int i = 3; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+
+			if (arg == "--frames" && i + 1 < argc)
+				frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			else if (arg == "--out" && i + 1 < argc)
+				outPath = argv[++i];
+			else if (arg == "--folded" && i + 1 < argc)
+				foldedPath = argv[++i];
+			else
+			{
+				printUsage();
+				return false;
+			}
+		}
+
+		return profileRun(argv[2], frames, outPath, foldedPath);
+	}
+
+	fmt::println(stderr, "Unrecognized command: {}", command);
+	printUsage();
+	return false;
+}
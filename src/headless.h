@@ -0,0 +1,34 @@
+#pragma once
+
+namespace Headless
+{
+
+/**
+ * @brief Check if command line arguments request a headless run instead of opening a window.
+ */
+bool isHeadlessCommand(int argc, char **argv);
+
+/**
+ * @brief Run a headless command with no window, audio device or frame pacing.
+ *
+ * --render-audio <rom> --out <file.wav> [--frames N | --seconds S] [--stems] [--rate HZ] [--quality Q] [--speed X]
+ * --render-gbs <file.gbs> --out <file.wav> [--frames N | --seconds S] [--stems] [--threads N] [--rate HZ] [--quality Q] [--speed X]
+ * --audio-bench [--seconds S]
+ * --state-bench <rom> [--frames N]
+ * --play-movie <movie> --rom <rom> [--hashes <file.txt>]
+ * --netplay-bench <rom> [--frames N] [--delay D] [--latency L] [--loss P]
+ * --determinism <rom> [--frames N]
+ * --fork-bench <rom> [--frames N] [--children C] [--branch-frames F] [--threads T]
+ * --shm-bench <rom> [--frames N]
+ * --pacing-bench <rom> [--seconds S] [--stall MS] [--locked-stall MS]
+ * --link-bench <rom> [--frames N] [--udp]
+ * --gdb <rom> [--port P]
+ * --gdb-check <rom> [--frames N]
+ * --debugger-check <rom> [--frames N]
+ * --profile <rom> [--frames N] [--out <file.csv>] [--folded <file.folded>]
+ *
+ * @return True on success, false otherwise.
+ */
+bool run(int argc, char **argv);
+
+} // namespace Headless
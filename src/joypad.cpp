@@ -29,86 +29,24 @@ void Joypad::writeJoypad(uint8_t data)
 	m_joypad.selectButtons = (data >> 5) & 1;
 }
 
-void Joypad::processEvent(SDL_Event *event)
+uint8_t Joypad::getButtons() const
 {
-	if (event->type == SDL_EVENT_KEY_DOWN)
-	{
-		switch (event->key.scancode)
-		{
-		case SDL_SCANCODE_W:
-			m_joypad.up = 0;
-			break;
-
-		case SDL_SCANCODE_A:
-			m_joypad.left = 0;
-			break;
-
-		case SDL_SCANCODE_S:
-			m_joypad.down = 0;
-			break;
-
-		case SDL_SCANCODE_D:
-			m_joypad.right = 0;
-			break;
-
-		case SDL_SCANCODE_L:
-			m_joypad.a = 0;
-			break;
-
-		case SDL_SCANCODE_K:
-			m_joypad.b = 0;
-			break;
-
-		case SDL_SCANCODE_Q:
-			m_joypad.start = 0;
-			break;
-
-		case SDL_SCANCODE_E:
-			m_joypad.select = 0;
-			break;
-
-		default:
-			break;
-		}
-	}
-	else if (event->type == SDL_EVENT_KEY_UP)
-	{
-		switch (event->key.scancode)
-		{
-		case SDL_SCANCODE_W:
-			m_joypad.up = 1;
-			break;
+	// button bits are active low
+	uint8_t buttons = (m_joypad.start << 3) | (m_joypad.select << 2) | (m_joypad.b << 1) | (m_joypad.a);
+	uint8_t dpad    = (m_joypad.down << 3) | (m_joypad.up << 2) | (m_joypad.left << 1) | (m_joypad.right);
 
-		case SDL_SCANCODE_A:
-			m_joypad.left = 1;
-			break;
-
-		case SDL_SCANCODE_S:
-			m_joypad.down = 1;
-			break;
-
-		case SDL_SCANCODE_D:
-			m_joypad.right = 1;
-			break;
-
-		case SDL_SCANCODE_L:
-			m_joypad.a = 1;
-			break;
-
-		case SDL_SCANCODE_K:
-			m_joypad.b = 1;
-			break;
-
-		case SDL_SCANCODE_Q:
-			m_joypad.start = 1;
-			break;
-
-		case SDL_SCANCODE_E:
-			m_joypad.select = 1;
-			break;
+	return static_cast<uint8_t>(~((dpad << 4) | buttons));
+}
 
-		default:
-			break;
-		}
-	}
-}
\ No newline at end of file
+void Joypad::setButtons(uint8_t buttons)
+{
+	m_joypad.a      = !(buttons & (1 << 0));
+	m_joypad.b      = !(buttons & (1 << 1));
+	m_joypad.select = !(buttons & (1 << 2));
+	m_joypad.start  = !(buttons & (1 << 3));
+
+	m_joypad.right = !(buttons & (1 << 4));
+	m_joypad.left  = !(buttons & (1 << 5));
+	m_joypad.up    = !(buttons & (1 << 6));
+	m_joypad.down  = !(buttons & (1 << 7));
+}
@@ -1,6 +1,5 @@
 #pragma once
 
-#include "SDL3/SDL.h"
 #include <cstdint>
 
 class Joypad
@@ -27,9 +26,31 @@ class Joypad
 		clear();
 	}
 
+	// bits of the getButtons() mask
+	static constexpr uint8_t BUTTON_A      = 1 << 0;
+	static constexpr uint8_t BUTTON_B      = 1 << 1;
+	static constexpr uint8_t BUTTON_SELECT = 1 << 2;
+	static constexpr uint8_t BUTTON_START  = 1 << 3;
+	static constexpr uint8_t BUTTON_RIGHT  = 1 << 4;
+	static constexpr uint8_t BUTTON_LEFT   = 1 << 5;
+	static constexpr uint8_t BUTTON_UP     = 1 << 6;
+	static constexpr uint8_t BUTTON_DOWN   = 1 << 7;
+
 	uint8_t readJoypad() const;
 	void    writeJoypad(uint8_t data);
-	void    processEvent(SDL_Event *event);
+
+	/**
+	 * @brief Get or set every button at once as a mask of pressed buttons, used to record and play back input.
+	 * Bits 0 - 3 are a, b, select, start and bits 4 - 7 are right, left, up, down.
+	 */
+	uint8_t getButtons() const;
+	void    setButtons(uint8_t buttons);
+
+	// press or release the buttons in a getButtons() mask, others keep their state
+	void setButtonsPressed(uint8_t buttons, bool pressed)
+	{
+		setButtons(static_cast<uint8_t>(pressed ? getButtons() | buttons : getButtons() & ~buttons));
+	}
 
 	void clear()
 	{
@@ -45,4 +66,19 @@ class Joypad
 		m_joypad.up         = 1;
 		m_joypad.down       = 1;
 	}
+
+	// save or load the select lines, see Utils::StateWriter. Button states are live input and are left as they are so
+	// loading a state never leaves a button held
+	template <typename Archive>
+	void serialize(Archive &archive)
+	{
+		// bitfields cannot be bound to references, round trip them through temporaries
+		uint8_t selectButtons = m_joypad.selectButtons;
+		uint8_t selectDpad    = m_joypad.selectDpad;
+
+		archive(selectButtons, selectDpad);
+
+		m_joypad.selectButtons = selectButtons;
+		m_joypad.selectDpad    = selectDpad;
+	}
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "GBS.h"
+
+#include <algorithm>
+
+Mapper::GBS::GBS(std::ifstream &gbsFile, const Mapper::CartInfo &cartInfo, const GbsHeader &header)
+	: IMapper(cartInfo)
+{
+	// music data is placed at the load address, size is rounded up to whole 16kb banks
+	std::vector<uint8_t> rom(cartInfo.RomSize);
+
+	gbsFile.seekg(GbsHeader::SIZE, std::ios::beg);
+	gbsFile.read(reinterpret_cast<char *>(rom.data() + header.LoadAddress), cartInfo.RomSize - header.LoadAddress);
+	gbsFile.clear();
+	gbsFile.seekg(0);
+
+	m_romBankCount = cartInfo.RomSize / 0x4000;
+
+	// rst vectors are relocated to load address + rst address
+	for (uint16_t rst = 0; rst <= 0x38; rst += 8)
+	{
+		uint16_t target = header.LoadAddress + rst;
+		rom[rst]        = 0xC3; // JP n16
+		rom[rst + 1]    = target & 0xFF;
+		rom[rst + 2]    = target >> 8;
+	}
+
+	// play calls are driven by the player so interrupts simply return
+	for (uint16_t vector = 0x40; vector <= 0x60; vector += 8)
+		rom[vector] = 0xD9; // RETI
+
+	const uint8_t driver[] = {
+		0xCD, static_cast<uint8_t>(header.InitAddress & 0xFF), static_cast<uint8_t>(header.InitAddress >> 8), // INIT_ENTRY: CALL init
+		0x18, 0xFE,                                                                                            // IDLE_LOOP: JR IDLE_LOOP
+		0xCD, static_cast<uint8_t>(header.PlayAddress & 0xFF), static_cast<uint8_t>(header.PlayAddress >> 8), // PLAY_ENTRY: CALL play
+		0x18, 0xF9,                                                                                            // JR IDLE_LOOP
+	};
+
+	std::copy(std::begin(driver), std::end(driver), rom.begin() + INIT_ENTRY);
+
+	m_rom = SharedRom(std::move(rom));
+}
+
+uint8_t Mapper::GBS::read(uint16_t position)
+{
+	if (position <= 0x3FFF)
+		return m_rom[position];
+	else if (position <= 0x7FFF)
+		return m_rom[(m_romBank << 14) | (position & 0x3FFF)];
+	else if (position >= 0xA000 && position <= 0xBFFF)
+		return m_ram[position & 0x1FFF];
+
+	return 0xFF;
+}
+
+void Mapper::GBS::write(uint16_t position, uint8_t data)
+{
+	if (position >= 0x2000 && position <= 0x3FFF)
+	{
+		uint32_t bank = data == 0 ? 1 : data;
+		m_romBank     = static_cast<uint8_t>(bank % m_romBankCount);
+	}
+	else if (position >= 0xA000 && position <= 0xBFFF)
+	{
+		m_ram[position & 0x1FFF] = data;
+	}
+}
+
+void Mapper::GBS::reset()
+{
+	m_romBank = 1 % m_romBankCount;
+	m_ram.fill(0);
+}
+
+void Mapper::GBS::saveState(Utils::StateWriter &writer)
+{
+	writer(m_romBank, m_ram);
+}
+
+void Mapper::GBS::loadState(Utils::StateReader &reader)
+{
+	reader(m_romBank, m_ram);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "mapper.h"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Mapper
+{
+
+// https://ocremix.org/info/GBS_Format_Specification
+struct GbsHeader
+{
+	static constexpr uint32_t SIZE = 0x70;
+
+	uint8_t  TrackCount   = 0;
+	uint8_t  FirstTrack   = 0; // 0 based, file stores it 1 based
+	uint16_t LoadAddress  = 0;
+	uint16_t InitAddress  = 0;
+	uint16_t PlayAddress  = 0;
+	uint16_t StackPointer = 0;
+	uint8_t  TimerModulo  = 0;
+	uint8_t  TimerControl = 0;
+
+	std::string Title;
+	std::string Author;
+	std::string Copyright;
+};
+
+// Sound only cartridge built from a .gbs file. Banks 0x4000 - 0x7FFF like a simplified MBC1 and places a small driver
+// in the unused space below the load address that calls the init and play routines of the file.
+class GBS : public IMapper
+{
+  public:
+	static constexpr uint16_t INIT_ENTRY = 0x0080; // CALL init
+	static constexpr uint16_t IDLE_LOOP  = 0x0083; // JR to self, cpu spins here between play calls
+	static constexpr uint16_t PLAY_ENTRY = 0x0085; // CALL play, then JR to idle loop
+
+	GBS(std::ifstream &gbsFile, const Mapper::CartInfo &cartInfo, const GbsHeader &header);
+	~GBS() override = default;
+
+	GBS(const GBS &) = default;
+
+	std::unique_ptr<IMapper> clone() const override
+	{
+		return std::make_unique<GBS>(*this);
+	}
+
+	virtual uint8_t read(uint16_t position) override;
+	virtual void    write(uint16_t position, uint8_t data) override;
+	virtual void    reset() override;
+
+	virtual void saveState(Utils::StateWriter &writer) override;
+	virtual void loadState(Utils::StateReader &reader) override;
+
+	virtual uint64_t hashRam(uint64_t seed) const override
+	{
+		return Utils::hash64(m_ram.data(), m_ram.size(), seed);
+	}
+
+	virtual uint32_t getRomBank(uint16_t position) const override
+	{
+		return position <= 0x3FFF ? 0 : m_romBank;
+	}
+
+  private:
+	SharedRom                     m_rom;
+	std::array<uint8_t, 1024 * 8> m_ram{};
+
+	uint32_t m_romBankCount = 0;
+	uint8_t  m_romBank      = 1;
+};
+
+} // namespace Mapper
@@ -5,17 +5,18 @@
 Mapper::MBC1::MBC1(std::ifstream &romFile, const Mapper::CartInfo &cartInfo)
 	: IMapper(cartInfo)
 {
-	m_rom.resize(cartInfo.RomSize);
+	std::vector<uint8_t> rom(cartInfo.RomSize);
 	m_ram.resize(cartInfo.RamSize);
 
 	romFile.seekg(0);
-	romFile.read(reinterpret_cast<char *>(m_rom.data()), cartInfo.RomSize);
+	romFile.read(reinterpret_cast<char *>(rom.data()), cartInfo.RomSize);
 	romFile.seekg(0);
 
+	m_rom = SharedRom(std::move(rom));
+
+	// ram starts zeroed without a battery
 	if (cartInfo.BatteryBacked)
 		loadSaveRam(m_ram);
-	else
-		std::fill(m_ram.begin(), m_ram.end(), (uint8_t)0);
 
 	m_registers.reset();
 }
@@ -54,12 +55,12 @@ uint8_t Mapper::MBC1::read(uint16_t position)
 	else if (m_registers.RamEnable && m_ram.size() != 0 && position >= 0xA000 && position <= 0xBFFF)
 	{
 		if (m_registers.BankModeSelect == 0)
-			data = m_ram[position & 0x1FFF];
+			data = m_ram.read(position & 0x1FFF);
 		else
 		{
 			uint32_t bankNumber = m_registers.Extra2Bits & (static_cast<uint32_t>(m_cartInfo.RamSize / 8192) - 1);
 			uint32_t address    = (bankNumber << 13) | (position & 0x1FFF);
-			data                = m_ram[address];
+			data                = m_ram.read(address);
 		}
 	}
 
@@ -94,12 +95,12 @@ void Mapper::MBC1::write(uint16_t position, uint8_t data)
 	else if (m_registers.RamEnable && m_ram.size() != 0 && position >= 0xA000 && position <= 0xBFFF)
 	{
 		if (m_registers.BankModeSelect == 0)
-			m_ram[position & 0x1FFF] = data;
+			m_ram.write(position & 0x1FFF, data);
 		else
 		{
 			uint32_t bankNumber = m_registers.Extra2Bits & (static_cast<uint32_t>(m_cartInfo.RamSize / 8192) - 1);
 			uint32_t address    = (bankNumber << 13) | (position & 0x1FFF);
-			m_ram[address]      = data;
+			m_ram.write(address, data);
 		}
 	}
 }
@@ -108,3 +109,28 @@ void Mapper::MBC1::reset()
 {
 	m_registers.reset();
 }
+
+void Mapper::MBC1::saveState(Utils::StateWriter &writer)
+{
+	serialize(writer);
+}
+
+void Mapper::MBC1::loadState(Utils::StateReader &reader)
+{
+	serialize(reader);
+}
+
+template <typename Archive>
+void Mapper::MBC1::serialize(Archive &archive)
+{
+	// bitfields cannot be bound to references, round trip them through temporaries
+	uint8_t romBankSelector = m_registers.RomBankSelector;
+	uint8_t extra2Bits      = m_registers.Extra2Bits;
+	uint8_t bankModeSelect  = m_registers.BankModeSelect;
+
+	archive(m_registers.RamEnable, romBankSelector, extra2Bits, bankModeSelect, m_ram);
+
+	m_registers.RomBankSelector = romBankSelector;
+	m_registers.Extra2Bits      = extra2Bits;
+	m_registers.BankModeSelect  = bankModeSelect;
+}
@@ -15,13 +15,39 @@ class MBC1 : public IMapper
 	MBC1(std::ifstream &romFile, const Mapper::CartInfo &cartInfo);
 	~MBC1() override;
 
+	MBC1(const MBC1 &) = default;
+
+	std::unique_ptr<IMapper> clone() const override
+	{
+		return std::make_unique<MBC1>(*this);
+	}
+
 	virtual uint8_t read(uint16_t position) override;
 	virtual void    write(uint16_t position, uint8_t data) override;
 	virtual void    reset() override;
 
+	virtual void saveState(Utils::StateWriter &writer) override;
+	virtual void loadState(Utils::StateReader &reader) override;
+
+	virtual uint64_t hashRam(uint64_t seed) const override
+	{
+		return m_ram.hash(seed);
+	}
+
+	virtual uint32_t getRomBank(uint16_t position) const override
+	{
+		const uint32_t bankMask = static_cast<uint32_t>(m_cartInfo.RomSize / 16384) - 1;
+
+		// mode 1 banks 0x0000 - 0x3FFF with the extra 2 bits as well
+		if (position <= 0x3FFF)
+			return m_registers.BankModeSelect == 0 ? 0 : (m_registers.Extra2Bits << 5) & bankMask;
+
+		return ((m_registers.Extra2Bits << 5) | m_registers.RomBankSelector) & bankMask;
+	}
+
   private:
-	std::vector<uint8_t> m_rom;
-	std::vector<uint8_t> m_ram;
+	SharedRom        m_rom;
+	Utils::CowMemory m_ram;
 
 	// registers
 
@@ -40,6 +66,9 @@ class MBC1 : public IMapper
 			BankModeSelect  = 0;
 		}
 	} m_registers;
+
+	template <typename Archive>
+	void serialize(Archive &archive);
 };
 
 } // namespace Mapper
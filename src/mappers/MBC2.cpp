@@ -3,12 +3,14 @@
 Mapper::MBC2::MBC2(std::ifstream &romFile, const Mapper::CartInfo &cartInfo)
 	: IMapper(cartInfo)
 {
-	m_rom.resize(cartInfo.RomSize);
+	std::vector<uint8_t> rom(cartInfo.RomSize);
 
 	romFile.seekg(0);
-	romFile.read(reinterpret_cast<char *>(m_rom.data()), cartInfo.RomSize);
+	romFile.read(reinterpret_cast<char *>(rom.data()), cartInfo.RomSize);
 	romFile.seekg(0);
 
+	m_rom = SharedRom(std::move(rom));
+
 	if (m_cartInfo.BatteryBacked)
 		loadSaveRam(m_ram.data(), m_ram.size());
 }
@@ -62,3 +64,13 @@ void Mapper::MBC2::reset()
 	m_registers.RamEnable     = false;
 	m_registers.RomBankSelect = 1;
 }
+
+void Mapper::MBC2::saveState(Utils::StateWriter &writer)
+{
+	writer(m_registers.RomBankSelect, m_registers.RamEnable, m_ram);
+}
+
+void Mapper::MBC2::loadState(Utils::StateReader &reader)
+{
+	reader(m_registers.RomBankSelect, m_registers.RamEnable, m_ram);
+}
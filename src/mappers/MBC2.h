@@ -17,14 +17,34 @@ class MBC2 : public IMapper
 	MBC2(std::ifstream &romFile, const Mapper::CartInfo &cartInfo);
 	~MBC2();
 
+	MBC2(const MBC2 &) = default;
+
+	std::unique_ptr<IMapper> clone() const override
+	{
+		return std::make_unique<MBC2>(*this);
+	}
+
 	virtual uint8_t read(uint16_t position) override;
 	virtual void    write(uint16_t position, uint8_t data) override;
 	virtual void    reset() override;
 
+	virtual void saveState(Utils::StateWriter &writer) override;
+	virtual void loadState(Utils::StateReader &reader) override;
+
+	virtual uint64_t hashRam(uint64_t seed) const override
+	{
+		return Utils::hash64(m_ram.data(), m_ram.size(), seed);
+	}
+
+	virtual uint32_t getRomBank(uint16_t position) const override
+	{
+		return position <= 0x3FFF ? 0 : m_registers.RomBankSelect;
+	}
+
 	static constexpr uint16_t RAM_SIZE = 512; // mbc2 has a fixed 512 bytes of internal ram only
 
   private:
-	std::vector<uint8_t>     m_rom;
+	SharedRom                     m_rom;
 	std::array<uint8_t, RAM_SIZE> m_ram{}; // 512 4 bit values as ram. Lower four bits treated as are undefined.
 
 	struct Registers
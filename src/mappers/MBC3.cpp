@@ -6,17 +6,18 @@
 Mapper::MBC3::MBC3(std::ifstream &romFile, const Mapper::CartInfo &cartInfo)
 	: IMapper(cartInfo)
 {
-	m_rom.resize(cartInfo.RomSize);
+	std::vector<uint8_t> rom(cartInfo.RomSize);
 	m_ram.resize(cartInfo.RamSize);
 
 	romFile.seekg(0);
-	romFile.read(reinterpret_cast<char *>(m_rom.data()), cartInfo.RomSize);
+	romFile.read(reinterpret_cast<char *>(rom.data()), cartInfo.RomSize);
 	romFile.seekg(0);
 
+	m_rom = SharedRom(std::move(rom));
+
+	// ram starts zeroed without a battery
 	if (cartInfo.BatteryBacked)
 		loadSaveRam(m_ram);
-	else
-		std::fill(m_ram.begin(), m_ram.end(), static_cast<uint8_t>(0));
 }
 
 Mapper::MBC3::~MBC3()
@@ -45,7 +46,7 @@ uint8_t Mapper::MBC3::read(uint16_t position)
 		if (m_registers.RamOrRtcSelector <= 0x07)
 		{
 			uint32_t address = (m_registers.RamOrRtcSelector << 13) | (position & 0x1FFF);
-			data             = m_ram[address];
+			data             = m_ram.read(address);
 		}
 		else
 		{
@@ -103,7 +104,7 @@ void Mapper::MBC3::write(uint16_t position, uint8_t data)
 		if (m_registers.RamOrRtcSelector <= 0x07)
 		{
 			uint32_t address = (m_registers.RamOrRtcSelector << 13) | (position & 0x1FFF);
-			m_ram[address] = data;
+			m_ram.write(address, data);
 		}
 		else
 		{
@@ -136,3 +137,22 @@ void Mapper::MBC3::reset()
 	m_registers.reset();
 	m_rtc.reset();
 }
+
+void Mapper::MBC3::saveState(Utils::StateWriter &writer)
+{
+	serialize(writer);
+}
+
+void Mapper::MBC3::loadState(Utils::StateReader &reader)
+{
+	serialize(reader);
+}
+
+template <typename Archive>
+void Mapper::MBC3::serialize(Archive &archive)
+{
+	archive(m_registers.RomBankSelector, m_registers.RamOrRtcSelector, m_registers.LatchState, m_registers.RamAndRtcEnable);
+
+	// rtc structs are plain bytes with no padding
+	archive(m_rtc, m_rtcLatch, m_ram);
+}
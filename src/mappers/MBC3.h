@@ -16,13 +16,33 @@ class MBC3 : public IMapper
 	MBC3(std::ifstream &romFile, const Mapper::CartInfo &cartInfo);
 	~MBC3() override;
 
+	MBC3(const MBC3 &) = default;
+
+	std::unique_ptr<IMapper> clone() const override
+	{
+		return std::make_unique<MBC3>(*this);
+	}
+
 	virtual uint8_t read(uint16_t position) override;
 	virtual void    write(uint16_t position, uint8_t data) override;
 	virtual void    reset() override;
 
+	virtual void saveState(Utils::StateWriter &writer) override;
+	virtual void loadState(Utils::StateReader &reader) override;
+
+	virtual uint64_t hashRam(uint64_t seed) const override
+	{
+		return m_ram.hash(seed);
+	}
+
+	virtual uint32_t getRomBank(uint16_t position) const override
+	{
+		return position <= 0x3FFF ? 0 : m_registers.RomBankSelector;
+	}
+
   private:
-	std::vector<uint8_t> m_rom;
-	std::vector<uint8_t> m_ram;
+	SharedRom        m_rom;
+	Utils::CowMemory m_ram;
 
 	struct Registers
 	{
@@ -68,6 +88,9 @@ class MBC3 : public IMapper
 	} m_rtc;
 
 	RTC m_rtcLatch;
+
+	template <typename Archive>
+	void serialize(Archive &archive);
 };
 
 } // namespace Mapper
\ No newline at end of file
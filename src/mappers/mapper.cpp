@@ -106,8 +106,18 @@ void Mapper::IMapper::dumpBatteryBackedRam(const std::vector<uint8_t> &ram) cons
 	dumpBatteryBackedRam(ram.data(), ram.size());
 }
 
+void Mapper::IMapper::dumpBatteryBackedRam(const Utils::CowMemory &ram) const
+{
+	std::vector<uint8_t> data(ram.size());
+	ram.copyTo(data.data());
+	dumpBatteryBackedRam(data);
+}
+
 void Mapper::IMapper::dumpBatteryBackedRam(const uint8_t *ram, std::size_t size) const
 {
+	if (!m_cartInfo.PersistSaveRam)
+		return;
+
 	auto savePath = m_cartInfo.CartFilePath.parent_path() / m_cartInfo.CartFilePath.filename().replace_extension(".sav");
 
 	std::ofstream saveFile(savePath, std::ios::binary);
@@ -122,8 +132,18 @@ void Mapper::IMapper::loadSaveRam(std::vector<uint8_t> &ram)
 	loadSaveRam(ram.data(), ram.size());
 }
 
+void Mapper::IMapper::loadSaveRam(Utils::CowMemory &ram)
+{
+	std::vector<uint8_t> data(ram.size());
+	loadSaveRam(data);
+	ram.copyFrom(data.data());
+}
+
 void Mapper::IMapper::loadSaveRam(uint8_t *ram, std::size_t size)
 {
+	if (!m_cartInfo.PersistSaveRam)
+		return;
+
 	auto savePath = m_cartInfo.CartFilePath.parent_path() / m_cartInfo.CartFilePath.filename().replace_extension(".sav");
 
 	std::ifstream saveFile(savePath, std::ios::binary);
@@ -6,8 +6,13 @@
 #include <fstream>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "utils/cowMemory.h"
+#include "utils/hash.h"
+#include "utils/stateArchive.h"
+
 namespace Mapper
 {
 
@@ -33,13 +38,45 @@ enum class MBC_TYPES
 
 struct CartInfo
 {
-	MBC_TYPES             MbcType       = MBC_TYPES::NO_MBC;
-	uint32_t              RomSize       = 0;
-	uint32_t              RamSize       = 0;
-	bool                  BatteryBacked = false;
+	MBC_TYPES             MbcType        = MBC_TYPES::NO_MBC;
+	uint32_t              RomSize        = 0;
+	uint32_t              RamSize        = 0;
+	uint32_t              Checksums      = 0; // header checksum and global checksum, identifies the rom in save states
+	bool                  BatteryBacked  = false;
+	bool                  PersistSaveRam = true; // read and write battery backed ram to a .sav file next to the rom
 	std::filesystem::path CartFilePath;
 };
 
+/**
+ * @brief Rom image that is never written after loading, copies of a mapper share it.
+ */
+class SharedRom
+{
+  public:
+	SharedRom() = default;
+
+	explicit SharedRom(std::vector<uint8_t> &&data)
+		: m_data(std::make_shared<const std::vector<uint8_t>>(std::move(data))), m_bytes(m_data->data()), m_size(m_data->size())
+	{
+	}
+
+	// every opcode fetch from rom lands here, index the bytes directly rather than through the shared vector
+	uint8_t operator[](std::size_t position) const
+	{
+		return m_bytes[position];
+	}
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+  private:
+	std::shared_ptr<const std::vector<uint8_t>> m_data;            // keeps m_bytes alive for every copy
+	const uint8_t                              *m_bytes = nullptr; // m_data->data()
+	std::size_t                                 m_size  = 0;
+};
+
 class IMapper
 {
   public:
@@ -50,17 +87,55 @@ class IMapper
 
 	virtual ~IMapper() = default;
 
+	/**
+	 * @brief Copy the mapper for a forked core. The copy shares the rom, cartridge ram pages are copied only once either
+	 * mapper writes to them. The copy never reads or writes the .sav file.
+	 */
+	virtual std::unique_ptr<IMapper> clone() const = 0;
+
 	virtual uint8_t read(uint16_t position)                = 0;
 	virtual void    write(uint16_t position, uint8_t data) = 0;
 	virtual void    reset()                                = 0;
 
+	// save or load bank registers and cartridge ram, the rom is never part of a save state
+	virtual void saveState(Utils::StateWriter &writer) = 0;
+	virtual void loadState(Utils::StateReader &reader) = 0;
+
+	// chain a hash of cartridge ram onto seed, mappers without ram return seed unchanged
+	virtual uint64_t hashRam(uint64_t seed) const
+	{
+		return seed;
+	}
+
+	// rom bank mapped at a rom address for profilers, mappers without banking have bank 0 and 1 mapped
+	virtual uint32_t getRomBank(uint16_t position) const
+	{
+		return position <= 0x3FFF ? 0 : 1;
+	}
+
 	void dumpBatteryBackedRam(const std::vector<uint8_t> &ram) const;
+	void dumpBatteryBackedRam(const Utils::CowMemory &ram) const;
 	void dumpBatteryBackedRam(const uint8_t *ram, std::size_t size) const;
 
-	void loadSaveRam( std::vector<uint8_t> &ram);
+	void loadSaveRam(std::vector<uint8_t> &ram);
+	void loadSaveRam(Utils::CowMemory &ram);
 	void loadSaveRam(uint8_t *ram, std::size_t size);
 
 	const CartInfo m_cartInfo{};
+
+  protected:
+	// for clone(), the battery flag is kept so save states still match but the .sav file belongs to the original
+	IMapper(const IMapper &other)
+		: m_cartInfo(withoutSaveRamPersistence(other.m_cartInfo))
+	{
+	}
+
+  private:
+	static CartInfo withoutSaveRamPersistence(CartInfo cartInfo)
+	{
+		cartInfo.PersistSaveRam = false;
+		return cartInfo;
+	}
 };
 
 bool loadMapper(std::ifstream &romFile, std::unique_ptr<IMapper> &mapper, CartInfo &cartInfo, std::string &errorMsg);
@@ -5,9 +5,13 @@ using namespace Mapper;
 NoMBC::NoMBC(std::ifstream &romFile, const CartInfo &cartInfo)
 	: IMapper(cartInfo)
 {
+	std::vector<uint8_t> rom(1024 * 32);
+
 	romFile.seekg(0);
-	romFile.read(reinterpret_cast<char *>(m_rom.data()), cartInfo.RomSize);
+	romFile.read(reinterpret_cast<char *>(rom.data()), cartInfo.RomSize);
 	romFile.seekg(0);
+
+	m_rom = SharedRom(std::move(rom));
 }
 
 uint8_t NoMBC::read(uint16_t position)
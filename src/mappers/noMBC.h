@@ -16,13 +16,28 @@ class NoMBC : public IMapper
 	NoMBC(std::ifstream &romFile, const Mapper::CartInfo &cartInfo);
 	~NoMBC() override = default;
 
+	NoMBC(const NoMBC &) = default;
+
+	std::unique_ptr<IMapper> clone() const override
+	{
+		return std::make_unique<NoMBC>(*this);
+	}
+
 	virtual uint8_t read(uint16_t position) override;
 	virtual void    write(uint16_t position, uint8_t data) override;
 	virtual void    reset() override
 	{
 	}
 
+	virtual void saveState(Utils::StateWriter &) override
+	{
+	}
+
+	virtual void loadState(Utils::StateReader &) override
+	{
+	}
+
   private:
-	std::array<uint8_t, 1024 * 32> m_rom{};
+	SharedRom m_rom; // 32kb
 };
 } // namespace Mapper
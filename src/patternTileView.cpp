@@ -14,6 +14,11 @@ PatternTileView::PatternTileView(const PPU &ppu, RendererGB::RenderContext *rend
 	m_tilePreviewQuad         = RendererGB::texturedQuadCreate(renderContext, Vec2<float>{TILE_WIDTH, TILE_HEIGHT});
 }
 
+void PatternTileView::captureVram()
+{
+	m_vram = m_ppu.getVram();
+}
+
 bool PatternTileView::drawViewportGui(RendererGB::RenderContext *renderContext)
 {
 	bool toggle = true;
@@ -128,7 +133,7 @@ bool PatternTileView::updateWindowSize(float width, float height)
 
 void PatternTileView::updateTileViewPixelBuffer()
 {
-	auto &vram = m_ppu.getVram();
+	auto &vram = m_vram;
 
 	// T TTTT TTTT YYYP
 	// | |||| |||| |||+- P: Bit plane selection
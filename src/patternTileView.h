@@ -15,6 +15,9 @@ class PatternTileView
 	PatternTileView(const PPU &, RendererGB::RenderContext *renderContext);
 	~PatternTileView() = default;
 
+	// copy vram for the next drawViewportGui(), called with the emulation lock held so drawing can go without it
+	void captureVram();
+
 	// returns false if gui is closed, else return true
 	bool drawViewportGui(RendererGB::RenderContext *renderContext);
 
@@ -33,8 +36,9 @@ class PatternTileView
 	static constexpr Utils::Vec2<float> MIN_TILE_VIEW_SIZE{64, 64};
 	static constexpr Utils::Vec2<float> TILE_PREVIEW_SIZE{160, 160};
 
-	const PPU         &m_ppu;
-	Utils::Vec2<float> m_tileViewportSize{0, 0};
+	const PPU                          &m_ppu;
+	std::array<uint8_t, PPU::VRAM_SIZE> m_vram{}; // copy of the ppu vram from captureVram()
+	Utils::Vec2<float>                  m_tileViewportSize{0, 0};
 
 	BudgetGbConstants::TileColorBuffer m_tileViewPixelBuffer{};
 
@@ -1,5 +1,6 @@
 #include "ppu.h"
 #include "sm83.h"
+#include "utils/hash.h"
 
 PPU::PPU(uint8_t &interruptFlags)
 	: m_interruptLine(interruptFlags)
@@ -449,7 +450,8 @@ void PPU::pushPixelToLCD()
 	uint16_t lcdPixelIndex = (160 * (143 - r_lcdY)) + (m_pixelX - 8);
 	m_pixelX += 1;
 
-	m_lcdColorBuffer[lcdPixelIndex] = outputColorIndex;
+	if (m_outputEnabled)
+		m_lcdColorBuffer[lcdPixelIndex] = outputColorIndex;
 
 	// enter H-blank once 160 pixels are drawn
 	if (m_pixelX == 160 + 8)
@@ -693,6 +695,45 @@ void PPU::init(bool useBootrom)
 	m_dotCounter = 0;
 }
 
+void PPU::saveState(Utils::StateWriter &writer)
+{
+	serialize(writer);
+}
+
+void PPU::loadState(Utils::StateReader &reader)
+{
+	serialize(reader);
+}
+
+uint64_t PPU::hashRam(uint64_t seed) const
+{
+	static_assert(sizeof(Sprite) == 4, "oam is hashed as raw bytes");
+
+	seed = Utils::hash64(m_vram.data(), m_vram.size(), seed);
+	return Utils::hash64(m_oamRam.data(), sizeof(m_oamRam), seed);
+}
+
+template <typename Archive>
+void PPU::serialize(Archive &archive)
+{
+	archive(r_LYC, r_scrollX, r_scrollY, r_windowX, r_windowY, r_oamStart, r_bgPaletteData, r_objPaletteData0, r_objPaletteData1);
+	archive(r_lcdStatus, r_lcdY, r_lcdControl);
+
+	archive(m_statInterruptSources, m_sharedInterruptLine, m_vram, m_oamRam);
+
+	archive(m_spriteScanner.secondaryOAM);
+	archive(m_spriteFetcher.spriteFetchPending, m_spriteFetcher.patternTileAddress, m_spriteFetcher.patternTileLoLatch, m_spriteFetcher.fetchQueue);
+	archive(m_spriteFifo.m_outputSprites);
+
+	archive(m_bgFetcher.patternTileAddress, m_bgFetcher.patternTileLoLatch, m_bgFetcher.patternTileHiLatch);
+	archive(m_bgFetcher.tileIndex, m_bgFetcher.fetchCounter, m_bgFetcher.fetchComplete);
+	archive(m_bgFifo.patternTileLoShifter, m_bgFifo.patternTileHiShifter, m_bgFifo.shiftCounter);
+
+	archive(m_scanlineDotCounter, m_ppuMode, m_pixelRenderState, m_spriteFetchState, m_pixelX, m_frameDone, m_dotCounter);
+	archive(m_window.WxMatch, m_window.WyMatch, m_window.TileX, m_window.LineCounterY);
+	archive(m_oamDmaController.byteCounter, m_oamDmaController.dmaInProgress);
+}
+
 void PPU::ppuDisable()
 {
 	r_lcdY               = 0;
@@ -2,6 +2,7 @@
 
 #include "emulatorConstants.h"
 #include "utils/ppuArray.h"
+#include "utils/stateArchive.h"
 #include "utils/vec.h"
 
 #include <array>
@@ -15,6 +16,16 @@ class PPU
 
 	void init(bool useBootrom);
 
+	/**
+	 * @brief Save or load registers, vram, oam and the fetcher and fifo state machines so a load resumes mid
+	 * scanline. The lcd color buffer is not saved, it is fully redrawn by the next frame.
+	 */
+	void saveState(Utils::StateWriter &writer);
+	void loadState(Utils::StateReader &reader);
+
+	// chain a hash of vram and oam onto seed, see BudgetGBCore::hashRam()
+	uint64_t hashRam(uint64_t seed) const;
+
 	uint8_t r_LYC             = 0; // value to compare against the current scanline (lcdY)
 	uint8_t r_scrollX         = 0;
 	uint8_t r_scrollY         = 0;
@@ -232,6 +243,7 @@ class PPU
 	};
 
 	BudgetGbConstants::LcdColorBuffer m_lcdColorBuffer{};
+	bool                              m_outputEnabled = true;
 
 	// 0: mode 0 state
 	// 1: mode 1 state
@@ -314,6 +326,9 @@ class PPU
 	bool processSpriteFetching();
 	void pushPixelToLCD();
 
+	template <typename Archive>
+	void serialize(Archive &archive);
+
 	// step through 6 cycle tile fetch sequence
 	void bgFetchStep();
 
@@ -369,6 +384,12 @@ class PPU
 		return m_vram[position & 0x1FFF];
 	}
 
+	// for debuggers, does not respect write access restrictions from ppu rendering
+	void debugWriteVram(uint16_t position, uint8_t data)
+	{
+		m_vram[position & 0x1FFF] = data;
+	}
+
 	uint8_t getLcdY() const
 	{
 		return r_lcdY;
@@ -408,5 +429,19 @@ class PPU
 		return m_lcdColorBuffer;
 	}
 
+	/**
+	 * @brief Stop writing pixels to the lcd color buffer, the pixel pipeline keeps running. Used for frames that are
+	 * emulated but never shown.
+	 */
+	void setOutputEnabled(bool enabled)
+	{
+		m_outputEnabled = enabled;
+	}
+
+	bool isOutputEnabled() const
+	{
+		return m_outputEnabled;
+	}
+
 	void ppuDisable();
 };
@@ -0,0 +1,64 @@
+#include "serial.h"
+#include "SerialLink.h"
+#include "sm83.h"
+
+void Serial::writeControl(uint8_t control)
+{
+	m_control        = control & (SC_TRANSFER_ENABLE | SC_INTERNAL_CLOCK);
+	m_transferCycles = (m_control & SC_TRANSFER_ENABLE) && (m_control & SC_INTERNAL_CLOCK) ? TRANSFER_CYCLES : 0;
+}
+
+void Serial::tick(uint8_t &interruptFlags)
+{
+	if (m_transferCycles > 0)
+	{
+		m_transferCycles -= 4;
+
+		// nothing plugged in, every bit shifted in reads high
+		if (m_transferCycles == 0 && !isLinked())
+			finishTransfer(0xFF, interruptFlags);
+	}
+
+	if (isLinked() && (m_linkCycles += 4) == m_nextBarrier)
+		exchange(interruptFlags);
+}
+
+void Serial::reset()
+{
+	m_data           = 0;
+	m_control        = 0;
+	m_transferCycles = 0;
+}
+
+void Serial::setLink(SerialLink *link)
+{
+	m_link        = link;
+	m_linkCycles  = 0;
+	m_nextBarrier = link ? link->getQuantum() : 0;
+}
+
+void Serial::exchange(uint8_t &interruptFlags)
+{
+	const bool done  = isTransferDone();
+	const bool ready = (m_control & (SC_TRANSFER_ENABLE | SC_INTERNAL_CLOCK)) == SC_TRANSFER_ENABLE;
+
+	const SerialLink::PortState local{m_data, ready, done};
+	SerialLink::PortState       remote{};
+
+	// a side that missed the exchange is treated as unplugged for this quantum
+	m_link->exchange(m_linkCycles, local, remote);
+	m_nextBarrier += m_link->getQuantum();
+
+	// both sides see the same two port states, so both settle a transfer the same way
+	if (done)
+		finishTransfer(remote.Ready ? remote.Data : 0xFF, interruptFlags);
+	else if (ready && remote.Done)
+		finishTransfer(remote.Data, interruptFlags);
+}
+
+void Serial::finishTransfer(uint8_t data, uint8_t &interruptFlags)
+{
+	m_data = data;
+	m_control &= ~SC_TRANSFER_ENABLE;
+	interruptFlags |= Sm83::InterruptFlags_SERIAL;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+
+class SerialLink;
+
+// https://gbdev.io/pandocs/Serial_Data_Transfer_(Link_Cable).html
+class Serial
+{
+  public:
+	// Bit 7: transfer enable, set to start a transfer and cleared once it finished
+	// Bit 0: clock select, 1 shifts on the internal clock (master), 0 waits on the clock of the other side (slave)
+	static constexpr uint8_t SC_TRANSFER_ENABLE = 1 << 7;
+	static constexpr uint8_t SC_INTERNAL_CLOCK  = 1 << 0;
+
+	static constexpr uint32_t TRANSFER_CYCLES = 4096; // t-cycles to shift out a byte at 8192 Hz
+
+	uint8_t readData() const
+	{
+		return m_data;
+	}
+
+	void writeData(uint8_t data)
+	{
+		m_data = data;
+	}
+
+	// unused bits read as 1
+	uint8_t readControl() const
+	{
+		return m_control | 0x7E;
+	}
+
+	void writeControl(uint8_t control);
+
+	/**
+	 * @brief Advance a transfer by one m-cycle and meet the other side of the link every quantum, see SerialLink.
+	 */
+	void tick(uint8_t &interruptFlags);
+
+	void reset();
+
+	/**
+	 * @brief Plug in a link cable, nullptr unplugs it. Without one a transfer on the internal clock reads 0xFF and one
+	 * on the external clock never finishes. The link is not owned and must outlive its use.
+	 */
+	void setLink(SerialLink *link);
+
+	/**
+	 * @brief Stop meeting the other side while frames are run again from a loaded state or run ahead, the link
+	 * counters are not part of the state and the other side already saw those frames. The port acts as unplugged until
+	 * the link is enabled again.
+	 */
+	void setLinkEnabled(bool enable)
+	{
+		m_linkEnabled = enable;
+	}
+
+	// save or load the registers and transfer progress, see Utils::StateWriter. The link is a connection, not state
+	template <typename Archive>
+	void serialize(Archive &archive)
+	{
+		archive(m_data, m_control, m_transferCycles);
+	}
+
+  private:
+	uint8_t  m_data           = 0;
+	uint8_t  m_control        = 0;
+	uint32_t m_transferCycles = 0; // t-cycles left of a transfer on the internal clock
+
+	SerialLink *m_link        = nullptr;
+	bool        m_linkEnabled = true;
+	uint64_t    m_linkCycles  = 0; // t-cycles the link was plugged in and enabled
+	uint64_t    m_nextBarrier = 0; // m_linkCycles of the next exchange with the other side
+
+	bool isLinked() const
+	{
+		return m_link && m_linkEnabled;
+	}
+
+	// a transfer on the internal clock shifted out every bit, the byte shifted in is settled at the next exchange
+	bool isTransferDone() const
+	{
+		return (m_control & (SC_TRANSFER_ENABLE | SC_INTERNAL_CLOCK)) == (SC_TRANSFER_ENABLE | SC_INTERNAL_CLOCK) && m_transferCycles == 0;
+	}
+
+	void exchange(uint8_t &interruptFlags);
+	void finishTransfer(uint8_t data, uint8_t &interruptFlags);
+};
@@ -9,6 +9,45 @@ Sm83::Sm83(Bus &bus)
 }
 
 void Sm83::instructionStep()
+{
+#ifdef BUDGETGB_PROFILER
+	if (m_profiler)
+	{
+		profiledInstructionStep();
+		return;
+	}
+#endif
+
+	executeInstruction();
+}
+
+#ifdef BUDGETGB_PROFILER
+void Sm83::profiledInstructionStep()
+{
+	const uint64_t startCycles = m_bus.getElapsedCycles();
+
+	if (m_isHalted)
+	{
+		executeInstruction();
+		m_profiler->recordHalt(static_cast<uint32_t>((m_bus.getElapsedCycles() - startCycles) / 4));
+		return;
+	}
+
+	// the bank is taken before the instruction runs, it may switch banks itself
+	const uint16_t address = m_programCounter;
+	const uint32_t bank    = m_bus.getRomBank(address);
+
+	uint16_t opcode = m_bus.busReadRaw(address);
+	if (opcode == 0xCB)
+		opcode = Profiler::CB_PREFIX | m_bus.busReadRaw(static_cast<uint16_t>(address + 1));
+
+	executeInstruction();
+
+	m_profiler->record(bank, address, opcode, static_cast<uint32_t>((m_bus.getElapsedCycles() - startCycles) / 4));
+}
+#endif
+
+void Sm83::executeInstruction()
 {
 	// normal execution when cpu is not halted from HALT instructions
 	if (!m_isHalted)
@@ -38,6 +77,7 @@ void Sm83::init(bool useBootrom)
 {
 	m_interrupts.reset();
 	m_timer.reset();
+	m_serial.reset();
 	m_isHalted           = false;
 	m_pcIncrementInhibit = false;
 
@@ -93,6 +133,34 @@ void Sm83::initWithoutBootrom()
 	m_bootRomDisable = 0xFF;
 }
 
+void Sm83::saveState(Utils::StateWriter &writer)
+{
+	serialize(writer);
+}
+
+void Sm83::loadState(Utils::StateReader &reader)
+{
+	serialize(reader);
+}
+
+template <typename Archive>
+void Sm83::serialize(Archive &archive)
+{
+	archive(m_bootRomDisable, m_programCounter, m_stackPointer);
+
+	// flags are bitfields, round trip them through their register value
+	uint8_t flags = m_registerAF.flags.getFlagsU8();
+	archive(m_registerAF.accumulator, flags);
+	m_registerAF.flags.setFlagsU8(flags);
+
+	archive(m_registerBC.hi, m_registerBC.lo, m_registerDE.hi, m_registerDE.lo, m_registerHL.hi, m_registerHL.lo);
+
+	archive(m_interrupts.m_interruptMasterEnable, m_interrupts.m_eiPending, m_interrupts.m_eiPendingElapsedInstructions);
+	archive(m_interrupts.m_interruptEnable, m_interrupts.m_interruptFlags);
+
+	archive(m_timer, m_serial, m_joypad, m_isHalted, m_pcIncrementInhibit);
+}
+
 void Sm83::handleInterrupt()
 {
 	if (m_interrupts.m_interruptMasterEnable)
@@ -146,6 +214,7 @@ void Sm83::handleInterrupt()
 			m_bus.cpuWrite(--m_stackPointer, static_cast<uint8_t>(m_programCounter));
 
 			m_programCounter = static_cast<uint16_t>(irqAddress);
+			profileCall();
 		}
 	}
 }
@@ -3522,6 +3591,7 @@ void Sm83::RET()
 
 	m_bus.tickM();
 	m_programCounter = (hi << 8) | lo;
+	profileReturn();
 }
 
 void Sm83::RET_CC(bool condition)
@@ -3579,6 +3649,7 @@ void Sm83::CALL_n16()
 	m_bus.cpuWrite(--m_stackPointer, static_cast<uint8_t>(m_programCounter));
 
 	m_programCounter = callAddress;
+	profileCall();
 }
 
 void Sm83::CALL_CC_n16(bool condition)
@@ -3594,6 +3665,7 @@ void Sm83::CALL_CC_n16(bool condition)
 		m_bus.cpuWrite(--m_stackPointer, static_cast<uint8_t>(m_programCounter));
 
 		m_programCounter = callAddress;
+		profileCall();
 	}
 }
 
@@ -3604,6 +3676,7 @@ void Sm83::RST(RstVector vec)
 	m_bus.cpuWrite(--m_stackPointer, static_cast<uint8_t>(m_programCounter));
 
 	m_programCounter = static_cast<uint16_t>(vec);
+	profileCall();
 }
 
 void Sm83::BIT_r8(BitSelect b, uint8_t dest)
@@ -8,6 +8,13 @@
 #include "opcodeLogger.h"
 #include "dmgBootrom.h"
 #include "joypad.h"
+#include "serial.h"
+#include "utils/stateArchive.h"
+
+#ifdef BUDGETGB_PROFILER
+#include "CallProfiler.h"
+#include "Profiler.h"
+#endif
 
 class Sm83
 {
@@ -146,6 +153,14 @@ class Sm83
 
 		void reset();
 
+		// save or load the timer including its internal edge detection state, see Utils::StateWriter
+		template <typename Archive>
+		void serialize(Archive &archive)
+		{
+			archive(m_divider, m_timerCounter, m_timerControl, m_timerModulo);
+			archive(m_timerCounterIsWritten, m_reloadScheduled, m_prevStateDivider, m_prevStateCounter);
+		}
+
 	  private:
 		bool m_timerCounterIsWritten = false; // true when timerCounter(TIMA) register is written to
 		bool m_reloadScheduled       = false; // true when timerCounter overflows from increment, meaning a reload and interrupt request is scheduled on the next m-cycle (next 4 t-cycles)
@@ -177,6 +192,7 @@ class Sm83
 
 	Sm83InterruptRegisters m_interrupts;
 	Sm83Timer              m_timer;
+	Serial                 m_serial;
 
 	bool m_logEnable = false;
 
@@ -186,11 +202,37 @@ class Sm83
 
 	void init(bool useBootrom);
 
+	/**
+	 * @brief Save or load registers, interrupts, timer, serial port and joypad, see BudgetGBCore::saveState().
+	 */
+	void saveState(Utils::StateWriter &writer);
+	void loadState(Utils::StateReader &reader);
+
 	/**
 	 * @brief Emulate cpu for a single instruction.
 	 */
 	void instructionStep();
 
+#ifdef BUDGETGB_PROFILER
+	/**
+	 * @brief Count every instruction that runs in profiler from here on, nullptr stops counting. Only builds with
+	 * BUDGETGB_PROFILER have a profiler hook in instructionStep().
+	 */
+	void setProfiler(Profiler *profiler)
+	{
+		m_profiler = profiler;
+	}
+
+	/**
+	 * @brief Report calls, rst, interrupt dispatch and returns to callProfiler from here on, nullptr stops reporting.
+	 * Reset the call profiler to the elapsed cycles of the bus first.
+	 */
+	void setCallProfiler(CallProfiler *callProfiler)
+	{
+		m_callProfiler = callProfiler;
+	}
+#endif
+
   private:
 	Bus &m_bus;
 
@@ -200,12 +242,43 @@ class Sm83
 	bool m_isHalted = false;
 	bool m_pcIncrementInhibit = false;
 
+#ifdef BUDGETGB_PROFILER
+	Profiler     *m_profiler     = nullptr;
+	CallProfiler *m_callProfiler = nullptr;
+
+	// instructionStep() while a profiler is set
+	void profiledInstructionStep();
+#endif
+
+	// a return address was pushed and the program counter set to the callee
+	void profileCall()
+	{
+#ifdef BUDGETGB_PROFILER
+		if (m_callProfiler)
+			m_callProfiler->call(m_bus.getRomBank(m_programCounter), m_programCounter, m_stackPointer, m_bus.getElapsedCycles() / 4);
+#endif
+	}
+
+	// a return address was popped, the cycles of the return go to the callee
+	void profileReturn()
+	{
+#ifdef BUDGETGB_PROFILER
+		if (m_callProfiler)
+			m_callProfiler->ret(static_cast<uint16_t>(m_stackPointer - 2), m_bus.getElapsedCycles() / 4);
+#endif
+	}
+
+	void executeInstruction();
+
 	void formatToOpcodeString(const std::string &format, uint16_t arg);
 	void formatToOpcodeString(const std::string &format);
 
 	void initWithBootrom();
 	void initWithoutBootrom();
 
+	template <typename Archive>
+	void serialize(Archive &archive);
+
 	/**
 	 * @brief Service any pending interrupt if the ime flag is set and the corresponding
 	 * interrupt enable flag is set.
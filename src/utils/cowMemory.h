@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "utils/hash.h"
+
+namespace Utils
+{
+
+/**
+ * @brief Byte array split into pages that copies share until one of them writes. Copying the array only copies page
+ * pointers, a write to a page that another copy still holds clones that page first. Copies may be used from different
+ * threads, a single copy from one thread at a time.
+ */
+class CowMemory
+{
+  public:
+	static constexpr std::size_t PAGE_SIZE = 512; // smallest cartridge ram, every larger size is a multiple of it
+
+	CowMemory() = default;
+
+	explicit CowMemory(std::size_t size)
+	{
+		resize(size);
+	}
+
+	// contents are zeroed
+	void resize(std::size_t size)
+	{
+		m_size = size;
+		m_pages.resize((size + PAGE_SIZE - 1) / PAGE_SIZE);
+
+		for (auto &page : m_pages)
+			page = std::make_shared<Page>();
+	}
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	uint8_t read(std::size_t position) const
+	{
+		return (*m_pages[position / PAGE_SIZE])[position % PAGE_SIZE];
+	}
+
+	void write(std::size_t position, uint8_t data)
+	{
+		getWritablePage(position / PAGE_SIZE)[position % PAGE_SIZE] = data;
+	}
+
+	// copy size() bytes out of or into the array
+	void copyTo(uint8_t *out) const
+	{
+		for (std::size_t page = 0; page < m_pages.size(); ++page)
+			std::memcpy(out + page * PAGE_SIZE, m_pages[page]->data(), getPageSize(page));
+	}
+
+	void copyFrom(const uint8_t *data)
+	{
+		for (std::size_t page = 0; page < m_pages.size(); ++page)
+			std::memcpy(getOverwrittenPage(page).data(), data + page * PAGE_SIZE, getPageSize(page));
+	}
+
+	// pages not shared with any other copy
+	std::size_t getUniquePageCount() const
+	{
+		return static_cast<std::size_t>(std::count_if(m_pages.begin(), m_pages.end(), [](const auto &page) { return page.use_count() == 1; }));
+	}
+
+	// hash64() of each page in turn, chained through the seed
+	uint64_t hash(uint64_t seed) const
+	{
+		for (std::size_t page = 0; page < m_pages.size(); ++page)
+			seed = hash64(m_pages[page]->data(), getPageSize(page), seed);
+
+		return seed;
+	}
+
+	// stored the same as a byte vector, see Utils::StateWriter
+	template <typename Archive>
+	void serialize(Archive &archive)
+	{
+		uint32_t size = static_cast<uint32_t>(m_size);
+		archive(size);
+
+		if constexpr (Archive::IS_LOADING)
+		{
+			// sized by the loaded cartridge, a length mismatch means the state belongs to another one
+			if (size != m_size)
+			{
+				archive.fail();
+				return;
+			}
+
+			for (std::size_t page = 0; page < m_pages.size(); ++page)
+				archive.readBytes(getOverwrittenPage(page).data(), getPageSize(page));
+		}
+		else
+		{
+			for (std::size_t page = 0; page < m_pages.size(); ++page)
+				archive.writeBytes(m_pages[page]->data(), getPageSize(page));
+		}
+	}
+
+  private:
+	typedef std::array<uint8_t, PAGE_SIZE> Page;
+
+	std::vector<std::shared_ptr<Page>> m_pages;
+	std::size_t                        m_size = 0;
+
+	std::size_t getPageSize(std::size_t page) const
+	{
+		return std::min(PAGE_SIZE, m_size - page * PAGE_SIZE);
+	}
+
+	Page &getWritablePage(std::size_t page)
+	{
+		std::shared_ptr<Page> &entry = m_pages[page];
+
+		if (entry.use_count() != 1)
+			entry = std::make_shared<Page>(*entry);
+		else
+			// the last other holder may have let go on another thread, make its reads of the page happen before our write
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+		return *entry;
+	}
+
+	// writable page whose old contents are about to be replaced entirely, a shared page is not copied
+	Page &getOverwrittenPage(std::size_t page)
+	{
+		std::shared_ptr<Page> &entry = m_pages[page];
+
+		if (entry.use_count() != 1)
+			entry = std::make_shared<Page>();
+		else
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+		return *entry;
+	}
+};
+
+} // namespace Utils
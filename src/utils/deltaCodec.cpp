@@ -0,0 +1,167 @@
+#include "deltaCodec.h"
+#include "simd.h"
+
+#include <cstring>
+
+#ifdef BUDGETGB_X86
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+constexpr std::size_t MIN_UNCHANGED_RUN = 8;  // shorter unchanged spans are folded into the literals, a run pair costs at least 2 bytes
+constexpr std::size_t MAX_VARINT_SIZE   = 10; // 7 bits per byte for a 64 bit count
+
+uint8_t *writeVarint(uint8_t *out, std::size_t value)
+{
+	while (value >= 0x80)
+	{
+		*out++ = static_cast<uint8_t>(value | 0x80);
+		value >>= 7;
+	}
+
+	*out++ = static_cast<uint8_t>(value);
+	return out;
+}
+
+bool readVarint(const uint8_t *&in, const uint8_t *end, std::size_t &value)
+{
+	value = 0;
+
+	for (unsigned int shift = 0; in != end && shift < 64; shift += 7)
+	{
+		const uint8_t byte = *in++;
+		value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+// index of the first byte at or after position where the buffers differ, size if there is none
+std::size_t findDifference(const uint8_t *a, const uint8_t *b, std::size_t position, std::size_t size)
+{
+#ifdef BUDGETGB_X86
+	for (; position + 16 <= size; position += 16)
+	{
+		const __m128i blockA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + position));
+		const __m128i blockB = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + position));
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(blockA, blockB)) != 0xFFFF)
+			break;
+	}
+#else
+	for (; position + 8 <= size; position += 8)
+	{
+		uint64_t wordA, wordB;
+		std::memcpy(&wordA, a + position, sizeof(wordA));
+		std::memcpy(&wordB, b + position, sizeof(wordB));
+
+		if (wordA != wordB)
+			break;
+	}
+#endif
+
+	// locate the differing byte inside the block
+	while (position < size && a[position] == b[position])
+		++position;
+
+	return position;
+}
+
+// index of the first run of MIN_UNCHANGED_RUN equal bytes at or after position, or a shorter run that reaches the end
+std::size_t findUnchangedRun(const uint8_t *a, const uint8_t *b, std::size_t position, std::size_t size)
+{
+	while (position < size)
+	{
+		if (a[position] != b[position])
+		{
+			++position;
+			continue;
+		}
+
+		std::size_t runEnd = position + 1;
+		while (runEnd < size && runEnd - position < MIN_UNCHANGED_RUN && a[runEnd] == b[runEnd])
+			++runEnd;
+
+		if (runEnd - position == MIN_UNCHANGED_RUN || runEnd == size)
+			return position;
+
+		position = runEnd;
+	}
+
+	return size;
+}
+
+void xorBytes(uint8_t *out, const uint8_t *a, const uint8_t *b, std::size_t size)
+{
+	std::size_t i = 0;
+
+#ifdef BUDGETGB_X86
+	for (; i + 16 <= size; i += 16)
+	{
+		const __m128i blockA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		const __m128i blockB = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_xor_si128(blockA, blockB));
+	}
+#endif
+
+	for (; i < size; ++i)
+		out[i] = a[i] ^ b[i];
+}
+} // namespace
+
+std::size_t Utils::getMaxXorDeltaSize(std::size_t size)
+{
+	// every run pair but the first and last holds at least one literal and MIN_UNCHANGED_RUN unchanged bytes
+	return size + (size / (MIN_UNCHANGED_RUN + 1) + 2) * 2 * MAX_VARINT_SIZE;
+}
+
+std::size_t Utils::encodeXorDelta(const uint8_t *current, const uint8_t *previous, std::size_t size, uint8_t *out)
+{
+	uint8_t    *write    = out;
+	std::size_t position = 0;
+
+	while (position < size)
+	{
+		const std::size_t literalStart = findDifference(current, previous, position, size);
+		const std::size_t literalEnd   = findUnchangedRun(current, previous, literalStart, size);
+
+		write = writeVarint(write, literalStart - position);
+		write = writeVarint(write, literalEnd - literalStart);
+
+		xorBytes(write, current + literalStart, previous + literalStart, literalEnd - literalStart);
+		write += literalEnd - literalStart;
+
+		position = literalEnd;
+	}
+
+	return static_cast<std::size_t>(write - out);
+}
+
+bool Utils::applyXorDelta(const uint8_t *delta, std::size_t deltaSize, uint8_t *buffer, std::size_t size)
+{
+	const uint8_t *read     = delta;
+	const uint8_t *end      = delta + deltaSize;
+	std::size_t    position = 0;
+
+	while (read != end)
+	{
+		std::size_t unchanged, literals;
+		if (!readVarint(read, end, unchanged) || !readVarint(read, end, literals))
+			return false;
+
+		if (unchanged > size - position || literals > size - position - unchanged || literals > static_cast<std::size_t>(end - read))
+			return false;
+
+		position += unchanged;
+
+		xorBytes(buffer + position, buffer + position, read, literals);
+		position += literals;
+		read += literals;
+	}
+
+	return position == size;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Utils
+{
+
+/**
+ * @brief Worst case encoded size of a delta between two buffers of size bytes.
+ */
+std::size_t getMaxXorDeltaSize(std::size_t size);
+
+/**
+ * @brief Encode the xor of two equal sized buffers as alternating runs of unchanged bytes and xored literal bytes.
+ * Each run pair is a varint count of unchanged bytes, a varint count of literals and the literals themselves.
+ * Unchanged spans are skipped 16 bytes at a time with SSE2 on x86.
+ * @param out Must hold at least getMaxXorDeltaSize(size) bytes.
+ * @return Number of bytes written to out.
+ */
+std::size_t encodeXorDelta(const uint8_t *current, const uint8_t *previous, std::size_t size, uint8_t *out);
+
+/**
+ * @brief Xor an encoded delta into buffer in place. Applying the delta of two buffers to either one produces the other.
+ * @return True on success, false if the delta is malformed or does not match size.
+ */
+bool applyXorDelta(const uint8_t *delta, std::size_t deltaSize, uint8_t *buffer, std::size_t size);
+
+} // namespace Utils
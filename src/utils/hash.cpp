@@ -0,0 +1,105 @@
+#include "hash.h"
+
+#include <cstring>
+
+namespace
+{
+constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87;
+constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4F;
+constexpr uint64_t PRIME_3 = 0x165667B19E3779F9;
+constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63;
+constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5;
+
+inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t read64(const uint8_t *data)
+{
+	uint64_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+inline uint32_t read32(const uint8_t *data)
+{
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+inline uint64_t round(uint64_t accumulator, uint64_t input)
+{
+	accumulator += input * PRIME_2;
+	accumulator = rotateLeft(accumulator, 31);
+	return accumulator * PRIME_1;
+}
+
+inline uint64_t mergeRound(uint64_t hash, uint64_t accumulator)
+{
+	hash ^= round(0, accumulator);
+	return hash * PRIME_1 + PRIME_4;
+}
+} // namespace
+
+uint64_t Utils::hash64(const void *data, std::size_t size, uint64_t seed)
+{
+	const uint8_t *read = static_cast<const uint8_t *>(data);
+	const uint8_t *end  = read + size;
+	uint64_t       hash;
+
+	if (size >= 32)
+	{
+		uint64_t lane1 = seed + PRIME_1 + PRIME_2;
+		uint64_t lane2 = seed + PRIME_2;
+		uint64_t lane3 = seed;
+		uint64_t lane4 = seed - PRIME_1;
+
+		for (; read + 32 <= end; read += 32)
+		{
+			lane1 = round(lane1, read64(read));
+			lane2 = round(lane2, read64(read + 8));
+			lane3 = round(lane3, read64(read + 16));
+			lane4 = round(lane4, read64(read + 24));
+		}
+
+		hash = rotateLeft(lane1, 1) + rotateLeft(lane2, 7) + rotateLeft(lane3, 12) + rotateLeft(lane4, 18);
+		hash = mergeRound(hash, lane1);
+		hash = mergeRound(hash, lane2);
+		hash = mergeRound(hash, lane3);
+		hash = mergeRound(hash, lane4);
+	}
+	else
+		hash = seed + PRIME_5;
+
+	hash += size;
+
+	for (; read + 8 <= end; read += 8)
+	{
+		hash ^= round(0, read64(read));
+		hash = rotateLeft(hash, 27) * PRIME_1 + PRIME_4;
+	}
+
+	if (read + 4 <= end)
+	{
+		hash ^= read32(read) * PRIME_1;
+		hash = rotateLeft(hash, 23) * PRIME_2 + PRIME_3;
+		read += 4;
+	}
+
+	for (; read < end; ++read)
+	{
+		hash ^= *read * PRIME_5;
+		hash = rotateLeft(hash, 11) * PRIME_1;
+	}
+
+	// avalanche
+	hash ^= hash >> 33;
+	hash *= PRIME_2;
+	hash ^= hash >> 29;
+	hash *= PRIME_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Utils
+{
+
+/**
+ * @brief 64-bit non cryptographic hash of a byte buffer, produces the same values as XXH64. Input is consumed as four
+ * independent 64-bit lanes so the multiplies of a 32 byte stripe overlap.
+ */
+uint64_t hash64(const void *data, std::size_t size, uint64_t seed = 0);
+
+} // namespace Utils
@@ -0,0 +1,104 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Utils::MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool Utils::MappedFile::open(const std::string &path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+
+	if (!m_mapping)
+		return false;
+
+	m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+
+	m_size = static_cast<std::size_t>(size.QuadPart);
+	return true;
+}
+
+void Utils::MappedFile::close()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+
+	if (m_mapping)
+		CloseHandle(m_mapping);
+
+	m_data    = nullptr;
+	m_mapping = nullptr;
+	m_size    = 0;
+}
+
+#else
+
+bool Utils::MappedFile::open(const std::string &path)
+{
+	close();
+
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat status{};
+	if (fstat(file, &status) != 0 || status.st_size <= 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	// the mapping keeps its own reference to the file
+	void *data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<const uint8_t *>(data);
+	m_size = static_cast<std::size_t>(status.st_size);
+	return true;
+}
+
+void Utils::MappedFile::close()
+{
+	if (m_data)
+		munmap(const_cast<uint8_t *>(m_data), m_size);
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Utils
+{
+
+/**
+ * @brief Read only memory map of a whole file. Nothing is read up front, pages come in from disk as they are first
+ * touched.
+ */
+class MappedFile
+{
+  public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile &)            = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	/**
+	 * @brief Map a file, unmapping the previous one.
+	 * @return True on success, false if the file is missing, empty or can not be mapped.
+	 */
+	bool open(const std::string &path);
+	void close();
+
+	const uint8_t *data() const
+	{
+		return m_data;
+	}
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	bool isOpen() const
+	{
+		return m_data != nullptr;
+	}
+
+  private:
+	const uint8_t *m_data = nullptr;
+	std::size_t    m_size = 0;
+
+#ifdef _WIN32
+	void *m_mapping = nullptr; // HANDLE of the file mapping object, the file handle is closed once it is mapped
+#endif
+};
+
+} // namespace Utils
@@ -87,6 +87,13 @@ class PPUArray
 		auto dist = std::distance(m_array.begin() + m_head, newEnd);
 		m_tail -= static_cast<uint32_t>(length() - dist);
 	}
+
+	// save or load the array contents along with the head and tail positions, see Utils::StateWriter
+	template <typename Archive>
+	void serialize(Archive &archive)
+	{
+		archive(m_array, m_head, m_tail);
+	}
 };
 
 } // namespace Utils
\ No newline at end of file
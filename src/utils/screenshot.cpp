@@ -0,0 +1,37 @@
+#include "screenshot.h"
+
+#include "fmt/base.h"
+#include "fmt/format.h"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+bool Utils::writeScreenshot(const std::string &path, const BudgetGbConstants::LcdColorBuffer &colorBuffer, const std::array<std::array<float, 3>, 4> &palette)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		fmt::println(stderr, "Failed to open screenshot at: {}", path);
+		return false;
+	}
+
+	std::array<std::array<uint8_t, 3>, 4> colors;
+	for (std::size_t i = 0; i < colors.size(); ++i)
+	{
+		for (std::size_t channel = 0; channel < 3; ++channel)
+			colors[i][channel] = static_cast<uint8_t>(palette[i][channel] * 255.0f + 0.5f);
+	}
+
+	std::vector<uint8_t> pixels;
+	pixels.reserve(colorBuffer.size() * 3);
+
+	for (uint8_t colorIndex : colorBuffer)
+		pixels.insert(pixels.end(), colors[colorIndex & 0x3].begin(), colors[colorIndex & 0x3].end());
+
+	const std::string header = fmt::format("P6\n{} {}\n255\n", BudgetGbConstants::LCD_WIDTH, BudgetGbConstants::LCD_HEIGHT);
+	file.write(header.data(), static_cast<std::streamsize>(header.size()));
+	file.write(reinterpret_cast<const char *>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+
+	return file.good();
+}
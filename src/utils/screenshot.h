@@ -0,0 +1,18 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "emulatorConstants.h"
+
+namespace Utils
+{
+
+/**
+ * @brief Write a frame of color indices as a binary ppm image, readable by most image tools without any library.
+ * @param palette Rgb of each color index in the range (0.0f - 1.0f).
+ * @return True on success, false otherwise.
+ */
+bool writeScreenshot(const std::string &path, const BudgetGbConstants::LcdColorBuffer &colorBuffer, const std::array<std::array<float, 3>, 4> &palette);
+
+} // namespace Utils
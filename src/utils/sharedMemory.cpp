@@ -0,0 +1,154 @@
+#include "sharedMemory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Utils::SharedMemory::~SharedMemory()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool Utils::SharedMemory::create(const std::string &name, std::size_t size)
+{
+	close();
+
+	const uint64_t mappingSize = size;
+	m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize), ("Local\\" + name).c_str());
+
+	if (!m_mapping)
+		return false;
+
+	m_data = static_cast<uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+
+	// page file backed mappings are zero filled, they go away with the last handle so there is no name to remove
+	m_size = size;
+	return true;
+}
+
+bool Utils::SharedMemory::open(const std::string &name)
+{
+	close();
+
+	m_mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, ("Local\\" + name).c_str());
+	if (!m_mapping)
+		return false;
+
+	m_data = static_cast<uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+
+	MEMORY_BASIC_INFORMATION info{};
+	VirtualQuery(m_data, &info, sizeof(info));
+	m_size = info.RegionSize;
+	return true;
+}
+
+void Utils::SharedMemory::close()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+
+	if (m_mapping)
+		CloseHandle(m_mapping);
+
+	m_data    = nullptr;
+	m_mapping = nullptr;
+	m_size    = 0;
+}
+
+#else
+
+bool Utils::SharedMemory::create(const std::string &name, std::size_t size)
+{
+	close();
+
+	const std::string path = "/" + name;
+	shm_unlink(path.c_str());
+
+	int file = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (file < 0)
+		return false;
+
+	if (ftruncate(file, static_cast<off_t>(size)) != 0)
+	{
+		::close(file);
+		shm_unlink(path.c_str());
+		return false;
+	}
+
+	void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	::close(file);
+
+	if (data == MAP_FAILED)
+	{
+		shm_unlink(path.c_str());
+		return false;
+	}
+
+	m_data  = static_cast<uint8_t *>(data);
+	m_size  = size;
+	m_owner = true;
+	m_name  = path;
+	return true;
+}
+
+bool Utils::SharedMemory::open(const std::string &name)
+{
+	close();
+
+	int file = shm_open(("/" + name).c_str(), O_RDWR, 0);
+	if (file < 0)
+		return false;
+
+	struct stat status{};
+	if (fstat(file, &status) != 0 || status.st_size <= 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	void *data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	::close(file);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<uint8_t *>(data);
+	m_size = static_cast<std::size_t>(status.st_size);
+	return true;
+}
+
+void Utils::SharedMemory::close()
+{
+	if (m_data)
+		munmap(m_data, m_size);
+
+	// consumers keep their mappings, only the name goes away
+	if (m_owner)
+		shm_unlink(m_name.c_str());
+
+	m_data  = nullptr;
+	m_size  = 0;
+	m_owner = false;
+	m_name.clear();
+}
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Utils
+{
+
+/**
+ * @brief Named memory segment shared between processes, a POSIX shared memory object or a Windows file mapping backed
+ * by the page file. The process that creates a segment owns its name and removes it on close.
+ */
+class SharedMemory
+{
+  public:
+	SharedMemory() = default;
+	~SharedMemory();
+
+	SharedMemory(const SharedMemory &)            = delete;
+	SharedMemory &operator=(const SharedMemory &) = delete;
+
+	/**
+	 * @brief Create a zero filled segment, replacing a stale one left behind under the same name.
+	 * @param name Segment name without a leading slash.
+	 * @return True on success, false otherwise.
+	 */
+	bool create(const std::string &name, std::size_t size);
+
+	/**
+	 * @brief Map a segment created by another process, read and write.
+	 * @return True on success, false if there is no segment with that name.
+	 */
+	bool open(const std::string &name);
+	void close();
+
+	uint8_t *data() const
+	{
+		return m_data;
+	}
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	bool isOpen() const
+	{
+		return m_data != nullptr;
+	}
+
+  private:
+	uint8_t    *m_data  = nullptr;
+	std::size_t m_size  = 0;
+	bool        m_owner = false;
+	std::string m_name;
+
+#ifdef _WIN32
+	void *m_mapping = nullptr; // HANDLE of the file mapping object
+#endif
+};
+
+} // namespace Utils
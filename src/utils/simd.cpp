@@ -0,0 +1,253 @@
+#include "simd.h"
+
+#include <cstring>
+
+#ifdef BUDGETGB_X86
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// gcc and clang only emit avx2 instructions inside functions marked with a target attribute, msvc emits any intrinsic
+#if defined(BUDGETGB_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace
+{
+float dotProductScalar(const float *a, const float *b, std::size_t size)
+{
+	// 4 separate sums to break the dependency chain, lets compilers vectorize on targets without a hand written kernel
+	float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+
+	for (std::size_t i = 0; i < size; i += 4)
+	{
+		sum0 += a[i + 0] * b[i + 0];
+		sum1 += a[i + 1] * b[i + 1];
+		sum2 += a[i + 2] * b[i + 2];
+		sum3 += a[i + 3] * b[i + 3];
+	}
+
+	return (sum0 + sum1) + (sum2 + sum3);
+}
+
+void downsampleScalar(const uint8_t *colorIndices, uint32_t width, uint32_t height, uint32_t factor, const uint8_t shades[4], uint8_t *out)
+{
+	const uint32_t blockSize = factor * factor;
+
+	for (uint32_t y = 0; y < height; y += factor)
+	{
+		for (uint32_t x = 0; x < width; x += factor)
+		{
+			uint32_t sum = 0;
+			for (uint32_t row = 0; row < factor; ++row)
+			{
+				for (uint32_t column = 0; column < factor; ++column)
+					sum += shades[colorIndices[(y + row) * width + x + column] & 0x3];
+			}
+
+			*out++ = static_cast<uint8_t>((sum + blockSize / 2) / blockSize);
+		}
+	}
+}
+
+#ifdef BUDGETGB_X86
+
+float dotProductSSE2(const float *a, const float *b, std::size_t size)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+
+	for (std::size_t i = 0; i < size; i += 8)
+	{
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+
+	__m128 sum = _mm_add_ps(sum0, sum1);
+	sum        = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum        = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+
+	return _mm_cvtss_f32(sum);
+}
+
+TARGET_AVX2 float dotProductAVX2(const float *a, const float *b, std::size_t size)
+{
+	__m256 sum0 = _mm256_setzero_ps();
+	__m256 sum1 = _mm256_setzero_ps();
+
+	std::size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+		sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+	}
+
+	if (i < size)
+		sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+
+	__m256 sum256 = _mm256_add_ps(sum0, sum1);
+	__m128 sum    = _mm_add_ps(_mm256_castps256_ps128(sum256), _mm256_extractf128_ps(sum256, 1));
+	sum           = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum           = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+
+	return _mm_cvtss_f32(sum);
+}
+
+// 16 color indices to their shades, sse2 has no byte shuffle so each of the 4 shades is selected with a compare
+inline __m128i shadeSSE2(__m128i indices, const __m128i shades[4])
+{
+	indices = _mm_and_si128(indices, _mm_set1_epi8(0x3));
+
+	__m128i result = _mm_and_si128(_mm_cmpeq_epi8(indices, _mm_setzero_si128()), shades[0]);
+	result         = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi8(indices, _mm_set1_epi8(1)), shades[1]));
+	result         = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi8(indices, _mm_set1_epi8(2)), shades[2]));
+	result         = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi8(indices, _mm_set1_epi8(3)), shades[3]));
+
+	return result;
+}
+
+void downsampleSSE2(const uint8_t *colorIndices, uint32_t width, uint32_t height, uint32_t factor, const uint8_t shades[4], uint8_t *out)
+{
+	const __m128i shadeVectors[4] = {
+		_mm_set1_epi8(static_cast<char>(shades[0])),
+		_mm_set1_epi8(static_cast<char>(shades[1])),
+		_mm_set1_epi8(static_cast<char>(shades[2])),
+		_mm_set1_epi8(static_cast<char>(shades[3])),
+	};
+
+	if (factor == 1)
+	{
+		for (uint32_t i = 0; i < width * height; i += 16)
+		{
+			__m128i shaded = shadeSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(colorIndices + i)), shadeVectors);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), shaded);
+		}
+
+		return;
+	}
+
+	const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+
+	for (uint32_t y = 0; y < height; y += factor)
+	{
+		for (uint32_t x = 0; x < width; x += 16)
+		{
+			// sums of horizontal pairs in 16 bit lanes, accumulated over the rows of the block
+			__m128i pairSums = _mm_setzero_si128();
+
+			for (uint32_t row = 0; row < factor; ++row)
+			{
+				__m128i shaded = shadeSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(colorIndices + (y + row) * width + x)), shadeVectors);
+				pairSums       = _mm_add_epi16(pairSums, _mm_add_epi16(_mm_and_si128(shaded, lowBytes), _mm_srli_epi16(shaded, 8)));
+			}
+
+			if (factor == 2)
+			{
+				__m128i means = _mm_srli_epi16(_mm_add_epi16(pairSums, _mm_set1_epi16(2)), 2);
+				_mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(means, means));
+				out += 8;
+			}
+			else
+			{
+				__m128i quadSums = _mm_madd_epi16(pairSums, _mm_set1_epi16(1));
+				__m128i means    = _mm_srli_epi32(_mm_add_epi32(quadSums, _mm_set1_epi32(8)), 4);
+				means            = _mm_packs_epi32(means, means);
+				means            = _mm_packus_epi16(means, means);
+
+				const int packed = _mm_cvtsi128_si32(means);
+				std::memcpy(out, &packed, 4);
+				out += 4;
+			}
+		}
+	}
+}
+
+#endif
+} // namespace
+
+Utils::SimdLevel Utils::detectSimdLevel()
+{
+#if defined(BUDGETGB_X86) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return SimdLevel::AVX2;
+
+	return SimdLevel::SSE2;
+#elif defined(BUDGETGB_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	bool fma = false, avx2 = false, osxsave = false;
+	if (maxLeaf >= 1)
+	{
+		__cpuid(info, 1);
+		fma     = (info[2] & (1 << 12)) != 0;
+		osxsave = (info[2] & (1 << 27)) != 0;
+	}
+
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	// os must save ymm registers on context switch
+	if (fma && avx2 && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+		return SimdLevel::AVX2;
+
+	return SimdLevel::SSE2;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+const char *Utils::getSimdLevelString(SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::SSE2:
+		return "SSE2";
+	case SimdLevel::AVX2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+Utils::DotProductFn Utils::getDotProduct(SimdLevel level)
+{
+#ifdef BUDGETGB_X86
+	switch (level)
+	{
+	case SimdLevel::AVX2:
+		return dotProductAVX2;
+	case SimdLevel::SSE2:
+		return dotProductSSE2;
+	default:
+		return dotProductScalar;
+	}
+#else
+	(void)level;
+	return dotProductScalar;
+#endif
+}
+
+Utils::DownsampleFn Utils::getDownsample(SimdLevel level)
+{
+#ifdef BUDGETGB_X86
+	// sse2 is the baseline of x86_64, the kernel is memory bound so avx2 would not be any faster
+	if (level != SimdLevel::Scalar)
+		return downsampleSSE2;
+
+	return downsampleScalar;
+#else
+	(void)level;
+	return downsampleScalar;
+#endif
+}
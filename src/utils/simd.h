@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BUDGETGB_X86 1
+#endif
+
+namespace Utils
+{
+
+enum class SimdLevel
+{
+	Scalar,
+	SSE2,
+	AVX2, // implies FMA
+};
+
+/**
+ * @brief Detect the widest instruction set supported by the running cpu. Non x86 targets always report scalar.
+ */
+SimdLevel detectSimdLevel();
+
+const char *getSimdLevelString(SimdLevel level);
+
+// dot product of two float arrays, size must be a multiple of 8
+typedef float (*DotProductFn)(const float *a, const float *b, std::size_t size);
+
+/**
+ * @brief Get a dot product kernel for an instruction set, falls back to narrower kernels if the level is not compiled in.
+ */
+DotProductFn getDotProduct(SimdLevel level);
+
+/**
+ * @brief Map a frame of 2 bit color indices through shades and shrink it by factor in both directions, each output
+ * byte is the rounded mean of a factor * factor block. Width must be a multiple of 16, factor is 1, 2 or 4 and divides
+ * both dimensions.
+ */
+typedef void (*DownsampleFn)(const uint8_t *colorIndices, uint32_t width, uint32_t height, uint32_t factor, const uint8_t shades[4], uint8_t *out);
+
+DownsampleFn getDownsample(SimdLevel level);
+
+} // namespace Utils
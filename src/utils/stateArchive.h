@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Utils
+{
+
+namespace Detail
+{
+template <typename T, typename Archive, typename = void>
+struct HasSerialize : std::false_type
+{
+};
+
+template <typename T, typename Archive>
+struct HasSerialize<T, Archive, std::void_t<decltype(std::declval<T &>().serialize(std::declval<Archive &>()))>> : std::true_type
+{
+};
+} // namespace Detail
+
+/**
+ * @brief Appends values to a byte buffer in the order they are passed in. Types with a serialize(Archive &) member
+ * are recursed into, byte vectors are stored with their length and everything else is copied as raw bytes.
+ *
+ * Structs are copied with their padding, list the fields of structs that have padding individually so the stream is
+ * deterministic. The buffer keeps its capacity between begin() calls, saving the same machine again does not
+ * allocate.
+ */
+class StateWriter
+{
+  public:
+	static constexpr bool IS_LOADING = false;
+
+	void begin()
+	{
+		m_buffer.clear();
+	}
+
+	template <typename... Ts>
+	void operator()(Ts &...values)
+	{
+		(write(values), ...);
+	}
+
+	void writeBytes(const void *data, std::size_t size)
+	{
+		const uint8_t *bytes = static_cast<const uint8_t *>(data);
+		m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+	}
+
+	/**
+	 * @brief Overwrite a value that was written earlier, used to fill in sizes once they are known.
+	 */
+	template <typename T>
+	void overwrite(std::size_t offset, const T &value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		std::memcpy(&m_buffer[offset], &value, sizeof(T));
+	}
+
+	std::size_t getSize() const
+	{
+		return m_buffer.size();
+	}
+
+	const std::vector<uint8_t> &getBuffer() const
+	{
+		return m_buffer;
+	}
+
+  private:
+	std::vector<uint8_t> m_buffer;
+
+	template <typename T>
+	void write(T &value)
+	{
+		if constexpr (Detail::HasSerialize<T, StateWriter>::value)
+		{
+			value.serialize(*this);
+		}
+		else if constexpr (std::is_same_v<T, std::vector<uint8_t>>)
+		{
+			uint32_t size = static_cast<uint32_t>(value.size());
+			writeBytes(&size, sizeof(size));
+			writeBytes(value.data(), value.size());
+		}
+		else
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "State values must be trivially copyable or have a serialize member");
+			writeBytes(&value, sizeof(T));
+		}
+	}
+};
+
+/**
+ * @brief Reads values back in the order a StateWriter wrote them. Reads past the end of the data or into a byte
+ * vector of a different length fail the reader, check isOk() once everything is read.
+ */
+class StateReader
+{
+  public:
+	static constexpr bool IS_LOADING = true;
+
+	StateReader(const uint8_t *data, std::size_t size)
+		: m_data(data),
+		  m_size(size)
+	{
+	}
+
+	template <typename... Ts>
+	void operator()(Ts &...values)
+	{
+		(read(values), ...);
+	}
+
+	bool readBytes(void *data, std::size_t size)
+	{
+		if (!m_ok || size > m_size - m_position)
+			return m_ok = false;
+
+		std::memcpy(data, m_data + m_position, size);
+		m_position += size;
+		return true;
+	}
+
+	bool isOk() const
+	{
+		return m_ok;
+	}
+
+	// mark data that was read successfully as not matching what is being loaded
+	void fail()
+	{
+		m_ok = false;
+	}
+
+	std::size_t getRemaining() const
+	{
+		return m_size - m_position;
+	}
+
+  private:
+	const uint8_t *m_data     = nullptr;
+	std::size_t    m_size     = 0;
+	std::size_t    m_position = 0;
+	bool           m_ok       = true;
+
+	template <typename T>
+	void read(T &value)
+	{
+		if constexpr (Detail::HasSerialize<T, StateReader>::value)
+		{
+			value.serialize(*this);
+		}
+		else if constexpr (std::is_same_v<T, std::vector<uint8_t>>)
+		{
+			// vectors are sized by the loaded cartridge, a length mismatch means the state belongs to another one
+			uint32_t size = 0;
+			if (readBytes(&size, sizeof(size)) && size != value.size())
+				m_ok = false;
+
+			readBytes(value.data(), value.size());
+		}
+		else
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "State values must be trivially copyable or have a serialize member");
+			readBytes(&value, sizeof(T));
+		}
+	}
+};
+
+} // namespace Utils
@@ -0,0 +1,280 @@
+#include "tcpSocket.h"
+#include "fmt/base.h"
+
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+typedef int    SocketLength;
+
+bool startupSockets()
+{
+	// winsock is started once for the lifetime of the process
+	static const bool started = []() {
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+
+	return started;
+}
+
+void closeSocket(intptr_t socket)
+{
+	closesocket(static_cast<SocketHandle>(socket));
+}
+
+bool setNonBlocking(intptr_t socket)
+{
+	u_long nonBlocking = 1;
+	return ioctlsocket(static_cast<SocketHandle>(socket), FIONBIO, &nonBlocking) == 0;
+}
+
+bool isWouldBlock()
+{
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+#else
+typedef int       SocketHandle;
+typedef socklen_t SocketLength;
+
+bool startupSockets()
+{
+	return true;
+}
+
+void closeSocket(intptr_t socket)
+{
+	::close(static_cast<SocketHandle>(socket));
+}
+
+bool setNonBlocking(intptr_t socket)
+{
+	const int flags = fcntl(static_cast<SocketHandle>(socket), F_GETFL, 0);
+	return flags != -1 && fcntl(static_cast<SocketHandle>(socket), F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool isWouldBlock()
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+#endif
+
+// small request and reply packets go out right away instead of waiting to be coalesced
+void setNoDelay(intptr_t socket)
+{
+	int noDelay = 1;
+	setsockopt(static_cast<SocketHandle>(socket), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay), sizeof(noDelay));
+}
+
+intptr_t createSocket()
+{
+	if (!startupSockets())
+	{
+		fmt::println(stderr, "Failed to initialize sockets!");
+		return -1;
+	}
+
+	const SocketHandle handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#ifdef _WIN32
+	if (handle == INVALID_SOCKET)
+#else
+	if (handle < 0)
+#endif
+	{
+		fmt::println(stderr, "Failed to create tcp socket!");
+		return -1;
+	}
+
+	return static_cast<intptr_t>(handle);
+}
+} // namespace
+
+Utils::TcpSocket::~TcpSocket()
+{
+	close();
+}
+
+bool Utils::TcpSocket::listen(uint16_t port)
+{
+	close();
+
+	m_socket = createSocket();
+	if (!isOpen())
+		return false;
+
+	// a port left in TIME_WAIT by the last run can be listened on again right away
+	int reuse = 1;
+	setsockopt(static_cast<SocketHandle>(m_socket), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&reuse), sizeof(reuse));
+
+	sockaddr_in address{};
+	address.sin_family      = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port        = htons(port);
+
+	if (bind(static_cast<SocketHandle>(m_socket), reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+	    ::listen(static_cast<SocketHandle>(m_socket), 1) != 0 || !setNonBlocking(m_socket))
+	{
+		fmt::println(stderr, "Failed to listen on tcp port {}", port);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool Utils::TcpSocket::accept(TcpSocket &connection)
+{
+	if (!isOpen())
+		return false;
+
+	const SocketHandle handle = ::accept(static_cast<SocketHandle>(m_socket), nullptr, nullptr);
+#ifdef _WIN32
+	if (handle == INVALID_SOCKET)
+#else
+	if (handle < 0)
+#endif
+		return false;
+
+	connection.close();
+	connection.m_socket = static_cast<intptr_t>(handle);
+
+	if (!setNonBlocking(connection.m_socket))
+	{
+		connection.close();
+		return false;
+	}
+
+	setNoDelay(connection.m_socket);
+	return true;
+}
+
+bool Utils::TcpSocket::connect(const std::string &address, uint16_t port)
+{
+	close();
+
+	m_socket = createSocket();
+	if (!isOpen())
+		return false;
+
+	addrinfo hints{};
+	hints.ai_family   = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo *result = nullptr;
+	if (getaddrinfo(address.c_str(), nullptr, &hints, &result) != 0 || result == nullptr)
+	{
+		fmt::println(stderr, "Failed to resolve address: {}", address);
+		close();
+		return false;
+	}
+
+	sockaddr_in peer = *reinterpret_cast<const sockaddr_in *>(result->ai_addr);
+	peer.sin_port    = htons(port);
+	freeaddrinfo(result);
+
+	if (::connect(static_cast<SocketHandle>(m_socket), reinterpret_cast<const sockaddr *>(&peer), sizeof(peer)) != 0 || !setNonBlocking(m_socket))
+	{
+		fmt::println(stderr, "Failed to connect to {}:{}", address, port);
+		close();
+		return false;
+	}
+
+	setNoDelay(m_socket);
+	return true;
+}
+
+void Utils::TcpSocket::close()
+{
+	if (isOpen())
+		closeSocket(m_socket);
+
+	m_socket = -1;
+}
+
+bool Utils::TcpSocket::send(const void *data, std::size_t size)
+{
+	const char *bytes = static_cast<const char *>(data);
+
+	while (size > 0 && isOpen())
+	{
+		const auto sent = ::send(static_cast<SocketHandle>(m_socket), bytes, static_cast<int>(size), 0);
+
+		if (sent > 0)
+		{
+			bytes += sent;
+			size -= static_cast<std::size_t>(sent);
+		}
+		else if (sent < 0 && isWouldBlock())
+			std::this_thread::yield();
+		else
+			close();
+	}
+
+	return size == 0;
+}
+
+std::size_t Utils::TcpSocket::receive(void *buffer, std::size_t capacity)
+{
+	if (!isOpen())
+		return 0;
+
+	const auto received = recv(static_cast<SocketHandle>(m_socket), static_cast<char *>(buffer), static_cast<int>(capacity), 0);
+
+	if (received > 0)
+		return static_cast<std::size_t>(received);
+
+	// 0 is an orderly hang up
+	if (received == 0 || !isWouldBlock())
+		close();
+
+	return 0;
+}
+
+bool Utils::TcpSocket::waitReadable(uint32_t timeoutMs)
+{
+	if (!isOpen())
+		return false;
+
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(static_cast<SocketHandle>(m_socket), &readable);
+
+	timeval timeout{};
+	timeout.tv_sec  = static_cast<long>(timeoutMs / 1000);
+	timeout.tv_usec = static_cast<long>(timeoutMs % 1000) * 1000;
+
+	return select(static_cast<int>(m_socket + 1), &readable, nullptr, nullptr, &timeout) > 0;
+}
+
+uint16_t Utils::TcpSocket::getLocalPort() const
+{
+	sockaddr_in  address{};
+	SocketLength addressLength = sizeof(address);
+
+	if (!isOpen() || getsockname(static_cast<SocketHandle>(m_socket), reinterpret_cast<sockaddr *>(&address), &addressLength) != 0)
+		return 0;
+
+	return ntohs(address.sin_port);
+}
+
+bool Utils::TcpSocket::isOpen() const
+{
+	return m_socket != -1;
+}
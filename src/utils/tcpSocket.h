@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Utils
+{
+
+/**
+ * @brief Non blocking ipv4 tcp socket, either listening on the loopback interface for local tools or connected to a
+ * single peer.
+ */
+class TcpSocket
+{
+  public:
+	TcpSocket() = default;
+	~TcpSocket();
+
+	TcpSocket(const TcpSocket &)            = delete;
+	TcpSocket &operator=(const TcpSocket &) = delete;
+
+	/**
+	 * @brief Listen on 127.0.0.1 only, nothing off this machine can connect.
+	 * @param port Local port, 0 picks a free one, see getLocalPort().
+	 * @return True on success, false otherwise.
+	 */
+	bool listen(uint16_t port);
+
+	/**
+	 * @brief Take a pending connection off a listening socket.
+	 * @return True if connection now holds one, false if none is pending.
+	 */
+	bool accept(TcpSocket &connection);
+
+	/**
+	 * @brief Connect to a listening socket, waits until connected.
+	 * @param address Dotted ipv4 address or host name.
+	 * @return True on success, false otherwise.
+	 */
+	bool connect(const std::string &address, uint16_t port);
+
+	void close();
+
+	// send all of data, waits while the send buffer is full. Closes the socket if the peer is gone
+	bool send(const void *data, std::size_t size);
+
+	/**
+	 * @brief Read bytes that arrived from the peer. Closes the socket once the peer hung up.
+	 * @return Number of bytes read, 0 if none are pending.
+	 */
+	std::size_t receive(void *buffer, std::size_t capacity);
+
+	/**
+	 * @brief Wait for bytes or a connection to arrive.
+	 * @return True if there is something to receive or accept.
+	 */
+	bool waitReadable(uint32_t timeoutMs);
+
+	uint16_t getLocalPort() const;
+
+	bool isOpen() const;
+
+  private:
+	// SOCKET on windows, file descriptor elsewhere
+	intptr_t m_socket = -1;
+};
+
+} // namespace Utils
@@ -0,0 +1,67 @@
+#include "threadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+Utils::ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (uint32_t i = 0; i < threadCount; ++i)
+		m_threads.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+Utils::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_taskAvailable.notify_all();
+
+	for (auto &thread : m_threads)
+		thread.join();
+}
+
+void Utils::ThreadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+
+	m_taskAvailable.notify_one();
+}
+
+void Utils::ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_tasksDone.wait(lock, [this]() { return m_tasks.empty() && m_runningTasks == 0; });
+}
+
+void Utils::ThreadPool::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_taskAvailable.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+		// queued tasks still run when stopping, the destructor promises they finish
+		if (m_tasks.empty())
+			return;
+
+		std::function<void()> task = std::move(m_tasks.front());
+		m_tasks.pop_front();
+		++m_runningTasks;
+
+		lock.unlock();
+		task();
+		lock.lock();
+
+		if (--m_runningTasks == 0 && m_tasks.empty())
+			m_tasksDone.notify_all();
+	}
+}
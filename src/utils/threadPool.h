@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utils
+{
+
+/**
+ * @brief Fixed set of worker threads running submitted tasks in submission order, used to run forked cores in
+ * parallel. Tasks must not submit to or wait on their own pool.
+ */
+class ThreadPool
+{
+  public:
+	/**
+	 * @param threadCount Worker threads, 0 uses one per hardware thread.
+	 */
+	explicit ThreadPool(uint32_t threadCount = 0);
+
+	// waits for every submitted task to finish
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &)            = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	void submit(std::function<void()> task);
+
+	/**
+	 * @brief Block until every task submitted so far has finished.
+	 */
+	void wait();
+
+	uint32_t getThreadCount() const
+	{
+		return static_cast<uint32_t>(m_threads.size());
+	}
+
+  private:
+	std::vector<std::thread>          m_threads;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex                        m_mutex;
+	std::condition_variable           m_taskAvailable;
+	std::condition_variable           m_tasksDone;
+	uint32_t                          m_runningTasks = 0;
+	bool                              m_stopping     = false;
+
+	void workerLoop();
+};
+
+} // namespace Utils
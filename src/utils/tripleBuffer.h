@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Utils
+{
+
+/**
+ * @brief Lock free hand off of the newest value from one producer thread to one consumer thread. The producer fills
+ * the write buffer and publishes it, the consumer swaps in the newest published buffer whenever it wants one. Neither
+ * side ever waits on the other, values published in between are skipped.
+ */
+template <typename T>
+class TripleBuffer
+{
+  public:
+	T &getWriteBuffer()
+	{
+		return m_buffers[m_writeIndex];
+	}
+
+	// hand the write buffer to the consumer and take the spare one to write next
+	void publish()
+	{
+		m_writeIndex = m_spare.exchange(static_cast<uint8_t>(m_writeIndex | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	/**
+	 * @brief Swap in the newest published buffer.
+	 * @return False if nothing was published since the last update, the read buffer is unchanged.
+	 */
+	bool update()
+	{
+		if (!(m_spare.load(std::memory_order_relaxed) & FRESH))
+			return false;
+
+		m_readIndex = m_spare.exchange(m_readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	const T &getReadBuffer() const
+	{
+		return m_buffers[m_readIndex];
+	}
+
+  private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t FRESH      = 0x4; // set on the spare index while it holds a buffer the consumer has not seen
+
+	std::array<T, 3> m_buffers{};
+
+	uint8_t              m_writeIndex = 0; // owned by the producer
+	uint8_t              m_readIndex  = 1; // owned by the consumer
+	std::atomic<uint8_t> m_spare      = 2;
+};
+
+} // namespace Utils
@@ -0,0 +1,190 @@
+#include "udpSocket.h"
+#include "fmt/base.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+typedef int    SocketLength;
+
+bool startupSockets()
+{
+	// winsock is started once for the lifetime of the process
+	static const bool started = []() {
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+
+	return started;
+}
+
+void closeSocket(intptr_t socket)
+{
+	closesocket(static_cast<SocketHandle>(socket));
+}
+
+bool setNonBlocking(intptr_t socket)
+{
+	u_long nonBlocking = 1;
+	return ioctlsocket(static_cast<SocketHandle>(socket), FIONBIO, &nonBlocking) == 0;
+}
+#else
+typedef int       SocketHandle;
+typedef socklen_t SocketLength;
+
+bool startupSockets()
+{
+	return true;
+}
+
+void closeSocket(intptr_t socket)
+{
+	::close(static_cast<SocketHandle>(socket));
+}
+
+bool setNonBlocking(intptr_t socket)
+{
+	const int flags = fcntl(static_cast<SocketHandle>(socket), F_GETFL, 0);
+	return flags != -1 && fcntl(static_cast<SocketHandle>(socket), F_SETFL, flags | O_NONBLOCK) == 0;
+}
+#endif
+} // namespace
+
+Utils::UdpSocket::~UdpSocket()
+{
+	close();
+}
+
+bool Utils::UdpSocket::open(uint16_t port)
+{
+	close();
+
+	if (!startupSockets())
+	{
+		fmt::println(stderr, "Failed to initialize sockets!");
+		return false;
+	}
+
+	const SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+	if (handle == INVALID_SOCKET)
+#else
+	if (handle < 0)
+#endif
+	{
+		fmt::println(stderr, "Failed to create udp socket!");
+		return false;
+	}
+
+	m_socket = static_cast<intptr_t>(handle);
+
+	sockaddr_in address{};
+	address.sin_family      = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port        = htons(port);
+
+	if (bind(handle, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || !setNonBlocking(m_socket))
+	{
+		fmt::println(stderr, "Failed to bind udp socket to port {}", port);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void Utils::UdpSocket::close()
+{
+	if (isOpen())
+		closeSocket(m_socket);
+
+	m_socket = -1;
+}
+
+bool Utils::UdpSocket::setPeer(const std::string &address, uint16_t port)
+{
+	if (!startupSockets())
+		return false;
+
+	addrinfo hints{};
+	hints.ai_family   = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	addrinfo *result = nullptr;
+	if (getaddrinfo(address.c_str(), nullptr, &hints, &result) != 0 || result == nullptr)
+	{
+		fmt::println(stderr, "Failed to resolve address: {}", address);
+		return false;
+	}
+
+	m_peerAddress = reinterpret_cast<const sockaddr_in *>(result->ai_addr)->sin_addr.s_addr;
+	m_peerPort    = htons(port);
+
+	freeaddrinfo(result);
+	return true;
+}
+
+bool Utils::UdpSocket::send(const void *data, std::size_t size)
+{
+	if (!isOpen())
+		return false;
+
+	sockaddr_in address{};
+	address.sin_family      = AF_INET;
+	address.sin_addr.s_addr = m_peerAddress;
+	address.sin_port        = m_peerPort;
+
+	const auto sent = sendto(static_cast<SocketHandle>(m_socket), static_cast<const char *>(data), static_cast<int>(size), 0, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+	return sent >= 0 && static_cast<std::size_t>(sent) == size;
+}
+
+std::size_t Utils::UdpSocket::receive(void *buffer, std::size_t capacity)
+{
+	if (!isOpen())
+		return 0;
+
+	while (true)
+	{
+		sockaddr_in  address{};
+		SocketLength addressLength = sizeof(address);
+
+		const auto received = recvfrom(static_cast<SocketHandle>(m_socket), static_cast<char *>(buffer), static_cast<int>(capacity), 0, reinterpret_cast<sockaddr *>(&address), &addressLength);
+
+		// nothing pending, or an error such as a port unreachable report from a peer that is not listening yet
+		if (received < 0)
+			return 0;
+
+		if (address.sin_addr.s_addr == m_peerAddress && address.sin_port == m_peerPort)
+			return static_cast<std::size_t>(received);
+	}
+}
+
+uint16_t Utils::UdpSocket::getLocalPort() const
+{
+	sockaddr_in  address{};
+	SocketLength addressLength = sizeof(address);
+
+	if (!isOpen() || getsockname(static_cast<SocketHandle>(m_socket), reinterpret_cast<sockaddr *>(&address), &addressLength) != 0)
+		return 0;
+
+	return ntohs(address.sin_port);
+}
+
+bool Utils::UdpSocket::isOpen() const
+{
+	return m_socket != -1;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Utils
+{
+
+/**
+ * @brief Non blocking ipv4 udp socket that exchanges datagrams with a single peer. Datagrams from any other address
+ * are dropped.
+ */
+class UdpSocket
+{
+  public:
+	UdpSocket() = default;
+	~UdpSocket();
+
+	UdpSocket(const UdpSocket &)            = delete;
+	UdpSocket &operator=(const UdpSocket &) = delete;
+
+	/**
+	 * @brief Bind to a local port on all interfaces.
+	 * @param port Local port, 0 picks a free one, see getLocalPort().
+	 * @return True on success, false otherwise.
+	 */
+	bool open(uint16_t port);
+	void close();
+
+	/**
+	 * @brief Set where datagrams are sent to and accepted from.
+	 * @param address Dotted ipv4 address or host name.
+	 * @return True on success, false if the address does not resolve.
+	 */
+	bool setPeer(const std::string &address, uint16_t port);
+
+	bool send(const void *data, std::size_t size);
+
+	/**
+	 * @brief Read the next pending datagram from the peer.
+	 * @return Size of the datagram, 0 if none is pending. Datagrams larger than capacity are truncated.
+	 */
+	std::size_t receive(void *buffer, std::size_t capacity);
+
+	uint16_t getLocalPort() const;
+
+	bool isOpen() const;
+
+  private:
+	// SOCKET on windows, file descriptor elsewhere
+	intptr_t m_socket = -1;
+
+	uint32_t m_peerAddress = 0; // network byte order
+	uint16_t m_peerPort    = 0; // network byte order
+};
+
+} // namespace Utils
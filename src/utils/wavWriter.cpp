@@ -0,0 +1,104 @@
+#include "wavWriter.h"
+
+#include "fmt/base.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr uint32_t WAV_HEADER_SIZE = 44;
+constexpr uint16_t BITS_PER_SAMPLE = 16;
+constexpr uint16_t CHANNEL_COUNT   = 1;
+
+// wav files are little endian regardless of host
+void writeU16(std::ofstream &file, uint16_t value)
+{
+	const char bytes[2] = {static_cast<char>(value & 0xFF), static_cast<char>(value >> 8)};
+	file.write(bytes, sizeof(bytes));
+}
+
+void writeU32(std::ofstream &file, uint32_t value)
+{
+	const char bytes[4] = {
+		static_cast<char>(value & 0xFF),
+		static_cast<char>((value >> 8) & 0xFF),
+		static_cast<char>((value >> 16) & 0xFF),
+		static_cast<char>(value >> 24),
+	};
+	file.write(bytes, sizeof(bytes));
+}
+} // namespace
+
+Utils::WavWriter::~WavWriter()
+{
+	close();
+}
+
+bool Utils::WavWriter::open(const std::string &path, uint32_t sampleRate)
+{
+	close();
+
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file.is_open())
+	{
+		fmt::println(stderr, "Failed to create wav file at: {}", path);
+		return false;
+	}
+
+	m_samplesWritten = 0;
+
+	constexpr uint16_t BLOCK_ALIGN = CHANNEL_COUNT * BITS_PER_SAMPLE / 8;
+
+	// data sizes are left as zero until close()
+	m_file.write("RIFF", 4);
+	writeU32(m_file, 0);
+	m_file.write("WAVE", 4);
+
+	m_file.write("fmt ", 4);
+	writeU32(m_file, 16);
+	writeU16(m_file, 1); // PCM
+	writeU16(m_file, CHANNEL_COUNT);
+	writeU32(m_file, sampleRate);
+	writeU32(m_file, sampleRate * BLOCK_ALIGN);
+	writeU16(m_file, BLOCK_ALIGN);
+	writeU16(m_file, BITS_PER_SAMPLE);
+
+	m_file.write("data", 4);
+	writeU32(m_file, 0);
+
+	return true;
+}
+
+void Utils::WavWriter::write(const float *samples, std::size_t count)
+{
+	if (!m_file.is_open())
+		return;
+
+	m_pcmBuffer.resize(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const float sample = std::clamp(samples[i], -1.0f, 1.0f);
+		m_pcmBuffer[i]     = static_cast<int16_t>(std::lround(sample * 32767.0f));
+	}
+
+	// pcm samples are written as is, assumes a little endian host
+	m_file.write(reinterpret_cast<const char *>(m_pcmBuffer.data()), count * sizeof(int16_t));
+	m_samplesWritten += static_cast<uint32_t>(count);
+}
+
+void Utils::WavWriter::close()
+{
+	if (!m_file.is_open())
+		return;
+
+	const uint32_t dataSize = m_samplesWritten * CHANNEL_COUNT * (BITS_PER_SAMPLE / 8);
+
+	m_file.seekp(4, std::ios::beg);
+	writeU32(m_file, WAV_HEADER_SIZE - 8 + dataSize);
+
+	m_file.seekp(WAV_HEADER_SIZE - 4, std::ios::beg);
+	writeU32(m_file, dataSize);
+
+	m_file.close();
+}
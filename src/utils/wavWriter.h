@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+
+/**
+ * @brief Streams mono 32-bit float samples into a 16-bit PCM wav file. Header sizes are patched in once the file is closed.
+ */
+class WavWriter
+{
+  public:
+	WavWriter() = default;
+	~WavWriter();
+
+	WavWriter(const WavWriter &)            = delete;
+	WavWriter &operator=(const WavWriter &) = delete;
+
+	/**
+	 * @brief Create wav file at path, overwrites any existing file.
+	 * @param path
+	 * @param sampleRate
+	 * @return True on success, false otherwise.
+	 */
+	bool open(const std::string &path, uint32_t sampleRate);
+
+	/**
+	 * @brief Append samples to the wav file, samples are clamped into the range (-1.0f - 1.0f).
+	 * @param samples
+	 * @param count
+	 */
+	void write(const float *samples, std::size_t count);
+
+	/**
+	 * @brief Patch header sizes and close the file.
+	 */
+	void close();
+
+	bool isOpen() const
+	{
+		return m_file.is_open();
+	}
+
+	uint32_t getSamplesWritten() const
+	{
+		return m_samplesWritten;
+	}
+
+  private:
+	std::ofstream        m_file;
+	std::vector<int16_t> m_pcmBuffer; // reused between writes to avoid allocating per frame
+	uint32_t             m_samplesWritten = 0;
+};
+
+} // namespace Utils
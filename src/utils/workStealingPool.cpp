@@ -0,0 +1,78 @@
+#include "workStealingPool.h"
+
+#include <algorithm>
+#include <thread>
+
+Utils::WorkStealingPool::WorkStealingPool(uint32_t threadCount)
+	: m_threadCount(threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount)
+{
+	for (uint32_t i = 0; i < m_threadCount; ++i)
+		m_queues.push_back(std::make_unique<WorkerQueue>());
+}
+
+void Utils::WorkStealingPool::run(uint32_t taskCount, const std::function<void(uint32_t worker, uint32_t index)> &task)
+{
+	m_steals.store(0, std::memory_order_relaxed);
+
+	// neighbouring tasks tend to cost about the same, contiguous runs keep the first steals rare
+	for (uint32_t worker = 0; worker < m_threadCount; ++worker)
+	{
+		const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(taskCount) * worker / m_threadCount);
+		const uint32_t last  = static_cast<uint32_t>(static_cast<uint64_t>(taskCount) * (worker + 1) / m_threadCount);
+
+		std::deque<uint32_t> &tasks = m_queues[worker]->Tasks;
+		tasks.clear();
+
+		for (uint32_t index = first; index < last; ++index)
+			tasks.push_back(index);
+	}
+
+	std::vector<std::thread> threads;
+	for (uint32_t worker = 1; worker < m_threadCount; ++worker)
+		threads.emplace_back(&WorkStealingPool::workerLoop, this, worker, std::cref(task));
+
+	workerLoop(0, task);
+
+	for (auto &thread : threads)
+		thread.join();
+}
+
+void Utils::WorkStealingPool::workerLoop(uint32_t worker, const std::function<void(uint32_t worker, uint32_t index)> &task)
+{
+	// nothing is queued once run() starts the workers, every queue empty means every task has been taken
+	uint32_t index;
+	while (popOwn(worker, index) || steal(worker, index))
+		task(worker, index);
+}
+
+bool Utils::WorkStealingPool::popOwn(uint32_t worker, uint32_t &index)
+{
+	WorkerQueue                &queue = *m_queues[worker];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+
+	if (queue.Tasks.empty())
+		return false;
+
+	index = queue.Tasks.front();
+	queue.Tasks.pop_front();
+	return true;
+}
+
+bool Utils::WorkStealingPool::steal(uint32_t worker, uint32_t &index)
+{
+	for (uint32_t offset = 1; offset < m_threadCount; ++offset)
+	{
+		WorkerQueue                &victim = *m_queues[(worker + offset) % m_threadCount];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+
+		if (victim.Tasks.empty())
+			continue;
+
+		index = victim.Tasks.back();
+		victim.Tasks.pop_back();
+		m_steals.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Utils
+{
+
+/**
+ * @brief Runs a fixed set of independent tasks on worker threads that each own a queue. Tasks are dealt out in
+ * contiguous runs up front, a worker that empties its own queue steals from the back of the others, so a few long
+ * tasks do not leave the other threads idle. Workers are numbered so each can keep its own state, like one emulator
+ * instance per worker, with nothing mutable shared between them.
+ */
+class WorkStealingPool
+{
+  public:
+	/**
+	 * @param threadCount Worker threads, 0 uses one per hardware thread.
+	 */
+	explicit WorkStealingPool(uint32_t threadCount = 0);
+
+	WorkStealingPool(const WorkStealingPool &)            = delete;
+	WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+	/**
+	 * @brief Run task(worker, index) for every index in [0, taskCount) and block until all have finished. The calling
+	 * thread is worker 0. Threads only live for one run, batches are long enough that starting them does not show.
+	 */
+	void run(uint32_t taskCount, const std::function<void(uint32_t worker, uint32_t index)> &task);
+
+	uint32_t getThreadCount() const
+	{
+		return m_threadCount;
+	}
+
+	// tasks taken from another worker's queue during the last run
+	uint64_t getStealCount() const
+	{
+		return m_steals.load(std::memory_order_relaxed);
+	}
+
+  private:
+	// padded to a cache line so workers popping their own queue do not contend on the same line
+	struct alignas(64) WorkerQueue
+	{
+		std::mutex           Mutex;
+		std::deque<uint32_t> Tasks;
+	};
+
+	uint32_t                                  m_threadCount;
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::atomic<uint64_t>                     m_steals{0};
+
+	void workerLoop(uint32_t worker, const std::function<void(uint32_t worker, uint32_t index)> &task);
+
+	// next task of a worker's own queue, taken from the front so runs stay in order
+	bool popOwn(uint32_t worker, uint32_t &index);
+
+	// last task of the first other queue that has any
+	bool steal(uint32_t worker, uint32_t &index);
+};
+
+} // namespace Utils